@@ -0,0 +1,112 @@
+#include "../src/include/lexer.h"
+#include "../src/include/parser.h"
+#include "../src/include/resolver.h"
+#include "../src/include/inference.h"
+#include "../src/include/interpreter.h"
+#include "../src/include/stack_interpreter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+static double elapsed_seconds(struct timespec start, struct timespec end)
+{
+  return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Number of calls fib(n) makes, itself included
+static long fib_calls(long n)
+{
+  long a = 1, b = 1; // calls(0), calls(1)
+  for (long i = 2; i <= n; i++)
+  {
+    long c = a + b + 1;
+    a = b;
+    b = c;
+  }
+  return n == 0 ? a : b;
+}
+
+// Parses, resolves, infers and runs the program in a fresh global scope, returning the seconds the run took
+static double run_program(char *program, int stack_engine)
+{
+  lexer_ *lexer = init_lexer(program);
+  token_stream_ *tokens = lexer_tokenize(lexer);
+  scope_ *scope = init_scope(NULL, "global_scope");
+  parser_ *parser = init_parser(tokens, scope);
+  resolver_ *resolver = init_resolver(scope);
+  interpreter_ *interpreter = init_interpreter(scope);
+
+  ast_ *root = parser_parse(parser, scope);
+  resolver_resolve(resolver, root);
+  inference_ *inference = init_inference(scope);
+  inference_infer(inference, root);
+  free_inference(inference);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  if (stack_engine)
+    stack_interpreter_run(interpreter, root);
+  else
+    interpreter_process(interpreter, root);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  free_parser(parser);
+  return elapsed_seconds(start, end);
+}
+
+int main(int argc, char *argv[])
+{
+  // Argument of the naive recursive fib being timed (default 25) and how many runs the best time is taken from
+  long n = argc > 1 ? strtol(argv[1], NULL, 10) : 25;
+  long runs = argc > 2 ? strtol(argv[2], NULL, 10) : 5;
+
+  char program[512];
+  snprintf(program, sizeof(program),
+           "SUBROUTINE fib(n)\n"
+           "  r <- n\n"
+           "  IF n > 1 THEN\n"
+           "    r <- fib(n - 1) + fib(n - 2)\n"
+           "  ENDIF\n"
+           "  RETURN r\n"
+           "ENDSUBROUTINE\n"
+           "result <- fib(%ld)\n",
+           n);
+
+  const char *engines[] = {"tree", "stack"};
+  long calls = fib_calls(n);
+
+  for (int engine = 0; engine < 2; engine++)
+  {
+    double best = 0;
+    for (long run = 0; run < runs; run++)
+    {
+      // The interpreter never frees what a run allocates, so each run gets a fresh process and the engines an equal
+      // heap to start from
+      int channel[2];
+      double seconds = 0;
+      if (pipe(channel) != 0)
+        return 1;
+      if (fork() == 0)
+      {
+        seconds = run_program(program, engine);
+        write(channel[1], &seconds, sizeof(seconds));
+        _exit(0);
+      }
+      read(channel[0], &seconds, sizeof(seconds));
+      wait(NULL);
+      close(channel[0]);
+      close(channel[1]);
+
+      if (run == 0 || seconds < best)
+        best = seconds;
+    }
+
+    printf("fib(%ld), %-5s engine: %ld calls in %.3f s, %.0f calls/sec, %.1f ns/call\n", n, engines[engine], calls,
+           best, calls / best, best * 1e9 / calls);
+  }
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include "../src/include/lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Representative statements repeated to build a large program in memory.
+static const char *program_lines[] = {
+    "# Generated benchmark program\n",
+    "CONSTANT LIMIT <- 1000\n",
+    "total_value <- (total_value + index_1 * 3) - 42 DIV 7\n",
+    "message <- \"The quick brown fox jumps over the lazy dog\"\n",
+    "ratio <- 3.14159 * radius ^ 2.0\n",
+    "IF (total_value MOD 3) = 0 AND NOT finished THEN\n",
+    "  OUTPUT 'Fizz', total_value, LEN(message)\n",
+    "ENDIF\n",
+    "FOR counter <- 1 TO LIMIT STEP 2\n",
+    "  scores[counter] <- scores[counter - 1] + 1\n",
+    "ENDFOR\n",
+    "banner <- \"A string literal that spans lines\n# is not a comment\nand hides newlines from the shard splitter\"\n",
+    "note <- \"Bytes only strings may hold, seen by a shard starting mid-string:\n@ ; % ~ $ ? & \r\ncaf\xC3\xA9\"\n",
+    NULL};
+
+static char *generate_program(size_t target_size)
+{
+  char *buffer = malloc(target_size + 256);
+  size_t used = 0;
+
+  while (used < target_size)
+  {
+    for (int i = 0; program_lines[i] != NULL; i++)
+    {
+      size_t length = strlen(program_lines[i]);
+      memcpy(buffer + used, program_lines[i], length);
+      used += length;
+    }
+  }
+
+  buffer[used] = '\0';
+  return buffer;
+}
+
+static double elapsed_seconds(struct timespec start, struct timespec end)
+{
+  return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Returns whether two token streams hold the same tokens at the same positions.
+static int same_tokens(token_stream_ *a, token_stream_ *b)
+{
+  if (a->count != b->count)
+    return 0;
+
+  for (unsigned int i = 0; i < a->count; i++)
+  {
+    token_ *x = &a->tokens[i];
+    token_ *y = &b->tokens[i];
+    if (x->type != y->type || x->offset != y->offset || x->length != y->length || x->line != y->line || x->column != y->column)
+      return 0;
+  }
+
+  return 1;
+}
+
+int main(int argc, char *argv[])
+{
+  // Size of the generated program in megabytes (default 8MB) and the most threads to try (default: every CPU)
+  size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 8;
+  int max_threads = argc > 2 ? atoi(argv[2]) : sysconf(_SC_NPROCESSORS_ONLN);
+  char *contents = generate_program(megabytes * 1024 * 1024);
+  size_t bytes = strlen(contents);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  lexer_ *lexer = init_lexer(contents);
+  token_stream_ *stream = lexer_tokenize(lexer);
+  size_t tokens = stream->count;
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double seconds = elapsed_seconds(start, end);
+
+  printf("Lexed %zu tokens from %.2f MB in %.3f seconds\n", tokens, bytes / (1024.0 * 1024.0), seconds);
+  printf("Throughput: %.0f tokens/sec, %.2f MB/sec\n", tokens / seconds, bytes / (1024.0 * 1024.0) / seconds);
+
+  // Sharded lexing across a growing number of threads, checked against the sequential tokens
+  for (int threads = 2; threads <= max_threads; threads *= 2)
+  {
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    lexer_ *parallel_lexer = init_lexer(contents);
+    token_stream_ *parallel_stream = lexer_tokenize_parallel(parallel_lexer, threads);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double parallel_seconds = elapsed_seconds(start, end);
+
+    if (!same_tokens(stream, parallel_stream))
+    {
+      fprintf(stderr, "Error: Lexing on %d threads produced different tokens.\n", threads);
+      return EXIT_FAILURE;
+    }
+
+    printf("%2d threads: %.0f tokens/sec, %.2f MB/sec (%.2fx)\n", threads, tokens / parallel_seconds,
+           bytes / (1024.0 * 1024.0) / parallel_seconds, seconds / parallel_seconds);
+
+    free_token_stream(parallel_stream);
+    free(parallel_lexer);
+  }
+
+  return 0;
+}
@@ -0,0 +1,147 @@
+#include "../src/include/lexer.h"
+#include "../src/include/scan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Programs that lean on each kernel: deep indentation, long comments and long identifiers.
+static const char *indented_lines[] = {
+    "                                IF total_value > 0 THEN\n",
+    "\t\t\t\t\t\t\t\t\t\t\t\tOUTPUT total_value\n",
+    "                                ENDIF\n",
+    NULL};
+
+static const char *commented_lines[] = {
+    "# The quick brown fox jumps over the lazy dog, then explains itself at considerable length\n",
+    "counter <- counter + 1 # Advance the counter by exactly one step on every single iteration\n",
+    NULL};
+
+static const char *identifier_lines[] = {
+    "accumulated_running_total_of_scores <- accumulated_running_total_of_scores + latest_submitted_score_value\n",
+    "OUTPUT average_score_across_every_student_in_the_class, highest_individual_score_recorded_so_far\n",
+    NULL};
+
+static char *generate_program(const char **lines, size_t target_size)
+{
+  char *buffer = malloc(target_size + 256);
+  size_t used = 0;
+
+  while (used < target_size)
+  {
+    for (int i = 0; lines[i] != NULL; i++)
+    {
+      size_t length = strlen(lines[i]);
+      memcpy(buffer + used, lines[i], length);
+      used += length;
+    }
+  }
+
+  buffer[used] = '\0';
+  return buffer;
+}
+
+static double elapsed_seconds(struct timespec start, struct timespec end)
+{
+  return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Lexes the whole program with the given kernels and returns the time taken.
+static double time_lexer(char *contents, const scan_kernels_ *kernels, unsigned int *token_count)
+{
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  lexer_ *lexer = init_lexer(contents);
+  lexer->scan = kernels;
+  token_stream_ *stream = lexer_tokenize(lexer);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  *token_count = stream->count;
+  free_token_stream(stream);
+  free(lexer);
+
+  return elapsed_seconds(start, end);
+}
+
+// Runs one kernel across the whole buffer, stepping over each character that ends a run, and returns the time taken.
+static double time_kernel(const char *contents, size_t length, size_t (*kernel)(const char *, size_t, size_t))
+{
+  struct timespec start, end;
+  size_t stops = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (size_t index = 0; index < length; index++)
+  {
+    index = kernel(contents, index, length);
+    stops++;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  // Keep the loop observable so it is not optimised away
+  if (stops == 0)
+    printf("No runs found\n");
+
+  return elapsed_seconds(start, end);
+}
+
+int main(int argc, char *argv[])
+{
+  // Size of each generated program in megabytes (default 8MB)
+  size_t megabytes = argc > 1 ? strtoul(argv[1], NULL, 10) : 8;
+
+  const char *names[] = {"indentation", "comments", "identifiers"};
+  const char **corpora[] = {indented_lines, commented_lines, identifier_lines};
+  const scan_kernels_ *kernels[] = {scan_scalar_kernels(), scan_sse2_kernels(), scan_avx2_kernels()};
+
+  printf("Selected kernels: %s\n", scan_select_kernels()->name);
+
+  for (int c = 0; c < 3; c++)
+  {
+    char *contents = generate_program(corpora[c], megabytes * 1024 * 1024);
+    double megabytes_lexed = strlen(contents) / (1024.0 * 1024.0);
+    double scalar_seconds = 0;
+    unsigned int scalar_tokens = 0;
+
+    for (int k = 0; k < 3; k++)
+    {
+      if (kernels[k] == NULL)
+        continue; // Not supported by this CPU
+
+      unsigned int tokens = 0;
+      double seconds = time_lexer(contents, kernels[k], &tokens);
+      if (k == 0)
+      {
+        scalar_seconds = seconds;
+        scalar_tokens = tokens;
+      }
+      else if (tokens != scalar_tokens)
+      {
+        fprintf(stderr, "Error: %s kernels produced %u tokens, scalar produced %u.\n", kernels[k]->name, tokens, scalar_tokens);
+        return EXIT_FAILURE;
+      }
+
+      printf("lexer   %-12s %-7s %8.2f MB/sec  %5.2fx\n", names[c], kernels[k]->name, megabytes_lexed / seconds, scalar_seconds / seconds);
+    }
+
+    // The kernel on its own, without the rest of the lexer around it
+    for (int k = 0; k < 3; k++)
+    {
+      if (kernels[k] == NULL)
+        continue;
+
+      size_t (*kernel)(const char *, size_t, size_t) = c == 0 ? kernels[k]->blanks : c == 1 ? kernels[k]->line_end : kernels[k]->identifier;
+      double seconds = time_kernel(contents, strlen(contents), kernel);
+      if (k == 0)
+        scalar_seconds = seconds;
+
+      printf("kernel  %-12s %-7s %8.2f MB/sec  %5.2fx\n", names[c], kernels[k]->name, megabytes_lexed / seconds, scalar_seconds / seconds);
+    }
+
+    free(contents);
+  }
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+#include "../src/include/scope.h"
+#include "../src/include/intern.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double elapsed_seconds(struct timespec start, struct timespec end)
+{
+  return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Builds `name <- value` the way the interpreter stores a variable.
+static ast_ *make_definition(const char *name, int64_t value)
+{
+  ast_ *definition = init_ast(AST_ASSIGNMENT);
+  definition->lhs = init_ast(AST_VARIABLE);
+  definition->lhs->variable_name = (char *)name;
+  definition->rhs = init_ast(AST_INTEGER);
+  definition->rhs->int_value.value = value;
+  definition->rhs->int_value.null = 0;
+  return definition;
+}
+
+int main(int argc, char *argv[])
+{
+  // Number of lookups timed at each scope size (default 10 million) and the largest scope (default 65536 variables)
+  long lookups = argc > 1 ? strtol(argv[1], NULL, 10) : 10000000;
+  long max_variables = argc > 2 ? strtol(argv[2], NULL, 10) : 65536;
+
+  for (long variables = 16; variables <= max_variables; variables *= 4)
+  {
+    scope_ *scope = init_scope(NULL, "global_scope");
+    char **names = malloc(variables * sizeof(char *));
+    ast_ **definitions = malloc(variables * sizeof(ast_ *));
+    char buffer[32];
+
+    for (long i = 0; i < variables; i++)
+    {
+      snprintf(buffer, sizeof(buffer), "variable_%ld", i);
+      names[i] = intern_name(buffer);
+      definitions[i] = make_definition(names[i], i);
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (long i = 0; i < variables; i++)
+    {
+      scope_add_variable_definition(scope, definitions[i]);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double insert_seconds = elapsed_seconds(start, end);
+
+    // Reads stride through the names so consecutive lookups land in unrelated slots
+    int64_t checksum = 0;
+    long stride = 7919 % variables;
+    long index = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (long i = 0; i < lookups; i++)
+    {
+      checksum += scope_get_variable_definition(scope, names[index])->int_value.value;
+      index += stride;
+      if (index >= variables)
+        index -= variables;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double lookup_seconds = elapsed_seconds(start, end);
+
+    // The same reads through the slots the resolver would give each variable
+    for (long i = 0; i < variables; i++)
+    {
+      definitions[i]->lhs->depth = 0;
+      definitions[i]->lhs->slot = (int)scope_find_slot(scope, names[i]);
+    }
+    index = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (long i = 0; i < lookups; i++)
+    {
+      checksum += scope_read_variable(scope, definitions[index]->lhs)->int_value.value;
+      index += stride;
+      if (index >= variables)
+        index -= variables;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double slot_seconds = elapsed_seconds(start, end);
+
+    printf("%6ld variables: %6.1f ns/lookup, %6.1f ns/slot read, %6.1f ns/insert (checksum %lld)\n", variables,
+           lookup_seconds * 1e9 / lookups, slot_seconds * 1e9 / lookups, insert_seconds * 1e9 / variables,
+           (long long)checksum);
+
+    free(definitions);
+    free(names);
+  }
+
+  return 0;
+}
@@ -0,0 +1,275 @@
+#include "../src/include/lexer.h"
+#include "../src/include/parser.h"
+#include "../src/include/resolver.h"
+#include "../src/include/inference.h"
+#include "../src/include/interpreter.h"
+#include "../src/include/closure.h"
+#include "../src/include/stack_interpreter.h"
+#include "../src/include/vm.h"
+#include "../src/include/jit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+static double elapsed_seconds(struct timespec start, struct timespec end)
+{
+  return (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Corpus the engines are compared on, each program scaled by the benchmark's first argument
+static const struct
+{
+  const char *name;
+  const char *source; // Format string taking the scale
+} corpus[] = {
+    {"integer loops", "total <- 0\n"
+                      "FOR i <- 1 TO %ld\n"
+                      "  IF i MOD 3 = 0 THEN\n"
+                      "    total <- total + i * 2\n"
+                      "  ELSE\n"
+                      "    total <- total - 1\n"
+                      "  ENDIF\n"
+                      "ENDFOR\n"
+                      "OUTPUT total\n"},
+    {"recursive fib", "SUBROUTINE fib(n)\n"
+                      "  IF n < 2 THEN\n"
+                      "    RETURN n\n"
+                      "  ENDIF\n"
+                      "  RETURN fib(n - 1) + fib(n - 2)\n"
+                      "ENDSUBROUTINE\n"
+                      "OUTPUT fib(%ld / 10000 + 5)\n"},
+    {"while and calls", "SUBROUTINE collatz(n)\n"
+                        "  steps <- 0\n"
+                        "  WHILE n != 1\n"
+                        "    IF n MOD 2 = 0 THEN\n"
+                        "      n <- n DIV 2\n"
+                        "    ELSE\n"
+                        "      n <- 3 * n + 1\n"
+                        "    ENDIF\n"
+                        "    steps <- steps + 1\n"
+                        "  ENDWHILE\n"
+                        "  RETURN steps\n"
+                        "ENDSUBROUTINE\n"
+                        "longest <- 0\n"
+                        "FOR start <- 1 TO %ld / 100\n"
+                        "  steps <- collatz(start)\n"
+                        "  IF steps > longest THEN\n"
+                        "    longest <- steps\n"
+                        "  ENDIF\n"
+                        "ENDFOR\n"
+                        "OUTPUT longest\n"},
+    {"arrays", "grid <- [0, 0, 0, 0, 0, 0, 0, 0, 0, 0]\n"
+               "FOR i <- 1 TO %ld / 10\n"
+               "  FOR j <- 0 TO 9\n"
+               "    grid[j] <- grid[j] + i MOD (j + 1)\n"
+               "  ENDFOR\n"
+               "ENDFOR\n"
+               "OUTPUT grid\n"},
+    {"strings", "text <- \"ab\"\n"
+                "WHILE LEN(text) < %ld\n"
+                "  text <- text + text\n"
+                "ENDWHILE\n"
+                "count <- 0\n"
+                "FOR c IN text\n"
+                "  IF c = \"a\" THEN\n"
+                "    count <- count + 1\n"
+                "  ENDIF\n"
+                "ENDFOR\n"
+                "OUTPUT count\n"},
+};
+
+// Programs every engine must run to the tree walker's output and errors, checked before anything is timed
+static const char *checks[] = {
+    // A failed division leaves its variable undefined, and later uses report it rather than trusting its type
+    "d <- 0\n"
+    "x <- 10 DIV d\n"
+    "OUTPUT x + 1\n"
+    "OUTPUT (10 MOD d) * 2, 7 / d - 1\n"
+    "SUBROUTINE ratio(a, b)\n"
+    "  RETURN a DIV b\n"
+    "ENDSUBROUTINE\n"
+    "total <- 0\n"
+    "q <- 0\n"
+    "r <- 0\n"
+    "FOR i <- 1 TO 100\n"
+    "  q <- ratio(i, i MOD 4)\n"
+    "  r <- i MOD (i MOD 3)\n"
+    "  total <- total + r\n"
+    "ENDFOR\n"
+    "OUTPUT total, q + 1\n",
+    // A call stops at its first failed argument, before running any call in the ones after it
+    "SUBROUTINE f(a, b)\n"
+    "  RETURN a + b\n"
+    "ENDSUBROUTINE\n"
+    "SUBROUTINE g()\n"
+    "  OUTPUT \"g\"\n"
+    "  RETURN 2\n"
+    "ENDSUBROUTINE\n"
+    "d <- 0\n"
+    "u <- 1 DIV d\n"
+    "a <- f(u, g())\n"
+    "a <- a\n"
+    "OUTPUT f(1, g())\n",
+};
+
+// Engines the corpus is run in, in the order they are reported; the stack engine, which call_bench times, is only
+// checked
+static const char *engines[] = {"tree", "closure", "vm", "jit", "stack"};
+#define ENGINES 4
+#define CHECKED_ENGINES (int)(sizeof(engines) / sizeof(engines[0]))
+
+// Parses, resolves, infers and runs the program in a fresh global scope, returning the seconds the run took
+static double run_program(char *program, int engine)
+{
+  lexer_ *lexer = init_lexer(program);
+  token_stream_ *tokens = lexer_tokenize(lexer);
+  scope_ *scope = init_scope(NULL, "global_scope");
+  parser_ *parser = init_parser(tokens, scope);
+  resolver_ *resolver = init_resolver(scope);
+  interpreter_ *interpreter = init_interpreter(scope);
+
+  ast_ *root = parser_parse(parser, scope);
+  resolver_resolve(resolver, root);
+  inference_ *inference = init_inference(scope);
+  inference_infer(inference, root);
+  free_inference(inference);
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  vm_ *vm = engine >= 2 ? vm_compile(interpreter, root) : NULL;
+  if (vm != NULL)
+  {
+    vm->jit = engine == 3 ? init_jit(vm) : NULL;
+    vm_run(vm);
+  }
+  else if (engine == 1)
+    closure_run(interpreter, root);
+  else if (engine == 4)
+    stack_interpreter_run(interpreter, root);
+  else
+    interpreter_process(interpreter, root);
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  if (vm != NULL)
+    free_vm(vm);
+  free_parser(parser);
+  return elapsed_seconds(start, end);
+}
+
+// Best time of `runs` runs of the program, each in a fresh process with its output discarded
+static double best_time(char *program, int engine, long runs)
+{
+  double best = 0;
+  for (long run = 0; run < runs; run++)
+  {
+    int channel[2];
+    double seconds = 0;
+    if (pipe(channel) != 0)
+      exit(EXIT_FAILURE);
+    if (fork() == 0)
+    {
+      int null = open("/dev/null", O_WRONLY);
+      dup2(null, STDOUT_FILENO);
+      seconds = run_program(program, engine);
+      write(channel[1], &seconds, sizeof(seconds));
+      _exit(0);
+    }
+    read(channel[0], &seconds, sizeof(seconds));
+    wait(NULL);
+    close(channel[0]);
+    close(channel[1]);
+
+    if (run == 0 || seconds < best)
+      best = seconds;
+  }
+  return best;
+}
+
+// Runs the program in a fresh process, returning everything it wrote to standard output and error, or NULL if the
+// process didn't exit cleanly
+static char *program_output(char *program, int engine)
+{
+  FILE *output = tmpfile();
+  if (output == NULL)
+    exit(EXIT_FAILURE);
+
+  pid_t child = fork();
+  if (child == 0)
+  {
+    setvbuf(stdout, NULL, _IONBF, 0); // Interleave output and errors in the order they are written
+    dup2(fileno(output), STDOUT_FILENO);
+    dup2(fileno(output), STDERR_FILENO);
+    run_program(program, engine);
+    _exit(0);
+  }
+
+  int status = 0;
+  waitpid(child, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+  {
+    fclose(output);
+    return NULL;
+  }
+
+  long size = ftell(output);
+  char *contents = malloc(size + 1);
+  rewind(output);
+  contents[fread(contents, 1, size, output)] = '\0';
+  fclose(output);
+  return contents;
+}
+
+int main(int argc, char *argv[])
+{
+  // Iterations of the corpus' main loops (default 200000) and how many runs the best time is taken from
+  long scale = argc > 1 ? strtol(argv[1], NULL, 10) : 200000;
+  long runs = argc > 2 ? strtol(argv[2], NULL, 10) : 3;
+
+  for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++)
+  {
+    char *program = strdup(checks[i]);
+    char *expected = program_output(program, 0);
+    for (int engine = 1; engine < CHECKED_ENGINES; engine++)
+    {
+      char *output = program_output(program, engine);
+      if (expected == NULL || output == NULL || strcmp(expected, output) != 0)
+      {
+        fprintf(stderr, "Error: Check program %zu ran differently in the %s engine.\n", i + 1,
+                expected == NULL ? "tree" : engines[engine]);
+        return EXIT_FAILURE;
+      }
+      free(output);
+    }
+    free(expected);
+    free(program);
+  }
+
+  double totals[ENGINES] = {0};
+  for (size_t i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++)
+  {
+    char program[1024];
+    snprintf(program, sizeof(program), corpus[i].source, scale);
+
+    double seconds[ENGINES];
+    printf("%-16s", corpus[i].name);
+    for (int engine = 0; engine < ENGINES; engine++)
+    {
+      seconds[engine] = best_time(program, engine, runs);
+      totals[engine] += seconds[engine];
+      printf(" %s %.3f s (%.1fx)", engines[engine], seconds[engine], seconds[0] / seconds[engine]);
+    }
+    printf("\n");
+  }
+
+  printf("%-16s", "total");
+  for (int engine = 0; engine < ENGINES; engine++)
+    printf(" %s %.3f s (%.1fx)", engines[engine], totals[engine], totals[0] / totals[engine]);
+  printf("\n");
+
+  return 0;
+}
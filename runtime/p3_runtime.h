@@ -0,0 +1,1086 @@
+#ifndef P3_RUNTIME_H
+#define P3_RUNTIME_H
+
+// Runtime for the C programs `p3 --emit-c` generates: the values a program computes with, and the tree walker's
+// rules for its operators, output, arrays, records, built-in methods and calls, with the same messages. A generated
+// program includes it once, so its functions are defined here rather than in a library of their own.
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+// Generated programs declare every variable and subroutine the source has, whether or not it is used
+#if defined(__GNUC__)
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+#endif
+
+// Deepest nesting of subroutine calls, which the program is generated with when --max-depth is given
+#ifndef P3_MAX_CALL_DEPTH
+#define P3_MAX_CALL_DEPTH 100000
+#endif
+
+// C stack kept free below the deepest call, for the built-in methods and error reporting it may still run
+#ifndef P3_STACK_RESERVE
+#define P3_STACK_RESERVE (256 * 1024)
+#endif
+
+typedef enum
+{
+  P3_UNSET,  // A variable nothing has been assigned to yet; zero, so static variables start out unset
+  P3_INTEGER,
+  P3_REAL,
+  P3_CHARACTER,
+  P3_STRING,
+  P3_BOOLEAN,
+  P3_ARRAY,
+  P3_RECORD,
+  P3_NOOP,  // The result of a call whose body ended without RETURN
+  P3_ERROR, // The result of an expression that failed, whose error has already been reported
+} p3_type_;
+
+// In the order of the interpreter's operators, so every one from P3_LESS on belongs to a boolean expression
+typedef enum
+{
+  P3_NONE,
+  P3_ADD,
+  P3_SUBTRACT,
+  P3_MULTIPLY,
+  P3_DIVIDE,
+  P3_POWER,
+  P3_INT_DIVIDE,
+  P3_MODULO,
+  P3_LESS,
+  P3_GREATER,
+  P3_EQUAL,
+  P3_NOT_EQUAL,
+  P3_LESS_EQUAL,
+  P3_GREATER_EQUAL,
+  P3_AND,
+  P3_OR,
+  P3_NOT,
+} p3_operator_;
+
+// Which statement a condition that isn't a boolean is reported for
+typedef enum
+{
+  P3_IF,
+  P3_ELSE_IF,
+  P3_LOOP,
+} p3_condition_;
+
+struct P3_ARRAY_STRUCT;
+struct P3_RECORD_STRUCT;
+
+// A value, passed around by value. Arrays and records are shared by reference, as the interpreter shares their nodes.
+typedef struct P3_VALUE_STRUCT
+{
+  p3_type_ type;
+  int null; // Whether an Integer, Real, Character or Boolean is unset, as a record field without a default is
+  union
+  {
+    int64_t int_value;
+    double real_value;
+    char char_value;
+    int boolean_value;
+    const char *string_value;        // NULL for a String field without a default
+    struct P3_ARRAY_STRUCT *array;
+    struct P3_RECORD_STRUCT *record; // NULL for a record field without a default
+  };
+} p3_value_;
+
+typedef struct P3_ARRAY_STRUCT
+{
+  int size;
+  int dimension;         // Arrays nested in it, plus one
+  p3_type_ element_type; // Type of its innermost elements, which record fields are checked against
+  p3_value_ *items;
+} p3_array_;
+
+typedef struct P3_FIELD_STRUCT
+{
+  const char *name;
+  p3_value_ value;
+  int dimension; // Dimension of the array the field holds, 0 for none
+} p3_field_;
+
+typedef struct P3_RECORD_STRUCT
+{
+  const char *name;
+  int field_count;
+  p3_field_ *fields;
+} p3_record_;
+
+// A RECORD statement: its fields' types, dimensions and default values
+typedef struct P3_RECORD_DEFINITION_STRUCT
+{
+  const char *name;
+  int field_count;
+  p3_field_ *fields;
+  int defined; // Whether the statement has run, before which the record can't be instantiated
+} p3_record_definition_;
+
+// Where FOR-IN is up to in its string or array
+typedef struct P3_ITERATOR_STRUCT
+{
+  p3_value_ collection;
+  int64_t position;
+  int64_t length;
+} p3_iterator_;
+
+#define P3_INTEGER_VALUE(value) ((p3_value_){.type = P3_INTEGER, .int_value = (value)})
+#define P3_REAL_VALUE(value) ((p3_value_){.type = P3_REAL, .real_value = (value)})
+#define P3_CHARACTER_VALUE(value) ((p3_value_){.type = P3_CHARACTER, .char_value = (value)})
+#define P3_BOOLEAN_VALUE(value) ((p3_value_){.type = P3_BOOLEAN, .boolean_value = (value)})
+#define P3_STRING_VALUE(value) ((p3_value_){.type = P3_STRING, .string_value = (value)})
+#define P3_NULL_VALUE(type_) ((p3_value_){.type = (type_), .null = 1})
+#define P3_UNSET_VALUE ((p3_value_){.type = P3_UNSET})
+#define P3_NOOP_VALUE ((p3_value_){.type = P3_NOOP})
+#define P3_ERROR_VALUE ((p3_value_){.type = P3_ERROR})
+
+#define P3_INLINE(type) ((type) == P3_INTEGER || (type) == P3_REAL || (type) == P3_CHARACTER || (type) == P3_BOOLEAN)
+#define P3_INTEGERS(left, right) \
+  ((left).type == P3_INTEGER && (right).type == P3_INTEGER && !((left).null | (right).null))
+
+// Integer +, - and * wrap around on overflow, as they are worked out unsigned, where overflow is defined
+#define P3_INTEGER_ADD(a, b) ((int64_t)((uint64_t)(a) + (uint64_t)(b)))
+#define P3_INTEGER_SUBTRACT(a, b) ((int64_t)((uint64_t)(a) - (uint64_t)(b)))
+#define P3_INTEGER_MULTIPLY(a, b) ((int64_t)((uint64_t)(a) * (uint64_t)(b)))
+
+// Whether an operand has no value to compute with; booleans are never treated as null
+#define P3_IS_NULL(value) (P3_INLINE((value).type) ? (value).type != P3_BOOLEAN && (value).null \
+                                                   : (value).type == P3_STRING && (value).string_value == NULL)
+
+// Only booleans carry a truth value; any other value reads as false
+#define P3_TRUTH(value) ((value).type == P3_BOOLEAN && (value).boolean_value)
+
+int p3_call_depth = 0;                 // Subroutine calls running; tail calls don't count
+static uintptr_t p3_stack_base;        // Where the C stack started, and how far calls may take it
+static size_t p3_stack_limit = SIZE_MAX;
+
+// Gets the program going, first thing in main: the program runs close to the top of the stack it starts on, so the
+// stack's size limit is what's left
+void p3_start(void)
+{
+  char stack_top;
+  p3_stack_base = (uintptr_t)&stack_top;
+  srand(time(NULL));
+
+  struct rlimit stack_size;
+  if (getrlimit(RLIMIT_STACK, &stack_size) == 0 && stack_size.rlim_cur != RLIM_INFINITY)
+  {
+    size_t size = stack_size.rlim_cur;
+    p3_stack_limit = size > 2 * P3_STACK_RESERVE ? size - P3_STACK_RESERVE : size / 2;
+  }
+}
+
+void *p3_allocate(size_t size)
+{
+  void *memory = malloc(size > 0 ? size : 1);
+  if (!memory)
+  {
+    fprintf(stderr, "Error: Memory allocation failed.\n");
+    exit(EXIT_FAILURE);
+  }
+  return memory;
+}
+
+// Reads a variable the way the tree walker reads its slot: an unset variable stops the program, and one holding a
+// failed expression or a call's missing result reports it and reads as a failed expression.
+p3_value_ p3_read_failed(p3_value_ value, const char *name, const char *scope)
+{
+  if (value.type == P3_UNSET)
+  {
+    fprintf(stderr, "Error: Variable definition `%s` not found in scope `%s`.\n", name, scope);
+    exit(EXIT_FAILURE);
+  }
+  if (value.type == P3_ERROR)
+    fprintf(stderr, "Interpreter Error: Undefined variable `%s`\n", name);
+  else
+    fprintf(stderr, "Interpreter Error: Uncaught statement of type `AST_NOOP`\n");
+  return P3_ERROR_VALUE;
+}
+
+static inline p3_value_ p3_read(p3_value_ value, const char *name, const char *scope)
+{
+  if (value.type >= P3_INTEGER && value.type <= P3_RECORD)
+    return value;
+  return p3_read_failed(value, name, scope);
+}
+
+static inline int p3_failed(p3_value_ value)
+{
+  return value.type == P3_ERROR;
+}
+
+// Prints a value as OUTPUT does; anything unset prints nothing
+void p3_print(p3_value_ value)
+{
+  if (P3_INLINE(value.type) && value.null)
+    return;
+
+  switch (value.type)
+  {
+  case P3_INTEGER:
+    printf("%" PRId64, value.int_value);
+    break;
+  case P3_REAL:
+    printf("%0.2f", value.real_value);
+    break;
+  case P3_CHARACTER:
+    printf("%c", value.char_value);
+    break;
+  case P3_BOOLEAN:
+    printf("%s", value.boolean_value ? "True" : "False");
+    break;
+  case P3_STRING:
+    if (value.string_value != NULL)
+      printf("%s", value.string_value);
+    break;
+  case P3_ARRAY:
+    if (value.array->size != 0)
+    {
+      printf("[");
+      for (int i = 0; i < value.array->size; i++)
+      {
+        p3_print(value.array->items[i]);
+        if (i < value.array->size - 1)
+          printf(", ");
+      }
+      printf("]");
+    }
+    break;
+  case P3_RECORD:
+    if (value.record != NULL && value.record->name != NULL)
+    {
+      printf("%s {", value.record->name);
+      for (int i = 0; i < value.record->field_count; i++)
+      {
+        printf("%s: ", value.record->fields[i].name);
+        p3_print(value.record->fields[i].value);
+        if (i < value.record->field_count - 1)
+          printf(", ");
+      }
+      printf("}");
+    }
+    break;
+  case P3_ERROR:
+    break; // Already reported
+  default:
+    fprintf(stderr, "Interpreter Error: Unsupported output type in AST_OUTPUT.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+// Prints one of an OUTPUT statement's values, followed by a space or, after its last, a newline
+void p3_output(p3_value_ value, int last)
+{
+  p3_print(value);
+  putchar(last ? '\n' : ' ');
+}
+
+// Divides integers, rounding towards zero; the most negative integer divided by -1 wraps round to itself
+int64_t p3_divide_integer(int64_t a, int64_t b)
+{
+  if (b == -1)
+    return P3_INTEGER_SUBTRACT(0, a);
+  return a / b;
+}
+
+int64_t p3_modulo_euclidean(int64_t a, int64_t b)
+{
+  if (b == -1)
+    return 0;
+  int64_t m = a % b;
+  if (m < 0)
+    m = (b < 0) ? m - b : m + b;
+  return m;
+}
+
+// Raises an integer to a non-negative integer power by squaring, so results stay exact across all 64 bits
+int64_t p3_power_integer(int64_t base, int64_t exponent)
+{
+  if (exponent < 0)
+    return (int64_t)pow((double)base, (double)exponent);
+
+  uint64_t result = 1;
+  uint64_t factor = (uint64_t)base;
+  while (exponent > 0)
+  {
+    if (exponent & 1)
+      result *= factor;
+    factor *= factor;
+    exponent >>= 1;
+  }
+  return (int64_t)result;
+}
+
+p3_value_ p3_concatenate(p3_value_ left, p3_value_ right)
+{
+  char left_text[2] = {left.char_value, '\0'}, right_text[2] = {right.char_value, '\0'};
+  const char *a = left.type == P3_CHARACTER ? left_text : left.string_value;
+  const char *b = right.type == P3_CHARACTER ? right_text : right.string_value;
+
+  size_t a_length = strlen(a), b_length = strlen(b);
+  char *result = p3_allocate(a_length + b_length + 1);
+  memcpy(result, a, a_length);
+  memcpy(result + a_length, b, b_length + 1);
+  return P3_STRING_VALUE(result);
+}
+
+// Reports why an operator doesn't apply to its operands
+p3_value_ p3_operation_error(p3_operator_ op, int unary, p3_value_ left, p3_value_ right)
+{
+  static const char *const symbols[] = {"", "+", "-", "*", "/", "^", "DIV", "MOD"};
+  int same_types = unary || left.type == right.type;
+
+  if (op >= P3_LESS)
+  {
+    if (!same_types)
+      fprintf(stderr, "Interpreter Error: Type mismatch in boolean expression\n");
+    else
+      fprintf(stderr, "Interpreter Error: Unsupported type for boolean comparison\n");
+    return P3_ERROR_VALUE;
+  }
+
+  switch (op)
+  {
+  case P3_ADD:
+    if (same_types)
+      fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer, Real, Character, or String types\n", symbols[op]);
+    else
+      fprintf(stderr, "Interpreter Error: Mismatched types between `%s` operator\n", symbols[op]);
+    break;
+  case P3_SUBTRACT:
+  case P3_MULTIPLY:
+  case P3_DIVIDE:
+  case P3_POWER:
+    if (same_types)
+      fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer or Real types\n", symbols[op]);
+    else
+      fprintf(stderr, "Interpreter Error: Mismatched types between `%s` operator\n", symbols[op]);
+    break;
+  default:
+    fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer types\n", symbols[op]);
+    break;
+  }
+  return P3_ERROR_VALUE;
+}
+
+// Checks the operands every operator starts with: a failed one fails quietly, an unset one is reported
+static int p3_operands_failed(p3_operator_ op, int unary, p3_value_ left, p3_value_ right)
+{
+  if ((!unary && p3_failed(left)) || p3_failed(right))
+    return 1;
+  if ((!unary && P3_IS_NULL(left)) || P3_IS_NULL(right))
+  {
+    fprintf(stderr, "Interpreter Error: Null value in %s expression\n", op >= P3_LESS ? "boolean" : "arithmetic");
+    return 1;
+  }
+  return 0;
+}
+
+// Compares two values of a type that can be ordered, returning -1, 0 or 1
+static int p3_compare(p3_value_ left, p3_value_ right)
+{
+  switch (left.type)
+  {
+  case P3_INTEGER:
+    return (left.int_value > right.int_value) - (left.int_value < right.int_value);
+  case P3_REAL:
+    return (left.real_value > right.real_value) - (left.real_value < right.real_value);
+  case P3_CHARACTER:
+    return (left.char_value > right.char_value) - (left.char_value < right.char_value);
+  default:
+  {
+    int order = strcmp(left.string_value, right.string_value);
+    return (order > 0) - (order < 0);
+  }
+  }
+}
+
+// Applies a binary operator to any operands, as the tree walker's dispatch tables do
+p3_value_ p3_operate(p3_operator_ op, p3_value_ left, p3_value_ right)
+{
+  if (p3_operands_failed(op, 0, left, right))
+    return P3_ERROR_VALUE;
+
+  if (op == P3_AND || op == P3_OR)
+  {
+    if (left.type != right.type)
+      return p3_operation_error(op, 0, left, right);
+    return P3_BOOLEAN_VALUE(op == P3_AND ? P3_TRUTH(left) && P3_TRUTH(right) : P3_TRUTH(left) || P3_TRUTH(right));
+  }
+
+  if (op == P3_ADD && (left.type == P3_CHARACTER || left.type == P3_STRING) &&
+      (right.type == P3_CHARACTER || right.type == P3_STRING))
+    return p3_concatenate(left, right);
+
+  if (left.type != right.type)
+    return p3_operation_error(op, 0, left, right);
+
+  if (op >= P3_LESS)
+  {
+    if (left.type != P3_INTEGER && left.type != P3_REAL && left.type != P3_CHARACTER && left.type != P3_STRING)
+      return p3_operation_error(op, 0, left, right);
+    int order = p3_compare(left, right);
+    switch (op)
+    {
+    case P3_LESS:
+      return P3_BOOLEAN_VALUE(order < 0);
+    case P3_GREATER:
+      return P3_BOOLEAN_VALUE(order > 0);
+    case P3_EQUAL:
+      return P3_BOOLEAN_VALUE(order == 0);
+    case P3_NOT_EQUAL:
+      return P3_BOOLEAN_VALUE(order != 0);
+    case P3_LESS_EQUAL:
+      return P3_BOOLEAN_VALUE(order <= 0);
+    default:
+      return P3_BOOLEAN_VALUE(order >= 0);
+    }
+  }
+
+  if (left.type == P3_INTEGER)
+  {
+    int64_t a = left.int_value, b = right.int_value;
+    switch (op)
+    {
+    case P3_ADD:
+      return P3_INTEGER_VALUE(P3_INTEGER_ADD(a, b));
+    case P3_SUBTRACT:
+      return P3_INTEGER_VALUE(P3_INTEGER_SUBTRACT(a, b));
+    case P3_MULTIPLY:
+      return P3_INTEGER_VALUE(P3_INTEGER_MULTIPLY(a, b));
+    case P3_DIVIDE:
+    case P3_INT_DIVIDE:
+    case P3_MODULO:
+      if (b == 0)
+      {
+        fprintf(stderr, "Interpreter Error: Division by zero\n");
+        return P3_ERROR_VALUE;
+      }
+      return P3_INTEGER_VALUE(op == P3_MODULO ? p3_modulo_euclidean(a, b) : p3_divide_integer(a, b));
+    default:
+      return P3_INTEGER_VALUE(p3_power_integer(a, b));
+    }
+  }
+
+  if (left.type == P3_REAL && op != P3_INT_DIVIDE && op != P3_MODULO)
+  {
+    double a = left.real_value, b = right.real_value;
+    switch (op)
+    {
+    case P3_ADD:
+      return P3_REAL_VALUE(a + b);
+    case P3_SUBTRACT:
+      return P3_REAL_VALUE(a - b);
+    case P3_MULTIPLY:
+      return P3_REAL_VALUE(a * b);
+    case P3_DIVIDE:
+      return P3_REAL_VALUE(a / b);
+    default:
+      return P3_REAL_VALUE(pow(a, b));
+    }
+  }
+
+  return p3_operation_error(op, 0, left, right);
+}
+
+// Applies unary minus or NOT
+p3_value_ p3_unary(p3_operator_ op, p3_value_ right)
+{
+  if (p3_operands_failed(op, 1, right, right))
+    return P3_ERROR_VALUE;
+
+  if (op == P3_NOT)
+    return P3_BOOLEAN_VALUE(!P3_TRUTH(right));
+  if (right.type == P3_INTEGER)
+    return P3_INTEGER_VALUE(P3_INTEGER_SUBTRACT(0, right.int_value));
+  if (right.type == P3_REAL)
+    return P3_REAL_VALUE(-right.real_value);
+  return p3_operation_error(op, 1, right, right);
+}
+
+// Operators whose integer form runs inline while `defined` holds; any other operands, and a zero divisor, get the
+// full rules
+#define P3_OPERATION(name, op, type_, field, defined, expression)         \
+  static inline p3_value_ name(p3_value_ left, p3_value_ right)           \
+  {                                                                       \
+    if (P3_INTEGERS(left, right))                                         \
+    {                                                                     \
+      int64_t a = left.int_value, b = right.int_value;                    \
+      if (defined)                                                        \
+        return (p3_value_){.type = type_, .field = (expression)};         \
+    }                                                                     \
+    return p3_operate(op, left, right);                                   \
+  }
+
+P3_OPERATION(p3_add, P3_ADD, P3_INTEGER, int_value, 1, P3_INTEGER_ADD(a, b))
+P3_OPERATION(p3_subtract, P3_SUBTRACT, P3_INTEGER, int_value, 1, P3_INTEGER_SUBTRACT(a, b))
+P3_OPERATION(p3_multiply, P3_MULTIPLY, P3_INTEGER, int_value, 1, P3_INTEGER_MULTIPLY(a, b))
+P3_OPERATION(p3_divide, P3_DIVIDE, P3_INTEGER, int_value, b != 0, p3_divide_integer(a, b))
+P3_OPERATION(p3_int_divide, P3_INT_DIVIDE, P3_INTEGER, int_value, b != 0, p3_divide_integer(a, b))
+P3_OPERATION(p3_modulo, P3_MODULO, P3_INTEGER, int_value, b != 0, p3_modulo_euclidean(a, b))
+P3_OPERATION(p3_power, P3_POWER, P3_INTEGER, int_value, 1, p3_power_integer(a, b))
+P3_OPERATION(p3_less, P3_LESS, P3_BOOLEAN, boolean_value, 1, a < b)
+P3_OPERATION(p3_greater, P3_GREATER, P3_BOOLEAN, boolean_value, 1, a > b)
+P3_OPERATION(p3_equal, P3_EQUAL, P3_BOOLEAN, boolean_value, 1, a == b)
+P3_OPERATION(p3_not_equal, P3_NOT_EQUAL, P3_BOOLEAN, boolean_value, 1, a != b)
+P3_OPERATION(p3_less_equal, P3_LESS_EQUAL, P3_BOOLEAN, boolean_value, 1, a <= b)
+P3_OPERATION(p3_greater_equal, P3_GREATER_EQUAL, P3_BOOLEAN, boolean_value, 1, a >= b)
+
+// Returns 1 or 0 for a True or False condition, or -1 after reporting one that isn't a boolean
+int p3_condition_failed(p3_condition_ statement)
+{
+  switch (statement)
+  {
+  case P3_IF:
+    fprintf(stderr, "Interpreter Error: IF condition could not be evaluated to a boolean\n");
+    break;
+  case P3_ELSE_IF:
+    fprintf(stderr, "Interpreter Error: ELSE IF condition could not be evaluated to a boolean\n");
+    break;
+  default:
+    fprintf(stderr, "Interpreter Error: Condition could not be evaluated to an integer\n");
+    break;
+  }
+  return -1;
+}
+
+static inline int p3_condition(p3_value_ value, p3_condition_ statement)
+{
+  if (value.type == P3_BOOLEAN && !value.null)
+    return value.boolean_value != 0;
+  return p3_condition_failed(statement);
+}
+
+// Checks a FOR loop's End, Step or Start value is an integer, reporting it if not
+int p3_bound(p3_value_ value, const char *bound)
+{
+  if (value.type == P3_INTEGER && !value.null)
+    return 1;
+  fprintf(stderr, "Interpreter Error: %s expression could not be recognized as an integer\n", bound);
+  return 0;
+}
+
+// Starts a FOR-IN loop over a string or an array, returning 0 after reporting anything else
+int p3_iterate(p3_iterator_ *iterator, p3_value_ collection)
+{
+  iterator->collection = collection;
+  iterator->position = 0;
+  if (collection.type == P3_STRING)
+    iterator->length = collection.string_value != NULL ? (int64_t)strlen(collection.string_value) : 0;
+  else if (collection.type == P3_ARRAY)
+    iterator->length = collection.array->size;
+  else
+  {
+    fprintf(stderr, "Interpreter Error: Collection type not supported in FOR-IN loop\n");
+    return 0;
+  }
+  return 1;
+}
+
+// Moves a FOR-IN loop on to its next item, a string's characters being strings of one character
+int p3_next(p3_iterator_ *iterator, p3_value_ *item)
+{
+  static char characters[256][2];
+  if (iterator->position >= iterator->length)
+    return 0;
+
+  int64_t position = iterator->position++;
+  if (iterator->collection.type == P3_STRING)
+  {
+    unsigned char character = (unsigned char)iterator->collection.string_value[position];
+    characters[character][0] = (char)character;
+    *item = P3_STRING_VALUE(characters[character]);
+  }
+  else
+  {
+    *item = iterator->collection.array->items[position];
+  }
+  return 1;
+}
+
+p3_value_ p3_array(p3_type_ element_type, int dimension, int size, const p3_value_ *items)
+{
+  p3_array_ *array = p3_allocate(sizeof(p3_array_));
+  array->size = size;
+  array->dimension = dimension;
+  array->element_type = element_type;
+  array->items = p3_allocate(size * sizeof(p3_value_));
+  if (size > 0)
+    memcpy(array->items, items, size * sizeof(p3_value_));
+  return (p3_value_){.type = P3_ARRAY, .array = array};
+}
+
+// Copies an array literal and the arrays nested in it, as assigning one does
+p3_value_ p3_copy(p3_value_ value)
+{
+  if (value.type != P3_ARRAY)
+    return value;
+
+  p3_value_ copy = p3_array(value.array->element_type, value.array->dimension, value.array->size, value.array->items);
+  for (int i = 0; i < copy.array->size; i++)
+    copy.array->items[i] = p3_copy(copy.array->items[i]);
+  return copy;
+}
+
+p3_value_ p3_record(const char *name, int field_count, const p3_field_ *fields)
+{
+  p3_record_ *record = p3_allocate(sizeof(p3_record_));
+  record->name = name;
+  record->field_count = field_count;
+  record->fields = p3_allocate(field_count * sizeof(p3_field_));
+  if (field_count > 0)
+    memcpy(record->fields, fields, field_count * sizeof(p3_field_));
+  return (p3_value_){.type = P3_RECORD, .record = record};
+}
+
+// Copies a field's value and everything in it, as a record instantiated from defaults gets its own
+p3_value_ p3_copy_field(p3_value_ value)
+{
+  if (value.type == P3_ARRAY)
+  {
+    p3_value_ copy = p3_array(value.array->element_type, value.array->dimension, value.array->size, value.array->items);
+    for (int i = 0; i < copy.array->size; i++)
+      copy.array->items[i] = p3_copy_field(copy.array->items[i]);
+    return copy;
+  }
+  if (value.type == P3_RECORD && value.record != NULL)
+  {
+    p3_value_ copy = p3_record(value.record->name, value.record->field_count, value.record->fields);
+    for (int i = 0; i < copy.record->field_count; i++)
+      copy.record->fields[i].value = p3_copy_field(copy.record->fields[i].value);
+    return copy;
+  }
+  return value;
+}
+
+// Whether a value can go in a record definition's field: the field's own type, or an array of it with its dimension
+static int p3_field_accepts(const p3_field_ *field, p3_value_ value)
+{
+  return value.type == field->value.type ||
+         (value.type == P3_ARRAY && value.array->element_type == field->value.type &&
+          value.array->dimension == field->dimension);
+}
+
+// Instantiates a record from one value per field. With an argument for every field (`complete`) each is used as it
+// is, and one that doesn't fit is left out; otherwise an unset value takes the field's default, every field gets a
+// copy of its own, and one that doesn't fit fails the instantiation.
+p3_value_ p3_instantiate(p3_record_definition_ *definition, int complete, const p3_value_ *values)
+{
+  p3_record_ *record = p3_allocate(sizeof(p3_record_));
+  record->name = definition->name;
+  record->field_count = 0;
+  record->fields = p3_allocate(definition->field_count * sizeof(p3_field_));
+  for (int i = 0; i < definition->field_count; i++)
+  {
+    const p3_field_ *field = &definition->fields[i];
+    p3_value_ value = values[i];
+    if (p3_failed(value))
+      return P3_ERROR_VALUE;
+    if (!complete && value.type == P3_UNSET)
+      value = field->value;
+
+    if (!p3_field_accepts(field, value))
+    {
+      if (complete)
+        continue;
+      fprintf(stderr, "Interpreter Error: Mismatched type or dimension for field '%s'.\n", field->name);
+      return P3_ERROR_VALUE;
+    }
+
+    p3_field_ *added = &record->fields[record->field_count++];
+    added->name = field->name;
+    added->value = complete ? value : p3_copy_field(value);
+    added->dimension = value.type == P3_ARRAY ? value.array->dimension : 0;
+  }
+  return (p3_value_){.type = P3_RECORD, .record = record};
+}
+
+// Finds the element of `container` (the array variable `name`) at the given indices, or reports why there is none
+static p3_value_ *p3_element(p3_value_ container, const char *name, const char *scope, int count,
+                             const p3_value_ *indices)
+{
+  if (container.type == P3_UNSET)
+    p3_read_failed(container, name, scope);
+  if (container.type == P3_ERROR)
+  {
+    fprintf(stderr, "Interpreter Error: could not fetch array from scope\n");
+    return NULL;
+  }
+  if (container.type != P3_ARRAY)
+  {
+    fprintf(stderr, "Interpreter Error: %s is not defined as an array.\n", name);
+    return NULL;
+  }
+
+  p3_value_ *element = NULL;
+  p3_value_ current = container;
+  for (int i = 0; i < count; i++)
+  {
+    if (indices[i].type != P3_INTEGER)
+    {
+      fprintf(stderr, "Interpreter Error: Array index must be an integer.\n");
+      return NULL;
+    }
+    if (indices[i].null)
+    {
+      fprintf(stderr, "Interpreter Error: Array index cannot be null.\n");
+      return NULL;
+    }
+    int index = (int)indices[i].int_value;
+    if (current.type != P3_ARRAY || index < 0 || index >= current.array->size)
+    {
+      fprintf(stderr, "Interpreter Error: Array index out of bounds or invalid array access.\n");
+      return NULL;
+    }
+    element = &current.array->items[index];
+    current = *element;
+  }
+  return element;
+}
+
+p3_value_ p3_index(p3_value_ container, const char *name, const char *scope, int count, const p3_value_ *indices)
+{
+  p3_value_ *element = p3_element(container, name, scope, count, indices);
+  return element != NULL ? *element : P3_ERROR_VALUE;
+}
+
+// Assigns an array element; when there is no such element the value is assigned to the variable instead, as the
+// tree walker does
+void p3_store_index(p3_value_ *container, const char *name, const char *scope, p3_value_ value, int count,
+                    const p3_value_ *indices)
+{
+  p3_value_ *element = p3_element(*container, name, scope, count, indices);
+  if (element == NULL)
+    *container = value;
+  else if (p3_failed(value) || element->type != value.type)
+    fprintf(stderr, "Interpreter Error: Type mismatch during assignment.\n");
+  else
+    *element = value;
+}
+
+// Finds the field `field` of `container` (the record variable `name`), or reports why there is none
+static p3_value_ *p3_record_field(p3_value_ container, const char *name, const char *field, const char *scope)
+{
+  if (container.type == P3_UNSET)
+    p3_read_failed(container, name, scope);
+  if (container.type != P3_RECORD)
+  {
+    fprintf(stderr, "Interpreter Error: %s is not defined as a record.\n", name);
+    return NULL;
+  }
+
+  for (int i = 0; container.record != NULL && i < container.record->field_count; i++)
+  {
+    if (strcmp(container.record->fields[i].name, field) == 0)
+      return &container.record->fields[i].value;
+  }
+  fprintf(stderr, "Interpreter Error: Field '%s' not found in record '%s'.\n", field, name);
+  return NULL;
+}
+
+p3_value_ p3_field(p3_value_ container, const char *name, const char *field, const char *scope)
+{
+  p3_value_ *value = p3_record_field(container, name, field, scope);
+  return value != NULL ? *value : P3_ERROR_VALUE;
+}
+
+void p3_store_field(p3_value_ *container, const char *name, const char *field, const char *scope, p3_value_ value)
+{
+  p3_value_ *slot = p3_record_field(*container, name, field, scope);
+  if (slot == NULL)
+    *container = value;
+  else if (p3_failed(value) || slot->type != value.type)
+    fprintf(stderr, "Interpreter Error: Type mismatch during assignment.\n");
+  else
+    *slot = value;
+}
+
+// Reads a line for `name <- USERINPUT`. Each such statement keeps the last line it read, which it gives again once
+// the input has run out.
+p3_value_ p3_input(const char *name, const char **line)
+{
+  printf("%s <- ", name);
+
+  char buffer[1024];
+  if (fgets(buffer, sizeof(buffer), stdin) != NULL)
+  {
+    size_t length = strlen(buffer);
+    if (length > 0 && buffer[length - 1] == '\n')
+      buffer[length - 1] = '\0';
+    *line = strcpy(p3_allocate(strlen(buffer) + 1), buffer);
+  }
+  return P3_STRING_VALUE(*line);
+}
+
+// Enters a subroutine, stopping the program once calls nest deeper than allowed or than the C stack can take
+static inline void p3_enter(const char *name)
+{
+  char here;
+  if (p3_call_depth >= P3_MAX_CALL_DEPTH)
+  {
+    fprintf(stderr, "Interpreter Error: Maximum call depth of %d exceeded calling subroutine '%s'.\n",
+            P3_MAX_CALL_DEPTH, name);
+    exit(EXIT_FAILURE);
+  }
+  if ((uintptr_t)&here < p3_stack_base && p3_stack_base - (uintptr_t)&here > p3_stack_limit)
+  {
+    fprintf(stderr, "Interpreter Error: Calling subroutine '%s' %d calls deep would overflow the C stack; raise the "
+                    "stack limit for deeper recursion.\n",
+            name, p3_call_depth);
+    exit(EXIT_FAILURE);
+  }
+  p3_call_depth++;
+}
+
+// Leaves a subroutine with its result
+static inline p3_value_ p3_leave(p3_value_ result)
+{
+  p3_call_depth--;
+  return result;
+}
+
+// A tail call to another subroutine, made by the call the subroutine returns to once it has left, so that a chain of
+// them between subroutines runs in constant C stack whatever the C is compiled with; NULL when there is none
+static p3_value_ (*p3_tail_call)(void);
+
+// Finishes a call to a subroutine, making the tail calls it left, and returns the last one's result
+static inline p3_value_ p3_settle(p3_value_ result)
+{
+  while (p3_tail_call != NULL)
+  {
+    p3_value_ (*call)(void) = p3_tail_call;
+    p3_tail_call = NULL;
+    result = call();
+  }
+  return result;
+}
+
+p3_value_ p3_mismatched_arguments(const char *name)
+{
+  fprintf(stderr, "Interpreter Error: Mismatched number of arguments for subroutine instantiation '%s'.\n", name);
+  return P3_ERROR_VALUE;
+}
+
+// Stops the program at a call to a record or subroutine whose definition hasn't run, or that the program never defines
+p3_value_ p3_undefined(const char *name, const char *scope)
+{
+  fprintf(stderr, "Error: No instantiation definition found for '%s' in scope `%s`\n", name, scope);
+  exit(EXIT_FAILURE);
+}
+
+void p3_uncaught(const char *type)
+{
+  fprintf(stderr, "Interpreter Error: Uncaught statement of type `%s`\n", type);
+}
+
+void p3_exit(int code)
+{
+  if (code == 0)
+  {
+    printf("Program exitted successfully!\n");
+    exit(EXIT_SUCCESS);
+  }
+  printf("Program exited with error code %d\n", code);
+  exit(code);
+}
+
+// Built-in methods, each called with its arguments evaluated. A call with the wrong number of them gets this instead.
+p3_value_ p3_builtin_arguments(const char *method, int expected, int count)
+{
+  fprintf(stderr, "Native Method Error: %s method expects %d argument%s, but got %d.\n", method, expected,
+          expected == 1 ? "" : "s", count);
+  return P3_ERROR_VALUE;
+}
+
+p3_value_ p3_len(p3_value_ value)
+{
+  if (value.type == P3_ARRAY)
+    return P3_INTEGER_VALUE(value.array->size);
+  if (value.type == P3_STRING && value.string_value != NULL)
+    return P3_INTEGER_VALUE((int64_t)strlen(value.string_value));
+  fprintf(stderr, "Native Method Error: LEN method expects an Array or a String.\n");
+  return P3_ERROR_VALUE;
+}
+
+// Whether an element POSITION looks at equals the value it looks for
+static int p3_same(p3_value_ a, p3_value_ b)
+{
+  if (a.type != b.type)
+  {
+    fprintf(stderr, "Interpreter Error: Mismatched types during comparison\n");
+    return 0;
+  }
+
+  switch (b.type)
+  {
+  case P3_STRING:
+    return a.string_value != NULL && b.string_value != NULL && strcmp(a.string_value, b.string_value) == 0;
+  case P3_INTEGER:
+    return !a.null && !b.null && a.int_value == b.int_value;
+  case P3_REAL:
+    return !a.null && !b.null && a.real_value == b.real_value;
+  case P3_CHARACTER:
+    return !a.null && !b.null && a.char_value == b.char_value;
+  case P3_BOOLEAN:
+    return !a.null && !b.null && a.boolean_value == b.boolean_value;
+  case P3_ARRAY:
+    if (a.array->size != b.array->size)
+      return 0;
+    for (int i = 0; i < a.array->size; i++)
+    {
+      if (!p3_same(a.array->items[i], b.array->items[i]))
+        return 0;
+    }
+    return 1;
+  default:
+    fprintf(stderr, "Interpreter Error: Unsupported AST type for comparison.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+p3_value_ p3_position(p3_value_ collection, p3_value_ value)
+{
+  if (collection.type == P3_ARRAY && collection.array->size > 0 && value.type == collection.array->items[0].type)
+  {
+    for (int i = 0; i < collection.array->size; i++)
+    {
+      if (p3_same(collection.array->items[i], value))
+        return P3_INTEGER_VALUE(i);
+    }
+    fprintf(stderr, "Native Method Error: Element not found in array.\n");
+    return P3_ERROR_VALUE;
+  }
+  if (collection.type == P3_STRING && collection.string_value != NULL && value.type == P3_CHARACTER)
+  {
+    const char *found = memchr(collection.string_value, value.char_value, strlen(collection.string_value));
+    if (found != NULL)
+      return P3_INTEGER_VALUE(found - collection.string_value);
+    fprintf(stderr, "Native Method Error: Character not found in string.\n");
+    return P3_ERROR_VALUE;
+  }
+  fprintf(stderr, "Native Method Error: POS method expects an Array or a String.\n");
+  return P3_ERROR_VALUE;
+}
+
+p3_value_ p3_substring(p3_value_ string, p3_value_ start_value, p3_value_ end_value)
+{
+  if (string.type != P3_STRING || string.string_value == NULL || start_value.type != P3_INTEGER ||
+      end_value.type != P3_INTEGER)
+  {
+    fprintf(stderr, "Native Method Error: SUBSTRING method expects a String followed by 2 integers.\n SUBSTRING(string, integer, integer)\n");
+    return P3_ERROR_VALUE;
+  }
+
+  int start = (int)start_value.int_value;
+  int end = (int)end_value.int_value + 1;
+  int length = (int)strlen(string.string_value);
+  if (start < 0 || start >= length || end < 0 || end > length || start > end)
+  {
+    fprintf(stderr, "Native Method Error: SUBSTRING indices out of bounds or invalid. Start: %d, End: %d, String Length: %d\n", start, end, length);
+    return P3_ERROR_VALUE;
+  }
+
+  char *substring = p3_allocate(end - start + 1);
+  memcpy(substring, string.string_value + start, end - start);
+  substring[end - start] = '\0';
+  return P3_STRING_VALUE(substring);
+}
+
+// Slices share their elements with the array, and match no record field's type
+p3_value_ p3_slice(p3_value_ array, p3_value_ start_value, p3_value_ end_value)
+{
+  if (array.type != P3_ARRAY || start_value.type != P3_INTEGER || end_value.type != P3_INTEGER)
+  {
+    fprintf(stderr, "Native Method Error: SLICE method expects an array followed by 2 integers.\n SLICE(array, integer, integer)\n");
+    return P3_ERROR_VALUE;
+  }
+
+  int start = (int)start_value.int_value;
+  int end = (int)end_value.int_value + 1;
+  int size = array.array->size;
+  if (start < 0 || start >= size || end < 0 || end > size || start > end)
+  {
+    fprintf(stderr, "Native Method Error: SLICE indices out of bounds or invalid. Start: %d, End: %d, Array Size: %d\n", start, end, size);
+    return P3_ERROR_VALUE;
+  }
+  return p3_array(P3_NOOP, array.array->dimension, end - start, array.array->items + start);
+}
+
+p3_value_ p3_string_to_int(p3_value_ value)
+{
+  if (value.type == P3_STRING && value.string_value != NULL)
+    return P3_INTEGER_VALUE(strtoll(value.string_value, NULL, 10));
+  fprintf(stderr, "Native Method Error: STRING_TO_INT method expects a string argument.\n");
+  return P3_ERROR_VALUE;
+}
+
+p3_value_ p3_string_to_real(p3_value_ value)
+{
+  if (value.type == P3_STRING && value.string_value != NULL)
+    return P3_REAL_VALUE(atof(value.string_value));
+  fprintf(stderr, "Native Method Error: STRING_TO_REAL method expects a string argument.\n");
+  return P3_ERROR_VALUE;
+}
+
+p3_value_ p3_int_to_string(p3_value_ value)
+{
+  if (value.type != P3_INTEGER)
+  {
+    fprintf(stderr, "Native Method Error: INT_TO_STRING method expects an integer argument.\n");
+    return P3_ERROR_VALUE;
+  }
+  char buffer[21];
+  snprintf(buffer, sizeof(buffer), "%" PRId64, value.int_value);
+  return P3_STRING_VALUE(strcpy(p3_allocate(strlen(buffer) + 1), buffer));
+}
+
+p3_value_ p3_real_to_string(p3_value_ value)
+{
+  if (value.type != P3_REAL)
+  {
+    fprintf(stderr, "Native Method Error: REAL_TO_STRING method expects a real argument.\n");
+    return P3_ERROR_VALUE;
+  }
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%f", value.real_value);
+  return P3_STRING_VALUE(strcpy(p3_allocate(strlen(buffer) + 1), buffer));
+}
+
+p3_value_ p3_char_to_code(p3_value_ value)
+{
+  if (value.type == P3_CHARACTER)
+    return P3_INTEGER_VALUE((int)value.char_value);
+  fprintf(stderr, "Native Method Error: CHAR_TO_CODE method expects a character argument.\n");
+  return P3_ERROR_VALUE;
+}
+
+p3_value_ p3_code_to_char(p3_value_ value)
+{
+  if (value.type == P3_INTEGER)
+    return P3_CHARACTER_VALUE((char)value.int_value);
+  fprintf(stderr, "Native Method Error: CODE_TO_CHAR method expects an integer argument.\n");
+  return P3_ERROR_VALUE;
+}
+
+p3_value_ p3_random_int(p3_value_ min_value, p3_value_ max_value)
+{
+  if (min_value.type != P3_INTEGER || max_value.type != P3_INTEGER)
+  {
+    fprintf(stderr, "Native Method Error: RANDOM_INT method expects two integer arguments.\n");
+    return P3_ERROR_VALUE;
+  }
+  int min = (int)min_value.int_value, max = (int)max_value.int_value;
+  return P3_INTEGER_VALUE(min + rand() % (max - min + 1));
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include "include/arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Every allocation starts on this boundary, which suits any of the structures stored in an arena
+#define ARENA_ALIGNMENT 16
+
+arena_ *init_arena(size_t block_size)
+{
+  arena_ *arena = calloc(1, sizeof(struct ARENA_STRUCT));
+  if (arena == NULL)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for arena initialization.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  arena->blocks = NULL;
+  arena->block_size = block_size > 0 ? block_size : ARENA_BLOCK_SIZE;
+
+  return arena;
+}
+
+// Starts a new block big enough for `size` bytes; blocks come from calloc, so every allocation is already zeroed.
+static arena_block_ *arena_grow(arena_ *arena, size_t size)
+{
+  size_t block_size = arena->block_size;
+  while (block_size < size)
+    block_size *= 2;
+
+  arena_block_ *block = calloc(1, sizeof(arena_block_) + block_size);
+  if (block == NULL)
+  {
+    fprintf(stderr, "Error: Memory allocation failed while growing arena to %zu bytes.\n", block_size);
+    exit(EXIT_FAILURE);
+  }
+
+  block->size = block_size;
+  block->used = 0;
+  block->next = arena->blocks;
+  arena->blocks = block;
+  arena->block_size = block_size * 2; // Fewer, larger blocks as the program grows
+
+  return block;
+}
+
+// Returns `size` zeroed bytes from the newest block, starting a new one when it is full.
+void *arena_alloc(arena_ *arena, size_t size)
+{
+  size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+
+  arena_block_ *block = arena->blocks;
+  if (block == NULL || block->size - block->used < size)
+    block = arena_grow(arena, size);
+
+  void *memory = block->data + block->used;
+  block->used += size;
+
+  return memory;
+}
+
+char *arena_strndup(arena_ *arena, const char *text, size_t length)
+{
+  char *copy = arena_alloc(arena, length + 1);
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+
+  return copy;
+}
+
+char *arena_strdup(arena_ *arena, const char *text)
+{
+  return arena_strndup(arena, text, strlen(text));
+}
+
+// Releases every allocation made from the arena, then the arena itself.
+void free_arena(arena_ *arena)
+{
+  if (arena == NULL)
+    return;
+
+  arena_block_ *block = arena->blocks;
+  while (block != NULL)
+  {
+    arena_block_ *next = block->next;
+    free(block);
+    block = next;
+  }
+
+  free(arena);
+}
@@ -1,87 +1,115 @@
 #include "include/ast.h"
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
+
+// Arena that new nodes and lists come from while a parser is running; NULL means the heap
+static arena_ *active_arena = NULL;
+
+// Makes `arena` back every node and list created from now on (NULL for the heap) and returns the previous one.
+arena_ *ast_use_arena(arena_ *arena)
+{
+  arena_ *previous = active_arena;
+  active_arena = arena;
+  return previous;
+}
+
+// Zeroed memory from the active arena, or from the heap when there is none.
+static void *ast_alloc(size_t size)
+{
+  if (active_arena != NULL)
+    return arena_alloc(active_arena, size);
+
+  return calloc(1, size);
+}
 
 // Function to initialize an AST node of a given type.
 ast_ *init_ast(enum ast_type type)
 {
-  ast_ *ast = calloc(1, sizeof(struct AST_STRUCT));
+  ast_ *ast = ast_alloc(sizeof(struct AST_STRUCT)); // Zeroed, so every pointer and count starts out NULL or 0
   ast->type = type;
 
-  // Initialize all fields to default "null" state
-  ast->scope = NULL;
-
-  ast->int_value.null = 1;
-  ast->int_value.value = 0;
-  ast->real_value.null = 1;
-  ast->real_value.value = 0.0;
-  ast->char_value.null = 1;
-  ast->char_value.value = '\0';
-  ast->string_value = NULL;
-  ast->boolean_value.null = 1;
-  ast->boolean_value.value = 0;
-  ast->array_elements = NULL;
-  ast->array_size = 0;
-  ast->array_dimension = 0;
-  ast->array_type = AST_NOOP;
-
-  ast->compound_value = NULL;
-  ast->lhs = NULL;
-  ast->rhs = NULL;
-  ast->constant = 0;
-  ast->userinput = 0;
-  ast->variable_name = NULL;
-  ast->field_name = NULL;
-  ast->index = NULL;
-  ast->class_name = NULL;
-  ast->arguments = NULL;
-  ast->arguments_count = 0;
-  ast->left = NULL;
-  ast->right = NULL;
-  ast->op = NULL;
-  ast->record_name = NULL;
-  ast->record_elements = NULL;
-  ast->field_count = 0;
-  ast->subroutine_name = NULL;
-  ast->parameters = NULL;
-  ast->parameter_count = 0;
-  ast->body = NULL;
-  ast->return_value = NULL;
-  ast->output_expressions = NULL;
-  ast->loop_variable = NULL;
-  ast->end_expr = NULL;
-  ast->step_expr = NULL;
-  ast->collection_expr = NULL;
-  ast->condition = NULL;
-  ast->indefinite_loop_type = 0;
-  ast->loop_body = NULL;
-  ast->if_condition = NULL;
-  ast->if_body = NULL;
-  ast->else_if_conditions = NULL;
-  ast->else_if_bodies = NULL;
-  ast->else_body = NULL;
-  ast->exit_code = 0;
+  // Literals start in the default "null" state until a value is stored
+  switch (type)
+  {
+  case AST_INTEGER:
+    ast->int_value.null = 1;
+    break;
+  case AST_REAL:
+    ast->real_value.null = 1;
+    break;
+  case AST_CHARACTER:
+    ast->char_value.null = 1;
+    break;
+  case AST_BOOLEAN:
+    ast->boolean_value.null = 1;
+    break;
+  case AST_ARRAY:
+    ast->array_type = AST_NOOP;
+    break;
+  case AST_VARIABLE:
+  case AST_ARRAY_ACCESS:
+  case AST_RECORD_ACCESS:
+    ast->depth = -1; // Looked up by name until the resolver gives it a slot
+    break;
+  default:
+    break;
+  }
 
   return ast;
 }
 
-ast_ **init_ast_list()
+ast_list_ *init_ast_list()
 {
-  ast_ **list = malloc(sizeof(ast_ *));
+  ast_list_ *list = ast_alloc(sizeof(ast_list_));
   if (list == NULL)
   {
     fprintf(stderr, "Error: Memory allocation failed during AST list initialization.\n");
     return NULL;
   }
-  list[0] = NULL;
+  list->items = NULL;
+  list->size = 0;
+  list->capacity = 0;
+  list->arena = active_arena; // Lists grow wherever they were created, even after the parser is done
   return list;
 }
 
-void add_ast_to_list(ast_ ***list, ast_ *new_ast)
+// Appends an entry, doubling the list's room when it is full so appends are amortized O(1).
+static void ast_list_push(ast_list_ *list, void *entry)
 {
-  size_t count = 0;
+  if (list->size == list->capacity)
+  {
+    size_t capacity = list->capacity > 0 ? list->capacity * 2 : 4;
+    ast_ **items;
+
+    if (list->arena != NULL)
+    {
+      // Arena memory cannot be resized, so move the entries into a block twice the size
+      items = arena_alloc(list->arena, sizeof(ast_ *) * capacity);
+      if (list->size > 0)
+        memcpy(items, list->items, sizeof(ast_ *) * list->size);
+    }
+    else
+    {
+      items = realloc(list->items, sizeof(ast_ *) * capacity);
+    }
+
+    if (items == NULL)
+    {
+      fprintf(stderr, "Error: Memory reallocation failed while expanding AST list. Current list size: %zu elements.\n", list->size);
+      return;
+    }
+
+    list->items = items;
+    list->capacity = capacity;
+  }
+
+  list->items[list->size++] = entry;
+}
 
-  if (*list == NULL || new_ast == NULL)
+void add_ast_to_list(ast_list_ *list, ast_ *new_ast)
+{
+  if (list == NULL || new_ast == NULL)
   {
     fprintf(stderr, "Error: Cannot add AST to list. The list or AST is NULL. Ensure the list is initialized before adding elements.\n");
     return;
@@ -92,241 +120,132 @@ void add_ast_to_list(ast_ ***list, ast_ *new_ast)
     return;
   }
 
-  while ((*list)[count] != NULL)
-  {
-    count++;
-  }
+  ast_list_push(list, new_ast);
+}
 
-  ast_ **temp = realloc(*list, sizeof(ast_ *) * (count + 2));
-  if (temp == NULL)
+void add_record_element_to_list(ast_list_ *list, ast_record_element_ *element)
+{
+  if (list == NULL || element == NULL)
   {
-    fprintf(stderr, "Error: Memory reallocation failed while expanding AST list. Current list size: %zu elements.\n", count);
+    fprintf(stderr, "Error: Cannot add record element to list. The list or element is NULL.\n");
     return;
   }
 
-  *list = temp;
-  (*list)[count] = new_ast;
-  (*list)[count + 1] = NULL;
+  ast_list_push(list, element);
 }
 
-ast_ *deep_copy(ast_ *original)
+// Deep copies every node in the list into a new heap list.
+static ast_list_ *deep_copy_list(ast_list_ *original)
 {
   if (original == NULL)
   {
     return NULL;
   }
 
-  // Allocate memory for the new AST node
-  ast_ *copy = init_ast(original->type);
-  if (copy == NULL)
-  {
-    return NULL;
-  }
-
-  // Copy simple fields
-  copy->int_value = original->int_value;
-  copy->real_value = original->real_value;
-  copy->char_value = original->char_value;
-  copy->boolean_value = original->boolean_value;
-
-  copy->constant = original->constant;
-  copy->userinput = original->userinput;
-
-  copy->array_size = original->array_size;
-  copy->array_type = original->array_type;
-  copy->array_dimension = original->array_dimension;
-  copy->field_count = original->field_count;
-  copy->parameter_count = original->parameter_count;
-  copy->arguments_count = original->arguments_count;
-  copy->exit_code = original->exit_code;
-
-  // Deep copy of strings
-  copy->string_value = original->string_value ? strdup(original->string_value) : NULL;
-  copy->variable_name = original->variable_name ? strdup(original->variable_name) : NULL;
-  copy->field_name = original->field_name ? strdup(original->field_name) : NULL;
-  copy->class_name = original->class_name ? strdup(original->class_name) : NULL;
-  copy->record_name = original->record_name ? strdup(original->record_name) : NULL;
-  copy->op = original->op ? strdup(original->op) : NULL;
-  copy->subroutine_name = original->subroutine_name ? strdup(original->subroutine_name) : NULL;
-
-  // Deep copy of AST subtrees (lhs, rhs, left, right, condition, etc.)
-  copy->lhs = deep_copy(original->lhs);
-  copy->rhs = deep_copy(original->rhs);
-  copy->left = deep_copy(original->left);
-  copy->right = deep_copy(original->right);
-  copy->return_value = deep_copy(original->return_value);
-  copy->loop_variable = deep_copy(original->loop_variable);
-  copy->end_expr = deep_copy(original->end_expr);
-  copy->step_expr = deep_copy(original->step_expr);
-  copy->collection_expr = deep_copy(original->collection_expr);
-  copy->condition = deep_copy(original->condition);
-  copy->if_condition = deep_copy(original->if_condition);
-
-  // Deep copy of AST lists (compound_value, array_elements, arguments, etc.)
-  if (original->compound_value)
-  {
-    size_t compound_size = 0;
-    while (original->compound_value[compound_size] != NULL)
-    {
-      compound_size++;
-    }
-
-    copy->compound_value = malloc((compound_size + 1) * sizeof(ast_ *));
-    for (size_t i = 0; i < compound_size; i++)
-    {
-      copy->compound_value[i] = deep_copy(original->compound_value[i]);
-    }
-    copy->compound_value[compound_size] = NULL;
-  }
-
-  if (original->array_elements)
-  {
-    copy->array_elements = malloc((original->array_size + 1) * sizeof(ast_ *));
-    for (int i = 0; i < original->array_size; i++)
-    {
-      copy->array_elements[i] = deep_copy(original->array_elements[i]);
-    }
-    copy->array_elements[original->array_size] = NULL;
-  }
-
-  if (original->arguments)
-  {
-    copy->arguments = malloc((original->arguments_count) * sizeof(ast_ *));
-    for (int i = 0; i < original->arguments_count; i++)
-    {
-      copy->arguments[i] = deep_copy(original->arguments[i]);
-    }
-  }
-
-  if (original->parameters)
-  {
-    copy->parameters = malloc((original->parameter_count) * sizeof(ast_ *));
-    for (int i = 0; i < original->parameter_count; i++)
-    {
-      copy->parameters[i] = deep_copy(original->parameters[i]);
-    }
-  }
-
-  if (original->body)
-  {
-    size_t body_size = 0;
-    while (original->body[body_size] != NULL)
-    {
-      body_size++;
-    }
-
-    copy->body = malloc((body_size + 1) * sizeof(ast_ *));
-    for (size_t i = 0; i < body_size; i++)
-    {
-      copy->body[i] = deep_copy(original->body[i]);
-    }
-    copy->body[body_size] = NULL;
-  }
-
-  if (original->output_expressions)
+  ast_list_ *copy = init_ast_list();
+  for (size_t i = 0; i < original->size; i++)
   {
-    size_t output_size = 0;
-    while (original->output_expressions[output_size] != NULL)
-    {
-      output_size++;
-    }
-
-    copy->output_expressions = malloc((output_size + 1) * sizeof(ast_ *));
-    for (size_t i = 0; i < output_size; i++)
-    {
-      copy->output_expressions[i] = deep_copy(original->output_expressions[i]);
-    }
-    copy->output_expressions[output_size] = NULL;
+    add_ast_to_list(copy, deep_copy(original->items[i]));
   }
 
-  if (original->loop_body)
-  {
-    size_t loop_body_size = 0;
-    while (original->loop_body[loop_body_size] != NULL)
-    {
-      loop_body_size++;
-    }
+  return copy;
+}
 
-    copy->loop_body = malloc((loop_body_size + 1) * sizeof(ast_ *));
-    for (size_t i = 0; i < loop_body_size; i++)
-    {
-      copy->loop_body[i] = deep_copy(original->loop_body[i]);
-    }
-    copy->loop_body[loop_body_size] = NULL;
-  }
+// Duplicates a string owned by a node, keeping NULL as NULL.
+static char *deep_copy_string(const char *original)
+{
+  return original ? strdup(original) : NULL;
+}
 
-  if (original->if_body)
+ast_ *deep_copy(ast_ *original)
+{
+  if (original == NULL)
   {
-    size_t if_body_size = 0;
-    while (original->if_body[if_body_size] != NULL)
-    {
-      if_body_size++;
-    }
-
-    copy->if_body = malloc((if_body_size + 1) * sizeof(ast_ *));
-    for (size_t i = 0; i < if_body_size; i++)
-    {
-      copy->if_body[i] = deep_copy(original->if_body[i]);
-    }
-    copy->if_body[if_body_size] = NULL;
+    return NULL;
   }
 
-  if (original->else_if_conditions)
+  // Allocate memory for the new AST node and copy the header and every value field in one go
+  ast_ *copy = init_ast(original->type);
+  if (copy == NULL)
   {
-    size_t else_if_size = 0;
-    while (original->else_if_conditions[else_if_size] != NULL)
-    {
-      else_if_size++;
-    }
-
-    copy->else_if_conditions = malloc((else_if_size + 1) * sizeof(ast_ *));
-    for (size_t i = 0; i < else_if_size; i++)
-    {
-      copy->else_if_conditions[i] = deep_copy(original->else_if_conditions[i]);
-    }
-    copy->else_if_conditions[else_if_size] = NULL;
+    return NULL;
   }
+  *copy = *original;
+  copy->closure = NULL; // Compiled for the original's fields, not the copies made below
 
-  if (original->else_if_bodies)
+  // Replace the borrowed strings, subtrees and lists of the node's kind with copies of their own
+  switch (original->type)
   {
-    size_t else_if_bodies_size = 0;
-    while (original->else_if_bodies[else_if_bodies_size] != NULL)
-    {
-      else_if_bodies_size++;
-    }
-
-    copy->else_if_bodies = malloc((else_if_bodies_size + 1) * sizeof(ast_ **));
-    for (size_t i = 0; i < else_if_bodies_size; i++)
-    {
-      size_t body_size = 0;
-      while (original->else_if_bodies[i][body_size] != NULL)
-      {
-        body_size++;
-      }
-
-      copy->else_if_bodies[i] = malloc((body_size + 1) * sizeof(ast_ *));
-      for (size_t j = 0; j < body_size; j++)
+  case AST_COMPOUND:
+    copy->compound_value = deep_copy_list(original->compound_value);
+    break;
+  case AST_STRING:
+    copy->string_value = deep_copy_string(original->string_value);
+    break;
+  case AST_ARRAY:
+    copy->array_elements = deep_copy_list(original->array_elements);
+    break;
+  case AST_ASSIGNMENT:
+    copy->lhs = deep_copy(original->lhs);
+    copy->rhs = deep_copy(original->rhs);
+    break;
+  case AST_VARIABLE:
+  case AST_ARRAY_ACCESS:
+  case AST_RECORD_ACCESS:
+    copy->variable_name = original->variable_name; // Names are interned and never freed, so copies share them
+    copy->field_name = deep_copy_string(original->field_name);
+    copy->index = deep_copy_list(original->index);
+    break;
+  case AST_INSTANTIATION:
+    copy->class_name = deep_copy_string(original->class_name);
+    copy->arguments = deep_copy_list(original->arguments);
+    break;
+  case AST_ARITHMETIC_EXPRESSION:
+  case AST_BOOLEAN_EXPRESSION:
+    copy->left = deep_copy(original->left);
+    copy->right = deep_copy(original->right);
+    copy->op = deep_copy_string(original->op);
+    break;
+  case AST_RECORD_DEFINITION:
+  case AST_RECORD:
+    copy->record_name = deep_copy_string(original->record_name);
+    break; // Record elements are shared with the original
+  case AST_SUBROUTINE:
+    copy->subroutine_name = deep_copy_string(original->subroutine_name);
+    copy->parameters = deep_copy_list(original->parameters);
+    copy->body = deep_copy_list(original->body);
+    break;
+  case AST_RETURN:
+    copy->return_value = deep_copy(original->return_value);
+    break;
+  case AST_OUTPUT:
+    copy->output_expressions = deep_copy_list(original->output_expressions);
+    break;
+  case AST_DEFINITE_LOOP:
+  case AST_INDEFINITE_LOOP:
+    copy->loop_variable = deep_copy(original->loop_variable);
+    copy->end_expr = deep_copy(original->end_expr);
+    copy->step_expr = deep_copy(original->step_expr);
+    copy->collection_expr = deep_copy(original->collection_expr);
+    copy->condition = deep_copy(original->condition);
+    copy->loop_body = deep_copy_list(original->loop_body);
+    break;
+  case AST_SELECTION:
+    copy->if_condition = deep_copy(original->if_condition);
+    copy->if_body = deep_copy_list(original->if_body);
+    copy->else_if_conditions = deep_copy_list(original->else_if_conditions);
+    copy->else_body = deep_copy_list(original->else_body);
+    if (original->else_if_bodies && original->else_if_conditions)
+    {
+      copy->else_if_bodies = malloc(original->else_if_conditions->size * sizeof(ast_list_ *));
+      for (size_t i = 0; i < original->else_if_conditions->size; i++)
       {
-        copy->else_if_bodies[i][j] = deep_copy(original->else_if_bodies[i][j]);
+        copy->else_if_bodies[i] = deep_copy_list(original->else_if_bodies[i]);
       }
-      copy->else_if_bodies[i][body_size] = NULL;
     }
-  }
-
-  if (original->else_body)
-  {
-    size_t else_body_size = 0;
-    while (original->else_body[else_body_size] != NULL)
-    {
-      else_body_size++;
-    }
-
-    copy->else_body = malloc((else_body_size + 1) * sizeof(ast_ *));
-    for (size_t i = 0; i < else_body_size; i++)
-    {
-      copy->else_body[i] = deep_copy(original->else_body[i]);
-    }
-    copy->else_body[else_body_size] = NULL;
+    break;
+  default:
+    break; // Integers, reals, characters, booleans and EXIT hold nothing but values
   }
 
   return copy;
@@ -433,7 +352,7 @@ int valid(ast_ *ast)
     break;
 
   case AST_ASSIGNMENT:
-    if (ast->lhs != NULL || ast->rhs != NULL || ast->constant != 0 || ast->userinput != 0)
+    if (ast->lhs != NULL || ast->rhs != NULL)
       return 0;
     break;
 
@@ -523,7 +442,7 @@ void print_ast_literal(ast_ *node, int indent)
     print_indent(indent);
     if (node->int_value.null == 0)
     {
-      printf("Integer: %d\n", node->int_value.value);
+      printf("Integer: %" PRId64 "\n", node->int_value.value);
     }
     else
     {
@@ -583,11 +502,9 @@ void print_ast_literal(ast_ *node, int indent)
       print_indent(indent);
       printf("Array:\n");
 
-      int i = 0;
-      while (node->array_elements[i] != NULL)
+      for (int i = 0; i < node->array_elements->size; i++)
       {
-        print_ast(node->array_elements[i], indent + 1);
-        i++;
+        print_ast(node->array_elements->items[i], indent + 1);
       }
 
       print_indent(indent);
@@ -609,15 +526,13 @@ void print_ast_literal(ast_ *node, int indent)
       printf("Record: %s\n", node->record_name);
       print_indent(indent);
       printf("Record Elements:\n");
-      int d = 0;
-      while (node->record_elements[d] != NULL)
+      for (int d = 0; d < node->record_elements->size; d++)
       {
         print_indent(indent + 1);
-        printf("Field: %s\n", node->record_elements[d]->element_name);
+        printf("Field: %s\n", node->record_elements->elements[d]->element_name);
         print_indent(indent + 2);
         printf("Element:\n");
-        print_ast(node->record_elements[d]->element, indent + 3);
-        d++;
+        print_ast(node->record_elements->elements[d]->element, indent + 3);
       }
       print_indent(indent);
       printf("Number of elements: %d\n", node->field_count);
@@ -648,11 +563,9 @@ void print_ast(ast_ *node, int indent)
   case AST_COMPOUND:
     print_indent(indent);
     printf("Compound:\n");
-    int a = 0;
-    while (node->compound_value[a] != NULL)
+    for (int a = 0; a < node->compound_value->size; a++)
     {
-      print_ast(node->compound_value[a], indent + 1);
-      a++;
+      print_ast(node->compound_value->items[a], indent + 1);
     }
     break;
   case AST_INTEGER:
@@ -717,11 +630,9 @@ void print_ast(ast_ *node, int indent)
       print_indent(indent + 1);
       printf("Array variable: %s\n", node->variable_name);
     }
-    int b = 0;
-    while (node->index[b] != NULL)
+    for (int b = 0; b < node->index->size; b++)
     {
-      print_ast(node->index[b], indent + 1);
-      b++;
+      print_ast(node->index->items[b], indent + 1);
     }
     break;
 
@@ -733,11 +644,9 @@ void print_ast(ast_ *node, int indent)
     }
     print_indent(indent);
     printf("Arguments:\n");
-    int c = 0;
-    while (node->arguments[c] != NULL)
+    for (int c = 0; c < node->arguments->size; c++)
     {
-      print_ast(node->arguments[c], indent + 1);
-      c++;
+      print_ast(node->arguments->items[c], indent + 1);
     }
     print_indent(indent);
     printf("Number of arguments: %d\n", node->arguments_count);
@@ -767,17 +676,15 @@ void print_ast(ast_ *node, int indent)
     }
     print_indent(indent);
     printf("Record Elements:\n");
-    int d = 0;
-    while (node->record_elements[d] != NULL)
+    for (int d = 0; d < node->record_elements->size; d++)
     {
       print_indent(indent + 1);
-      printf("Field: %s\n", node->record_elements[d]->element_name);
+      printf("Field: %s\n", node->record_elements->elements[d]->element_name);
       print_indent(indent + 2);
       printf("Element:\n");
-      print_ast(node->record_elements[d]->element, indent + 3);
+      print_ast(node->record_elements->elements[d]->element, indent + 3);
       print_indent(indent + 2);
-      printf("Dimension: %d\n", node->record_elements[d]->dimension);
-      d++;
+      printf("Dimension: %d\n", node->record_elements->elements[d]->dimension);
     }
     print_indent(indent);
     printf("Number of elements: %d\n", node->field_count);
@@ -790,21 +697,17 @@ void print_ast(ast_ *node, int indent)
     }
     print_indent(indent);
     printf("Parameters:\n");
-    int e = 0;
-    while (node->parameters[e] != NULL)
+    for (int e = 0; e < node->parameters->size; e++)
     {
-      print_ast(node->parameters[e], indent + 1);
-      e++;
+      print_ast(node->parameters->items[e], indent + 1);
     }
     print_indent(indent);
     printf("Number of parameters: %d\n", node->parameter_count);
     print_indent(indent);
     printf("Body:\n");
-    int f = 0;
-    while (node->body[f] != NULL)
+    for (int f = 0; f < node->body->size; f++)
     {
-      print_ast(node->body[f], indent + 1);
-      f++;
+      print_ast(node->body->items[f], indent + 1);
     }
     break;
   case AST_RETURN:
@@ -818,11 +721,9 @@ void print_ast(ast_ *node, int indent)
   case AST_OUTPUT:
     print_indent(indent);
     printf("Output Expressions:\n");
-    int g = 0;
-    while (node->output_expressions[g] != NULL)
+    for (int g = 0; g < node->output_expressions->size; g++)
     {
-      print_ast(node->output_expressions[g], indent + 1);
-      g++;
+      print_ast(node->output_expressions->items[g], indent + 1);
     }
     break;
   case AST_DEFINITE_LOOP:
@@ -853,11 +754,9 @@ void print_ast(ast_ *node, int indent)
       print_ast(node->step_expr, indent + 2);
     }
     printf("Body:\n");
-    int h = 0;
-    while (node->loop_body[h] != NULL)
+    for (int h = 0; h < node->loop_body->size; h++)
     {
-      print_ast(node->loop_body[h], indent + 1);
-      h++;
+      print_ast(node->loop_body->items[h], indent + 1);
     }
     break;
   case AST_INDEFINITE_LOOP:
@@ -871,11 +770,9 @@ void print_ast(ast_ *node, int indent)
     }
     print_indent(indent);
     printf("Loop Body:\n");
-    int i = 0;
-    while (node->loop_body[i] != NULL)
+    for (int i = 0; i < node->loop_body->size; i++)
     {
-      print_ast(node->loop_body[i], indent + 1);
-      i++;
+      print_ast(node->loop_body->items[i], indent + 1);
     }
     break;
   case AST_SELECTION:
@@ -890,35 +787,29 @@ void print_ast(ast_ *node, int indent)
     printf("IF Body:\n");
     if (node->if_body != NULL)
     {
-      int j = 0;
-      while (node->if_body[j] != NULL)
+      for (int j = 0; j < node->if_body->size; j++)
       {
-        print_ast(node->if_body[j], indent + 1);
-        j++;
+        print_ast(node->if_body->items[j], indent + 1);
       }
     }
 
     // Iterate over ELSE IF conditions and bodies together
     if (node->else_if_conditions != NULL && node->else_if_bodies != NULL)
     {
-      int k = 0;
-      while (node->else_if_conditions[k] != NULL && node->else_if_bodies[k] != NULL)
+      for (int k = 0; k < node->else_if_conditions->size; k++)
       {
         // Print the ELSE IF condition
         print_indent(indent);
         printf("ELSE IF Condition[%d]:\n", k);
-        print_ast(node->else_if_conditions[k], indent + 1);
+        print_ast(node->else_if_conditions->items[k], indent + 1);
 
         // Print the ELSE IF body
         print_indent(indent);
         printf("ELSE IF Body[%d]:\n", k);
-        int n = 0;
-        while (node->else_if_bodies[k][n] != NULL)
+        for (int n = 0; n < node->else_if_bodies[k]->size; n++)
         {
-          print_ast(node->else_if_bodies[k][n], indent + 1);
-          n++;
+          print_ast(node->else_if_bodies[k]->items[n], indent + 1);
         }
-        k++;
       }
     }
 
@@ -926,11 +817,9 @@ void print_ast(ast_ *node, int indent)
     printf("ELSE Body:\n");
     if (node->else_body != NULL)
     {
-      int l = 0;
-      while (node->else_body[l] != NULL)
+      for (int l = 0; l < node->else_body->size; l++)
       {
-        print_ast(node->else_body[l], indent + 1);
-        l++;
+        print_ast(node->else_body->items[l], indent + 1);
       }
     }
     break;
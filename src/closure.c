@@ -0,0 +1,310 @@
+#include "include/closure.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// The closure engine is the tree walker with its dispatch done ahead of time. Where the walker switches on a node's
+// type, looks its operator up in a table, and compares a call's name against every built-in each time it runs a
+// node, a closure has already picked the function for the node and its operands and calls it directly.
+
+// Types a variable's value node can have that evaluate to themselves
+#define CLOSURE_LITERAL(type) ((type) == AST_INTEGER || (type) == AST_REAL || (type) == AST_CHARACTER ||     \
+                               (type) == AST_BOOLEAN || (type) == AST_STRING || (type) == AST_ARRAY || \
+                               (type) == AST_RECORD)
+
+#define CLOSURE_INTEGERS(left, right) \
+  ((left).type == AST_INTEGER && (right).type == AST_INTEGER && !((left).null | (right).null))
+
+// Anything not specialised runs the tree walker's handler for the node
+static value_ closure_tree_evaluate(interpreter_ *interpreter, const closure_ *closure)
+{
+  return interpreter_evaluate_node(interpreter, closure->node);
+}
+
+static ast_ *closure_tree_process(interpreter_ *interpreter, const closure_ *closure)
+{
+  return interpreter_process_node(interpreter, closure->node);
+}
+
+// Evaluating a node that has to be processed, such as a call, takes the value of the node it gives
+static value_ closure_process_value(interpreter_ *interpreter, const closure_ *closure)
+{
+  return value_from_ast(closure->process(interpreter, closure));
+}
+
+static value_ closure_constant(interpreter_ *interpreter, const closure_ *closure)
+{
+  return closure->constant;
+}
+
+static ast_ *closure_node(interpreter_ *interpreter, const closure_ *closure)
+{
+  return closure->node;
+}
+
+// Reads the value node in a resolved variable's slot, or NULL when it isn't a literal; the tree walker then reports
+// an unset or failed variable, or evaluates whatever else the slot holds.
+static inline ast_ *closure_slot_value(scope_ *scope, const ast_ *variable)
+{
+  for (int depth = variable->depth; depth > 0; depth--)
+    scope = scope->parent;
+
+  ast_ *vdef = scope->slots[variable->slot];
+  if (vdef == NULL || vdef->rhs == NULL || !CLOSURE_LITERAL(vdef->rhs->type))
+    return NULL;
+  return vdef->rhs;
+}
+
+static value_ closure_variable(interpreter_ *interpreter, const closure_ *closure)
+{
+  ast_ *value = closure_slot_value(interpreter->scope, closure->node);
+  if (value == NULL)
+    return interpreter_evaluate_node(interpreter, closure->node);
+  if (value->type == AST_INTEGER)
+    return (value_){.type = AST_INTEGER, .null = value->int_value.null, .int_value = value->int_value.value};
+  return value_from_ast(value);
+}
+
+static ast_ *closure_process_variable(interpreter_ *interpreter, const closure_ *closure)
+{
+  ast_ *value = closure_slot_value(interpreter->scope, closure->node);
+  return value != NULL ? value : interpreter_process_node(interpreter, closure->node);
+}
+
+// Operators whose integer form runs inline, each in three versions: one evaluating both operands, one for a right
+// operand that is an integer literal, and one for operands the inference pass proved are integers, which checks
+// nothing else. The inline form only runs while `defined` holds; other operand types, and a zero divisor, get the
+// tree walker's rules.
+#define CLOSURE_OPERATOR(name, result_type, field, defined, expression)                                            \
+  static value_ closure_##name(interpreter_ *interpreter, const closure_ *closure)                                 \
+  {                                                                                                                \
+    value_ left = closure->left->evaluate(interpreter, closure->left);                                             \
+    value_ right = closure->right->evaluate(interpreter, closure->right);                                          \
+    if (CLOSURE_INTEGERS(left, right))                                                                             \
+    {                                                                                                              \
+      int64_t a = left.int_value, b = right.int_value;                                                             \
+      if (defined)                                                                                                 \
+        return (value_){.type = result_type, .field = (expression)};                                               \
+    }                                                                                                              \
+    return interpreter_apply_operation(closure->node, left, right);                                                \
+  }                                                                                                                \
+                                                                                                                   \
+  static value_ closure_##name##_constant(interpreter_ *interpreter, const closure_ *closure)                      \
+  {                                                                                                                \
+    value_ left = closure->left->evaluate(interpreter, closure->left);                                             \
+    if (left.type == AST_INTEGER && !left.null)                                                                    \
+    {                                                                                                              \
+      int64_t a = left.int_value, b = closure->constant.int_value;                                                 \
+      if (defined)                                                                                                 \
+        return (value_){.type = result_type, .field = (expression)};                                               \
+    }                                                                                                              \
+    return interpreter_apply_operation(closure->node, left, closure->constant);                                    \
+  }                                                                                                                \
+                                                                                                                   \
+  static value_ closure_##name##_proven(interpreter_ *interpreter, const closure_ *closure)                        \
+  {                                                                                                                \
+    value_ left = closure->left->evaluate(interpreter, closure->left);                                             \
+    value_ right = closure->right->evaluate(interpreter, closure->right);                                          \
+    int64_t a = left.int_value, b = right.int_value;                                                               \
+    if (defined)                                                                                                   \
+      return (value_){.type = result_type, .field = (expression)};                                                 \
+    return interpreter_apply_operation(closure->node, left, right);                                                \
+  }
+
+// The same expressions as the tree walker's integer operations and comparisons
+CLOSURE_OPERATOR(add, AST_INTEGER, int_value, 1, INTEGER_ADD(a, b))
+CLOSURE_OPERATOR(subtract, AST_INTEGER, int_value, 1, INTEGER_SUBTRACT(a, b))
+CLOSURE_OPERATOR(multiply, AST_INTEGER, int_value, 1, INTEGER_MULTIPLY(a, b))
+CLOSURE_OPERATOR(divide, AST_INTEGER, int_value, b != 0, divide_integer(a, b))
+CLOSURE_OPERATOR(modulo, AST_INTEGER, int_value, b != 0, modulo_Euclidean(a, b))
+CLOSURE_OPERATOR(power, AST_INTEGER, int_value, 1, power_integer(a, b))
+CLOSURE_OPERATOR(less, AST_BOOLEAN, boolean_value, 1, a < b)
+CLOSURE_OPERATOR(less_equal, AST_BOOLEAN, boolean_value, 1, a <= b)
+CLOSURE_OPERATOR(greater, AST_BOOLEAN, boolean_value, 1, a > b)
+CLOSURE_OPERATOR(greater_equal, AST_BOOLEAN, boolean_value, 1, a >= b)
+CLOSURE_OPERATOR(equal, AST_BOOLEAN, boolean_value, 1, a == b)
+CLOSURE_OPERATOR(not_equal, AST_BOOLEAN, boolean_value, 1, a != b)
+
+static const struct
+{
+  closure_evaluator_ operands;
+  closure_evaluator_ constant;
+  closure_evaluator_ proven;
+} closure_operators[] = {
+    [OP_ADD] = {closure_add, closure_add_constant, closure_add_proven},
+    [OP_SUBTRACT] = {closure_subtract, closure_subtract_constant, closure_subtract_proven},
+    [OP_MULTIPLY] = {closure_multiply, closure_multiply_constant, closure_multiply_proven},
+    [OP_DIVIDE] = {closure_divide, closure_divide_constant, closure_divide_proven},
+    [OP_INT_DIVIDE] = {closure_divide, closure_divide_constant, closure_divide_proven},
+    [OP_MODULO] = {closure_modulo, closure_modulo_constant, closure_modulo_proven},
+    [OP_POWER] = {closure_power, closure_power_constant, closure_power_proven},
+    [OP_LESS] = {closure_less, closure_less_constant, closure_less_proven},
+    [OP_LESS_EQUAL] = {closure_less_equal, closure_less_equal_constant, closure_less_equal_proven},
+    [OP_GREATER] = {closure_greater, closure_greater_constant, closure_greater_proven},
+    [OP_GREATER_EQUAL] = {closure_greater_equal, closure_greater_equal_constant, closure_greater_equal_proven},
+    [OP_EQUAL] = {closure_equal, closure_equal_constant, closure_equal_proven},
+    [OP_NOT_EQUAL] = {closure_not_equal, closure_not_equal_constant, closure_not_equal_proven},
+};
+
+// Logical operators, unary minus and NOT go straight to the tree walker's dispatch table
+static value_ closure_operate(interpreter_ *interpreter, const closure_ *closure)
+{
+  value_ left = value_error();
+  if (closure->left != NULL)
+    left = closure->left->evaluate(interpreter, closure->left);
+  value_ right = closure->right->evaluate(interpreter, closure->right);
+  return interpreter_apply_operation(closure->node, left, right);
+}
+
+static ast_ *closure_process_operation(interpreter_ *interpreter, const closure_ *closure)
+{
+  return value_to_ast(closure->evaluate(interpreter, closure));
+}
+
+static ast_ *closure_builtin(interpreter_ *interpreter, const closure_ *closure)
+{
+  return closure->builtin(interpreter, closure->node);
+}
+
+static ast_ *closure_instantiate(interpreter_ *interpreter, const closure_ *closure)
+{
+  return interpreter_instantiate_definition(interpreter, closure->node);
+}
+
+static ast_ *closure_assignment(interpreter_ *interpreter, const closure_ *closure)
+{
+  return interpreter_store_assignment(interpreter, closure->node, closure->right->process(interpreter, closure->right));
+}
+
+// Assigns a resolved variable that already holds a value by updating its definition in place, as the scope would
+// once the tree walker had made a new one for it. Unset variables and constants take the tree walker's path.
+static ast_ *closure_assign_variable(interpreter_ *interpreter, const closure_ *closure)
+{
+  ast_ *node = closure->node;
+  ast_ *value = closure->right->process(interpreter, closure->right);
+
+  scope_ *scope = interpreter->scope;
+  for (int depth = node->lhs->depth; depth > 0; depth--)
+    scope = scope->parent;
+
+  ast_ *existing = scope->slots[node->lhs->slot];
+  if (existing == NULL || existing->lhs->constant == 1)
+    return interpreter_store_assignment(interpreter, node, value);
+
+  existing->lhs = node->lhs;
+  existing->rhs = value;
+  return existing;
+}
+
+closure_ *closure_compile(ast_ *node)
+{
+  if (node->closure != NULL)
+    return node->closure;
+
+  closure_ *closure = calloc(1, sizeof(struct CLOSURE_STRUCT));
+  if (!closure)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for a closure.\n");
+    exit(EXIT_FAILURE);
+  }
+  closure->node = node;
+  closure->evaluate = closure_tree_evaluate;
+  closure->process = closure_tree_process;
+
+  switch (node->type)
+  {
+  case AST_INTEGER:
+  case AST_REAL:
+  case AST_CHARACTER:
+  case AST_BOOLEAN:
+  case AST_STRING:
+  case AST_ARRAY:
+  case AST_RECORD:
+    closure->constant = value_from_ast(node);
+    closure->evaluate = closure_constant;
+    closure->process = closure_node;
+    break;
+
+  case AST_VARIABLE:
+    if (node->depth >= 0)
+    {
+      closure->evaluate = closure_variable;
+      closure->process = closure_process_variable;
+    }
+    break;
+
+  case AST_ARITHMETIC_EXPRESSION:
+  case AST_BOOLEAN_EXPRESSION:
+    closure->right = closure_compile(node->right);
+    closure->process = closure_process_operation;
+    closure->evaluate = closure_operate;
+    if (node->left != NULL)
+    {
+      closure->left = closure_compile(node->left);
+      if (node->operator > OP_NONE && node->operator < (int)(sizeof(closure_operators) / sizeof(closure_operators[0])) &&
+          closure_operators[node->operator].operands != NULL)
+      {
+        if (node->right->type == AST_INTEGER && !node->right->int_value.null)
+        {
+          closure->constant = value_from_ast(node->right);
+          closure->evaluate = closure_operators[node->operator].constant;
+        }
+        else if (node->left->proven == AST_INTEGER && node->right->proven == AST_INTEGER)
+        {
+          closure->evaluate = closure_operators[node->operator].proven;
+        }
+        else
+        {
+          closure->evaluate = closure_operators[node->operator].operands;
+        }
+      }
+    }
+    break;
+
+  case AST_INSTANTIATION:
+    closure->builtin = interpreter_find_builtin(node->class_name);
+    closure->process = closure->builtin != NULL ? closure_builtin : closure_instantiate;
+    closure->evaluate = closure_process_value;
+    break;
+
+  case AST_ASSIGNMENT:
+    closure->right = closure_compile(node->rhs);
+    closure->process = closure_assignment;
+    if (node->lhs->type == AST_VARIABLE && node->lhs->depth >= 0 && node->lhs->userinput != 1 &&
+        node->rhs->type != AST_ARRAY)
+      closure->process = closure_assign_variable;
+    break;
+
+  default:
+    break;
+  }
+
+  node->closure = closure;
+  return closure;
+}
+
+// Values made while running (a variable's value, a bound argument) are literals, which run without a closure of
+// their own so that only the program's nodes are ever compiled
+value_ closure_evaluate(interpreter_ *interpreter, ast_ *node)
+{
+  if (node->closure == NULL && CLOSURE_LITERAL(node->type))
+    return value_from_ast(node);
+
+  closure_ *closure = closure_compile(node);
+  return closure->evaluate(interpreter, closure);
+}
+
+ast_ *closure_process(interpreter_ *interpreter, ast_ *node)
+{
+  if (node->closure == NULL && CLOSURE_LITERAL(node->type))
+    return node;
+
+  closure_ *closure = closure_compile(node);
+  return closure->process(interpreter, closure);
+}
+
+void closure_run(interpreter_ *interpreter, ast_ *root)
+{
+  interpreter->closures = 1;
+  interpreter_process(interpreter, root);
+  interpreter->closures = 0;
+}
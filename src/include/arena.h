@@ -0,0 +1,37 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Size of an arena's first block; each block after it is twice the size of the one before
+#ifndef ARENA_BLOCK_SIZE
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#endif
+
+// One contiguous, zero-filled chunk of an arena
+typedef struct ARENA_BLOCK_STRUCT
+{
+  struct ARENA_BLOCK_STRUCT *next; // Block allocated before this one
+  size_t size;                     // Bytes available in `data`
+  size_t used;                     // Bytes handed out so far
+  _Alignas(16) char data[];        // Aligned so every allocation can hold any structure
+} arena_block_;
+
+// Bump allocator: allocations are never freed individually, only all at once with free_arena
+typedef struct ARENA_STRUCT
+{
+  arena_block_ *blocks; // Newest block first; allocations come from its unused tail
+  size_t block_size;    // Size of the next block to allocate
+} arena_;
+
+arena_ *init_arena(size_t block_size);
+
+void *arena_alloc(arena_ *arena, size_t size);
+
+char *arena_strndup(arena_ *arena, const char *text, size_t length);
+
+char *arena_strdup(arena_ *arena, const char *text);
+
+void free_arena(arena_ *arena);
+
+#endif
@@ -2,6 +2,9 @@
 #define AST_H
 
 #include <stdlib.h>
+#include <stdint.h>
+#include "arena.h"
+#include "token.h"
 
 // Enum representing the different types of AST nodes.
 enum ast_type
@@ -44,15 +47,28 @@ typedef struct AST_RECORD_DEFINITION_ELEMENT_STRUCT
     int dimension;           // Dimension of the element (e.g., [] or [[]])
 } ast_record_element_;
 
+// Growable list of AST nodes that stores its length, so appending is amortized O(1) and nothing scans for a terminator.
+typedef struct AST_LIST_STRUCT
+{
+    union
+    {
+        struct AST_STRUCT **items;      // Nodes in order
+        ast_record_element_ **elements; // Fields in order (for record_elements lists)
+    };
+    size_t size;     // Number of entries in the list
+    size_t capacity; // Number of entries there is room for before growing
+    arena_ *arena;   // Arena the list lives in, or NULL if it is on the heap
+} ast_list_;
+
 typedef struct
 {
-    int value;
+    int64_t value;
     int null; // Default value is 1
 } NullableInt;
 
 typedef struct
 {
-    float value;
+    double value;
     int null; // Default value is 1
 } NullableFloat;
 
@@ -69,96 +85,139 @@ typedef struct
 } NullableBool;
 
 // Structure representing an Abstract Syntax Tree (AST) node.
+// A small header (the type) is followed by a union holding only the fields of the node's kind,
+// so a literal costs a few dozen bytes instead of carrying every kind's fields. Only read the fields
+// that belong to `type`; the others share the same memory.
 typedef struct AST_STRUCT
 {
-    enum ast_type type;         // Type of AST node
-    struct SCOPE_STRUCT *scope; // Scope the AST node belongs to
-
-    /* AST_COMPOUND */
-    struct AST_STRUCT **compound_value; // List of statements (if this node is a compound statement)
-
-    /* AST_LITERAL */
-    NullableInt int_value;      // Integer value (if this node is an integer literal)
-    NullableFloat real_value;   // Real value (if this node is a floating-point literal)
-    NullableChar char_value;    // Character value (if this node is a character literal)
-    NullableBool boolean_value; // Boolean value (if this node is a boolean literal)
-
-    char *string_value; // String value (if this node is a string literal)
-
-    struct AST_STRUCT **array_elements; // List of elements (if this node is an array literal)
-    int array_size;                     // Number of elements (if this node is an array literal
-    int array_dimension; // Number of nested arrays
-    enum ast_type array_type; // AST literal type of array
-
-    /* AST_ASSIGNMENT */
-    struct AST_STRUCT *lhs; // Left-hand side value to assign (variable or record access)
-    struct AST_STRUCT *rhs; // Right-hand side value to assign (expression being assigned)
-    int constant;           // Whether the assignment is a constant
-    int userinput;          // Whether the assignment is a user input
-
-    /* AST_VARIABLE */
-    char *variable_name; // Name of the variable (if this node is a variable reference)
-
-    /* AST_RECORD_DEFINITION_ACCESS */
-    char *field_name; // The field being accessed (e.g., "passed")
-
-    /* AST_ARRAY_ACCESS */
-    struct AST_STRUCT **index; // List of indices (for multidimensional array access)
-
-    /* AST_INSTANTIATION */
-    char *class_name;              // Name of the class
-    struct AST_STRUCT **arguments; // List of arguments (for function calls/instantiations)
-    int arguments_count;           // Number of arguments
-
-    /* AST_EXPRESSION */
-    struct AST_STRUCT *left;  // Left operand (if this node is a binary operation)
-    struct AST_STRUCT *right; // Right operand (if this node is a binary operation)
-    char *op;                 // Operator as a string (e.g., "+", "-", "*", "DIV", "MOD")
-
-    /* AST_RECORD_DEFINITION */
-    char *record_name;                     // Name of the record (e.g., "Student")
-    ast_record_element_ **record_elements; // List of element declarations (e.g., fields like "name", "age")
-    int field_count;                       // Number of fields in the record
-
-    /* AST_SUBROUTINE */
-    char *subroutine_name;          // Name of the subroutine
-    struct AST_STRUCT **parameters; // List of parameters (AST_VARIABLE nodes)
-    int parameter_count;            // Number of parameters in the subroutine
-    struct AST_STRUCT **body;       // Body of the subroutine (List of AST nodes)
-
-    /* AST_RETURN */
-    struct AST_STRUCT *return_value; // Return value (if any) of the subroutine
-
-    /* AST_OUTPUT */
-    struct AST_STRUCT **output_expressions; // List of expressions to be output
-
-    /* AST_DEFINITE_LOOP */
-    struct AST_STRUCT *end_expr;        // End expression (if FOR <var> <- start TO end [STEP step])
-    struct AST_STRUCT *step_expr;       // Step expression (if any)
-    struct AST_STRUCT *loop_variable;   // Assignment AST with var <- start or var <- collection[0]
-    struct AST_STRUCT *collection_expr; // Collection to iterate over (if FOR <var> IN collection)
-
-    /* AST_INDEFINITE_LOOP */
-    struct AST_STRUCT *condition;  // Condition to evaluate for the loop (e.g., "a < 4")
-    int indefinite_loop_type;
-    struct AST_STRUCT **loop_body; // Body of the loop (list of statements)
-
-    /* AST_SELECTION */
-    struct AST_STRUCT *if_condition;        // Condition for IF block
-    struct AST_STRUCT **if_body;            // List of AST nodes representing the IF body
-    struct AST_STRUCT **else_if_conditions; // List of conditions for ELSE IF blocks
-    struct AST_STRUCT ***else_if_bodies;    // List of AST node lists representing ELSE IF bodies
-    struct AST_STRUCT **else_body;          // List of AST nodes representing the ELSE body
-
-    int exit_code; // Exit code for EXIT statements
+    enum ast_type type; // Type of AST node; selects the member of the union below
+    enum ast_type proven; // Type the inference pass proved the node's value has, never null (AST_COMPOUND if unproven)
+    struct CLOSURE_STRUCT *closure; // Evaluator the closure engine compiled for the node, reused by every later run
+
+    union
+    {
+        /* AST_ARITHMETIC_EXPRESSION, AST_BOOLEAN_EXPRESSION */
+        struct
+        {
+            struct AST_STRUCT *left;     // Left operand (if this node is a binary operation)
+            struct AST_STRUCT *right;    // Right operand (if this node is a binary operation)
+            char *op;                    // Operator as a string (e.g., "+", "-", "*", "DIV", "MOD"), kept for messages
+            enum operator_type operator; // Operator the evaluator dispatches on
+            int calls;                   // Whether an operand makes a call (set by the resolver)
+        };
+
+        /* AST_INTEGER, AST_REAL, AST_CHARACTER, AST_BOOLEAN, AST_STRING */
+        union
+        {
+            NullableInt int_value;      // Integer value (if this node is an integer literal)
+            NullableFloat real_value;   // Real value (if this node is a floating-point literal)
+            NullableChar char_value;    // Character value (if this node is a character literal)
+            NullableBool boolean_value; // Boolean value (if this node is a boolean literal)
+            char *string_value;         // String value (if this node is a string literal)
+        };
+
+        /* AST_ASSIGNMENT */
+        struct
+        {
+            struct AST_STRUCT *lhs; // Left-hand side value to assign (variable or record access)
+            struct AST_STRUCT *rhs; // Right-hand side value to assign (expression being assigned)
+        };
+
+        /* AST_VARIABLE, AST_ARRAY_ACCESS, AST_RECORD_ACCESS */
+        struct
+        {
+            char *variable_name; // Name of the variable, array or record being referenced
+            ast_list_ *index;    // List of indices (for multidimensional array access)
+            char *field_name;    // The field being accessed (e.g., "passed")
+            int constant;        // Whether the variable is a constant
+            int userinput;       // Whether the variable is assigned from user input
+            int depth;           // Scopes out from the current one that hold the variable, or -1 to look it up by name
+            int slot;            // Slot of the variable in that scope (if depth is not -1)
+        };
+
+        /* AST_COMPOUND */
+        ast_list_ *compound_value; // List of statements (if this node is a compound statement)
+
+        /* AST_ARRAY */
+        struct
+        {
+            ast_list_ *array_elements; // List of elements (if this node is an array literal)
+            int array_size;            // Number of elements (if this node is an array literal)
+            int array_dimension;       // Number of nested arrays
+            enum ast_type array_type;  // AST literal type of array
+        };
+
+        /* AST_INSTANTIATION */
+        struct
+        {
+            char *class_name;     // Name of the class
+            ast_list_ *arguments; // List of arguments (for function calls/instantiations)
+            int arguments_count;  // Number of arguments
+        };
+
+        /* AST_RECORD_DEFINITION, AST_RECORD */
+        struct
+        {
+            char *record_name;          // Name of the record (e.g., "Student")
+            ast_list_ *record_elements; // List of element declarations (e.g., fields like "name", "age")
+            int field_count;            // Number of fields in the record
+        };
+
+        /* AST_SUBROUTINE */
+        struct
+        {
+            char *subroutine_name; // Name of the subroutine
+            ast_list_ *parameters; // List of parameters (AST_VARIABLE nodes)
+            int parameter_count;   // Number of parameters in the subroutine
+            ast_list_ *body;       // Body of the subroutine (List of AST nodes)
+            struct SCOPE_LAYOUT_STRUCT *frame_layout; // Names each call's frame declares, parameters first
+        };
+
+        /* AST_RETURN */
+        struct AST_STRUCT *return_value; // Return value (if any) of the subroutine
+
+        /* AST_OUTPUT */
+        ast_list_ *output_expressions; // List of expressions to be output
+
+        /* AST_DEFINITE_LOOP, AST_INDEFINITE_LOOP */
+        struct
+        {
+            struct AST_STRUCT *loop_variable;   // Assignment AST with var <- start or var <- collection[0]
+            struct AST_STRUCT *end_expr;        // End expression (if FOR <var> <- start TO end [STEP step])
+            struct AST_STRUCT *step_expr;       // Step expression (if any)
+            struct AST_STRUCT *collection_expr; // Collection to iterate over (if FOR <var> IN collection)
+            struct AST_STRUCT *condition;       // Condition to evaluate for the loop (e.g., "a < 4")
+            int indefinite_loop_type;           // 0 for REPEAT, 1 for WHILE
+            ast_list_ *loop_body;               // Body of the loop (list of statements)
+            struct SCOPE_LAYOUT_STRUCT *layout; // Names the loop's scope declares up front (NULL if it wasn't resolved)
+        };
+
+        /* AST_SELECTION */
+        struct
+        {
+            struct AST_STRUCT *if_condition; // Condition for IF block
+            ast_list_ *if_body;              // List of AST nodes representing the IF body
+            ast_list_ *else_if_conditions;   // List of conditions for ELSE IF blocks
+            ast_list_ **else_if_bodies;      // One body per ELSE IF condition, in the same order
+            ast_list_ *else_body;            // List of AST nodes representing the ELSE body
+        };
+
+        /* AST_EXIT */
+        int exit_code; // Exit code for EXIT statements
+    };
 } ast_;
 
+// Function to select the arena that backs new AST nodes and lists (NULL for the heap).
+arena_ *ast_use_arena(arena_ *arena);
+
 // Function to initialize an AST node of a given type.
 ast_ *init_ast(enum ast_type type);
 
-ast_ **init_ast_list();
+ast_list_ *init_ast_list();
+
+void add_ast_to_list(ast_list_ *list, ast_ *new_ast);
 
-void add_ast_to_list(ast_ ***list, ast_ *new_ast);
+void add_record_element_to_list(ast_list_ *list, ast_record_element_ *element);
 
 ast_ *deep_copy(ast_ *original);
 
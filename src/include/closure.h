@@ -0,0 +1,38 @@
+#ifndef CLOSURE_H
+#define CLOSURE_H
+#include "interpreter.h"
+
+struct CLOSURE_STRUCT;
+
+// A closure runs the node it was compiled from; evaluating gives its value, processing the node the tree walker's
+// interpreter_process would give
+typedef value_ (*closure_evaluator_)(interpreter_ *interpreter, const struct CLOSURE_STRUCT *closure);
+typedef ast_ *(*closure_processor_)(interpreter_ *interpreter, const struct CLOSURE_STRUCT *closure);
+
+// A node compiled once into functions specialised to what is known of it before it runs: the operator and whether
+// the right operand is an integer constant, the scope a variable's slot is in, the built-in a call names. It is
+// cached on the node, so every pass of a loop and every call of a subroutine reuses it.
+typedef struct CLOSURE_STRUCT
+{
+  closure_evaluator_ evaluate;
+  closure_processor_ process;
+  ast_ *node;
+  struct CLOSURE_STRUCT *left;  // Operands of an operator, or the value of an assignment (right)
+  struct CLOSURE_STRUCT *right;
+  value_ constant;              // A literal's value, or an operator's constant right operand
+  interpreter_builtin_ builtin; // Built-in method an instantiation calls
+} closure_;
+
+// Returns the node's closure, compiling it on first use
+closure_ *closure_compile(ast_ *node);
+
+// interpreter_evaluate and interpreter_process for the closure engine, which the tree walker hands nodes to while
+// interpreter->closures is set. Statements and the rarer expressions run the tree walker's own handlers, whose
+// operands come back through here.
+value_ closure_evaluate(interpreter_ *interpreter, ast_ *node);
+ast_ *closure_process(interpreter_ *interpreter, ast_ *node);
+
+// Runs a program like interpreter_process, with every node it reaches compiled to a closure
+void closure_run(interpreter_ *interpreter, ast_ *root);
+
+#endif
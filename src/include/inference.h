@@ -0,0 +1,40 @@
+#ifndef INFERENCE_H
+#define INFERENCE_H
+#include "ast.h"
+#include "scope.h"
+
+// A block of the program whose variables the pass follows: the global scope, a subroutine's frame or a loop's scope,
+// as the resolver laid them out
+typedef struct INFERENCE_BLOCK_STRUCT
+{
+  struct INFERENCE_BLOCK_STRUCT *parent;
+  scope_layout_ *layout; // Names the block declares in slot order (NULL for the global scope, which is searched instead)
+  size_t first;          // Index of the block's first slot in the pass's state
+  size_t size;           // Number of slots the block declares
+} inference_block_;
+
+typedef struct INFERENCE_STRUCT
+{
+  scope_ *global_scope;
+  inference_block_ *block;  // Innermost block being inferred
+  enum ast_type *types;     // What each slot of every enclosing block is known to hold, innermost block last
+  size_t size;              // Slots in use in `types`
+  size_t capacity;
+  int reachable;            // Whether the statement being inferred can run at all
+  unsigned char *clobbered; // Global slots some subroutine may assign, which any call may change
+  size_t globals;           // Number of global slots the pass follows
+  int subroutine;           // Whether a subroutine body is being inferred, so the globals it assigns are clobbered
+  int clobbering;           // Whether a global was found to be clobbered since the subroutines were last inferred
+  ast_list_ *mismatches;    // Operations found applied to operands of types they reject, reported once inferred
+} inference_;
+
+inference_ *init_inference(scope_ *global_scope);
+
+// Infers a resolved program's types ahead of running it. Every arithmetic and boolean expression whose operands are
+// proven to be of types its operator accepts has `proven` set to the type of its result, so the evaluator can skip
+// its checks; one whose operands are proven to be of types the operator rejects is reported as a warning.
+void inference_infer(inference_ *inference, ast_ *root);
+
+void free_inference(inference_ *inference);
+
+#endif
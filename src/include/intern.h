@@ -0,0 +1,20 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Number of slots the intern table starts with; it doubles whenever it is half full
+#ifndef INTERN_INITIAL_CAPACITY
+#define INTERN_INITIAL_CAPACITY 256
+#endif
+
+// Interned names are unique: two names are equal exactly when their pointers are, so they can be compared and
+// hashed by address. They live until the program exits and must not be modified.
+char *intern_name(const char *name);
+
+char *intern_name_n(const char *name, size_t length);
+
+uint32_t intern_hash(const char *name, size_t length);
+
+#endif
@@ -1,16 +1,84 @@
 #ifndef INTERPRETER_H
 #define INTERPRETER_H
 #include "ast.h"
+#include "value.h"
+#include "scope.h"
+
+// Number of evaluated arguments a call keeps inline before it has to allocate room for them
+#ifndef INTERPRETER_INLINE_ARGUMENTS
+#define INTERPRETER_INLINE_ARGUMENTS 8
+#endif
+
+// Deepest nesting of subroutine calls a program may reach, unless --max-depth says otherwise
+#ifndef INTERPRETER_MAX_CALL_DEPTH
+#define INTERPRETER_MAX_CALL_DEPTH 100000
+#endif
+
+// C stack kept free below the deepest call the tree walker makes, for the builtins and error reporting it may still run
+#ifndef INTERPRETER_STACK_RESERVE
+#define INTERPRETER_STACK_RESERVE (256 * 1024)
+#endif
+
+// A subroutine call in progress. A chain of tail calls runs in the same record, one subroutine after another.
+typedef struct INTERPRETER_CALL_STRUCT
+{
+  struct INTERPRETER_CALL_STRUCT *caller; // Call this one runs inside, NULL for one made from the main program
+  ast_ *definition;                       // Subroutine whose body is running
+  value_ *arguments;                      // Arguments for the next body to run, evaluated before its frame is bound
+  int argument_capacity;
+  value_ inline_arguments[INTERPRETER_INLINE_ARGUMENTS];
+  ast_ *tail_call; // Call a `RETURN f(...)` made in tail position, run next in place of a nested call
+  ast_ *result;
+} interpreter_call_;
 
 typedef struct INTERPRETER_STRUCT
 {
-  // Add any interpreter-specific fields here, like symbol tables, etc.
+  scope_ *scope;             // Environment names are looked up in; loops and calls swap it while they run
+  scope_ *global_scope;      // Parent of every subroutine call's frame
+  interpreter_call_ *call;   // Innermost subroutine call running, NULL in the main program
+  int returning;             // Set by RETURN; statement lists stop running until the call has unwound to its frame
+  int call_depth;            // Subroutine calls running; tail calls don't count
+  int closures;              // Whether nodes run through the closures the closure engine caches on them
+  int max_call_depth;        // Deepest call allowed before the program is stopped with an error
+  char *stack_base;          // Where the tree walker's C stack started, and how far it may grow from there
+  size_t stack_limit;
 } interpreter_;
 
-interpreter_ *init_interpreter();
+// A built-in method, run on the instantiation that calls it
+typedef ast_ *(*interpreter_builtin_)(interpreter_ *interpreter, ast_ *node);
+
+interpreter_ *init_interpreter(scope_ *scope);
 
 ast_ *interpreter_process(interpreter_ *interpreter, ast_ *node);
 
+value_ interpreter_evaluate(interpreter_ *interpreter, ast_ *node);
+
+// The tree walker's own dispatch on a node's type, which the closure engine falls back on
+ast_ *interpreter_process_node(interpreter_ *interpreter, ast_ *node);
+value_ interpreter_evaluate_node(interpreter_ *interpreter, ast_ *node);
+
+// Integer +, - and * wrap around on overflow, as they are worked out unsigned, where overflow is defined
+#define INTEGER_ADD(a, b) ((int64_t)((uint64_t)(a) + (uint64_t)(b)))
+#define INTEGER_SUBTRACT(a, b) ((int64_t)((uint64_t)(a) - (uint64_t)(b)))
+#define INTEGER_MULTIPLY(a, b) ((int64_t)((uint64_t)(a) * (uint64_t)(b)))
+
+// Pieces of the tree walker shared with the other engines
+int64_t divide_integer(int64_t a, int64_t b);
+int64_t modulo_Euclidean(int64_t a, int64_t b);
+int64_t power_integer(int64_t base, int64_t exponent);
+value_ interpreter_apply_operation(ast_ *node, value_ left_val, value_ right_val);
+enum ast_type interpreter_operation_type(ast_ *node, enum ast_type left, enum ast_type right);
+ast_ *interpreter_store_assignment(interpreter_ *interpreter, ast_ *node, ast_ *rhs_value);
+void interpreter_output_value(value_ value, interpreter_ *interpreter);
+ast_ *interpreter_called_subroutine(interpreter_ *interpreter, ast_ *node);
+void interpreter_bind_arguments(scope_ *frame, ast_ *definition, value_ *arguments);
+void interpreter_call_depth_error(interpreter_ *interpreter, ast_ *definition);
+ast_ *interpreter_array_variable(ast_ *array, ast_ *node);
+ast_ **interpreter_array_element(ast_ *current_array, value_ index_value);
+ast_ **interpreter_record_field(ast_ *record, ast_ *node);
+interpreter_builtin_ interpreter_find_builtin(const char *name);
+ast_ *interpreter_instantiate_definition(interpreter_ *interpreter, ast_ *node);
+
 // Methods for processing each AST type
 ast_ *interpreter_process_compound(interpreter_ *interpreter, ast_ *node);
 ast_ *interpreter_process_assignment(interpreter_ *interpreter, ast_ *node);
@@ -18,14 +86,14 @@ ast_ *interpreter_process_variable(interpreter_ *interpreter, ast_ *node);
 ast_ **interpreter_process_record_access(interpreter_ *interpreter, ast_ *node);
 ast_ **interpreter_process_array_access(interpreter_ *interpreter, ast_ *node);
 ast_ *interpreter_process_instantiation(interpreter_ *interpreter, ast_ *node);
-ast_ *interpreter_process_arithmetic_expression(interpreter_ *interpreter, ast_ *node);
-ast_ *interpreter_process_boolean_expression(interpreter_ *interpreter, ast_ *node);
+value_ interpreter_evaluate_operation(interpreter_ *interpreter, ast_ *node);
 ast_ *interpreter_process_record_definition(interpreter_ *interpreter, ast_ *node);
 ast_ *interpreter_process_subroutine(interpreter_ *interpreter, ast_ *node);
 ast_ *interpreter_process_output(interpreter_ *interpreter, ast_ *node);
 ast_ *interpreter_process_definite_loop(interpreter_ *interpreter, ast_ *node);
 ast_ *interpreter_process_indefinite_loop(interpreter_ *interpreter, ast_ *node);
 ast_ *interpreter_process_selection(interpreter_ *interpreter, ast_ *node);
+ast_ *interpreter_process_return(interpreter_ *interpreter, ast_ *node);
 ast_ *interpreter_process_exit(interpreter_ *interpreter, ast_ *node);
 
 #endif
@@ -0,0 +1,96 @@
+#ifndef JIT_H
+#define JIT_H
+#include "vm.h"
+#include <stdio.h>
+
+// The JIT emits x86-64 machine code, and needs Linux's mmap and the VM's threaded dispatch
+#if defined(__x86_64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#define JIT_AVAILABLE 1
+#else
+#define JIT_AVAILABLE 0
+#endif
+
+// Times a loop's back edge is taken, and a subroutine called, before the JIT compiles it
+#ifndef JIT_HOT_LOOP
+#define JIT_HOT_LOOP 64
+#endif
+
+#ifndef JIT_HOT_CALL
+#define JIT_HOT_CALL 16
+#endif
+
+// Compiled subroutines call each other on the C stack, so they nest at most this deep before handing the call back
+#ifndef JIT_MAX_NATIVE_DEPTH
+#define JIT_MAX_NATIVE_DEPTH 4096
+#endif
+
+#define JIT_MAX_REGISTERS 64 // Registers a compiled subroutine's frame may have, to bound the C stack it takes
+#define JIT_MAX_BAILS 16     // Failed entries after which compiled code is no longer used
+
+// A compiled loop runs from its first instruction with the frame's registers, returning the instruction the VM
+// continues at, or -1 without having done anything if the registers don't hold the types it was compiled for.
+typedef int (*jit_loop_code_)(value_ *registers, int64_t budget);
+
+// A compiled subroutine takes Integer arguments and stores its result, returning 0 if it couldn't finish (a call
+// too deep, a division by zero, a body ending without RETURN): it has no side effects, so the VM runs it instead.
+typedef int (*jit_subroutine_code_)(const int64_t *arguments, int64_t budget, int64_t *result);
+
+// A loop or subroutine the JIT was asked to compile, with what it has done since
+typedef struct JIT_REGION_STRUCT
+{
+  vm_function_ *function;
+  ast_ *node;        // Loop compiled, or the subroutine's definition
+  int first, last;   // Instructions of the function it covers
+  int subroutine;    // Whether it is a whole subroutine rather than a loop
+  const char *reason; // Why it wasn't compiled, NULL if it was
+  void *code;        // Executable pages holding the machine code
+  size_t code_size;  // Bytes of machine code
+  size_t mapped_size;
+  long entries;  // Times the VM ran it (a loop entered, a subroutine called)
+  long failures; // Entries given back to the VM (a loop's guards failing, a subroutine bailing out)
+} jit_region_;
+
+// What the JIT has counted and compiled for one of the VM's functions
+typedef struct JIT_FUNCTION_STRUCT
+{
+  int *passes;                    // Times each back edge has been taken
+  jit_region_ **loops;            // Compiled loop entered at each instruction, if any
+  jit_region_ *region;            // The whole function compiled as a subroutine, if it has been tried
+  jit_subroutine_code_ native;    // Its entry, NULL until it compiles and once it keeps bailing out
+  enum ast_type returns;          // Type of its result
+  int calls;                      // Calls the VM has made to it
+  int compiling;                  // Whether it is being compiled, for the subroutines it calls
+} jit_function_;
+
+typedef struct JIT_STRUCT
+{
+  vm_ *vm;
+  jit_function_ **functions; // One for each of the VM's functions
+  jit_region_ **regions;     // Every loop and subroutine tried, in order
+  int region_count;
+  int region_capacity;
+} jit_;
+
+// Starts watching a compiled program's loops and calls, or returns NULL (with a warning) where there is no JIT
+jit_ *init_jit(vm_ *vm);
+
+// Compiles the loop from instruction `first` to its back edge at `last`, taking the types of the values in
+// `registers` as those it is entered with. Returns NULL if it uses something other than integers and booleans.
+jit_region_ *jit_compile_loop(jit_ *jit, vm_function_ *function, int first, int last, const value_ *registers);
+
+// Compiles a subroutine that takes integers and computes with integers and booleans only; NULL if it can't be.
+jit_region_ *jit_compile_subroutine(jit_ *jit, vm_function_ *function);
+
+// Runs a compiled loop, returning the instruction to continue at, or -1 if the VM should run it instead
+int jit_run_loop(jit_ *jit, jit_region_ *region, value_ *registers);
+
+// Calls a compiled subroutine with the `count` arguments from `arguments`, storing its result. Returns 0, having
+// done nothing, if the arguments aren't all integers or the compiled code bails out.
+int jit_call(jit_ *jit, vm_function_ *function, const value_ *arguments, int count, value_ *result);
+
+// Prints what was compiled and how often it ran
+void jit_report(jit_ *jit, FILE *stream);
+
+void free_jit(jit_ *jit);
+
+#endif
@@ -1,34 +1,79 @@
 #ifndef LEXER_H
 #define LEXER_H
 #include "token.h"
+#include "scan.h"
+#include <stdint.h>
+
+// Bytes read per refill by a streaming lexer
+#ifndef LEXER_CHUNK_SIZE
+#define LEXER_CHUNK_SIZE (64 * 1024)
+#endif
 
 typedef struct LEXER_STRUCT
 {
   char *contents;
+  unsigned int length; // Length of contents, cached so progressing never rescans the buffer
   unsigned int index;
   char c;
   int line;
   int column;
+  const scan_kernels_ *scan; // Bulk scanning kernels chosen for this CPU
+
+  /* Streaming input: contents is a window onto the input rather than the whole program */
+  int fd;                   // Descriptor chunks are read from, or -1 when contents holds the whole program
+  int eof;                  // Whether fd has been read to the end
+  unsigned int capacity;    // Allocated size of the window
+  unsigned int base;        // Offset of contents[0] within the whole input
+  unsigned int token_start; // Offset of the token being collected; the window keeps it on refill
+  unsigned int pinned;      // Offset of the oldest token the token stream still holds
+
+  /* Parallel lexing: a shard may start inside a string, so its errors are only reported once confirmed */
+  int speculative; // Whether errors should be recorded in `failed` instead of reported
+  int failed;      // Whether a speculative lex hit an error
 
 } lexer_;
 
 lexer_ *init_lexer(char *contents);
 
+lexer_ *init_lexer_stream(int fd);
+
+int lexer_refill(lexer_ *lexer);
+
+void lexer_ensure(lexer_ *lexer, unsigned int count);
+
+unsigned int lexer_offset(lexer_ *lexer);
+
+const char *lexer_text(lexer_ *lexer, unsigned int offset);
+
 void lexer_progress(lexer_ *lexer);
 
-token_ *lexer_skip(lexer_ *lexer);
+void lexer_advance(lexer_ *lexer, unsigned int count);
+
+void lexer_scan(lexer_ *lexer, size_t (*kernel)(const char *text, size_t index, size_t length));
+
+void lexer_skip(lexer_ *lexer);
+
+token_ lexer_next(lexer_ *lexer);
+
+token_stream_ *lexer_tokenize(lexer_ *lexer);
+
+void lexer_tokenize_range(lexer_ *lexer, unsigned int end, token_stream_ *stream);
+
+token_stream_ *lexer_tokenize_parallel(lexer_ *lexer, int threads);
+
+int lexer_fill_stream(token_stream_ *stream);
 
-token_ *lexer_next(lexer_ *lexer);
+token_stream_ *lexer_stream_tokens(lexer_ *lexer);
 
-token_ *lexer_peek(lexer_ *lexer);
+token_ lexer_collect_string(lexer_ *lexer);
 
-token_ *lexer_collect_string(lexer_ *lexer);
+token_ lexer_collect_alphanum(lexer_ *lexer);
 
-token_ *lexer_collect_alphanum(lexer_ *lexer);
+token_ lexer_collect_number(lexer_ *lexer);
 
-token_ *lexer_collect_number(lexer_ *lexer);
+double lexer_decode_real(const char *text, unsigned int length, uint64_t mantissa, int decimal_exponent, int overflow);
 
-token_ *lexer_collect_token(lexer_ *lexer, token_ *token);
+token_ lexer_collect_token(lexer_ *lexer, enum token_type type);
 
-char *lexer_get_char_as_string(lexer_ *lexer);
+token_ lexer_collect_operator(lexer_ *lexer, enum token_type type, enum operator_type op);
 #endif
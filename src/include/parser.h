@@ -4,28 +4,28 @@
 #include "lexer.h"
 #include "ast.h"
 #include "scope.h"
+#include "arena.h"
 
 typedef struct PARSER_STRUCT
 {
-  lexer_ *lexer;
+  token_stream_ *tokens;
+  unsigned int position; // Number of the current token within the stream
   token_ *current_token;
-  token_ *prev_token;
   scope_ *scope;
+  arena_ *arena; // Backs every node, list and name the parser produces
 } parser_;
 
-typedef ast_ *(*handler_function)(parser_ *parser, scope_ *scope);
+// Function prototypes
+parser_ *init_parser(token_stream_ *tokens, scope_ *scope);
 
-typedef struct
-{
-  const char *keyword;
-  handler_function handler;
-} keyword_map_entry;
+void free_parser(parser_ *parser);
 
-// Function prototypes
-parser_ *init_parser(lexer_ *lexer, scope_ *scope);
+token_ *parser_peek(parser_ *parser, unsigned int distance);
 
 void parser_expect(parser_ *parser, enum token_type expected_type);
 
+void parser_expect_keyword(parser_ *parser, enum keyword_type expected_keyword);
+
 ast_ *parser_parse(parser_ *parser, scope_ *scope);
 
 ast_ *parser_parse_statement(parser_ *parser, scope_ *scope);
@@ -35,8 +35,8 @@ ast_ *parser_parse_statements(parser_ *parser, scope_ *scope);
 ast_ *parser_parse_id(parser_ *parser, scope_ *scope);
 
 // Additional function prototypes
-ast_ **init_ast_list(void);
-void add_ast_to_list(ast_ ***list, ast_ *new_ast);
+ast_list_ *init_ast_list(void);
+void add_ast_to_list(ast_list_ *list, ast_ *new_ast);
 
 ast_ *parse_expression(parser_ *parser, scope_ *scope);
 
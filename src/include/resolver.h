@@ -0,0 +1,27 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+#include "ast.h"
+#include "scope.h"
+
+// A part of the program that gets a scope of its own at runtime: the global scope, a loop's or a subroutine's frame
+typedef struct RESOLVER_BLOCK_STRUCT
+{
+  struct RESOLVER_BLOCK_STRUCT *parent;
+  scope_ *scope;         // The global scope itself, or a stand-in holding the names a loop's scope or a frame will declare
+  scope_layout_ *layout; // The stand-in's names in slot order (NULL for the global scope, which is declared into directly)
+  ast_list_ *constants;  // Variables declared CONSTANT in this block
+} resolver_block_;
+
+typedef struct RESOLVER_STRUCT
+{
+  resolver_block_ *block;   // Block being resolved
+  resolver_block_ *global;  // Outermost block, kept so the REPL resolves each line after the last
+  ast_list_ *subroutines;   // Subroutines whose bodies are still to be resolved
+  int checked;              // Whether undefined variables and constant overwrites are reported (not in code after an EXIT)
+} resolver_;
+
+resolver_ *init_resolver(scope_ *global_scope);
+
+void resolver_resolve(resolver_ *resolver, ast_ *root);
+
+#endif
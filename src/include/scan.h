@@ -0,0 +1,25 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+// Scanning kernels used by the lexer to skip runs of characters in bulk.
+// Each kernel starts at `index` and returns the index of the first character that ends the run,
+// or `length` if the run reaches the end of the buffer. None of the runs ever contain a newline.
+typedef struct SCAN_KERNELS_STRUCT
+{
+  const char *name;
+  size_t (*blanks)(const char *text, size_t index, size_t length);     // Spaces and tabs
+  size_t (*line_end)(const char *text, size_t index, size_t length);   // Everything up to the next '\n'
+  size_t (*identifier)(const char *text, size_t index, size_t length); // [A-Za-z0-9_]
+} scan_kernels_;
+
+const scan_kernels_ *scan_scalar_kernels();
+
+const scan_kernels_ *scan_sse2_kernels();
+
+const scan_kernels_ *scan_avx2_kernels();
+
+const scan_kernels_ *scan_select_kernels();
+
+#endif
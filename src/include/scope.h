@@ -2,24 +2,63 @@
 #define SCOPE_H
 #include "ast.h"
 
+// Number of variable slots a scope starts with; the map doubles whenever it is half full
+#ifndef SCOPE_INITIAL_CAPACITY
+#define SCOPE_INITIAL_CAPACITY 16
+#endif
+
+// One entry of a scope's variable map
+typedef struct SCOPE_VARIABLE_STRUCT
+{
+  const char *name; // Interned variable name, or NULL for an empty entry
+  size_t slot;      // Index of the variable's definition in the scope's slots
+} scope_variable_;
+
 typedef struct SCOPE_STRUCT
 {
-  ast_ **instantiation_definitions;
-  ast_ **variable_definitions;
+  struct SCOPE_STRUCT *parent; // Enclosing scope, searched when a name isn't defined here (next free scope once freed)
+  ast_list_ *instantiation_definitions;
+  scope_variable_ *variables; // Open-addressing hash map from the address of an interned name to its slot
+  size_t variable_capacity;   // Map entries allocated; always a power of two
+  ast_ **slots;               // Assignment holding each variable (lhs) and its value (rhs); NULL while declared but unset
+  size_t variable_count;      // Variables declared, which is also the number of slots and map entries in use
+  size_t slot_capacity;       // Slots allocated
   const char *scope_name;
 
 } scope_;
 
-scope_ *init_scope(scope_ *parent_scope, const char *scope_name);
-void set_scope(ast_ *node, scope_ *scope);
+// Names a resolved block declares, in slot order. A scope created for the block declares them before anything
+// runs, so resolved references can index its slots directly.
+typedef struct SCOPE_LAYOUT_STRUCT
+{
+  const char **names;
+  size_t size;
+  size_t capacity;
+} scope_layout_;
 
-scope_ *get_scope(ast_ *node);
+scope_ *init_scope(scope_ *parent_scope, const char *scope_name);
+void free_scope(scope_ *scope);
+void scope_reset(scope_ *scope);
 
 ast_ *scope_add_instantiation_definition(scope_ *scope, ast_ *idef);
 
 ast_ *scope_get_instantiation_definition(scope_ *scope, const char *iname);
 
+ast_ *scope_find_instantiation_definition(scope_ *scope, const char *iname);
+
 ast_ *scope_add_variable_definition(scope_ *scope, ast_ *vdef);
 
 ast_ *scope_get_variable_definition(scope_ *scope, const char *vname);
+
+size_t scope_declare_variable(scope_ *scope, const char *name);
+
+long scope_find_slot(scope_ *scope, const char *name);
+
+void scope_declare_layout(scope_ *scope, scope_layout_ *layout);
+
+ast_ *scope_assign_variable(scope_ *scope, ast_ *vdef);
+
+ast_ *scope_read_variable(scope_ *scope, ast_ *variable);
+
+void scope_read_userinput(ast_ *vdef);
 #endif
\ No newline at end of file
@@ -0,0 +1,10 @@
+#ifndef STACK_INTERPRETER_H
+#define STACK_INTERPRETER_H
+#include "interpreter.h"
+
+// Runs a program like interpreter_process, but keeps statements, operators and subroutine calls on heap-allocated
+// work and value stacks instead of the C stack, so recursion is only limited by the interpreter's max_call_depth.
+// Leaf expressions (array and record access, built-in methods, record instantiation) still go through the tree walker.
+void stack_interpreter_run(interpreter_ *interpreter, ast_ *root);
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <stdint.h>
+
 enum token_type
 {
   TOKEN_ID = 1 << 0,         // 1 : identifier
@@ -24,16 +26,118 @@ enum token_type
   TOKEN_COLON = 1 << 18,     // 524288 : :
   TOKEN_FULLSTOP = 1 << 19,  // 1048576 : .
   TOKEN_PIPE = 1 << 20,      // 2097152 : |
-  TOKEN_EOF = 1 << 21        // 4194304 : ^D
+  TOKEN_EOF = 1 << 21,       // 4194304 : ^D
+  TOKEN_KEYWORD = 1 << 22    // 8388608 : CONSTANT | FOR | IF | ... (see keyword_type)
+};
+
+// Reserved words, classified once by the lexer. Tokens that are not keywords carry KEYWORD_NONE.
+enum keyword_type
+{
+  KEYWORD_NONE = 0,
+  KEYWORD_CONSTANT,
+  KEYWORD_REPEAT,
+  KEYWORD_UNTIL,
+  KEYWORD_WHILE,
+  KEYWORD_ENDWHILE,
+  KEYWORD_FOR,
+  KEYWORD_TO,
+  KEYWORD_STEP,
+  KEYWORD_IN,
+  KEYWORD_ENDFOR,
+  KEYWORD_IF,
+  KEYWORD_THEN,
+  KEYWORD_ELSE,
+  KEYWORD_ENDIF,
+  KEYWORD_RECORD,
+  KEYWORD_ENDRECORD,
+  KEYWORD_SUBROUTINE,
+  KEYWORD_ENDSUBROUTINE,
+  KEYWORD_RETURN,
+  KEYWORD_OUTPUT,
+  KEYWORD_EXIT,
+  KEYWORD_USERINPUT,
+  KEYWORD_STRING,  // String  (record field type, lexed as TOKEN_ID)
+  KEYWORD_INTEGER, // Integer (record field type, lexed as TOKEN_ID)
+  KEYWORD_REAL,    // Real    (record field type, lexed as TOKEN_ID)
+  KEYWORD_BOOLEAN, // Boolean (record field type, lexed as TOKEN_ID)
+  KEYWORD_CHAR,    // Char    (record field type, lexed as TOKEN_ID)
+  KEYWORD_TRUE,    // True  (lexed as TOKEN_BOOL)
+  KEYWORD_FALSE,   // False (lexed as TOKEN_BOOL)
+  KEYWORD_DIV,     // DIV (lexed as TOKEN_ARITH_OP)
+  KEYWORD_MOD,     // MOD (lexed as TOKEN_ARITH_OP)
+  KEYWORD_AND,     // AND (lexed as TOKEN_BOOL_OP)
+  KEYWORD_OR,      // OR  (lexed as TOKEN_BOOL_OP)
+  KEYWORD_NOT      // NOT (lexed as TOKEN_BOOL_OP)
 };
 
+// The specific operator behind a TOKEN_ARITH_OP, TOKEN_REL_OP or TOKEN_BOOL_OP token.
+enum operator_type
+{
+  OP_NONE = 0,
+  OP_ADD,           // +
+  OP_SUBTRACT,      // -
+  OP_MULTIPLY,      // *
+  OP_DIVIDE,        // /
+  OP_POWER,         // ^
+  OP_INT_DIVIDE,    // DIV
+  OP_MODULO,        // MOD
+  OP_LESS,          // <
+  OP_GREATER,       // >
+  OP_EQUAL,         // =
+  OP_NOT_EQUAL,     // !=
+  OP_LESS_EQUAL,    // <=
+  OP_GREATER_EQUAL, // >=
+  OP_AND,           // AND
+  OP_OR,            // OR
+  OP_NOT            // NOT
+};
+
+// A token is a view into the lexer's source buffer; its text is only copied out when needed.
 typedef struct TOKEN_STRUCT
 {
   enum token_type type;
-  char *value;
+  unsigned int offset; // Offset of the token's first character within the whole input
+  unsigned int length; // Number of characters in the token's text
+  int line;            // Line the token starts on
+  int column;          // Column the token starts on
+  enum keyword_type keyword; // Which reserved word the token is, if any
+  enum operator_type op;     // Which operator the token is, if any
+  union
+  {
+    int64_t int_value; // Decoded value of a TOKEN_INT
+    double real_value; // Decoded value of a TOKEN_REAL
+  };
 } token_;
 
+// A contiguous array of tokens. lexer_tokenize fills it with the whole program at once; a streaming
+// lexer instead fills it on demand through `fill`, dropping tokens the reader has released.
+typedef struct TOKEN_STREAM_STRUCT
+{
+  token_ *tokens;
+  unsigned int count;
+  unsigned int capacity;
+  const char *source;     // Buffer the tokens' views point into
+  unsigned int base;      // Offset of source[0] within the whole input (non-zero once a stream has moved on)
+  unsigned int discarded; // Number of tokens dropped from the front; tokens[0] is token number `discarded`
+  unsigned int released;  // Tokens numbered below this are no longer needed by the reader
+  int (*fill)(struct TOKEN_STREAM_STRUCT *stream); // Appends more tokens, returning 0 once the input is exhausted
+  void *producer;                                  // Passed back to `fill` (the streaming lexer)
+} token_stream_;
+
 const char *token_type_to_string(enum token_type types);
-token_ *init_token(enum token_type type, char *value);
+const char *keyword_type_to_string(enum keyword_type keyword);
+token_ init_token(enum token_type type, unsigned int offset, unsigned int length, int line, int column);
+
+const char *token_stream_text(token_stream_ *stream, token_ *token);
+
+char *token_copy_value(token_stream_ *stream, token_ *token);
+
+token_stream_ *init_token_stream(const char *source, unsigned int capacity);
+
+void free_token_stream(token_stream_ *stream);
+
+void token_stream_push(token_stream_ *stream, token_ token);
+
+token_ *token_stream_at(token_stream_ *stream, unsigned int number);
 
 #endif
@@ -0,0 +1,11 @@
+#ifndef TRANSPILER_H
+#define TRANSPILER_H
+#include "interpreter.h"
+#include <stdio.h>
+
+// Writes a resolved program to `stream` as a standalone C program that does what the interpreter would, built with
+// the values and rules of runtime/p3_runtime.h. `source` names the program in the output's header comment. Returns
+// 0, having written nothing, after reporting why if the program uses something the translation doesn't cover.
+int transpiler_emit(interpreter_ *interpreter, ast_ *root, const char *source, FILE *stream);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef VALUE_H
+#define VALUE_H
+#include "ast.h"
+
+// Result of evaluating an expression, passed around by value so intermediate results allocate nothing.
+// Integers, reals, characters and booleans are held inline; every other type is boxed in the AST node it came from.
+typedef struct VALUE_STRUCT
+{
+  enum ast_type type; // Type of the value, using the AST literal types
+  int null;           // Whether an inline value is unset, mirroring the Nullable* flags of literal nodes
+  union
+  {
+    int64_t int_value;       // AST_INTEGER
+    double real_value;       // AST_REAL
+    char char_value;         // AST_CHARACTER
+    int boolean_value;       // AST_BOOLEAN
+    struct AST_STRUCT *node; // Any other type; NULL when evaluation failed
+  };
+} value_;
+
+_Static_assert(sizeof(value_) == 16, "value_ should fit in two registers");
+
+// Whether values of this type are held inline rather than boxed in a node
+#define VALUE_INLINE(type) ((type) == AST_INTEGER || (type) == AST_REAL || (type) == AST_CHARACTER || (type) == AST_BOOLEAN)
+
+// Only booleans carry a truth value; any other value reads as false
+#define VALUE_TRUTH(value) ((value).type == AST_BOOLEAN && (value).boolean_value)
+
+value_ value_integer(int64_t int_value);
+
+value_ value_real(double real_value);
+
+value_ value_boolean(int boolean_value);
+
+value_ value_error();
+
+int value_is_error(value_ value);
+
+value_ value_from_ast(ast_ *node);
+
+ast_ *value_to_ast(value_ value);
+
+#endif
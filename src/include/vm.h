@@ -0,0 +1,150 @@
+#ifndef VM_H
+#define VM_H
+#include "interpreter.h"
+
+// Frames and registers the VM starts with; both double whenever a call needs more
+#ifndef VM_INITIAL_FRAMES
+#define VM_INITIAL_FRAMES 64
+#endif
+
+#ifndef VM_INITIAL_REGISTERS
+#define VM_INITIAL_REGISTERS 1024
+#endif
+
+// Every instruction the VM runs, with the operands it reads: `a`, `b`, `c` and `d` are registers unless noted.
+// A register operand with VM_CONSTANT set names one of the function's constants until compiling has finished.
+#define VM_OPCODES(X)                                                                                               \
+  X(MOVE)          /* a <- b                                                                                  */ \
+  X(NEW_ARRAY)     /* a <- a copy of the array literal in b, as assigning one makes                           */ \
+  X(GET_GLOBAL)    /* a <- global b, from a subroutine                                                        */ \
+  X(SET_GLOBAL)    /* global a <- b                                                                           */ \
+  X(CLEAR)         /* unset the b registers from a, which a loop's scope declares                             */ \
+  X(ADD)           /* a <- b op c, with integer operands handled inline and the rest by the tree walker's rules */ \
+  X(SUBTRACT)                                                                                                       \
+  X(MULTIPLY)                                                                                                       \
+  X(DIVIDE)                                                                                                         \
+  X(MODULO)                                                                                                         \
+  X(POWER)                                                                                                          \
+  X(LESS)                                                                                                           \
+  X(LESS_EQUAL)                                                                                                     \
+  X(GREATER)                                                                                                        \
+  X(GREATER_EQUAL)                                                                                                  \
+  X(EQUAL)                                                                                                          \
+  X(NOT_EQUAL)                                                                                                      \
+  X(OPERATE)       /* a <- node's operator applied to b and c (c alone for a unary one)                       */ \
+  X(JUMP)          /* continue at instruction a                                                               */ \
+  X(TEST)          /* continue at a if b is False; at d if it isn't a boolean                                 */ \
+  X(BRANCH_LESS)   /* continue at a unless b op c; at d if the comparison fails                               */ \
+  X(BRANCH_LESS_EQUAL)                                                                                              \
+  X(BRANCH_GREATER)                                                                                                 \
+  X(BRANCH_GREATER_EQUAL)                                                                                           \
+  X(BRANCH_EQUAL)                                                                                                   \
+  X(BRANCH_NOT_EQUAL)                                                                                               \
+  X(CHECK_INTEGER) /* continue at a unless b is an integer, reporting which of a FOR loop's bounds (c) it is  */ \
+  X(FOR_TEST)      /* continue at a once counter b has passed end c, counting in steps of d                   */ \
+  X(FOR_LOOP)      /* add step d to counter b and continue at a unless it has passed end c                    */ \
+  X(FOR_IN_START)  /* continue at a unless b is a string or array; c and c + 1 get the position and length    */ \
+  X(FOR_IN_NEXT)   /* d <- the next item of b, at position c, or continue at a when there are none left       */ \
+  X(CHECK_ARGUMENT) /* continue at call a if argument b failed, so the call fails before its next one         */ \
+  X(CALL)          /* a <- subroutine d called with the c arguments from b                                    */ \
+  X(TAIL_CALL)     /* call subroutine d with the c arguments from b in place of the running one               */ \
+  X(RETURN)        /* return b to the caller                                                                  */ \
+  X(RETURN_NONE)   /* return from a body that ended without RETURN                                           */ \
+  X(INSTANTIATE)   /* a <- node run by the tree walker with the c evaluated arguments from b                  */ \
+  X(INDEX)         /* a <- element of array b at the d indices from c                                         */ \
+  X(STORE_INDEX)   /* element of array b at the d indices from c <- a                                         */ \
+  X(FIELD)         /* a <- node's field of record b                                                           */ \
+  X(STORE_FIELD)   /* node's field of record b <- a                                                           */ \
+  X(OUTPUT)        /* print b followed by a space (c = 0) or a newline (c = 1); just the newline when b < 0  */ \
+  X(INPUT)         /* a <- a line read from the user, prompted for with node's variable                      */ \
+  X(DEFINE)        /* run node's RECORD or SUBROUTINE definition; b is the subroutine's function, or -1       */ \
+  X(UNCAUGHT)      /* report node as a statement that can't run here                                          */ \
+  X(EXIT)          /* run node's EXIT                                                                         */ \
+  X(HALT)          /* end of the main program                                                                 */
+
+#define VM_OPCODE_ENUM(name) VM_##name,
+typedef enum
+{
+  VM_OPCODES(VM_OPCODE_ENUM)
+  VM_OPCODE_COUNT
+} vm_opcode_;
+#undef VM_OPCODE_ENUM
+
+// Marks a register operand naming a constant, which lives after the function's other registers
+#define VM_CONSTANT (1 << 30)
+
+// Flags on an instruction. When an operand is a variable's register, reading it follows the tree walker's rules for
+// a variable that is unset, holds no value or holds a failed expression, and reports them against the scope the
+// instruction runs in.
+#define VM_READ_B 1   // Operand b is a variable
+#define VM_READ_C 2   // Operand c is a variable
+#define VM_IN_LOOP 4  // The instruction runs in a loop's scope (for error messages)
+#define VM_MESSAGE(flags) ((flags) >> 3) // Which statement a failed condition is reported for
+#define VM_WITH_MESSAGE(message) ((message) << 3)
+
+typedef struct VM_INSTRUCTION_STRUCT
+{
+  const void *handler; // Label the instruction's opcode runs at, once the program has been threaded
+  unsigned char opcode;
+  unsigned char flags;
+  int a, b, c, d;
+  ast_ *node; // Node the instruction was compiled from, for the tree walker's rules and error messages
+} vm_instruction_;
+
+// The main program or a subroutine compiled to bytecode. Its frame holds the variables of its own block first,
+// then those of the loops in it and its temporaries, then its constants.
+typedef struct VM_FUNCTION_STRUCT
+{
+  ast_ *definition; // Subroutine compiled, NULL for the main program
+  const char *scope_name;
+  vm_instruction_ *code;
+  int code_size;
+  int code_capacity;
+  value_ *constants;
+  int constant_count;
+  int constant_capacity;
+  int variable_count; // Registers of the function's own block, unset whenever a call starts
+  int register_count; // Registers before the constants
+  int frame_size;     // Registers a call takes, constants included
+  int defined;        // Whether the subroutine's definition has run, so it can be called
+  struct JIT_FUNCTION_STRUCT *jit; // What the JIT has counted and compiled for it, NULL unless the JIT is on
+} vm_function_;
+
+// A call running in the VM, kept on a heap stack so recursion doesn't use the C stack
+typedef struct VM_FRAME_STRUCT
+{
+  vm_function_ *function;
+  const vm_instruction_ *resume; // Caller's next instruction
+  size_t base;                   // Caller's first register
+  int result;                    // Caller's register the call's result goes in
+} vm_frame_;
+
+typedef struct VM_STRUCT
+{
+  interpreter_ *interpreter; // Call depth limit, and the global scope definitions are registered in
+  vm_function_ **functions;  // The main program, then every subroutine it defines
+  int function_count;
+  value_ *registers;
+  size_t register_capacity;
+  vm_frame_ *frames;
+  int frame_capacity;
+  value_ *arguments; // A tail call's arguments, on their way from the old body's registers to the new one's
+  int argument_capacity;
+  ast_ *characters[256]; // One-character strings FOR-IN loops over strings give, shared as none is changed in place
+  struct JIT_STRUCT *jit; // Compiles hot loops and subroutines to machine code, NULL unless it is turned on
+} vm_;
+
+// Value of a variable's register before anything is assigned to it
+extern ast_ vm_unset;
+
+// Compiles a resolved program to register bytecode, or returns NULL if it uses something only the tree walker runs
+// (subroutines or records defined inside a loop or a subroutine, or two subroutines with the same name).
+vm_ *vm_compile(interpreter_ *interpreter, ast_ *root);
+
+// Runs a compiled program. The output is the tree walker's, apart from what a program could only see through the
+// walker sharing nodes between variables: assigning a FOR loop's counter copies it rather than following it.
+void vm_run(vm_ *vm);
+
+void free_vm(vm_ *vm);
+
+#endif
@@ -0,0 +1,624 @@
+#include "include/inference.h"
+#include "include/interpreter.h"
+#include <stdio.h>
+#include <string.h>
+
+// The inference pass runs a resolved program abstractly before it runs for real. Each variable slot holds what is
+// known of its value rather than the value: AST_NOOP while it is unset (reading it stops the program, so nothing
+// flows on from there), a literal type once it is proven to hold a non-null value of that type, or AST_COMPOUND when
+// it may hold anything. An expression that may fail as it runs, which leaves the variable it is assigned to undefined,
+// is never proven. Selections join what their branches leave, loops are inferred until a pass of their body adds
+// nothing to what is known at their head, and RETURN and EXIT end the path they are on.
+
+#define INFERENCE_UNSET AST_NOOP
+#define INFERENCE_UNKNOWN AST_COMPOUND
+
+// Passes over a loop's body after which slots that are still changing are given up on
+#ifndef INFERENCE_LOOP_PASSES
+#define INFERENCE_LOOP_PASSES 3
+#endif
+
+// What is known of every slot at one point of the program, saved to restore or join with another path
+typedef struct INFERENCE_STATE_STRUCT
+{
+  enum ast_type *types;
+  size_t size;
+  int reachable;
+} inference_state_;
+
+inference_ *init_inference(scope_ *global_scope)
+{
+  inference_ *inference = calloc(1, sizeof(struct INFERENCE_STRUCT));
+  if (!inference)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for type inference.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  inference->global_scope = global_scope;
+  inference->mismatches = init_ast_list();
+  return inference;
+}
+
+void free_inference(inference_ *inference)
+{
+  free(inference->types);
+  free(inference->clobbered);
+  free(inference);
+}
+
+// What a slot holds after a point two paths meet at
+static enum ast_type inference_join_type(enum ast_type a, enum ast_type b)
+{
+  if (a == b || b == INFERENCE_UNSET)
+    return a;
+  if (a == INFERENCE_UNSET)
+    return b;
+  return INFERENCE_UNKNOWN;
+}
+
+static const char *inference_type_name(enum ast_type type)
+{
+  switch (type)
+  {
+  case AST_INTEGER:
+    return "Integer";
+  case AST_REAL:
+    return "Real";
+  case AST_CHARACTER:
+    return "Character";
+  case AST_STRING:
+    return "String";
+  case AST_BOOLEAN:
+    return "Boolean";
+  default:
+    return "unknown";
+  }
+}
+
+// Starts inferring a block nested in the current one, whose `size` slots are all unset.
+static void inference_enter_block(inference_ *inference, inference_block_ *block, scope_layout_ *layout, size_t size)
+{
+  if (inference->size + size > inference->capacity)
+  {
+    inference->capacity = (inference->size + size) * 2;
+    inference->types = realloc(inference->types, inference->capacity * sizeof(enum ast_type));
+    if (!inference->types)
+    {
+      fprintf(stderr, "Error: Memory allocation failed for type inference.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  block->parent = inference->block;
+  block->layout = layout;
+  block->first = inference->size;
+  block->size = size;
+  for (size_t i = 0; i < size; i++)
+    inference->types[block->first + i] = INFERENCE_UNSET;
+
+  inference->size += size;
+  inference->block = block;
+}
+
+static void inference_leave_block(inference_ *inference, inference_block_ *block)
+{
+  inference->size = block->first;
+  inference->block = block->parent;
+}
+
+static inference_state_ inference_save(inference_ *inference)
+{
+  inference_state_ state = {malloc((inference->size + 1) * sizeof(enum ast_type)), inference->size, inference->reachable};
+  if (!state.types)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for type inference.\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(state.types, inference->types, inference->size * sizeof(enum ast_type));
+  return state;
+}
+
+static void inference_restore(inference_ *inference, const inference_state_ *state)
+{
+  memcpy(inference->types, state->types, state->size * sizeof(enum ast_type));
+  inference->size = state->size;
+  inference->reachable = state->reachable;
+}
+
+// Joins the current state into one saved at the same block, for the point the paths meet at.
+static void inference_join_into(inference_ *inference, inference_state_ *state)
+{
+  if (!inference->reachable)
+    return;
+
+  if (!state->reachable)
+  {
+    memcpy(state->types, inference->types, state->size * sizeof(enum ast_type));
+    state->reachable = 1;
+    return;
+  }
+
+  for (size_t i = 0; i < state->size; i++)
+    state->types[i] = inference_join_type(state->types[i], inference->types[i]);
+}
+
+// Sets what a slot holds. A global set in a subroutine body is one any call may change.
+static void inference_set(inference_ *inference, size_t index, enum ast_type type)
+{
+  inference->types[index] = type;
+  if (inference->subroutine && index < inference->globals && !inference->clobbered[index])
+  {
+    inference->clobbered[index] = 1;
+    inference->clobbering = 1;
+  }
+}
+
+// Index in the state of a resolved variable's slot, or -1 if it is looked up by name or the pass doesn't follow it
+static long inference_slot(inference_ *inference, ast_ *variable)
+{
+  if (variable->depth < 0)
+    return -1;
+
+  inference_block_ *block = inference->block;
+  for (int depth = variable->depth; depth > 0 && block != NULL; depth--)
+    block = block->parent;
+
+  if (block == NULL || variable->slot < 0 || (size_t)variable->slot >= block->size)
+    return -1;
+  return (long)(block->first + variable->slot);
+}
+
+// Index in the state of the slot `block` declares for `name`, or -1 if it doesn't declare it
+static long inference_find(inference_ *inference, inference_block_ *block, const char *name)
+{
+  if (block->parent == NULL)
+  {
+    long slot = scope_find_slot(inference->global_scope, name);
+    return slot >= 0 && (size_t)slot < block->size ? slot : -1;
+  }
+
+  for (size_t i = 0; block->layout != NULL && i < block->layout->size; i++)
+  {
+    if (strcmp(block->layout->names[i], name) == 0)
+      return (long)(block->first + i);
+  }
+  return -1;
+}
+
+// Assigns a variable; one only found by name at runtime may be any slot of that name in sight.
+static void inference_assign(inference_ *inference, ast_ *variable, enum ast_type type)
+{
+  long index = inference_slot(inference, variable);
+  if (index >= 0)
+  {
+    inference_set(inference, index, type);
+    return;
+  }
+
+  for (inference_block_ *block = inference->block; variable->depth < 0 && block != NULL; block = block->parent)
+  {
+    index = inference_find(inference, block, variable->variable_name);
+    if (index >= 0)
+      inference_set(inference, index, INFERENCE_UNKNOWN);
+  }
+}
+
+// Assigns the nearest slot named `name`, as the scope does when a FOR loop resets its variable.
+static void inference_assign_name(inference_ *inference, const char *name, enum ast_type type)
+{
+  for (inference_block_ *block = inference->block; block != NULL; block = block->parent)
+  {
+    long index = inference_find(inference, block, name);
+    if (index >= 0)
+    {
+      inference_set(inference, index, type);
+      return;
+    }
+  }
+}
+
+static enum ast_type inference_expression(inference_ *inference, ast_ *node);
+
+// Whether an operation its operands' types allow may still fail: an integer division or MOD whose divisor isn't a
+// literal other than zero
+static int inference_may_fail(ast_ *node, enum ast_type type)
+{
+  if (type != AST_INTEGER ||
+      (node->operator != OP_DIVIDE && node->operator != OP_INT_DIVIDE && node->operator != OP_MODULO))
+    return 0;
+  return node->right->type != AST_INTEGER || node->right->int_value.null || node->right->int_value.value == 0;
+}
+
+// Infers a call's arguments. The call may run a subroutine, which may change any global a subroutine assigns.
+static void inference_instantiation(inference_ *inference, ast_ *node)
+{
+  int named = 0;
+  for (size_t i = 0; i < node->arguments->size; i++)
+  {
+    ast_ *argument = node->arguments->items[i];
+    if (argument->type == AST_ASSIGNMENT)
+    {
+      named = 1;
+      argument = argument->rhs;
+    }
+    inference_expression(inference, argument);
+  }
+
+  for (size_t i = 0; i < inference->globals; i++)
+  {
+    if (inference->clobbered[i])
+      inference->types[i] = INFERENCE_UNKNOWN;
+  }
+
+  // A named argument is set through an assignment of its own, which the resolver never gave a slot
+  for (size_t i = 0; named && i < inference->size; i++)
+    inference_set(inference, i, INFERENCE_UNKNOWN);
+}
+
+// Infers the type of an expression's value, noting it on the node. Operators proven to be applied to operands of
+// types they accept are what the evaluator runs without checks.
+static enum ast_type inference_expression(inference_ *inference, ast_ *node)
+{
+  enum ast_type type = INFERENCE_UNKNOWN;
+  if (node == NULL)
+    return type;
+
+  switch (node->type)
+  {
+  case AST_INTEGER:
+    type = node->int_value.null ? INFERENCE_UNKNOWN : AST_INTEGER;
+    break;
+  case AST_REAL:
+    type = node->real_value.null ? INFERENCE_UNKNOWN : AST_REAL;
+    break;
+  case AST_CHARACTER:
+    type = node->char_value.null ? INFERENCE_UNKNOWN : AST_CHARACTER;
+    break;
+  case AST_BOOLEAN:
+    type = node->boolean_value.null ? INFERENCE_UNKNOWN : AST_BOOLEAN;
+    break;
+  case AST_STRING:
+    type = node->string_value == NULL ? INFERENCE_UNKNOWN : AST_STRING;
+    break;
+  case AST_VARIABLE:
+  {
+    long index = inference_slot(inference, node);
+    if (index >= 0 && inference->types[index] != INFERENCE_UNSET)
+      type = inference->types[index];
+    break;
+  }
+  case AST_ARRAY:
+    for (size_t i = 0; i < node->array_elements->size; i++)
+      inference_expression(inference, node->array_elements->items[i]);
+    break;
+  case AST_ARRAY_ACCESS:
+    for (size_t i = 0; i < node->index->size; i++)
+      inference_expression(inference, node->index->items[i]);
+    break;
+  case AST_INSTANTIATION:
+    inference_instantiation(inference, node);
+    break;
+  case AST_ARITHMETIC_EXPRESSION:
+  case AST_BOOLEAN_EXPRESSION:
+  {
+    enum ast_type left = node->left != NULL ? inference_expression(inference, node->left) : INFERENCE_UNSET;
+    enum ast_type right = inference_expression(inference, node->right);
+    if ((node->left == NULL || left != INFERENCE_UNKNOWN) && right != INFERENCE_UNKNOWN)
+    {
+      type = interpreter_operation_type(node, left, right);
+      if (inference_may_fail(node, type))
+        type = INFERENCE_UNKNOWN;
+      else if (type == AST_NOOP)
+      {
+        type = INFERENCE_UNKNOWN;
+        size_t i = 0;
+        while (i < inference->mismatches->size && inference->mismatches->items[i] != node)
+          i++;
+        if (i == inference->mismatches->size)
+          add_ast_to_list(inference->mismatches, node);
+      }
+    }
+    break;
+  }
+  default:
+    break;
+  }
+
+  node->proven = type;
+  return type;
+}
+
+static void inference_statement(inference_ *inference, ast_ *node);
+
+static void inference_statements(inference_ *inference, ast_list_ *statements)
+{
+  for (size_t i = 0; statements != NULL && i < statements->size && inference->reachable; i++)
+    inference_statement(inference, statements->items[i]);
+}
+
+static void inference_assignment(inference_ *inference, ast_ *node)
+{
+  enum ast_type type = inference_expression(inference, node->rhs);
+  ast_ *target = node->lhs;
+
+  // An element or field assignment that fails assigns the whole array or record instead
+  if (target->type == AST_ARRAY_ACCESS)
+    inference_expression(inference, target);
+  if (target->type != AST_VARIABLE || target->userinput == 1)
+    type = INFERENCE_UNKNOWN;
+
+  inference_assign(inference, target, type);
+}
+
+// Joins what a pass of a loop's body left into what is known at the loop's head, returning whether that changed it.
+// Slots still changing after INFERENCE_LOOP_PASSES passes are given up on, so no loop is inferred many times over.
+static int inference_widen(inference_ *inference, inference_state_ *head, int pass)
+{
+  if (!inference->reachable)
+    return 0;
+
+  int changed = 0;
+  for (size_t i = 0; i < head->size; i++)
+  {
+    enum ast_type type = inference_join_type(head->types[i], inference->types[i]);
+    if (type != head->types[i])
+    {
+      head->types[i] = pass >= INFERENCE_LOOP_PASSES ? INFERENCE_UNKNOWN : type;
+      changed = 1;
+    }
+  }
+  return changed;
+}
+
+// Infers a loop in its own block until a pass of its body changes nothing at its head, which the last pass was then
+// inferred from. A FOR loop's `variable` holds `item` as each pass starts; any other loop checks its condition. The
+// loop finishes in the state its last check is made in, before a FOR loop resets its variable.
+static void inference_loop(inference_ *inference, ast_ *node, ast_ *variable, enum ast_type item)
+{
+  inference_block_ block;
+  inference_enter_block(inference, &block, node->layout, node->layout != NULL ? node->layout->size : 0);
+
+  inference_state_ head = inference_save(inference);
+  inference_state_ finish = {NULL, 0, 0};
+  for (int pass = 1;; pass++)
+  {
+    inference_restore(inference, &head);
+    if (variable != NULL)
+      inference_assign(inference, variable, item);
+    else
+      inference_expression(inference, node->condition);
+
+    free(finish.types);
+    finish = inference_save(inference);
+    inference_statements(inference, node->loop_body);
+
+    if (!inference_widen(inference, &head, pass))
+      break;
+  }
+
+  inference_restore(inference, &finish);
+  free(head.types);
+  free(finish.types);
+  inference_leave_block(inference, &block);
+}
+
+static void inference_definite_loop(inference_ *inference, ast_ *node)
+{
+  ast_ *variable = node->loop_variable->lhs;
+  enum ast_type item = AST_INTEGER;
+  int checked; // Whether the header is proven to pass the checks that would stop the loop before it starts
+
+  if (node->collection_expr != NULL)
+  {
+    // Iterating a string gives its characters as strings; an array's elements may be anything
+    enum ast_type collection = inference_expression(inference, node->collection_expr);
+    item = collection == AST_STRING ? AST_STRING : INFERENCE_UNKNOWN;
+    checked = collection == AST_STRING;
+  }
+  else
+  {
+    checked = inference_expression(inference, node->end_expr) == AST_INTEGER;
+    checked &= node->step_expr == NULL || inference_expression(inference, node->step_expr) == AST_INTEGER;
+    checked &= inference_expression(inference, node->loop_variable->rhs) == AST_INTEGER;
+  }
+
+  inference_state_ stopped = inference_save(inference);
+  stopped.reachable = !checked;
+
+  inference_loop(inference, node, variable, item);
+
+  // The variable is reset by name in the enclosing scope, to its start value or, after a FOR-IN loop, unset
+  inference_assign_name(inference, variable->variable_name,
+                        node->collection_expr != NULL ? INFERENCE_UNKNOWN : AST_INTEGER);
+
+  inference_join_into(inference, &stopped);
+  inference_restore(inference, &stopped);
+  free(stopped.types);
+}
+
+// Infers each branch of a selection from what is known once every condition has been checked, which covers however
+// many of them run before one holds.
+static void inference_selection(inference_ *inference, ast_ *node)
+{
+  int checked = inference_expression(inference, node->if_condition) == AST_BOOLEAN;
+  for (size_t i = 0; node->else_if_conditions != NULL && i < node->else_if_conditions->size; i++)
+    checked &= inference_expression(inference, node->else_if_conditions->items[i]) == AST_BOOLEAN;
+
+  // No branch runs without an ELSE, or when a condition fails to evaluate to a boolean
+  inference_state_ conditions = inference_save(inference);
+  inference_state_ finish = inference_save(inference);
+  finish.reachable = !checked || node->else_body == NULL;
+
+  inference_statements(inference, node->if_body);
+  inference_join_into(inference, &finish);
+  for (size_t i = 0; node->else_if_conditions != NULL && i < node->else_if_conditions->size; i++)
+  {
+    inference_restore(inference, &conditions);
+    inference_statements(inference, node->else_if_bodies[i]);
+    inference_join_into(inference, &finish);
+  }
+  if (node->else_body != NULL)
+  {
+    inference_restore(inference, &conditions);
+    inference_statements(inference, node->else_body);
+    inference_join_into(inference, &finish);
+  }
+
+  inference_restore(inference, &finish);
+  free(conditions.types);
+  free(finish.types);
+}
+
+static void inference_statement(inference_ *inference, ast_ *node)
+{
+  switch (node->type)
+  {
+  case AST_COMPOUND:
+    inference_statements(inference, node->compound_value);
+    break;
+  case AST_ASSIGNMENT:
+    inference_assignment(inference, node);
+    break;
+  case AST_OUTPUT:
+    for (size_t i = 0; i < node->output_expressions->size; i++)
+      inference_expression(inference, node->output_expressions->items[i]);
+    break;
+  case AST_RETURN:
+    inference_expression(inference, node->return_value);
+    inference->reachable = 0;
+    break;
+  case AST_EXIT:
+    inference->reachable = 0;
+    break;
+  case AST_DEFINITE_LOOP:
+    inference_definite_loop(inference, node);
+    break;
+  case AST_INDEFINITE_LOOP:
+    inference_loop(inference, node, NULL, INFERENCE_UNKNOWN);
+    break;
+  case AST_SELECTION:
+    inference_selection(inference, node);
+    break;
+  case AST_SUBROUTINE:
+  case AST_RECORD_DEFINITION:
+    break;
+  default:
+    inference_expression(inference, node);
+    break;
+  }
+}
+
+// Gathers the subroutines the resolver gave slots to: those defined in any statement list, however nested, short of
+// the statements after an EXIT.
+static void inference_collect(ast_list_ *statements, ast_list_ *subroutines)
+{
+  for (size_t i = 0; statements != NULL && i < statements->size; i++)
+  {
+    ast_ *statement = statements->items[i];
+
+    switch (statement->type)
+    {
+    case AST_COMPOUND:
+      inference_collect(statement->compound_value, subroutines);
+      break;
+    case AST_SUBROUTINE:
+      add_ast_to_list(subroutines, statement);
+      inference_collect(statement->body, subroutines);
+      break;
+    case AST_DEFINITE_LOOP:
+    case AST_INDEFINITE_LOOP:
+      inference_collect(statement->loop_body, subroutines);
+      break;
+    case AST_SELECTION:
+      inference_collect(statement->if_body, subroutines);
+      for (size_t j = 0; statement->else_if_conditions != NULL && j < statement->else_if_conditions->size; j++)
+        inference_collect(statement->else_if_bodies[j], subroutines);
+      inference_collect(statement->else_body, subroutines);
+      break;
+    case AST_EXIT:
+      return;
+    default:
+      break;
+    }
+  }
+}
+
+// Infers a subroutine body in a frame holding its arguments, with nothing known of the globals it may see.
+static void inference_subroutine(inference_ *inference, ast_ *node)
+{
+  for (size_t i = 0; i < inference->globals; i++)
+    inference->types[i] = INFERENCE_UNKNOWN;
+  inference->reachable = 1;
+
+  inference_block_ frame;
+  inference_enter_block(inference, &frame, node->frame_layout, node->frame_layout != NULL ? node->frame_layout->size : 0);
+  for (int i = 0; i < node->parameter_count; i++)
+  {
+    long index = inference_slot(inference, node->parameters->items[i]);
+    if (index >= 0)
+      inference->types[index] = INFERENCE_UNKNOWN;
+  }
+
+  inference_statements(inference, node->body);
+  inference_leave_block(inference, &frame);
+}
+
+// Warns of the operations whose operands were still proven to be of types they reject once everything was inferred.
+static void inference_report(inference_ *inference)
+{
+  for (size_t i = 0; i < inference->mismatches->size; i++)
+  {
+    ast_ *node = inference->mismatches->items[i];
+    enum ast_type left = node->left != NULL ? node->left->proven : INFERENCE_UNSET;
+    enum ast_type right = node->right->proven;
+    if ((node->left != NULL && left == INFERENCE_UNKNOWN) || right == INFERENCE_UNKNOWN ||
+        interpreter_operation_type(node, left, right) != AST_NOOP)
+      continue;
+
+    if (node->left == NULL)
+      fprintf(stderr, "Type Warning: `%s` can't be applied to a %s value, so the expression fails if it runs\n",
+              node->op, inference_type_name(right));
+    else
+      fprintf(stderr, "Type Warning: `%s` can't be applied to %s and %s values, so the expression fails if it runs\n",
+              node->op, inference_type_name(left), inference_type_name(right));
+  }
+}
+
+void inference_infer(inference_ *inference, ast_ *root)
+{
+  ast_list_ *subroutines = init_ast_list();
+  if (root->type == AST_COMPOUND)
+    inference_collect(root->compound_value, subroutines);
+
+  inference->globals = inference->global_scope->variable_count;
+  inference->clobbered = calloc(inference->globals + 1, 1);
+  if (!inference->clobbered)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for type inference.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  inference_block_ global;
+  inference_enter_block(inference, &global, NULL, inference->globals);
+
+  // Subroutines are inferred again while they turn up globals a call may change, which an earlier pass assumed it
+  // couldn't
+  inference->subroutine = 1;
+  do
+  {
+    inference->clobbering = 0;
+    for (size_t i = 0; i < subroutines->size; i++)
+      inference_subroutine(inference, subroutines->items[i]);
+  } while (inference->clobbering);
+  inference->subroutine = 0;
+
+  // The program starts with every global unset
+  for (size_t i = 0; i < inference->globals; i++)
+    inference->types[i] = INFERENCE_UNSET;
+  inference->reachable = 1;
+  inference_statement(inference, root);
+
+  inference_leave_block(inference, &global);
+  inference_report(inference);
+}
@@ -0,0 +1,89 @@
+#include "include/intern.h"
+#include "include/arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct INTERN_ENTRY_STRUCT
+{
+  char *name;      // Interned copy of the name, or NULL for an empty slot
+  uint32_t hash;   // Hash of the name, kept so growing the table never rehashes the text
+  uint32_t length; // Length of the name in bytes
+} intern_entry_;
+
+static intern_entry_ *intern_entries = NULL;
+static size_t intern_capacity = 0;
+static size_t intern_count = 0;
+static arena_ *intern_arena = NULL; // Storage for every interned name
+
+// 32-bit FNV-1a
+uint32_t intern_hash(const char *name, size_t length)
+{
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++)
+  {
+    hash ^= (unsigned char)name[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Doubles the table (or creates it) and reinserts every name by its stored hash.
+static void intern_grow()
+{
+  size_t capacity = intern_capacity ? intern_capacity * 2 : INTERN_INITIAL_CAPACITY;
+  intern_entry_ *entries = calloc(capacity, sizeof(intern_entry_));
+  if (entries == NULL)
+  {
+    fprintf(stderr, "Error: Memory allocation failed while growing the name table.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (size_t i = 0; i < intern_capacity; i++)
+  {
+    if (intern_entries[i].name == NULL)
+      continue;
+
+    size_t slot = intern_entries[i].hash & (capacity - 1);
+    while (entries[slot].name != NULL)
+      slot = (slot + 1) & (capacity - 1);
+    entries[slot] = intern_entries[i];
+  }
+
+  free(intern_entries);
+  intern_entries = entries;
+  intern_capacity = capacity;
+}
+
+char *intern_name_n(const char *name, size_t length)
+{
+  if (intern_count * 2 >= intern_capacity)
+    intern_grow();
+
+  uint32_t hash = intern_hash(name, length);
+  size_t slot = hash & (intern_capacity - 1);
+
+  // Linear probing: stop at the name itself or at the first empty slot
+  while (intern_entries[slot].name != NULL)
+  {
+    intern_entry_ *entry = &intern_entries[slot];
+    if (entry->hash == hash && entry->length == length && memcmp(entry->name, name, length) == 0)
+      return entry->name;
+    slot = (slot + 1) & (intern_capacity - 1);
+  }
+
+  if (intern_arena == NULL)
+    intern_arena = init_arena(0);
+
+  intern_entries[slot].name = arena_strndup(intern_arena, name, length);
+  intern_entries[slot].hash = hash;
+  intern_entries[slot].length = (uint32_t)length;
+  intern_count++;
+
+  return intern_entries[slot].name;
+}
+
+char *intern_name(const char *name)
+{
+  return intern_name_n(name, strlen(name));
+}
@@ -1,109 +1,121 @@
 #include "include/interpreter.h"
+#include "include/closure.h"
 #include "include/scope.h"
+#include "include/value.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 #include <math.h>
 #include <time.h>
+#include <stdint.h>
+#include <sys/resource.h>
 
-ast_ *concatenate(ast_ *left_val, ast_ *right_val)
+// Whether an operand has no value to compute with; booleans are never treated as null
+#define VALUE_IS_NULL(value) (VALUE_INLINE((value).type) ? (value).type != AST_BOOLEAN && (value).null \
+                                                        : (value).type == AST_STRING && (value).node->string_value == NULL)
+
+// Statements have no result; they all return this one node rather than allocating a NOOP each time
+static ast_ interpreter_noop = {.type = AST_NOOP};
+
+value_ concatenate(value_ left_val, value_ right_val)
 {
   char *result = NULL;
 
   // Handle character + character
-  if (left_val->type == AST_CHARACTER && right_val->type == AST_CHARACTER)
+  if (left_val.type == AST_CHARACTER && right_val.type == AST_CHARACTER)
   {
-    if (left_val->char_value.null == 0 && right_val->char_value.null == 0)
+    if (!left_val.null && !right_val.null)
     {
       result = (char *)malloc(3); // 2 chars + null terminator
       if (result == NULL)
       {
         fprintf(stderr, "Failed to allocate memory for char concatenation\n");
-        return NULL;
+        return value_error();
       }
-      result[0] = left_val->char_value.value;  // Access the char value
-      result[1] = right_val->char_value.value; // Access the char value
+      result[0] = left_val.char_value;  // Access the char value
+      result[1] = right_val.char_value; // Access the char value
       result[2] = '\0';
     }
     else
     {
       fprintf(stderr, "Concatenation error: One of the character values is null\n");
-      return NULL;
+      return value_error();
     }
   }
   // Handle string + character
-  else if (left_val->type == AST_STRING && right_val->type == AST_CHARACTER)
+  else if (left_val.type == AST_STRING && right_val.type == AST_CHARACTER)
   {
-    if (left_val->string_value != NULL && right_val->char_value.null == 0)
+    if (left_val.node->string_value != NULL && !right_val.null)
     {
-      result = (char *)malloc(strlen(left_val->string_value) + 2); // 1 char + null terminator
+      result = (char *)malloc(strlen(left_val.node->string_value) + 2); // 1 char + null terminator
       if (result == NULL)
       {
         fprintf(stderr, "Failed to allocate memory for string-char concatenation\n");
-        return NULL;
+        return value_error();
       }
-      strcpy(result, left_val->string_value);
-      result[strlen(left_val->string_value)] = right_val->char_value.value; // Access the char value
-      result[strlen(left_val->string_value) + 1] = '\0';
+      strcpy(result, left_val.node->string_value);
+      result[strlen(left_val.node->string_value)] = right_val.char_value; // Access the char value
+      result[strlen(left_val.node->string_value) + 1] = '\0';
     }
     else
     {
       fprintf(stderr, "Concatenation error: One of the values is null\n");
-      return NULL;
+      return value_error();
     }
   }
   // Handle character + string
-  else if (left_val->type == AST_CHARACTER && right_val->type == AST_STRING)
+  else if (left_val.type == AST_CHARACTER && right_val.type == AST_STRING)
   {
-    if (left_val->char_value.null == 0 && right_val->string_value != NULL)
+    if (!left_val.null && right_val.node->string_value != NULL)
     {
-      result = (char *)malloc(2 + strlen(right_val->string_value)); // 1 char + string + null terminator
+      result = (char *)malloc(2 + strlen(right_val.node->string_value)); // 1 char + string + null terminator
       if (result == NULL)
       {
         fprintf(stderr, "Failed to allocate memory for char-string concatenation\n");
-        return NULL;
+        return value_error();
       }
-      result[0] = left_val->char_value.value; // Access the char value
-      strcpy(&result[1], right_val->string_value);
+      result[0] = left_val.char_value; // Access the char value
+      strcpy(&result[1], right_val.node->string_value);
     }
     else
     {
       fprintf(stderr, "Concatenation error: One of the values is null\n");
-      return NULL;
+      return value_error();
     }
   }
   // Handle string + string
-  else if (left_val->type == AST_STRING && right_val->type == AST_STRING)
+  else if (left_val.type == AST_STRING && right_val.type == AST_STRING)
   {
-    if (left_val->string_value != NULL && right_val->string_value != NULL)
+    if (left_val.node->string_value != NULL && right_val.node->string_value != NULL)
     {
-      result = (char *)malloc(strlen(left_val->string_value) + strlen(right_val->string_value) + 1);
+      result = (char *)malloc(strlen(left_val.node->string_value) + strlen(right_val.node->string_value) + 1);
       if (result == NULL)
       {
         fprintf(stderr, "Failed to allocate memory for string-string concatenation\n");
-        return NULL;
+        return value_error();
       }
-      strcpy(result, left_val->string_value);
-      strcat(result, right_val->string_value);
+      strcpy(result, left_val.node->string_value);
+      strcat(result, right_val.node->string_value);
     }
     else
     {
       fprintf(stderr, "Concatenation error: One of the string values is null\n");
-      return NULL;
+      return value_error();
     }
   }
   // Invalid types for concatenation
   else
   {
     fprintf(stderr, "Concatenation error: Unsupported types\n");
-    return NULL;
+    return value_error();
   }
 
   // Create a new AST node for the concatenated result
   ast_ *new_node = init_ast(AST_STRING);
   new_node->string_value = result;
 
-  return new_node;
+  return value_from_ast(new_node);
 }
 
 void interpreter_output_literal(ast_ *expr, interpreter_ *interpreter)
@@ -121,7 +133,7 @@ void interpreter_output_literal(ast_ *expr, interpreter_ *interpreter)
   case AST_INTEGER:
     if (expr->int_value.null == 0)
     {
-      printf("%d", expr->int_value.value);
+      printf("%" PRId64, expr->int_value.value);
     }
     break;
 
@@ -152,7 +164,7 @@ void interpreter_output_literal(ast_ *expr, interpreter_ *interpreter)
       printf("[");
       for (size_t j = 0; j < expr->array_size; j++)
       {
-        interpreter_output_literal(expr->array_elements[j], interpreter);
+        interpreter_output_literal(expr->array_elements->items[j], interpreter);
         if (j < expr->array_size - 1)
         {
           printf(", ");
@@ -168,8 +180,8 @@ void interpreter_output_literal(ast_ *expr, interpreter_ *interpreter)
       printf("%s {", expr->record_name); // Open record name and brace
       for (size_t k = 0; k < expr->field_count; k++)
       {
-        printf("%s: ", expr->record_elements[k]->element_name);                     // Print field name
-        interpreter_output_literal(expr->record_elements[k]->element, interpreter); // Print field value
+        printf("%s: ", expr->record_elements->elements[k]->element_name);                     // Print field name
+        interpreter_output_literal(expr->record_elements->elements[k]->element, interpreter); // Print field value
 
         // Print comma after every element except the last one
         if (k < expr->field_count - 1)
@@ -186,6 +198,33 @@ void interpreter_output_literal(ast_ *expr, interpreter_ *interpreter)
   }
 }
 
+// Prints a value, formatting inline types directly and boxed ones through their node.
+void interpreter_output_value(value_ value, interpreter_ *interpreter)
+{
+  if (VALUE_INLINE(value.type) && value.null)
+    return;
+
+  switch (value.type)
+  {
+  case AST_INTEGER:
+    printf("%" PRId64, value.int_value);
+    break;
+  case AST_REAL:
+    printf("%0.2f", value.real_value);
+    break;
+  case AST_CHARACTER:
+    printf("%c", value.char_value);
+    break;
+  case AST_BOOLEAN:
+    printf("%s", value.boolean_value ? "True" : "False");
+    break;
+  default:
+    if (value.node != NULL) // A failed expression has already reported its error
+      interpreter_output_literal(value.node, interpreter);
+    break;
+  }
+}
+
 int compare_ast_literals(ast_ *a, ast_ *b)
 {
   // First, check if the types match
@@ -228,7 +267,7 @@ int compare_ast_literals(ast_ *a, ast_ *b)
     for (size_t i = 0; i < a->array_size; i++)
     {
       // Compare the elements of the array using compare_ast_literals (recursion for nested arrays)
-      if (!compare_ast_literals(a->array_elements[i], b->array_elements[i]))
+      if (!compare_ast_literals(a->array_elements->items[i], b->array_elements->items[i]))
       {
         return 0; // Element mismatch found
       }
@@ -243,9 +282,20 @@ int compare_ast_literals(ast_ *a, ast_ *b)
   return 0; // Fallback, in case no match was found
 }
 
-int modulo_Euclidean(int a, int b)
+// Divides integers, rounding towards zero; the most negative integer divided by -1 wraps round to itself
+// rather than trapping.
+int64_t divide_integer(int64_t a, int64_t b)
 {
-  int m = a % b;
+  if (b == -1)
+    return INTEGER_SUBTRACT(0, a);
+  return a / b;
+}
+
+int64_t modulo_Euclidean(int64_t a, int64_t b)
+{
+  if (b == -1)
+    return 0; // a % -1 traps for the most negative integer
+  int64_t m = a % b;
   if (m < 0)
   {
     // m += (b < 0) ? -b : b; // avoid this form: it is UB when b == INT_MIN
@@ -254,6 +304,26 @@ int modulo_Euclidean(int a, int b)
   return m;
 }
 
+// Raises an integer to a non-negative integer power by squaring, so results stay exact across all 64 bits.
+int64_t power_integer(int64_t base, int64_t exponent)
+{
+  if (exponent < 0)
+  {
+    return (int64_t)pow((double)base, (double)exponent);
+  }
+
+  uint64_t result = 1;
+  uint64_t factor = (uint64_t)base; // Unsigned so overflow wraps instead of being undefined
+  while (exponent > 0)
+  {
+    if (exponent & 1)
+      result *= factor;
+    factor *= factor;
+    exponent >>= 1;
+  }
+  return (int64_t)result;
+}
+
 ast_ *handle_len_method(interpreter_ *interpreter, ast_ *node)
 {
   if (node->arguments_count != 1)
@@ -262,7 +332,7 @@ ast_ *handle_len_method(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *arg0 = interpreter_process(interpreter, node->arguments[0]);
+  ast_ *arg0 = interpreter_process(interpreter, node->arguments->items[0]);
 
   if (arg0->type == AST_ARRAY)
   {
@@ -293,15 +363,15 @@ ast_ *handle_position_method(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *arg0 = interpreter_process(interpreter, node->arguments[0]); // The array or string
-  ast_ *arg1 = interpreter_process(interpreter, node->arguments[1]); // The value to find
+  ast_ *arg0 = interpreter_process(interpreter, node->arguments->items[0]); // The array or string
+  ast_ *arg1 = interpreter_process(interpreter, node->arguments->items[1]); // The value to find
   ast_ *return_value = init_ast(AST_INTEGER);
 
-  if (arg0->type == AST_ARRAY && arg1->type == arg0->array_elements[0]->type)
+  if (arg0->type == AST_ARRAY && arg1->type == arg0->array_elements->items[0]->type)
   {
     for (int i = 0; i < arg0->array_size; i++)
     {
-      if (compare_ast_literals(arg0->array_elements[i], arg1) == 1)
+      if (compare_ast_literals(arg0->array_elements->items[i], arg1) == 1)
       {
         return_value->int_value.value = i;
         return_value->int_value.null = 0;
@@ -340,9 +410,9 @@ ast_ *handle_substring_method(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *string = interpreter_process(interpreter, node->arguments[0]);      // The string
-  ast_ *start_value = interpreter_process(interpreter, node->arguments[1]); // Start index
-  ast_ *end_value = interpreter_process(interpreter, node->arguments[2]);   // End index
+  ast_ *string = interpreter_process(interpreter, node->arguments->items[0]);      // The string
+  ast_ *start_value = interpreter_process(interpreter, node->arguments->items[1]); // Start index
+  ast_ *end_value = interpreter_process(interpreter, node->arguments->items[2]);   // End index
 
   if (string->type == AST_STRING && start_value->type == AST_INTEGER && end_value->type == AST_INTEGER)
   {
@@ -389,9 +459,9 @@ ast_ *handle_slice_method(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *array = interpreter_process(interpreter, node->arguments[0]);       // The array or matrix
-  ast_ *start_value = interpreter_process(interpreter, node->arguments[1]); // Start index
-  ast_ *end_value = interpreter_process(interpreter, node->arguments[2]);   // End index
+  ast_ *array = interpreter_process(interpreter, node->arguments->items[0]);       // The array or matrix
+  ast_ *start_value = interpreter_process(interpreter, node->arguments->items[1]); // Start index
+  ast_ *end_value = interpreter_process(interpreter, node->arguments->items[2]);   // End index
 
   if (array->type == AST_ARRAY && start_value->type == AST_INTEGER && end_value->type == AST_INTEGER)
   {
@@ -410,8 +480,8 @@ ast_ *handle_slice_method(interpreter_ *interpreter, ast_ *node)
 
     for (int i = start; i < end; i++)
     {
-      ast_ *element = array->array_elements[i];
-      add_ast_to_list(&(slice->array_elements), element); // Add the element to the slice
+      ast_ *element = array->array_elements->items[i];
+      add_ast_to_list(slice->array_elements, element); // Add the element to the slice
     }
 
     slice->array_size = end - start;
@@ -435,10 +505,10 @@ ast_ *handle_string_to_int_method(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *string_arg = interpreter_process(interpreter, node->arguments[0]);
+  ast_ *string_arg = interpreter_process(interpreter, node->arguments->items[0]);
   if (string_arg->type == AST_STRING)
   {
-    int int_value = atoi(string_arg->string_value);
+    int64_t int_value = strtoll(string_arg->string_value, NULL, 10);
     ast_ *return_value = init_ast(AST_INTEGER);
     return_value->int_value.value = int_value;
     return_value->int_value.null = 0;
@@ -458,7 +528,7 @@ ast_ *handle_string_to_real_method(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *string_arg = interpreter_process(interpreter, node->arguments[0]);
+  ast_ *string_arg = interpreter_process(interpreter, node->arguments->items[0]);
   if (string_arg->type == AST_STRING)
   {
     double real_value = atof(string_arg->string_value);
@@ -481,11 +551,11 @@ ast_ *handle_int_to_string_method(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *int_arg = interpreter_process(interpreter, node->arguments[0]);
+  ast_ *int_arg = interpreter_process(interpreter, node->arguments->items[0]);
   if (int_arg->type == AST_INTEGER)
   {
-    char buffer[12]; // Buffer large enough to hold any 32-bit integer
-    snprintf(buffer, sizeof(buffer), "%d", int_arg->int_value.value);
+    char buffer[21]; // Buffer large enough to hold any 64-bit integer
+    snprintf(buffer, sizeof(buffer), "%" PRId64, int_arg->int_value.value);
     ast_ *return_value = init_ast(AST_STRING);
     return_value->string_value = strdup(buffer);
     return return_value;
@@ -504,7 +574,7 @@ ast_ *handle_real_to_string_method(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *real_arg = interpreter_process(interpreter, node->arguments[0]);
+  ast_ *real_arg = interpreter_process(interpreter, node->arguments->items[0]);
   if (real_arg->type == AST_REAL)
   {
     char buffer[32]; // Buffer large enough to hold any double
@@ -527,7 +597,7 @@ ast_ *handle_char_to_code_method(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *char_arg = interpreter_process(interpreter, node->arguments[0]);
+  ast_ *char_arg = interpreter_process(interpreter, node->arguments->items[0]);
   if (char_arg->type == AST_CHARACTER)
   {
     int char_code = (int)char_arg->char_value.value; // Convert char to ASCII code
@@ -550,7 +620,7 @@ ast_ *handle_code_to_char_method(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *int_arg = interpreter_process(interpreter, node->arguments[0]);
+  ast_ *int_arg = interpreter_process(interpreter, node->arguments->items[0]);
   if (int_arg->type == AST_INTEGER)
   {
     char char_value = (char)int_arg->int_value.value; // Convert ASCII code to char
@@ -573,8 +643,8 @@ ast_ *handle_random_int_method(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *min_value = interpreter_process(interpreter, node->arguments[0]);
-  ast_ *max_value = interpreter_process(interpreter, node->arguments[1]);
+  ast_ *min_value = interpreter_process(interpreter, node->arguments->items[0]);
+  ast_ *max_value = interpreter_process(interpreter, node->arguments->items[1]);
 
   if (min_value->type == AST_INTEGER && max_value->type == AST_INTEGER)
   {
@@ -623,30 +693,30 @@ ast_ *copy_field_value(ast_ *field_value)
     element->array_dimension = field_value->array_dimension;
 
     // Deep copy array elements
-    element->array_elements = (ast_ **)malloc(field_value->array_size * sizeof(ast_ *));
+    element->array_elements = init_ast_list();
 
     for (int i = 0; i < field_value->array_size; i++)
     {
-      element->array_elements[i] = copy_field_value(field_value->array_elements[i]);
+      add_ast_to_list(element->array_elements, copy_field_value(field_value->array_elements->items[i]));
     }
     break;
   case AST_RECORD:
     element->record_name = strdup(field_value->record_name); // Copy the record name
 
     element->field_count = field_value->field_count;
-    element->record_elements = (ast_record_element_ **)malloc(field_value->field_count * sizeof(ast_record_element_ *));
+    element->record_elements = init_ast_list();
 
     // Deep copy each record element
     for (int i = 0; i < field_value->field_count; i++)
     {
-      ast_record_element_ *src_field = field_value->record_elements[i];
+      ast_record_element_ *src_field = field_value->record_elements->elements[i];
       ast_record_element_ *dst_field = malloc(sizeof(ast_record_element_));
 
       dst_field->element_name = strdup(src_field->element_name); // Copy field name
       dst_field->element = copy_field_value(src_field->element); // Deep copy the field value
       dst_field->dimension = src_field->dimension;
 
-      element->record_elements[i] = dst_field;
+      add_record_element_to_list(element->record_elements, dst_field);
     }
     break;
   default:
@@ -656,13 +726,43 @@ ast_ *copy_field_value(ast_ *field_value)
   return element;
 }
 
-interpreter_ *init_interpreter()
+interpreter_ *init_interpreter(scope_ *scope)
 {
   interpreter_ *interpreter = calloc(1, sizeof(struct INTERPRETER_STRUCT));
+  interpreter->scope = scope;
+  interpreter->global_scope = scope;
+  interpreter->max_call_depth = INTERPRETER_MAX_CALL_DEPTH;
+
+  // The interpreter runs close to the top of the stack it's created on, so the stack's size limit is what's left
+  char stack_top;
+  struct rlimit stack_size;
+  interpreter->stack_base = &stack_top;
+  interpreter->stack_limit = SIZE_MAX;
+  if (getrlimit(RLIMIT_STACK, &stack_size) == 0 && stack_size.rlim_cur != RLIM_INFINITY)
+  {
+    size_t size = stack_size.rlim_cur;
+    interpreter->stack_limit = size > 2 * INTERPRETER_STACK_RESERVE ? size - INTERPRETER_STACK_RESERVE : size / 2;
+  }
+
   return interpreter;
 }
 
+// Stops the program when a call would nest deeper than --max-depth allows.
+void interpreter_call_depth_error(interpreter_ *interpreter, ast_ *definition)
+{
+  fprintf(stderr, "Interpreter Error: Maximum call depth of %d exceeded calling subroutine '%s'.\n",
+          interpreter->max_call_depth, definition->subroutine_name);
+  exit(EXIT_FAILURE);
+}
+
 ast_ *interpreter_process(interpreter_ *interpreter, ast_ *node)
+{
+  if (interpreter->closures)
+    return closure_process(interpreter, node);
+  return interpreter_process_node(interpreter, node);
+}
+
+ast_ *interpreter_process_node(interpreter_ *interpreter, ast_ *node)
 {
   switch (node->type)
   {
@@ -693,9 +793,8 @@ ast_ *interpreter_process(interpreter_ *interpreter, ast_ *node)
   case AST_INSTANTIATION:
     return interpreter_process_instantiation(interpreter, node);
   case AST_ARITHMETIC_EXPRESSION:
-    return interpreter_process_arithmetic_expression(interpreter, node);
   case AST_BOOLEAN_EXPRESSION:
-    return interpreter_process_boolean_expression(interpreter, node);
+    return value_to_ast(interpreter_evaluate(interpreter, node)); // Only allocates when a node is really needed
   case AST_RECORD_DEFINITION:
     return interpreter_process_record_definition(interpreter, node);
   case AST_SUBROUTINE:
@@ -708,6 +807,11 @@ ast_ *interpreter_process(interpreter_ *interpreter, ast_ *node)
     return interpreter_process_indefinite_loop(interpreter, node);
   case AST_SELECTION:
     return interpreter_process_selection(interpreter, node);
+  case AST_RETURN:
+    if (interpreter->call != NULL)
+      return interpreter_process_return(interpreter, node);
+    fprintf(stderr, "Interpreter Error: Uncaught statement of type `%s`\n", ast_type_to_string(node->type));
+    return NULL;
   case AST_EXIT:
     return interpreter_process_exit(interpreter, node);
   default:
@@ -718,22 +822,74 @@ ast_ *interpreter_process(interpreter_ *interpreter, ast_ *node)
   return NULL; // This line will never be reached due to the exit above
 }
 
+// Evaluates an expression to a value; literals, variables and operators produce their result without allocating.
+value_ interpreter_evaluate(interpreter_ *interpreter, ast_ *node)
+{
+  if (interpreter->closures)
+    return closure_evaluate(interpreter, node);
+  return interpreter_evaluate_node(interpreter, node);
+}
+
+value_ interpreter_evaluate_node(interpreter_ *interpreter, ast_ *node)
+{
+  switch (node->type)
+  {
+  case AST_INTEGER:
+  case AST_REAL:
+  case AST_CHARACTER:
+  case AST_BOOLEAN:
+    return value_from_ast(node);
+  case AST_VARIABLE:
+  {
+    ast_ *vdef = scope_read_variable(interpreter->scope, node);
+    if (!vdef)
+    {
+      fprintf(stderr, "Interpreter Error: Undefined variable `%s`\n", node->variable_name);
+      return value_error();
+    }
+    return interpreter_evaluate(interpreter, vdef);
+  }
+  case AST_ARRAY_ACCESS:
+  {
+    ast_ **element = interpreter_process_array_access(interpreter, node);
+    return element ? value_from_ast(*element) : value_error();
+  }
+  case AST_RECORD_ACCESS:
+  {
+    ast_ **element = interpreter_process_record_access(interpreter, node);
+    return element ? value_from_ast(*element) : value_error();
+  }
+  case AST_ARITHMETIC_EXPRESSION:
+  case AST_BOOLEAN_EXPRESSION:
+    return interpreter_evaluate_operation(interpreter, node);
+  default:
+    return value_from_ast(interpreter_process(interpreter, node));
+  }
+}
+
 ast_ *interpreter_process_compound(interpreter_ *interpreter, ast_ *node)
 {
-  int i = 0;
-  while (node->compound_value[i] != NULL)
+  for (int i = 0; i < node->compound_value->size; i++)
   {
-    interpreter_process(interpreter, node->compound_value[i]);
-    i++;
+    interpreter_process(interpreter, node->compound_value->items[i]);
   }
   // Keep this
-  return init_ast(AST_NOOP);
+  return &interpreter_noop;
 }
 
 ast_ *interpreter_process_assignment(interpreter_ *interpreter, ast_ *node)
 {
-  // Process the right-hand side value
-  ast_ *rhs_value = interpreter_process(interpreter, node->rhs);
+  return interpreter_store_assignment(interpreter, node, interpreter_process(interpreter, node->rhs));
+}
+
+// Stores the processed right-hand side of an assignment in the variable, array element or record field it names.
+ast_ *interpreter_store_assignment(interpreter_ *interpreter, ast_ *node, ast_ *rhs_value)
+{
+  // An array literal is copied, as its elements may be assigned to later
+  if (node->rhs->type == AST_ARRAY)
+  {
+    rhs_value = deep_copy(rhs_value);
+  }
 
   // Initialize a new AST node for the assignment
   ast_ *new_assignment = init_ast(AST_ASSIGNMENT);
@@ -768,7 +924,9 @@ ast_ *interpreter_process_assignment(interpreter_ *interpreter, ast_ *node)
     // Update the assignment node for arrays or records
     new_assignment->lhs = init_ast(AST_VARIABLE);
     new_assignment->lhs->variable_name = node->lhs->variable_name;
-    new_assignment->rhs = scope_get_variable_definition(get_scope(node), node->lhs->variable_name); // Reassign the modified array/record
+    new_assignment->lhs->depth = node->lhs->depth;
+    new_assignment->lhs->slot = node->lhs->slot;
+    new_assignment->rhs = scope_read_variable(interpreter->scope, node->lhs); // Reassign the modified array/record
   }
   else
   {
@@ -778,14 +936,14 @@ ast_ *interpreter_process_assignment(interpreter_ *interpreter, ast_ *node)
   }
 
   // Add the variable and its value to the scope
-  scope_add_variable_definition(get_scope(node), new_assignment);
+  scope_assign_variable(interpreter->scope, new_assignment);
 
   return new_assignment; // Return the new assignment node
 }
 
 ast_ *interpreter_process_variable(interpreter_ *interpreter, ast_ *node)
 {
-  ast_ *vdef = scope_get_variable_definition(get_scope(node), node->variable_name);
+  ast_ *vdef = scope_read_variable(interpreter->scope, node);
 
   if (!vdef)
   {
@@ -798,8 +956,26 @@ ast_ *interpreter_process_variable(interpreter_ *interpreter, ast_ *node)
 ast_ **interpreter_process_array_access(interpreter_ *interpreter, ast_ *node)
 {
   // Fetch the original array from the scope
-  ast_ *array = scope_get_variable_definition(get_scope(node), node->variable_name);
+  ast_ *current_array = interpreter_array_variable(scope_read_variable(interpreter->scope, node), node);
+  ast_ **element = NULL;
+
+  // Iterate over the indices to access nested arrays or the target element
+  for (size_t index_count = 0; current_array != NULL && index_count < node->index->size; index_count++)
+  {
+    element = interpreter_array_element(current_array, interpreter_evaluate(interpreter, node->index->items[index_count]));
+    if (element == NULL)
+      return NULL;
 
+    // Move to the next nested array
+    current_array = *element;
+  }
+
+  return element; // Pointer to the array element, for reading or modifying it
+}
+
+// Checks the value of the variable an array access names is an array, returning it (or NULL after an error).
+ast_ *interpreter_array_variable(ast_ *array, ast_ *node)
+{
   if (!array)
   {
     fprintf(stderr, "Interpreter Error: could not fetch array from scope\n");
@@ -812,59 +988,45 @@ ast_ **interpreter_process_array_access(interpreter_ *interpreter, ast_ *node)
     return NULL;
   }
 
-  ast_ *current_array = array;
-  int index_count = 0;
+  return array;
+}
 
-  // Iterate over the indices to access nested arrays or the target element
-  while (node->index[index_count] != NULL)
+// Returns a pointer to the element of `current_array` an evaluated index selects, or NULL after an error.
+ast_ **interpreter_array_element(ast_ *current_array, value_ index_value)
+{
+  if (index_value.type != AST_INTEGER)
   {
-    ast_ *index_value = interpreter_process(interpreter, node->index[index_count]);
-
-    if (index_value->type != AST_INTEGER)
-    {
-      fprintf(stderr, "Interpreter Error: Array index must be an integer.\n");
-      return NULL;
-    }
-
-    if (index_value->int_value.null == 0)
-    {
-      int index = index_value->int_value.value;
+    fprintf(stderr, "Interpreter Error: Array index must be an integer.\n");
+    return NULL;
+  }
 
-      // Ensure current_array is valid and the index is within bounds
-      if (current_array->type != AST_ARRAY || index < 0 || index >= current_array->array_size)
-      {
-        fprintf(stderr, "Interpreter Error: Array index out of bounds or invalid array access.\n");
-        return NULL;
-      }
+  if (index_value.null != 0)
+  {
+    fprintf(stderr, "Interpreter Error: Array index cannot be null.\n");
+    return NULL;
+  }
 
-      // If this is the last index, return a pointer to the array element
-      if (node->index[index_count + 1] == NULL)
-      {
-        return &current_array->array_elements[index]; // Return pointer to the array element
-      }
-      else
-      {
-        // Move to the next nested array
-        current_array = current_array->array_elements[index];
-      }
-    }
-    else
-    {
-      fprintf(stderr, "Interpreter Error: Array index cannot be null.\n");
-      return NULL;
-    }
+  int index = index_value.int_value;
 
-    index_count++;
+  // Ensure current_array is valid and the index is within bounds
+  if (current_array->type != AST_ARRAY || index < 0 || index >= current_array->array_size)
+  {
+    fprintf(stderr, "Interpreter Error: Array index out of bounds or invalid array access.\n");
+    return NULL;
   }
 
-  return NULL; // Should not reach here
+  return &current_array->array_elements->items[index];
 }
 
 ast_ **interpreter_process_record_access(interpreter_ *interpreter, ast_ *node)
 {
   // Get the record from the scope by its variable name
-  ast_ *record = scope_get_variable_definition(get_scope(node), node->variable_name);
+  return interpreter_record_field(scope_read_variable(interpreter->scope, node), node);
+}
 
+// Returns a pointer to the field of `record` a record access names, or NULL after an error.
+ast_ **interpreter_record_field(ast_ *record, ast_ *node)
+{
   // Ensure that the variable is actually a record
   if (!record || record->type != AST_RECORD)
   {
@@ -875,7 +1037,7 @@ ast_ **interpreter_process_record_access(interpreter_ *interpreter, ast_ *node)
   // Loop through the record elements to find the matching field
   for (int i = 0; i < record->field_count; i++)
   {
-    ast_record_element_ *field = record->record_elements[i];
+    ast_record_element_ *field = record->record_elements->elements[i];
 
     // Check if the field name matches the requested field
     if (strcmp(field->element_name, node->field_name) == 0)
@@ -888,60 +1050,186 @@ ast_ **interpreter_process_record_access(interpreter_ *interpreter, ast_ *node)
   // If the field wasn't found, output an error
   fprintf(stderr, "Interpreter Error: Field '%s' not found in record '%s'.\n", node->field_name, node->variable_name);
   return NULL;
+}
 
-  return NULL; // Fallback, should not reach here
+// Returns the subroutine an expression calls, or NULL when it isn't a subroutine call. Subroutines can't be named
+// after built-in methods, so a call to one that's defined is a subroutine call; calls with the wrong number of
+// arguments are left to interpreter_process_instantiation to report.
+ast_ *interpreter_called_subroutine(interpreter_ *interpreter, ast_ *node)
+{
+  if (node->type != AST_INSTANTIATION)
+    return NULL;
+
+  ast_ *definition = scope_find_instantiation_definition(interpreter->scope, node->class_name);
+  if (definition == NULL || definition->type != AST_SUBROUTINE || node->arguments_count != definition->parameter_count)
+    return NULL;
+
+  return definition;
 }
 
-ast_ *interpreter_process_instantiation(interpreter_ *interpreter, ast_ *node)
+// Binds evaluated arguments to the parameter slots at the start of a subroutine's frame. Each parameter gets its own
+// copy of the argument's node; inline values are copied straight from the result.
+void interpreter_bind_arguments(scope_ *frame, ast_ *definition, value_ *arguments)
 {
-  // Processing built-in methods
-  if (strcmp(node->class_name, "LEN") == 0)
+  for (int i = 0; i < definition->parameter_count; i++)
   {
-    return handle_len_method(interpreter, node);
-  }
-  else if (strcmp(node->class_name, "POSITION") == 0)
-  {
-    return handle_position_method(interpreter, node);
-  }
-  else if (strcmp(node->class_name, "SUBSTRING") == 0)
-  {
-    return handle_substring_method(interpreter, node);
-  }
-  else if (strcmp(node->class_name, "SLICE") == 0)
-  {
-    return handle_slice_method(interpreter, node);
-  }
-  else if (strcmp(node->class_name, "STRING_TO_INT") == 0)
-  {
-    return handle_string_to_int_method(interpreter, node);
+    ast_ *var = init_ast(AST_ASSIGNMENT);
+    var->lhs = definition->parameters->items[i];
+    if (VALUE_INLINE(arguments[i].type))
+    {
+      var->rhs = value_to_ast(arguments[i]);
+    }
+    else
+    {
+      var->rhs = init_ast(arguments[i].type);
+      *var->rhs = *arguments[i].node;
+    }
+
+    scope_assign_variable(frame, var);
   }
-  else if (strcmp(node->class_name, "STRING_TO_REAL") == 0)
+}
+
+// Evaluates a call's arguments in the current scope into the call record, returning 0 if any of them fails.
+static int interpreter_evaluate_arguments(interpreter_ *interpreter, interpreter_call_ *call, ast_ *node)
+{
+  if (node->arguments_count > call->argument_capacity)
   {
-    return handle_string_to_real_method(interpreter, node);
+    value_ *arguments = malloc(node->arguments_count * sizeof(value_));
+    if (!arguments)
+    {
+      fprintf(stderr, "Interpreter Error: Memory allocation failed for the arguments of '%s'.\n", node->class_name);
+      return 0;
+    }
+    if (call->arguments != call->inline_arguments)
+      free(call->arguments);
+    call->arguments = arguments;
+    call->argument_capacity = node->arguments_count;
   }
-  else if (strcmp(node->class_name, "INT_TO_STRING") == 0)
+
+  for (int i = 0; i < node->arguments_count; i++)
   {
-    return handle_int_to_string_method(interpreter, node);
+    call->arguments[i] = interpreter_evaluate(interpreter, node->arguments->items[i]);
+    if (value_is_error(call->arguments[i]))
+      return 0;
   }
-  else if (strcmp(node->class_name, "REAL_TO_STRING") == 0)
+
+  return 1;
+}
+
+// Calls a subroutine in a frame whose parent is the global scope. The body is shared by every call and only ever read.
+// When the body ends in a tail call, the frame is reset (or recycled, for another subroutine) and the loop runs the
+// next body in it, so a chain of tail calls runs in constant C stack and allocates no frames.
+static ast_ *interpreter_call_subroutine(interpreter_ *interpreter, ast_ *definition, ast_ *node)
+{
+  interpreter_call_ call = {interpreter->call, definition};
+  call.arguments = call.inline_arguments;
+  call.argument_capacity = INTERPRETER_INLINE_ARGUMENTS;
+
+  // The first call's arguments are evaluated in the caller's scope, the rest by the RETURN making the tail call
+  if (!interpreter_evaluate_arguments(interpreter, &call, node))
+    return NULL;
+
+  // Each nested call takes C stack, so the walker stops cleanly before it runs out rather than crashing
+  if (interpreter->call_depth >= interpreter->max_call_depth)
+    interpreter_call_depth_error(interpreter, definition);
+  if ((size_t)(interpreter->stack_base - (char *)&call) > interpreter->stack_limit)
   {
-    return handle_real_to_string_method(interpreter, node);
+    fprintf(stderr, "Interpreter Error: Calling subroutine '%s' %d calls deep would overflow the C stack; run with "
+                    "--engine=stack for deeper recursion.\n",
+            definition->subroutine_name, interpreter->call_depth);
+    exit(EXIT_FAILURE);
   }
-  else if (strcmp(node->class_name, "CHAR_TO_CODE") == 0)
+  interpreter->call_depth++;
+
+  scope_ *caller_scope = interpreter->scope;
+  scope_ *frame = NULL;
+  ast_ *frame_definition = NULL; // Subroutine the frame's layout was declared for
+  interpreter->call = &call;
+
+  do
   {
-    return handle_char_to_code_method(interpreter, node);
-  }
-  else if (strcmp(node->class_name, "CODE_TO_CHAR") == 0)
+    if (frame_definition == call.definition)
+    {
+      scope_reset(frame); // Self tail call: same layout, so only the values go
+    }
+    else
+    {
+      // First call, or a tail call to another subroutine; the frame just freed is the one init_scope hands back
+      free_scope(frame);
+      frame = init_scope(interpreter->global_scope, call.definition->subroutine_name);
+      scope_declare_layout(frame, call.definition->frame_layout);
+      frame_definition = call.definition;
+    }
+
+    interpreter_bind_arguments(frame, call.definition, call.arguments);
+    interpreter->scope = frame;
+    call.tail_call = NULL;
+    call.result = &interpreter_noop;
+
+    for (int i = 0; i < call.definition->body->size && !interpreter->returning; i++)
+    {
+      interpreter_process(interpreter, call.definition->body->items[i]);
+    }
+    interpreter->returning = 0;
+  } while (call.tail_call != NULL);
+
+  // Pop the frame however the body ended
+  interpreter->scope = caller_scope;
+  interpreter->call = call.caller;
+  interpreter->call_depth--;
+  free_scope(frame);
+  if (call.arguments != call.inline_arguments)
+    free(call.arguments);
+  return call.result;
+}
+
+// Built-in methods, which take precedence over any record or subroutine of the same name
+static const struct
+{
+  const char *name;
+  interpreter_builtin_ handler;
+} interpreter_builtins[] = {
+    {"LEN", handle_len_method},
+    {"POSITION", handle_position_method},
+    {"SUBSTRING", handle_substring_method},
+    {"SLICE", handle_slice_method},
+    {"STRING_TO_INT", handle_string_to_int_method},
+    {"STRING_TO_REAL", handle_string_to_real_method},
+    {"INT_TO_STRING", handle_int_to_string_method},
+    {"REAL_TO_STRING", handle_real_to_string_method},
+    {"CHAR_TO_CODE", handle_char_to_code_method},
+    {"CODE_TO_CHAR", handle_code_to_char_method},
+    {"RANDOM_INT", handle_random_int_method},
+};
+
+// Returns the handler of the built-in method called `name`, or NULL if there is none.
+interpreter_builtin_ interpreter_find_builtin(const char *name)
+{
+  for (size_t i = 0; i < sizeof(interpreter_builtins) / sizeof(interpreter_builtins[0]); i++)
   {
-    return handle_code_to_char_method(interpreter, node);
+    if (strcmp(name, interpreter_builtins[i].name) == 0)
+      return interpreter_builtins[i].handler;
   }
-  else if (strcmp(node->class_name, "RANDOM_INT") == 0)
+  return NULL;
+}
+
+ast_ *interpreter_process_instantiation(interpreter_ *interpreter, ast_ *node)
+{
+  // Processing built-in methods
+  interpreter_builtin_ builtin = interpreter_find_builtin(node->class_name);
+  if (builtin != NULL)
   {
-    return handle_random_int_method(interpreter, node);
+    return builtin(interpreter, node);
   }
 
+  return interpreter_instantiate_definition(interpreter, node);
+}
+
+// Instantiates the record or calls the subroutine an instantiation names, once it is known not to be a built-in.
+ast_ *interpreter_instantiate_definition(interpreter_ *interpreter, ast_ *node)
+{
   // Use scope_get_instantiation_definition to find the record definition
-  ast_ *inst_definition = scope_get_instantiation_definition(get_scope(node), node->class_name);
+  ast_ *inst_definition = scope_get_instantiation_definition(interpreter->scope, node->class_name);
 
   if (!inst_definition)
   {
@@ -967,7 +1255,7 @@ ast_ *interpreter_process_instantiation(interpreter_ *interpreter, ast_ *node)
     // Create a new AST_RECORD node for the instantiated record
     ast_ *new_record = init_ast(AST_RECORD);
     new_record->record_name = node->class_name;
-    new_record->record_elements = (ast_record_element_ **)init_ast_list();
+    new_record->record_elements = init_ast_list();
     new_record->field_count = 0;
 
     if (node->arguments_count != inst_definition->field_count)
@@ -977,13 +1265,13 @@ ast_ *interpreter_process_instantiation(interpreter_ *interpreter, ast_ *node)
       // Iterate over record fields
       for (int i = 0; i < inst_definition->field_count; i++)
       {
-        ast_record_element_ *inst_field = inst_definition->record_elements[i];
+        ast_record_element_ *inst_field = inst_definition->record_elements->elements[i];
         ast_ *field_value = NULL;
 
         // Find matching argument or use default value
-        if (j < node->arguments_count && strcmp(node->arguments[j]->lhs->variable_name, inst_field->element_name) == 0)
+        if (j < node->arguments_count && strcmp(node->arguments->items[j]->lhs->variable_name, inst_field->element_name) == 0)
         {
-          field_value = interpreter_process(interpreter, node->arguments[j]->rhs);
+          field_value = interpreter_process(interpreter, node->arguments->items[j]->rhs);
           j++; // Move to next argument
         }
         else
@@ -1004,7 +1292,7 @@ ast_ *interpreter_process_instantiation(interpreter_ *interpreter, ast_ *node)
           record_element->element = copy_field_value(field_value);
           record_element->dimension = (field_value->type == AST_ARRAY) ? field_value->array_dimension : 0;
 
-          add_ast_to_list((ast_ ***)&new_record->record_elements, (ast_ *)record_element);
+          add_record_element_to_list(new_record->record_elements, record_element);
           new_record->field_count++;
         }
         else
@@ -1019,21 +1307,21 @@ ast_ *interpreter_process_instantiation(interpreter_ *interpreter, ast_ *node)
       // Handle exact match in argument count and field count
       for (int i = 0; i < node->arguments_count; i++)
       {
-        ast_ *arg = interpreter_process(interpreter, node->arguments[i]);
+        ast_ *arg = interpreter_process(interpreter, node->arguments->items[i]);
 
-        if ((arg->type == inst_definition->record_elements[i]->element->type) ||
-            (arg->type == AST_ARRAY && arg->array_type == inst_definition->record_elements[i]->element->type &&
-             arg->array_dimension == inst_definition->record_elements[i]->dimension))
+        if ((arg->type == inst_definition->record_elements->elements[i]->element->type) ||
+            (arg->type == AST_ARRAY && arg->array_type == inst_definition->record_elements->elements[i]->element->type &&
+             arg->array_dimension == inst_definition->record_elements->elements[i]->dimension))
         {
           ast_record_element_ *record_element = malloc(sizeof(ast_record_element_));
           if (!record_element)
             return NULL;
 
-          record_element->element_name = inst_definition->record_elements[i]->element_name;
+          record_element->element_name = inst_definition->record_elements->elements[i]->element_name;
           record_element->element = arg;
           record_element->dimension = (arg->type == AST_ARRAY) ? arg->array_dimension : 0;
 
-          add_ast_to_list((ast_ ***)&new_record->record_elements, (ast_ *)record_element);
+          add_record_element_to_list(new_record->record_elements, record_element);
           new_record->field_count++;
         }
       }
@@ -1043,432 +1331,294 @@ ast_ *interpreter_process_instantiation(interpreter_ *interpreter, ast_ *node)
   }
   else if (inst_definition->type == AST_SUBROUTINE)
   {
-    ast_ *inst_definition_copy = deep_copy(inst_definition);
-    // Assign the arguments to the subroutine's parameters within this new scope
-    for (int i = 0; i < node->arguments_count; i++)
-    {
-      ast_ *arg = interpreter_process(interpreter, node->arguments[i]);
-      ast_ *var = init_ast(AST_ASSIGNMENT);
-      var->lhs = init_ast(AST_VARIABLE);
-      var->lhs->variable_name = strdup(inst_definition_copy->parameters[i]->variable_name);
-      var->rhs = init_ast(arg->type);
-      *var->rhs = *arg;
-
-      // Add the variable to the subroutine-specific scope
-      scope_add_variable_definition(node->scope, var);
-    }
-
-    // Process the function body within this new scope
-    for (int i = 0; inst_definition_copy->body[i] != NULL; i++)
-    {
-      ast_ *current_statement = inst_definition_copy->body[i];
-      set_scope(current_statement, node->scope);
-
-      if (current_statement->type == AST_RETURN)
-      {
-        return interpreter_process(interpreter, current_statement->return_value);
-      }
-
-      interpreter_process(interpreter, current_statement);
-    }
+    return interpreter_call_subroutine(interpreter, inst_definition, node);
   }
 
-  return init_ast(AST_NOOP);
+  return &interpreter_noop;
 }
-ast_ *interpreter_process_arithmetic_expression(interpreter_ *interpreter, ast_ *node)
+// Operations on two values whose types have already been checked by the dispatch table
+typedef value_ (*binary_operation_)(value_ left, value_ right);
+
+// Operations on the single operand of a unary minus or NOT
+typedef value_ (*unary_operation_)(value_ right);
+
+#define INTEGER_OPERATION(name, expression)   \
+  static value_ name(value_ left, value_ right) \
+  {                                             \
+    int64_t a = left.int_value;                 \
+    int64_t b = right.int_value;                \
+    return value_integer(expression);           \
+  }
+
+#define REAL_OPERATION(name, expression)        \
+  static value_ name(value_ left, value_ right) \
+  {                                             \
+    double a = left.real_value;                 \
+    double b = right.real_value;                \
+    return value_real(expression);              \
+  }
+
+// Defines the six comparisons of one type, given how to read an operand of that type as `a` and `b`
+#define COMPARISONS(type_name, a_value, b_value)                                                                          \
+  static value_ less_##type_name(value_ left, value_ right) { return value_boolean((a_value) < (b_value)); }             \
+  static value_ greater_##type_name(value_ left, value_ right) { return value_boolean((a_value) > (b_value)); }          \
+  static value_ less_equal_##type_name(value_ left, value_ right) { return value_boolean((a_value) <= (b_value)); }      \
+  static value_ greater_equal_##type_name(value_ left, value_ right) { return value_boolean((a_value) >= (b_value)); }   \
+  static value_ equal_##type_name(value_ left, value_ right) { return value_boolean((a_value) == (b_value)); }           \
+  static value_ not_equal_##type_name(value_ left, value_ right) { return value_boolean((a_value) != (b_value)); }
+
+INTEGER_OPERATION(add_integers, INTEGER_ADD(a, b))
+INTEGER_OPERATION(subtract_integers, INTEGER_SUBTRACT(a, b))
+INTEGER_OPERATION(multiply_integers, INTEGER_MULTIPLY(a, b))
+INTEGER_OPERATION(power_integers, power_integer(a, b))
+
+// Integer division and MOD report a zero divisor rather than letting it trap
+static value_ divide_integers(value_ left, value_ right)
 {
-  ast_ *left_val = NULL;
-  ast_ *right_val = NULL;
+  if (right.int_value == 0)
+  {
+    fprintf(stderr, "Interpreter Error: Division by zero\n");
+    return value_error();
+  }
+  return value_integer(divide_integer(left.int_value, right.int_value));
+}
 
-  // Process the left side, if not null
-  if (node->left != NULL)
+static value_ modulo_integers(value_ left, value_ right)
+{
+  if (right.int_value == 0)
   {
-    left_val = interpreter_process(interpreter, node->left);
+    fprintf(stderr, "Interpreter Error: Division by zero\n");
+    return value_error();
   }
+  return value_integer(modulo_Euclidean(left.int_value, right.int_value));
+}
 
-  // Process the right side, which should always exist
-  right_val = interpreter_process(interpreter, node->right);
+REAL_OPERATION(add_reals, a + b)
+REAL_OPERATION(subtract_reals, a - b)
+REAL_OPERATION(multiply_reals, a * b)
+REAL_OPERATION(divide_reals, a / b)
+REAL_OPERATION(power_reals, pow(a, b))
 
-  // Check for null values before proceeding
-  if ((left_val && ((left_val->type == AST_INTEGER && left_val->int_value.null == 1) ||
-                    (left_val->type == AST_REAL && left_val->real_value.null == 1) ||
-                    (left_val->type == AST_CHARACTER && left_val->char_value.null == 1) ||
-                    (left_val->type == AST_STRING && left_val->string_value == NULL))) ||
-      (right_val && ((right_val->type == AST_INTEGER && right_val->int_value.null == 1) ||
-                     (right_val->type == AST_REAL && right_val->real_value.null == 1) ||
-                     (right_val->type == AST_CHARACTER && right_val->char_value.null == 1) ||
-                     (right_val->type == AST_STRING && right_val->string_value == NULL))))
-  {
-    fprintf(stderr, "Interpreter Error: Null value in arithmetic expression\n");
-    return NULL;
-  }
+COMPARISONS(integers, left.int_value, right.int_value)
+COMPARISONS(reals, left.real_value, right.real_value)
+COMPARISONS(characters, left.char_value, right.char_value)
+COMPARISONS(strings, strcmp(left.node->string_value, right.node->string_value), 0)
 
-  // Handle unary minus operation
-  if ((strcmp(node->op, "-") == 0) && node->left == NULL)
-  {
-    if (right_val->type == AST_INTEGER)
-    {
-      ast_ *result = init_ast(AST_INTEGER);
-      result->int_value.value = -(right_val->int_value.value);
-      // printf("-1 * %d\n", right_val->int_value.value);
-      result->int_value.null = 0;
-      return result;
-    }
-    else if (right_val->type == AST_REAL)
-    {
-      ast_ *result = init_ast(AST_REAL);
-      result->real_value.value = -(right_val->real_value.value);
-      // printf("-1.0 * %.2f\n", right_val->real_value.value);
-      result->real_value.null = 0;
-      return result;
-    }
-    else
-    {
-      fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer or Real types\n", node->op);
-      return NULL;
-    }
-  }
+static value_ logical_and(value_ left, value_ right)
+{
+  return value_boolean(VALUE_TRUTH(left) && VALUE_TRUTH(right));
+}
 
-  // Handle binary operations
-  if (strcmp(node->op, "+") == 0)
-  {
-    if ((left_val->type == AST_CHARACTER || left_val->type == AST_STRING) &&
-        (right_val->type == AST_CHARACTER || right_val->type == AST_STRING))
-    {
-      return concatenate(left_val, right_val); // General concatenation for char/string
-    }
-    else if (left_val->type == right_val->type)
-    {
-      if (left_val->type == AST_INTEGER && right_val->type == AST_INTEGER)
-      {
-        ast_ *result = init_ast(AST_INTEGER);
-        result->int_value.value = left_val->int_value.value + right_val->int_value.value;
-        // printf("%d + %d\n", left_val->int_value.value, right_val->int_value.value);
-        result->int_value.null = 0;
-        return result;
-      }
-      else if (left_val->type == AST_REAL && right_val->type == AST_REAL)
-      {
-        ast_ *result = init_ast(AST_REAL);
-        result->real_value.value = left_val->real_value.value + right_val->real_value.value;
-        // printf("%.2f + %.2f\n", left_val->real_value.value, right_val->real_value.value);
-        result->real_value.null = 0;
-        return result;
-      }
-      else
-      {
-        fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer, Real, Character, or String types\n", node->op);
-        return NULL;
-      }
-    }
-    else
-    {
-      fprintf(stderr, "Interpreter Error: Mismatched types between `%s` operator\n", node->op);
-      return NULL;
-    }
-  }
-  else if (strcmp(node->op, "-") == 0)
-  {
-    if (left_val->type == right_val->type)
-    {
-      if (left_val->type == AST_INTEGER && right_val->type == AST_INTEGER)
-      {
-        ast_ *result = init_ast(AST_INTEGER);
-        result->int_value.value = left_val->int_value.value - right_val->int_value.value;
-        result->int_value.null = 0;
-        return result;
-      }
-      else if (left_val->type == AST_REAL && right_val->type == AST_REAL)
-      {
-        ast_ *result = init_ast(AST_REAL);
-        result->real_value.value = left_val->real_value.value - right_val->real_value.value;
-        result->real_value.null = 0;
-        return result;
-      }
-      else
-      {
-        fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer or Real types\n", node->op);
-        return NULL;
-      }
-    }
-    else
-    {
-      fprintf(stderr, "Interpreter Error: Mismatched types between `%s` operator\n", node->op);
-      return NULL;
-    }
-  }
-  else if (strcmp(node->op, "*") == 0)
+static value_ logical_or(value_ left, value_ right)
+{
+  return value_boolean(VALUE_TRUTH(left) || VALUE_TRUTH(right));
+}
+
+static value_ logical_not(value_ right)
+{
+  return value_boolean(!VALUE_TRUTH(right));
+}
+
+static value_ negate_integer(value_ right)
+{
+  return value_integer(INTEGER_SUBTRACT(0, right.int_value));
+}
+
+static value_ negate_real(value_ right)
+{
+  return value_real(-right.real_value);
+}
+
+// Highest operand type the dispatch tables are indexed by; every literal type sorts at or below it
+#define OPERAND_TYPES (AST_RECORD + 1)
+
+// Fills in one operator for every pair of operands of the same type
+#define SAME_TYPES(op, operation)                                                                 \
+  [op][AST_COMPOUND][AST_COMPOUND] = operation, [op][AST_NOOP][AST_NOOP] = operation,            \
+  [op][AST_INTEGER][AST_INTEGER] = operation, [op][AST_REAL][AST_REAL] = operation,              \
+  [op][AST_CHARACTER][AST_CHARACTER] = operation, [op][AST_STRING][AST_STRING] = operation,      \
+  [op][AST_BOOLEAN][AST_BOOLEAN] = operation, [op][AST_ARRAY][AST_ARRAY] = operation,            \
+  [op][AST_RECORD][AST_RECORD] = operation
+
+// Fills in one comparison operator for every type that can be ordered
+#define ORDERED_TYPES(op, name)                                                                                   \
+  [op][AST_INTEGER][AST_INTEGER] = name##_integers, [op][AST_REAL][AST_REAL] = name##_reals,                     \
+  [op][AST_CHARACTER][AST_CHARACTER] = name##_characters, [op][AST_STRING][AST_STRING] = name##_strings
+
+// Every binary operator, indexed by operator and the types of its operands; NULL marks a type error
+static const binary_operation_ binary_operations[OP_NOT + 1][OPERAND_TYPES][OPERAND_TYPES] = {
+    [OP_ADD][AST_INTEGER][AST_INTEGER] = add_integers,
+    [OP_ADD][AST_REAL][AST_REAL] = add_reals,
+    [OP_ADD][AST_CHARACTER][AST_CHARACTER] = concatenate,
+    [OP_ADD][AST_CHARACTER][AST_STRING] = concatenate,
+    [OP_ADD][AST_STRING][AST_CHARACTER] = concatenate,
+    [OP_ADD][AST_STRING][AST_STRING] = concatenate,
+    [OP_SUBTRACT][AST_INTEGER][AST_INTEGER] = subtract_integers,
+    [OP_SUBTRACT][AST_REAL][AST_REAL] = subtract_reals,
+    [OP_MULTIPLY][AST_INTEGER][AST_INTEGER] = multiply_integers,
+    [OP_MULTIPLY][AST_REAL][AST_REAL] = multiply_reals,
+    [OP_DIVIDE][AST_INTEGER][AST_INTEGER] = divide_integers,
+    [OP_DIVIDE][AST_REAL][AST_REAL] = divide_reals,
+    [OP_POWER][AST_INTEGER][AST_INTEGER] = power_integers,
+    [OP_POWER][AST_REAL][AST_REAL] = power_reals,
+    [OP_INT_DIVIDE][AST_INTEGER][AST_INTEGER] = divide_integers,
+    [OP_MODULO][AST_INTEGER][AST_INTEGER] = modulo_integers,
+    ORDERED_TYPES(OP_LESS, less),
+    ORDERED_TYPES(OP_GREATER, greater),
+    ORDERED_TYPES(OP_LESS_EQUAL, less_equal),
+    ORDERED_TYPES(OP_GREATER_EQUAL, greater_equal),
+    ORDERED_TYPES(OP_EQUAL, equal),
+    ORDERED_TYPES(OP_NOT_EQUAL, not_equal),
+    SAME_TYPES(OP_AND, logical_and),
+    SAME_TYPES(OP_OR, logical_or),
+};
+
+// Every unary operator, indexed by operator and the type of its operand; NULL marks a type error
+static const unary_operation_ unary_operations[OP_NOT + 1][OPERAND_TYPES] = {
+    [OP_SUBTRACT][AST_INTEGER] = negate_integer,
+    [OP_SUBTRACT][AST_REAL] = negate_real,
+    [OP_NOT][AST_COMPOUND] = logical_not,
+    [OP_NOT][AST_NOOP] = logical_not,
+    [OP_NOT][AST_INTEGER] = logical_not,
+    [OP_NOT][AST_REAL] = logical_not,
+    [OP_NOT][AST_CHARACTER] = logical_not,
+    [OP_NOT][AST_STRING] = logical_not,
+    [OP_NOT][AST_BOOLEAN] = logical_not,
+    [OP_NOT][AST_ARRAY] = logical_not,
+    [OP_NOT][AST_RECORD] = logical_not,
+};
+
+// Reports why an operator has no entry in the dispatch tables for its operands.
+static value_ operation_error(ast_ *node, value_ left, value_ right)
+{
+  int same_types = node->left == NULL || left.type == right.type;
+
+  if (node->type == AST_BOOLEAN_EXPRESSION)
   {
-    if (left_val->type == right_val->type)
-    {
-      if (left_val->type == AST_INTEGER && right_val->type == AST_INTEGER)
-      {
-        ast_ *result = init_ast(AST_INTEGER);
-        result->int_value.value = left_val->int_value.value * right_val->int_value.value;
-        result->int_value.null = 0;
-        return result;
-      }
-      else if (left_val->type == AST_REAL && right_val->type == AST_REAL)
-      {
-        ast_ *result = init_ast(AST_REAL);
-        result->real_value.value = left_val->real_value.value * right_val->real_value.value;
-        result->real_value.null = 0;
-        return result;
-      }
-      else
-      {
-        fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer or Real types\n", node->op);
-        return NULL;
-      }
-    }
+    if (node->operator < OP_LESS || node->operator > OP_NOT)
+      fprintf(stderr, "Interpreter Error: Invalid boolean operation: %s\n", node->op);
+    else if (!same_types)
+      fprintf(stderr, "Interpreter Error: Type mismatch in boolean expression\n");
     else
-    {
-      fprintf(stderr, "Interpreter Error: Mismatched types between `%s` operator\n", node->op);
-      return NULL;
-    }
+      fprintf(stderr, "Interpreter Error: Unsupported type for boolean comparison\n");
+    return value_error();
   }
-  else if (strcmp(node->op, "/") == 0)
+
+  switch (node->operator)
   {
-    if (left_val->type == right_val->type)
-    {
-      if (left_val->type == AST_INTEGER && right_val->type == AST_INTEGER)
-      {
-        ast_ *result = init_ast(AST_INTEGER);
-        result->int_value.value = left_val->int_value.value / right_val->int_value.value;
-        result->int_value.null = 0;
-        return result;
-      }
-      else if (left_val->type == AST_REAL && right_val->type == AST_REAL)
-      {
-        ast_ *result = init_ast(AST_REAL);
-        result->real_value.value = left_val->real_value.value / right_val->real_value.value;
-        result->real_value.null = 0;
-        return result;
-      }
-      else
-      {
-        fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer or Real types\n", node->op);
-        return NULL;
-      }
-    }
+  case OP_ADD:
+    if (same_types)
+      fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer, Real, Character, or String types\n", node->op);
     else
-    {
       fprintf(stderr, "Interpreter Error: Mismatched types between `%s` operator\n", node->op);
-      return NULL;
-    }
-  }
-  else if (strcmp(node->op, "^") == 0)
-  {
-    if (left_val->type == right_val->type)
-    {
-      if (left_val->type == AST_INTEGER && right_val->type == AST_INTEGER)
-      {
-        ast_ *result = init_ast(AST_INTEGER);
-        result->int_value.value = pow(left_val->int_value.value, right_val->int_value.value);
-        result->int_value.null = 0;
-        return result;
-      }
-      else if (left_val->type == AST_REAL && right_val->type == AST_REAL)
-      {
-        ast_ *result = init_ast(AST_REAL);
-        result->real_value.value = pow(left_val->real_value.value, right_val->real_value.value);
-        result->real_value.null = 0;
-        return result;
-      }
-      else
-      {
-        fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer or Real types\n", node->op);
-        return NULL;
-      }
-    }
+    break;
+  case OP_SUBTRACT:
+  case OP_MULTIPLY:
+  case OP_DIVIDE:
+  case OP_POWER:
+    if (same_types)
+      fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer or Real types\n", node->op);
     else
-    {
       fprintf(stderr, "Interpreter Error: Mismatched types between `%s` operator\n", node->op);
-      return NULL;
-    }
-  }
-  else if (strcmp(node->op, "DIV") == 0)
-  {
-    if (left_val->type == AST_INTEGER && right_val->type == AST_INTEGER)
-    {
-      ast_ *result = init_ast(AST_INTEGER);
-      result->int_value.value = left_val->int_value.value / right_val->int_value.value; // Integer division
-      result->int_value.null = 0;
-      return result;
-    }
-    else
-    {
-      fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer types\n", node->op);
-      return NULL;
-    }
-  }
-  else if (strcmp(node->op, "MOD") == 0)
-  {
-    if (left_val->type == AST_INTEGER && right_val->type == AST_INTEGER)
-    {
-      ast_ *result = init_ast(AST_INTEGER);
-      result->int_value.value = modulo_Euclidean(left_val->int_value.value, right_val->int_value.value);
-      result->int_value.null = 0;
-      return result;
-    }
-    else
-    {
-      fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer types\n", node->op);
-      return NULL;
-    }
+    break;
+  case OP_INT_DIVIDE:
+  case OP_MODULO:
+    fprintf(stderr, "Interpreter Error: `%s` operator is only compatible with Integer types\n", node->op);
+    break;
+  default:
+    fprintf(stderr, "Interpreter Error: Invalid arithmetic operation: %s\n", node->op);
+    break;
   }
 
-  fprintf(stderr, "Interpreter Error: Invalid arithmetic operation: %s\n", node->op);
-  return NULL;
-  return NULL; // Return a no-op if no valid operation found
+  return value_error();
 }
 
-ast_ *interpreter_process_boolean_expression(interpreter_ *interpreter, ast_ *node)
+// Evaluates an arithmetic or boolean expression: the operands are evaluated, then the operator and their
+// types select the operation from the dispatch tables with a single indirect call.
+value_ interpreter_evaluate_operation(interpreter_ *interpreter, ast_ *node)
 {
+  value_ left_val = value_error();
+  value_ right_val;
 
-  ast_ *left_val = NULL;
-  ast_ *right_val = NULL;
-
-  if (strcmp(node->op, "NOT") != 0)
+  // Process the left side, if not null
+  if (node->left != NULL)
   {
-    left_val = interpreter_process(interpreter, node->left);
-    right_val = interpreter_process(interpreter, node->right);
+    left_val = interpreter_evaluate(interpreter, node->left);
+  }
 
-    // Ensure both values are not null before proceeding
-    if ((left_val->type == AST_INTEGER && left_val->int_value.null == 1) ||
-        (right_val->type == AST_INTEGER && right_val->int_value.null == 1) ||
-        (left_val->type == AST_REAL && left_val->real_value.null == 1) ||
-        (right_val->type == AST_REAL && right_val->real_value.null == 1) ||
-        (left_val->type == AST_CHARACTER && left_val->char_value.null == 1) ||
-        (right_val->type == AST_CHARACTER && right_val->char_value.null == 1) ||
-        (left_val->type == AST_STRING && left_val->string_value == NULL) ||
-        (right_val->type == AST_STRING && right_val->string_value == NULL))
-    {
-      fprintf(stderr, "Interpreter Error: Null value in boolean expression\n");
-      return NULL;
-    }
+  // Process the right side, which should always exist
+  right_val = interpreter_evaluate(interpreter, node->right);
 
-    // Ensure both sides are of comparable types (int, real, char, string)
-    if (left_val->type != right_val->type)
-    {
-      fprintf(stderr, "Interpreter Error: Type mismatch in boolean expression\n");
-      return NULL;
-    }
-  }
-  else
+  return interpreter_apply_operation(node, left_val, right_val);
+}
+
+// Type of the value an operator gives for operands of the given types, or AST_NOOP when the dispatch tables have no
+// entry for them and it would report a type error; `left` is ignored for unary operators.
+enum ast_type interpreter_operation_type(ast_ *node, enum ast_type left, enum ast_type right)
+{
+  if (node->operator <= OP_NONE || node->operator > OP_NOT || right >= OPERAND_TYPES ||
+      (node->left != NULL && left >= OPERAND_TYPES))
+    return AST_NOOP;
+
+  if (node->left == NULL)
   {
-    // Evaluate only the right side for 'NOT' operation
-    right_val = interpreter_process(interpreter, node->right);
-    if ((right_val->type == AST_INTEGER && right_val->int_value.null == 1) ||
-        (right_val->type == AST_REAL && right_val->real_value.null == 1) ||
-        (right_val->type == AST_CHARACTER && right_val->char_value.null == 1) ||
-        (right_val->type == AST_STRING && right_val->string_value == NULL))
-    {
-      fprintf(stderr, "Interpreter Error: Null value in boolean expression\n");
-      return NULL;
-    }
+    if (unary_operations[node->operator][right] == NULL)
+      return AST_NOOP;
+    return node->operator == OP_NOT ? AST_BOOLEAN : right;
   }
 
-  ast_ *result = init_ast(AST_BOOLEAN);
+  binary_operation_ operation = binary_operations[node->operator][left][right];
+  if (operation == NULL)
+    return AST_NOOP;
+  if (operation == concatenate)
+    return AST_STRING;
+  return node->operator >= OP_LESS ? AST_BOOLEAN : left; // Comparisons and logical operators give booleans
+}
 
-  // Handle logical operations 'AND' and 'OR'
-  if (strcmp(node->op, "AND") == 0)
+// Applies an operator to operands that have already been evaluated; `left_val` is ignored for unary operators.
+value_ interpreter_apply_operation(ast_ *node, value_ left_val, value_ right_val)
+{
+  // Operands the inference pass proved are set and of types the operator accepts go straight to the operation
+  if (node->proven != AST_COMPOUND)
   {
-    result->boolean_value.value = (left_val->boolean_value.value && right_val->boolean_value.value);
+    return node->left == NULL ? unary_operations[node->operator][right_val.type](right_val)
+                              : binary_operations[node->operator][left_val.type][right_val.type](left_val, right_val);
   }
-  else if (strcmp(node->op, "OR") == 0)
+
+  // An operand that failed to evaluate has already reported its error
+  if ((node->left != NULL && value_is_error(left_val)) || value_is_error(right_val))
   {
-    result->boolean_value.value = (left_val->boolean_value.value || right_val->boolean_value.value);
+    return value_error();
   }
-  else if (strcmp(node->op, "NOT") == 0)
+
+  // Check for null values before proceeding
+  if ((node->left != NULL && VALUE_IS_NULL(left_val)) || VALUE_IS_NULL(right_val))
   {
-    result->boolean_value.value = !right_val->boolean_value.value;
+    fprintf(stderr, "Interpreter Error: Null value in %s expression\n",
+            node->type == AST_BOOLEAN_EXPRESSION ? "boolean" : "arithmetic");
+    return value_error();
   }
-  // Handle comparisons for int and real
-  else if (left_val->type == AST_INTEGER || left_val->type == AST_REAL)
-  {
-    double left_num = (left_val->type == AST_INTEGER) ? left_val->int_value.value : left_val->real_value.value;
-    double right_num = (right_val->type == AST_INTEGER) ? right_val->int_value.value : right_val->real_value.value;
 
-    if (strcmp(node->op, "<") == 0)
-      result->boolean_value.value = left_num < right_num;
-    else if (strcmp(node->op, ">") == 0)
-      result->boolean_value.value = left_num > right_num;
-    else if (strcmp(node->op, "<=") == 0)
-      result->boolean_value.value = left_num <= right_num;
-    else if (strcmp(node->op, ">=") == 0)
-      result->boolean_value.value = left_num >= right_num;
-    else if (strcmp(node->op, "=") == 0)
-      result->boolean_value.value = left_num == right_num;
-    else if (strcmp(node->op, "!=") == 0)
-      result->boolean_value.value = left_num != right_num;
-    else
-    {
-      fprintf(stderr, "Interpreter Error: Invalid boolean operation: %s\n", node->op);
-      return NULL;
-    }
-  }
-  // Handle comparisons for char (based on ASCII values)
-  else if (left_val->type == AST_CHARACTER)
-  {
-    char left_char = left_val->char_value.value;
-    char right_char = right_val->char_value.value;
-
-    if (strcmp(node->op, "<") == 0)
-      result->boolean_value.value = left_char < right_char;
-    else if (strcmp(node->op, ">") == 0)
-      result->boolean_value.value = left_char > right_char;
-    else if (strcmp(node->op, "<=") == 0)
-      result->boolean_value.value = left_char <= right_char;
-    else if (strcmp(node->op, ">=") == 0)
-      result->boolean_value.value = left_char >= right_char;
-    else if (strcmp(node->op, "=") == 0)
-      result->boolean_value.value = left_char == right_char;
-    else if (strcmp(node->op, "!=") == 0)
-      result->boolean_value.value = left_char != right_char;
-    else
-    {
-      fprintf(stderr, "Interpreter Error: Invalid boolean operation: %s\n", node->op);
-      return NULL;
-    }
-  }
-  // Handle comparisons for strings (lexicographical comparison)
-  else if (left_val->type == AST_STRING)
-  {
-    int cmp_result = strcmp(left_val->string_value, right_val->string_value);
-
-    if (strcmp(node->op, "<") == 0)
-      result->boolean_value.value = cmp_result < 0;
-    else if (strcmp(node->op, ">") == 0)
-      result->boolean_value.value = cmp_result > 0;
-    else if (strcmp(node->op, "<=") == 0)
-      result->boolean_value.value = cmp_result <= 0;
-    else if (strcmp(node->op, ">=") == 0)
-      result->boolean_value.value = cmp_result >= 0;
-    else if (strcmp(node->op, "=") == 0)
-      result->boolean_value.value = cmp_result == 0;
-    else if (strcmp(node->op, "!=") == 0)
-      result->boolean_value.value = cmp_result != 0;
-    else
-    {
-      fprintf(stderr, "Interpreter Error: Invalid boolean operation: %s\n", node->op);
-      return NULL;
-    }
+  if (node->operator <= OP_NONE || node->operator > OP_NOT || right_val.type >= OPERAND_TYPES ||
+      (node->left != NULL && left_val.type >= OPERAND_TYPES))
+  {
+    return operation_error(node, left_val, right_val);
   }
-  else
+
+  if (node->left == NULL)
   {
-    fprintf(stderr, "Interpreter Error: Unsupported type for boolean comparison\n");
-    return NULL;
+    unary_operation_ operation = unary_operations[node->operator][right_val.type];
+    return operation ? operation(right_val) : operation_error(node, left_val, right_val);
   }
 
-  result->boolean_value.null = 0;
-  return result;
+  binary_operation_ operation = binary_operations[node->operator][left_val.type][right_val.type];
+  return operation ? operation(left_val, right_val) : operation_error(node, left_val, right_val);
 }
 
 ast_ *interpreter_process_record_definition(interpreter_ *interpreter, ast_ *node)
 {
   scope_add_instantiation_definition(
-      get_scope(node),
+      interpreter->scope,
       node);
 
   return node;
@@ -1476,7 +1626,7 @@ ast_ *interpreter_process_record_definition(interpreter_ *interpreter, ast_ *nod
 ast_ *interpreter_process_subroutine(interpreter_ *interpreter, ast_ *node)
 {
   scope_add_instantiation_definition(
-      get_scope(node),
+      interpreter->scope,
       node);
 
   return node;
@@ -1485,13 +1635,13 @@ ast_ *interpreter_process_subroutine(interpreter_ *interpreter, ast_ *node)
 ast_ *interpreter_process_output(interpreter_ *interpreter, ast_ *node)
 {
   // Loop through each output expression
-  for (size_t i = 0; node->output_expressions[i] != NULL; i++)
+  for (size_t i = 0; i < node->output_expressions->size; i++)
   {
-    ast_ *expr = interpreter_process(interpreter, node->output_expressions[i]);
-    interpreter_output_literal(expr, interpreter);
+    value_ expr = interpreter_evaluate(interpreter, node->output_expressions->items[i]);
+    interpreter_output_value(expr, interpreter);
 
     // Print a space between expressions, but avoid trailing space after the last expression
-    if (node->output_expressions[i + 1] != NULL)
+    if (i + 1 < node->output_expressions->size)
     {
       printf(" ");
     }
@@ -1500,65 +1650,73 @@ ast_ *interpreter_process_output(interpreter_ *interpreter, ast_ *node)
   // After printing all expressions, add a newline
   printf("\n");
 
-  return init_ast(AST_NOOP);
+  return &interpreter_noop;
+}
+
+// Runs a loop's body with the loop's own scope as the environment, restoring the enclosing one afterwards
+static void interpreter_process_loop_body(interpreter_ *interpreter, ast_ *node, scope_ *local_scope)
+{
+  scope_ *enclosing_scope = interpreter->scope;
+  interpreter->scope = local_scope;
+
+  for (int i = 0; i < node->loop_body->size && !interpreter->returning; i++)
+  {
+    interpreter_process(interpreter, node->loop_body->items[i]);
+  }
+
+  interpreter->scope = enclosing_scope;
 }
 
 ast_ *interpreter_process_definite_loop(interpreter_ *interpreter, ast_ *node)
 {
+  // The loop variable is set through an assignment of the loop's own, never through the shared loop node, so a
+  // subroutine running this loop can recurse into it without the inner loop moving the outer one's counter
+  ast_ *loop_variable = init_ast(AST_ASSIGNMENT);
+  loop_variable->lhs = node->loop_variable->lhs;
+
   if (node->collection_expr != NULL)
   {
     // FOR-IN loop
     ast_ *collection = interpreter_process(interpreter, node->collection_expr);
 
-    // Store the original loop variable value (deep copy of the RHS)
-    ast_ *original_value = deep_copy(node->loop_variable->rhs);
-
     // Check if collection is either a string or an array
     if (collection->type == AST_STRING)
     {
       // Iterate over string characters
       int length = strlen(collection->string_value);
-      scope_ *local_scope = init_scope(node->scope, "child_scope");
+      scope_ *local_scope = init_scope(interpreter->scope, "child_scope");
+      scope_declare_layout(local_scope, node->layout);
 
-      for (int i = 0; i < length; i++)
+      for (int i = 0; i < length && !interpreter->returning; i++)
       {
         // Set loop variable to the current character
-        node->loop_variable->rhs = init_ast(AST_STRING);
-        node->loop_variable->rhs->string_value = (char *)malloc(2);
-        node->loop_variable->rhs->string_value[0] = collection->string_value[i];
-        node->loop_variable->rhs->string_value[1] = '\0'; // Null-terminate
+        loop_variable->rhs = init_ast(AST_STRING);
+        loop_variable->rhs->string_value = (char *)malloc(2);
+        loop_variable->rhs->string_value[0] = collection->string_value[i];
+        loop_variable->rhs->string_value[1] = '\0'; // Null-terminate
 
-        scope_add_variable_definition(local_scope, node->loop_variable);
+        scope_assign_variable(local_scope, loop_variable);
 
-        // Execute the loop body
-        for (int j = 0; node->loop_body[j] != NULL; j++)
-        {
-          ast_ *current_statement = node->loop_body[j];
-          set_scope(current_statement, local_scope);
-          interpreter_process(interpreter, current_statement);
-        }
+        interpreter_process_loop_body(interpreter, node, local_scope);
       }
+      free_scope(local_scope);
     }
     else if (collection->type == AST_ARRAY)
     {
       // Iterate over array elements
       int array_size = collection->array_size;
-      scope_ *local_scope = init_scope(node->scope, "child_scope");
+      scope_ *local_scope = init_scope(interpreter->scope, "child_scope");
+      scope_declare_layout(local_scope, node->layout);
 
-      for (int i = 0; i < array_size; i++)
+      for (int i = 0; i < array_size && !interpreter->returning; i++)
       {
         // Set loop variable to the current array element
-        node->loop_variable->rhs = collection->array_elements[i];
-        scope_add_variable_definition(local_scope, node->loop_variable);
+        loop_variable->rhs = collection->array_elements->items[i];
+        scope_assign_variable(local_scope, loop_variable);
 
-        // Execute the loop body
-        for (int j = 0; node->loop_body[j] != NULL; j++)
-        {
-          ast_ *current_statement = node->loop_body[j];
-          set_scope(current_statement, local_scope);
-          interpreter_process(interpreter, current_statement);
-        }
+        interpreter_process_loop_body(interpreter, node, local_scope);
       }
+      free_scope(local_scope);
     }
     else
     {
@@ -1566,99 +1724,94 @@ ast_ *interpreter_process_definite_loop(interpreter_ *interpreter, ast_ *node)
       return NULL;
     }
 
-    // Reset the loop variable to its original value
-    node->loop_variable->rhs = original_value;
-    scope_add_variable_definition(node->scope, node->loop_variable); // Update the scope with the reset value
+    // Reset the loop variable to its original (unset) value
+    ast_ *reset = init_ast(AST_ASSIGNMENT);
+    reset->lhs = node->loop_variable->lhs;
+    reset->rhs = node->loop_variable->rhs;
+    scope_add_variable_definition(interpreter->scope, reset); // Update the scope with the reset value
   }
   else
   {
     // FOR variable <- start TO end [STEP step] logic
 
     // Process the end expression
-    ast_ *end = interpreter_process(interpreter, node->end_expr);
-    if (end->type != AST_INTEGER || end->int_value.null == 1)
+    value_ end = interpreter_evaluate(interpreter, node->end_expr);
+    if (end.type != AST_INTEGER || end.null)
     {
       fprintf(stderr, "Interpreter Error: End expression could not be recognized as an integer\n");
       return NULL;
     }
 
     // Process the step expression, default to 1 if not specified
-    ast_ *step;
-    if (node->step_expr != NULL)
-    {
-      step = interpreter_process(interpreter, node->step_expr);
-    }
-    else
-    {
-      step = init_ast(AST_INTEGER);
-      step->int_value.value = 1;
-      step->int_value.null = 0;
-    }
+    value_ step = node->step_expr != NULL ? interpreter_evaluate(interpreter, node->step_expr) : value_integer(1);
 
-    if (step->type != AST_INTEGER || step->int_value.null == 1)
+    if (step.type != AST_INTEGER || step.null)
     {
       fprintf(stderr, "Interpreter Error: Step expression could not be recognized as an integer\n");
       return NULL;
     }
 
-    // Store the original loop variable value (deep copy)
-    ast_ *original_value = deep_copy(node->loop_variable->rhs);
+    // Evaluate the start expression into a node the loop can count with
+    value_ start = interpreter_evaluate(interpreter, node->loop_variable->rhs);
+    if (start.type != AST_INTEGER || start.null)
+    {
+      fprintf(stderr, "Interpreter Error: Start expression could not be recognized as an integer\n");
+      return NULL;
+    }
+    loop_variable->rhs = value_to_ast(start);
 
     // Initialize the local scope and the loop variable
-    scope_ *local_scope = init_scope(node->scope, "child_scope");
-    scope_add_variable_definition(local_scope, node->loop_variable);
+    scope_ *local_scope = init_scope(interpreter->scope, "child_scope");
+    scope_declare_layout(local_scope, node->layout);
+    scope_assign_variable(local_scope, loop_variable);
 
     // Loop based on the step direction (positive or negative)
-    while ((step->int_value.value > 0 && node->loop_variable->rhs->int_value.value <= end->int_value.value) ||
-           (step->int_value.value < 0 && node->loop_variable->rhs->int_value.value >= end->int_value.value))
+    while ((step.int_value > 0 && loop_variable->rhs->int_value.value <= end.int_value) ||
+           (step.int_value < 0 && loop_variable->rhs->int_value.value >= end.int_value))
     {
-      // Execute the loop body
-      for (int i = 0; node->loop_body[i] != NULL; i++)
-      {
-        ast_ *current_statement = node->loop_body[i];
-        set_scope(current_statement, local_scope);
-        interpreter_process(interpreter, current_statement);
-      }
+      interpreter_process_loop_body(interpreter, node, local_scope);
+      if (interpreter->returning)
+        break;
 
       // Increment (or decrement) the loop variable by the step value
-      node->loop_variable->rhs->int_value.value += step->int_value.value;
-      scope_add_variable_definition(local_scope, node->loop_variable);
+      loop_variable->rhs->int_value.value += step.int_value;
+      scope_assign_variable(local_scope, loop_variable);
     }
+    free_scope(local_scope);
 
-    // Reset the loop variable to its original value
-    node->loop_variable->rhs = original_value;
-    scope_add_variable_definition(node->scope, node->loop_variable); // Update the scope with the reset value
+    // Reset the loop variable to its start value
+    ast_ *reset = init_ast(AST_ASSIGNMENT);
+    reset->lhs = node->loop_variable->lhs;
+    reset->rhs = value_to_ast(start);
+    scope_add_variable_definition(interpreter->scope, reset); // Update the scope with the reset value
   }
 
-  return init_ast(AST_NOOP); // Return a NOOP after loop execution
+  return &interpreter_noop; // Return a NOOP after loop execution
 }
 
 ast_ *interpreter_process_indefinite_loop(interpreter_ *interpreter, ast_ *node)
 {
   // Initialize the local scope
-  scope_ *local_scope = init_scope(node->scope, "child_scope");
+  scope_ *local_scope = init_scope(interpreter->scope, "child_scope");
+  scope_declare_layout(local_scope, node->layout);
 
   if (node->indefinite_loop_type == 1) // WHILE loop
   {
     // Evaluate the condition
-    ast_ *condition = interpreter_process(interpreter, node->condition);
-    if (condition->type != AST_BOOLEAN || condition->boolean_value.null == 1)
+    value_ condition = interpreter_evaluate(interpreter, node->condition);
+    if (condition.type != AST_BOOLEAN || condition.null)
     {
       fprintf(stderr, "Interpreter Error: Condition could not be evaluated to an integer\n");
       return NULL;
     }
-    while ((condition->boolean_value.value))
+    while (condition.boolean_value)
     {
-      // Process the loop body
-      for (int i = 0; node->loop_body[i] != NULL; i++)
-      {
-        ast_ *current_statement = node->loop_body[i];
-        set_scope(current_statement, local_scope);
-        interpreter_process(interpreter, current_statement);
-      }
+      interpreter_process_loop_body(interpreter, node, local_scope);
+      if (interpreter->returning)
+        break;
 
-      condition = interpreter_process(interpreter, node->condition);
-      if (condition->type != AST_BOOLEAN || condition->boolean_value.null == 1)
+      condition = interpreter_evaluate(interpreter, node->condition);
+      if (condition.type != AST_BOOLEAN || condition.null)
       {
         fprintf(stderr, "Interpreter Error: Condition could not be evaluated to an integer\n");
         return NULL;
@@ -1668,8 +1821,8 @@ ast_ *interpreter_process_indefinite_loop(interpreter_ *interpreter, ast_ *node)
   else if (node->indefinite_loop_type == 0) // REPEAT loop
   {
     // Evaluate the condition
-    ast_ *condition = interpreter_process(interpreter, node->condition);
-    if (condition->type != AST_BOOLEAN || condition->boolean_value.null == 1)
+    value_ condition = interpreter_evaluate(interpreter, node->condition);
+    if (condition.type != AST_BOOLEAN || condition.null)
     {
       fprintf(stderr, "Interpreter Error: Condition could not be evaluated to an integer\n");
       return NULL;
@@ -1677,26 +1830,23 @@ ast_ *interpreter_process_indefinite_loop(interpreter_ *interpreter, ast_ *node)
 
     do
     {
-      // Process the loop body
-      for (int i = 0; node->loop_body[i] != NULL; i++)
-      {
-        ast_ *current_statement = node->loop_body[i];
-        set_scope(current_statement, local_scope);
-        interpreter_process(interpreter, current_statement);
-      }
+      interpreter_process_loop_body(interpreter, node, local_scope);
+      if (interpreter->returning)
+        break;
 
-      condition = interpreter_process(interpreter, node->condition);
-      if (condition->type != AST_BOOLEAN || condition->boolean_value.null == 1)
+      condition = interpreter_evaluate(interpreter, node->condition);
+      if (condition.type != AST_BOOLEAN || condition.null)
       {
         fprintf(stderr, "Interpreter Error: Condition could not be evaluated to an integer\n");
         return NULL;
       }
 
       // Negate the condition to determine whether to repeat the loop
-    } while (!(condition->boolean_value.value));
+    } while (!condition.boolean_value);
   }
 
-  return init_ast(AST_NOOP);
+  free_scope(local_scope);
+  return &interpreter_noop;
 }
 
 ast_ *interpreter_process_selection(interpreter_ *interpreter, ast_ *node)
@@ -1710,20 +1860,20 @@ ast_ *interpreter_process_selection(interpreter_ *interpreter, ast_ *node)
   }
 
   // Process the IF condition
-  ast_ *if_condition = interpreter_process(interpreter, node->if_condition);
-  if (if_condition->type != AST_BOOLEAN || if_condition->boolean_value.null == 1)
+  value_ if_condition = interpreter_evaluate(interpreter, node->if_condition);
+  if (if_condition.type != AST_BOOLEAN || if_condition.null)
   {
     fprintf(stderr, "Interpreter Error: IF condition could not be evaluated to a boolean\n");
     return NULL;
   }
 
   // If the IF condition is true, execute the IF body
-  if (if_condition->boolean_value.value)
+  if (if_condition.boolean_value)
   {
     condition_matched = 1; // Mark that a condition has been met
-    for (int i = 0; node->if_body[i] != NULL; i++)
+    for (int i = 0; i < node->if_body->size && !interpreter->returning; i++)
     {
-      ast_ *current_statement = node->if_body[i];
+      ast_ *current_statement = node->if_body->items[i];
       interpreter_process(interpreter, current_statement);
     }
   }
@@ -1731,45 +1881,68 @@ ast_ *interpreter_process_selection(interpreter_ *interpreter, ast_ *node)
   // Process the ELSE IF conditions and bodies if no IF condition was matched
   if (!condition_matched && node->else_if_conditions != NULL && node->else_if_bodies != NULL)
   {
-    int k = 0;
-    while (node->else_if_conditions[k] != NULL && node->else_if_bodies[k] != NULL)
+    for (int k = 0; k < node->else_if_conditions->size; k++)
     {
       // Evaluate the ELSE IF condition
-      ast_ *else_if_condition = interpreter_process(interpreter, node->else_if_conditions[k]);
-      if (else_if_condition->type != AST_BOOLEAN || else_if_condition->boolean_value.null == 1)
+      value_ else_if_condition = interpreter_evaluate(interpreter, node->else_if_conditions->items[k]);
+      if (else_if_condition.type != AST_BOOLEAN || else_if_condition.null)
       {
         fprintf(stderr, "Interpreter Error: ELSE IF condition could not be evaluated to a boolean\n");
         return NULL;
       }
 
       // If the ELSE IF condition is true, execute the ELSE IF body
-      if (else_if_condition->boolean_value.value)
+      if (else_if_condition.boolean_value)
       {
         condition_matched = 1; // Mark that a condition has been met
-        for (int j = 0; node->else_if_bodies[k][j] != NULL; j++)
+        for (int j = 0; j < node->else_if_bodies[k]->size && !interpreter->returning; j++)
         {
-          ast_ *current_statement = node->else_if_bodies[k][j];
+          ast_ *current_statement = node->else_if_bodies[k]->items[j];
           interpreter_process(interpreter, current_statement);
         }
         break; // Stop checking other ELSE IFs after a match
       }
-
-      k++; // Move to the next ELSE IF condition-body pair
     }
   }
 
   // Process the ELSE body if no IF or ELSE IF conditions were true
   if (!condition_matched && node->else_body != NULL)
   {
-    for (int l = 0; node->else_body[l] != NULL; l++)
+    for (int l = 0; l < node->else_body->size && !interpreter->returning; l++)
     {
-      ast_ *current_statement = node->else_body[l];
+      ast_ *current_statement = node->else_body->items[l];
       interpreter_process(interpreter, current_statement);
     }
   }
 
   // Do not return early, allowing the loop to continue processing
-  return init_ast(AST_NOOP);
+  return &interpreter_noop;
+}
+
+// Ends the running subroutine call, however deep in loops and selections the RETURN is. `RETURN f(...)` calling a
+// subroutine is a tail call: its arguments are evaluated here and the call runs f next, in place of a nested call.
+ast_ *interpreter_process_return(interpreter_ *interpreter, ast_ *node)
+{
+  interpreter_call_ *call = interpreter->call;
+  ast_ *value = node->return_value;
+  ast_ *target = interpreter_called_subroutine(interpreter, value);
+
+  if (target == NULL)
+  {
+    call->result = interpreter_process(interpreter, value);
+  }
+  else if (interpreter_evaluate_arguments(interpreter, call, value))
+  {
+    call->definition = target;
+    call->tail_call = value;
+  }
+  else
+  {
+    call->result = NULL;
+  }
+
+  interpreter->returning = 1;
+  return &interpreter_noop;
 }
 
 ast_ *interpreter_process_exit(interpreter_ *interpreter, ast_ *node)
@@ -22,10 +22,13 @@ char *get_file_contents(const char *filepath)
     length = ftell(file);
     fseek(file, 0, SEEK_SET);
 
-    buffer = calloc(length, length);
+    buffer = calloc(length + 1, 1); // One extra byte keeps the contents NUL-terminated
 
-    if (buffer)
-      fread(buffer, 1, length, file);
+    if (buffer == NULL || fread(buffer, 1, length, file) != (size_t)length)
+    {
+      printf("Error reading file %s\n", filepath);
+      exit(2);
+    }
 
     fclose(file);
     return buffer;
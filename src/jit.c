@@ -0,0 +1,1491 @@
+#include "include/jit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if JIT_AVAILABLE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// The JIT compiles the VM's bytecode for hot loops and subroutines to x86-64 machine code. A loop is compiled from
+// its first instruction to its back edge and works on the frame's registers in place, so it can stop before any
+// instruction and hand the VM a frame to carry on with: an instruction the JIT leaves to the VM, or a jump out of the
+// loop, returns the instruction to continue at. A subroutine is compiled whole, keeps its registers as plain integers
+// on the C stack and only computes, so a call it can't finish is simply made again by the VM.
+//
+// Compiled code only ever holds Integers and Booleans. The registers a loop reads before assigning are checked once
+// as it is entered and a subroutine's arguments as it is called; the type of every other register follows from the
+// instructions that assign it. Code that reads anything else isn't compiled.
+
+jit_ *init_jit(vm_ *vm)
+{
+#if !JIT_AVAILABLE
+  fprintf(stderr, "Warning: The JIT needs x86-64 Linux; running the VM without it.\n");
+  return NULL;
+#else
+  jit_ *jit = calloc(1, sizeof(struct JIT_STRUCT));
+  if (jit != NULL)
+    jit->functions = calloc(vm->function_count, sizeof(jit_function_ *));
+  if (jit == NULL || jit->functions == NULL)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for the JIT.\n");
+    exit(EXIT_FAILURE);
+  }
+  jit->vm = vm;
+
+  for (int i = 0; i < vm->function_count; i++)
+  {
+    jit_function_ *compiled = calloc(1, sizeof(struct JIT_FUNCTION_STRUCT));
+    if (compiled != NULL)
+    {
+      compiled->passes = calloc(vm->functions[i]->code_size, sizeof(int));
+      compiled->loops = calloc(vm->functions[i]->code_size, sizeof(jit_region_ *));
+    }
+    if (compiled == NULL || compiled->passes == NULL || compiled->loops == NULL)
+    {
+      fprintf(stderr, "Error: Memory allocation failed for the JIT.\n");
+      exit(EXIT_FAILURE);
+    }
+    jit->functions[i] = vm->functions[i]->jit = compiled;
+  }
+  return jit;
+#endif
+}
+
+static jit_region_ *jit_add_region(jit_ *jit, vm_function_ *function, int first, int last, int subroutine,
+                                   ast_ *node)
+{
+  if (jit->region_count == jit->region_capacity)
+  {
+    jit->region_capacity = jit->region_capacity ? jit->region_capacity * 2 : 8;
+    jit->regions = realloc(jit->regions, jit->region_capacity * sizeof(jit_region_ *));
+  }
+  jit_region_ *region = jit->regions != NULL ? calloc(1, sizeof(struct JIT_REGION_STRUCT)) : NULL;
+  if (region == NULL)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for the JIT.\n");
+    exit(EXIT_FAILURE);
+  }
+  region->function = function;
+  region->node = node;
+  region->first = first;
+  region->last = last;
+  region->subroutine = subroutine;
+  jit->regions[jit->region_count++] = region;
+  return region;
+}
+
+// Calls compiled code may nest before handing back: the calls the VM has left, as far as the C stack allows
+static int64_t jit_budget(jit_ *jit)
+{
+  interpreter_ *interpreter = jit->vm->interpreter;
+  int64_t budget = (int64_t)interpreter->max_call_depth - interpreter->call_depth;
+  return budget < JIT_MAX_NATIVE_DEPTH ? budget : JIT_MAX_NATIVE_DEPTH;
+}
+
+int jit_run_loop(jit_ *jit, jit_region_ *region, value_ *registers)
+{
+  region->entries++;
+  int next = ((jit_loop_code_)region->code)(registers, jit_budget(jit));
+  if (next < 0)
+    region->failures++;
+  return next;
+}
+
+int jit_call(jit_ *jit, vm_function_ *function, const value_ *arguments, int count, value_ *result)
+{
+  jit_function_ *compiled = function->jit;
+  int64_t values[count > 0 ? count : 1];
+  for (int i = 0; i < count; i++)
+  {
+    if (arguments[i].type != AST_INTEGER || arguments[i].null)
+      return 0;
+    values[i] = arguments[i].int_value;
+  }
+
+  int64_t value;
+  compiled->region->entries++;
+  if (!compiled->native(values, jit_budget(jit), &value))
+  {
+    if (++compiled->region->failures >= JIT_MAX_BAILS)
+      compiled->native = NULL;
+    return 0;
+  }
+
+  if (compiled->returns == AST_BOOLEAN)
+    *result = (value_){.type = AST_BOOLEAN, .boolean_value = (int)value};
+  else
+    *result = (value_){.type = AST_INTEGER, .int_value = value};
+  return 1;
+}
+
+#if JIT_AVAILABLE
+
+// OUTPUT from compiled code, as the VM prints it
+static void jit_output(interpreter_ *interpreter, const value_ *value, int newline)
+{
+  if (value != NULL)
+    interpreter_output_value(*value, interpreter);
+  putchar(newline ? '\n' : ' ');
+}
+
+// What the analysis knows of a register: its type, and whether it may still hold the value a loop was entered with
+#define JIT_OTHER 0 // Anything else, an unset register included; compiled code never reads it
+#define JIT_INTEGER 1
+#define JIT_BOOLEAN 2
+#define JIT_EITHER 3 // Reads that take either type
+#define JIT_ENTRY 4
+#define JIT_TYPE(state) ((state) & 3)
+
+// How compiled code treats an instruction
+enum
+{
+  JIT_REJECT, // The region can't be compiled
+  JIT_NATIVE, // Run as machine code
+  JIT_EXIT,   // Left to the VM, which the region hands back to before it
+};
+
+// Jump targets other than an instruction: handing back without finishing, returning what is in RAX, and leaving a
+// loop before instruction i (-3 - i), which the VM then runs
+#define JIT_GIVE_BACK -1
+#define JIT_FINISH -2
+#define JIT_EXIT_AT(index) (-3 - (index))
+
+typedef struct JIT_PATCH_STRUCT
+{
+  size_t at;  // Offset of the 32-bit displacement to fill in
+  int target; // Instruction jumped to, or one of the targets above
+} jit_patch_;
+
+typedef struct JIT_COMPILER_STRUCT
+{
+  jit_ *jit;
+  jit_region_ *region;
+  vm_function_ *function;
+  int first, last;
+  int subroutine;
+  int registers;          // Registers the analysis tracks; those after them hold the function's constants
+  enum ast_type returns;  // Type a subroutine is compiled to return
+  int returns_other;      // Whether a RETURN gives the other type, so compiling for that might work
+  unsigned char *states;  // Type of each register before each instruction
+  unsigned char *reached; // Whether each instruction can run
+  unsigned char *guards;  // Type each register is checked for as a loop is entered, JIT_OTHER if it isn't
+  int scratch;            // Slots of the C stack frame for calls' arguments and results
+  unsigned char *bytes;   // Machine code
+  size_t size;
+  size_t capacity;
+  int *labels; // Offset of each instruction's code, or -1
+  int *exits;  // Offset of the code leaving the loop for each instruction, or -1
+  int give_back;
+  int epilogue;
+  jit_patch_ *patches;
+  int patch_count;
+  int patch_capacity;
+} jit_compiler_;
+
+// Machine registers, by their encoding
+enum
+{
+  RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+  R8, R9, R10, R11, R12, R13, R14, R15,
+};
+
+// Condition codes; flipping the lowest bit negates one
+enum
+{
+  CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7,
+  CC_S = 0x8, CC_NS = 0x9, CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF,
+};
+
+#define JIT_JMP -1 // Condition code of an unconditional jump
+
+static void jit_byte(jit_compiler_ *c, unsigned char byte)
+{
+  if (c->size == c->capacity)
+  {
+    c->capacity = c->capacity ? c->capacity * 2 : 1024;
+    c->bytes = realloc(c->bytes, c->capacity);
+    if (!c->bytes)
+    {
+      fprintf(stderr, "Error: Memory allocation failed for the JIT.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  c->bytes[c->size++] = byte;
+}
+
+static void jit_int32(jit_compiler_ *c, int32_t value)
+{
+  for (int i = 0; i < 4; i++)
+    jit_byte(c, (unsigned char)((uint32_t)value >> (8 * i)));
+}
+
+static void jit_int64(jit_compiler_ *c, int64_t value)
+{
+  for (int i = 0; i < 8; i++)
+    jit_byte(c, (unsigned char)((uint64_t)value >> (8 * i)));
+}
+
+// REX prefix for an instruction whose ModRM reg field is `reg` and r/m field `rm`, left out when it adds nothing
+static void jit_rex(jit_compiler_ *c, int wide, int reg, int rm)
+{
+  unsigned char rex = 0x40 | (wide ? 8 : 0) | (reg & 8 ? 4 : 0) | (rm & 8 ? 1 : 0);
+  if (rex != 0x40)
+    jit_byte(c, rex);
+}
+
+// ModRM for [base + displacement]
+static void jit_address(jit_compiler_ *c, int reg, int base, int32_t displacement)
+{
+  jit_byte(c, 0x80 | (reg & 7) << 3 | (base & 7));
+  if ((base & 7) == RSP)
+    jit_byte(c, 0x24);
+  jit_int32(c, displacement);
+}
+
+// ModRM for a register operand
+static void jit_direct(jit_compiler_ *c, int reg, int rm)
+{
+  jit_byte(c, 0xC0 | (reg & 7) << 3 | (rm & 7));
+}
+
+// mov reg, [base + displacement]; 32 bits wide (zero-extended) unless `wide`
+static void jit_load(jit_compiler_ *c, int wide, int reg, int base, int32_t displacement)
+{
+  jit_rex(c, wide, reg, base);
+  jit_byte(c, 0x8B);
+  jit_address(c, reg, base, displacement);
+}
+
+// mov [base + displacement], reg
+static void jit_store(jit_compiler_ *c, int reg, int base, int32_t displacement)
+{
+  jit_rex(c, 1, reg, base);
+  jit_byte(c, 0x89);
+  jit_address(c, reg, base, displacement);
+}
+
+// mov qword [base + displacement], immediate
+static void jit_store_immediate(jit_compiler_ *c, int base, int32_t displacement, int32_t immediate)
+{
+  jit_rex(c, 1, 0, base);
+  jit_byte(c, 0xC7);
+  jit_address(c, 0, base, displacement);
+  jit_int32(c, immediate);
+}
+
+// mov reg, immediate
+static void jit_move_immediate(jit_compiler_ *c, int reg, int64_t immediate)
+{
+  jit_rex(c, 1, 0, reg);
+  if (immediate == (int32_t)immediate)
+  {
+    jit_byte(c, 0xC7);
+    jit_direct(c, 0, reg);
+    jit_int32(c, (int32_t)immediate);
+  }
+  else
+  {
+    jit_byte(c, 0xB8 | (reg & 7));
+    jit_int64(c, immediate);
+  }
+}
+
+// An ALU instruction `opcode` on two registers (add 0x01, sub 0x29, and 0x21, or 0x09, cmp 0x39, test 0x85,
+// mov 0x89), 32 bits wide unless `wide`
+static void jit_arithmetic(jit_compiler_ *c, int wide, unsigned char opcode, int destination, int source)
+{
+  jit_rex(c, wide, source, destination);
+  jit_byte(c, opcode);
+  jit_direct(c, source, destination);
+}
+
+// An ALU instruction on a register and an immediate (add /0, sub /5, cmp /7)
+static void jit_arithmetic_immediate(jit_compiler_ *c, int operation, int reg, int32_t immediate)
+{
+  jit_rex(c, 1, 0, reg);
+  jit_byte(c, 0x81);
+  jit_direct(c, operation, reg);
+  jit_int32(c, immediate);
+}
+
+// lea reg, [base + displacement]
+static void jit_lea(jit_compiler_ *c, int reg, int base, int32_t displacement)
+{
+  jit_rex(c, 1, reg, base);
+  jit_byte(c, 0x8D);
+  jit_address(c, reg, base, displacement);
+}
+
+static void jit_push(jit_compiler_ *c, int reg)
+{
+  jit_rex(c, 0, 0, reg);
+  jit_byte(c, 0x50 | (reg & 7));
+}
+
+static void jit_pop(jit_compiler_ *c, int reg)
+{
+  jit_rex(c, 0, 0, reg);
+  jit_byte(c, 0x58 | (reg & 7));
+}
+
+// setcc on the low byte of reg (RAX to RBX), zero-extended to the whole register
+static void jit_set(jit_compiler_ *c, int condition, int reg)
+{
+  jit_byte(c, 0x0F);
+  jit_byte(c, 0x90 | condition);
+  jit_direct(c, 0, reg);
+  jit_byte(c, 0x0F);
+  jit_byte(c, 0xB6);
+  jit_direct(c, reg, reg);
+}
+
+// Calls a C function, with its arguments already in place
+static void jit_call_function(jit_compiler_ *c, void *function)
+{
+  jit_move_immediate(c, RAX, (int64_t)(intptr_t)function);
+  jit_byte(c, 0xFF);
+  jit_direct(c, 2, RAX);
+}
+
+// Jumps (JIT_JMP) or branches on a condition to a target filled in once the code is laid out
+static void jit_jump(jit_compiler_ *c, int condition, int target)
+{
+  if (condition == JIT_JMP)
+  {
+    jit_byte(c, 0xE9);
+  }
+  else
+  {
+    jit_byte(c, 0x0F);
+    jit_byte(c, 0x80 | condition);
+  }
+
+  if (c->patch_count == c->patch_capacity)
+  {
+    c->patch_capacity = c->patch_capacity ? c->patch_capacity * 2 : 64;
+    c->patches = realloc(c->patches, c->patch_capacity * sizeof(jit_patch_));
+    if (!c->patches)
+    {
+      fprintf(stderr, "Error: Memory allocation failed for the JIT.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  c->patches[c->patch_count++] = (jit_patch_){c->size, target};
+  jit_int32(c, 0);
+}
+
+// A short jump forward within an instruction's code, returning where to land it
+static size_t jit_skip(jit_compiler_ *c, int condition)
+{
+  jit_byte(c, condition == JIT_JMP ? 0xEB : 0x70 | condition);
+  jit_byte(c, 0);
+  return c->size - 1;
+}
+
+static void jit_land(jit_compiler_ *c, size_t skip)
+{
+  c->bytes[skip] = (unsigned char)(c->size - skip - 1);
+}
+
+// Where a compiled instruction goes when it can't finish: a loop leaves before it for the VM to run, a subroutine
+// hands the whole call back
+static int jit_give_up(jit_compiler_ *c, int index)
+{
+  return c->subroutine ? JIT_GIVE_BACK : JIT_EXIT_AT(index);
+}
+
+static int jit_is_constant(jit_compiler_ *c, int reg)
+{
+  return reg >= c->registers;
+}
+
+static value_ jit_constant(jit_compiler_ *c, int reg)
+{
+  return c->function->constants[reg - c->registers];
+}
+
+// Loads operand `reg` of the given type into a machine register: constants as immediates, registers from a loop's
+// frame (16-byte values) or a subroutine's (plain integers)
+static void jit_operand(jit_compiler_ *c, int machine, int reg, int type)
+{
+  if (jit_is_constant(c, reg))
+  {
+    value_ value = jit_constant(c, reg);
+    jit_move_immediate(c, machine, value.type == AST_BOOLEAN ? value.boolean_value != 0 : value.int_value);
+  }
+  else if (c->subroutine)
+  {
+    jit_load(c, 1, machine, RBX, 8 * reg);
+  }
+  else
+  {
+    // A Boolean's value is an int, so the rest of the union may be anything
+    jit_load(c, type != JIT_BOOLEAN, machine, RBX, 16 * reg + 8);
+  }
+}
+
+// Stores a machine register into register `reg` as a value of the given type
+static void jit_result(jit_compiler_ *c, int machine, int reg, int type)
+{
+  if (c->subroutine)
+  {
+    jit_store(c, machine, RBX, 8 * reg);
+    return;
+  }
+  jit_store_immediate(c, RBX, 16 * reg, type == JIT_BOOLEAN ? AST_BOOLEAN : AST_INTEGER); // Not null
+  jit_store(c, machine, RBX, 16 * reg + 8);
+}
+
+static int jit_constant_type(jit_compiler_ *c, int reg)
+{
+  value_ value = jit_constant(c, reg);
+  if (value.type == AST_INTEGER && !value.null)
+    return JIT_INTEGER;
+  if (value.type == AST_BOOLEAN && !value.null)
+    return JIT_BOOLEAN;
+  return JIT_OTHER;
+}
+
+static unsigned char *jit_state(jit_compiler_ *c, int index)
+{
+  return c->states + (size_t)(index - c->first) * c->registers;
+}
+
+static int jit_in_region(jit_compiler_ *c, int index)
+{
+  return index >= c->first && index <= c->last;
+}
+
+static jit_function_ *jit_callee(jit_compiler_ *c, const vm_instruction_ *instruction)
+{
+  return c->jit->functions[instruction->d];
+}
+
+static int jit_type_of(enum ast_type type)
+{
+  return type == AST_BOOLEAN ? JIT_BOOLEAN : JIT_INTEGER;
+}
+
+static int jit_kind(jit_compiler_ *c, const vm_instruction_ *instruction)
+{
+  switch (instruction->opcode)
+  {
+  case VM_MOVE:
+  case VM_CLEAR:
+  case VM_ADD:
+  case VM_SUBTRACT:
+  case VM_MULTIPLY:
+  case VM_DIVIDE:
+  case VM_MODULO:
+  case VM_POWER:
+  case VM_OPERATE:
+  case VM_LESS:
+  case VM_LESS_EQUAL:
+  case VM_GREATER:
+  case VM_GREATER_EQUAL:
+  case VM_EQUAL:
+  case VM_NOT_EQUAL:
+  case VM_JUMP:
+  case VM_TEST:
+  case VM_BRANCH_LESS:
+  case VM_BRANCH_LESS_EQUAL:
+  case VM_BRANCH_GREATER:
+  case VM_BRANCH_GREATER_EQUAL:
+  case VM_BRANCH_EQUAL:
+  case VM_BRANCH_NOT_EQUAL:
+  case VM_CHECK_INTEGER:
+  case VM_FOR_TEST:
+  case VM_FOR_LOOP:
+  case VM_CHECK_ARGUMENT:
+  case VM_CALL:
+    return JIT_NATIVE;
+  case VM_OUTPUT:
+    return c->subroutine ? JIT_REJECT : JIT_NATIVE;
+  case VM_RETURN:
+  case VM_RETURN_NONE:
+  case VM_TAIL_CALL:
+    return c->subroutine ? JIT_NATIVE : JIT_EXIT;
+  case VM_UNCAUGHT:
+  case VM_EXIT:
+  case VM_HALT:
+    return c->subroutine ? JIT_REJECT : JIT_EXIT;
+  default:
+    return JIT_REJECT;
+  }
+}
+
+// Instructions that can run next, inside the region or not; returns how many
+static int jit_successors(jit_compiler_ *c, int index, int *targets)
+{
+  const vm_instruction_ *instruction = &c->function->code[index];
+  if (jit_kind(c, instruction) != JIT_NATIVE)
+    return 0;
+
+  switch (instruction->opcode)
+  {
+  case VM_JUMP:
+    targets[0] = instruction->a;
+    return 1;
+  case VM_TEST:
+  case VM_BRANCH_LESS:
+  case VM_BRANCH_LESS_EQUAL:
+  case VM_BRANCH_GREATER:
+  case VM_BRANCH_GREATER_EQUAL:
+  case VM_BRANCH_EQUAL:
+  case VM_BRANCH_NOT_EQUAL:
+  case VM_FOR_TEST:
+  case VM_FOR_LOOP:
+    targets[0] = index + 1;
+    targets[1] = instruction->a;
+    return 2;
+  case VM_RETURN:
+  case VM_RETURN_NONE:
+  case VM_TAIL_CALL: // A subroutine calling itself starts over with the types it was called with
+    return 0;
+  default:
+    targets[0] = index + 1;
+    return 1;
+  }
+}
+
+// Applies an instruction's assignment to the state before it
+static void jit_transfer(jit_compiler_ *c, const vm_instruction_ *instruction, unsigned char *state)
+{
+  switch (instruction->opcode)
+  {
+  case VM_MOVE:
+    state[instruction->a] = jit_is_constant(c, instruction->b) ? jit_constant_type(c, instruction->b)
+                                                               : JIT_TYPE(state[instruction->b]);
+    break;
+  case VM_CLEAR:
+    for (int i = 0; i < instruction->b; i++)
+      state[instruction->a + i] = JIT_OTHER;
+    break;
+  case VM_ADD:
+  case VM_SUBTRACT:
+  case VM_MULTIPLY:
+  case VM_DIVIDE:
+  case VM_MODULO:
+  case VM_POWER:
+    state[instruction->a] = JIT_INTEGER;
+    break;
+  case VM_OPERATE:
+    state[instruction->a] = instruction->node->operator == OP_SUBTRACT ? JIT_INTEGER : JIT_BOOLEAN;
+    break;
+  case VM_LESS:
+  case VM_LESS_EQUAL:
+  case VM_GREATER:
+  case VM_GREATER_EQUAL:
+  case VM_EQUAL:
+  case VM_NOT_EQUAL:
+    state[instruction->a] = JIT_BOOLEAN;
+    break;
+  case VM_FOR_LOOP:
+    state[instruction->b] = JIT_INTEGER;
+    break;
+  case VM_CALL:
+    if (c->subroutine && c->jit->vm->functions[instruction->d] == c->function)
+      state[instruction->a] = jit_type_of(c->returns);
+    else
+      state[instruction->a] = jit_type_of(jit_callee(c, instruction)->returns);
+    break;
+  default:
+    break;
+  }
+}
+
+// Merges a state into the one before instruction `index`, returning whether that changed it
+static int jit_merge(jit_compiler_ *c, int index, const unsigned char *state)
+{
+  if (!jit_in_region(c, index))
+    return 0;
+
+  unsigned char *into = jit_state(c, index);
+  if (!c->reached[index - c->first])
+  {
+    memcpy(into, state, c->registers);
+    c->reached[index - c->first] = 1;
+    return 1;
+  }
+
+  int changed = 0;
+  for (int i = 0; i < c->registers; i++)
+  {
+    unsigned char merged = JIT_TYPE(into[i]) == JIT_TYPE(state[i]) ? into[i] | state[i] : JIT_OTHER;
+    changed |= merged != into[i];
+    into[i] = merged;
+  }
+  return changed;
+}
+
+// Finds the types every register can have before each instruction, starting from `entry`
+static void jit_analyse(jit_compiler_ *c, const unsigned char *entry)
+{
+  unsigned char *state = malloc(c->registers + 1);
+  if (!state)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for the JIT.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  jit_merge(c, c->first, entry);
+  for (int changed = 1; changed;)
+  {
+    changed = 0;
+    for (int i = c->first; i <= c->last; i++)
+    {
+      if (!c->reached[i - c->first])
+        continue;
+      memcpy(state, jit_state(c, i), c->registers);
+      jit_transfer(c, &c->function->code[i], state);
+
+      int targets[2];
+      int count = jit_successors(c, i, targets);
+      for (int k = 0; k < count; k++)
+        changed |= jit_merge(c, targets[k], state);
+    }
+  }
+  free(state);
+}
+
+// Whether operand `reg` has one of the types `wanted` (JIT_INTEGER, JIT_BOOLEAN or JIT_EITHER) in the state before
+// an instruction; if that depends on the value a loop was entered with, the entry checks it.
+static int jit_read(jit_compiler_ *c, const unsigned char *state, int reg, int wanted)
+{
+  int type = jit_is_constant(c, reg) ? jit_constant_type(c, reg) : state[reg];
+  if (!(JIT_TYPE(type) & wanted))
+    return 0;
+  if (type & JIT_ENTRY)
+    c->guards[reg] = JIT_TYPE(type);
+  return 1;
+}
+
+static int jit_read_integers(jit_compiler_ *c, const unsigned char *state, int first, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    if (!jit_read(c, state, first + i, JIT_INTEGER))
+      return 0;
+  }
+  return 1;
+}
+
+// Checks an instruction that can run can be compiled in the state before it, returning why not, or NULL
+static const char *jit_check(jit_compiler_ *c, int index, const unsigned char *state)
+{
+  static const char *const values = "works on values that aren't all Integers and Booleans";
+  const vm_instruction_ *instruction = &c->function->code[index];
+  ast_ *node = instruction->node;
+  int ok = 1;
+
+  switch (jit_kind(c, instruction))
+  {
+  case JIT_REJECT:
+    return c->subroutine ? "does more than compute with Integers and Booleans"
+                         : "uses an instruction the JIT doesn't compile";
+  case JIT_EXIT:
+    return NULL;
+  default:
+    break;
+  }
+
+  switch (instruction->opcode)
+  {
+  case VM_MOVE:
+    // A loop copies any constant as it is
+    ok = (!c->subroutine && jit_is_constant(c, instruction->b)) || jit_read(c, state, instruction->b, JIT_EITHER);
+    break;
+  case VM_ADD:
+  case VM_SUBTRACT:
+  case VM_MULTIPLY:
+  case VM_DIVIDE:
+  case VM_MODULO:
+  case VM_POWER:
+  case VM_LESS:
+  case VM_LESS_EQUAL:
+  case VM_GREATER:
+  case VM_GREATER_EQUAL:
+  case VM_EQUAL:
+  case VM_NOT_EQUAL:
+  case VM_BRANCH_LESS:
+  case VM_BRANCH_LESS_EQUAL:
+  case VM_BRANCH_GREATER:
+  case VM_BRANCH_GREATER_EQUAL:
+  case VM_BRANCH_EQUAL:
+  case VM_BRANCH_NOT_EQUAL:
+    ok = jit_read(c, state, instruction->b, JIT_INTEGER) && jit_read(c, state, instruction->c, JIT_INTEGER);
+    break;
+  case VM_OPERATE:
+    if (node->left == NULL && node->operator == OP_SUBTRACT)
+      ok = jit_read(c, state, instruction->c, JIT_INTEGER);
+    else if (node->left == NULL && node->operator == OP_NOT)
+      ok = jit_read(c, state, instruction->c, JIT_BOOLEAN);
+    else if (node->left != NULL && (node->operator == OP_AND || node->operator == OP_OR))
+      ok = jit_read(c, state, instruction->b, JIT_BOOLEAN) && jit_read(c, state, instruction->c, JIT_BOOLEAN);
+    else
+      return "uses an operator the JIT doesn't compile";
+    break;
+  case VM_TEST:
+    ok = jit_read(c, state, instruction->b, JIT_BOOLEAN);
+    break;
+  case VM_CHECK_INTEGER:
+    ok = jit_read(c, state, instruction->b, JIT_INTEGER);
+    break;
+  case VM_CHECK_ARGUMENT:
+    ok = jit_read(c, state, instruction->b, JIT_EITHER);
+    break;
+  case VM_FOR_TEST:
+  case VM_FOR_LOOP:
+    ok = jit_read(c, state, instruction->b, JIT_INTEGER) && jit_read(c, state, instruction->c, JIT_INTEGER) &&
+         jit_read(c, state, instruction->d, JIT_INTEGER);
+    break;
+  case VM_OUTPUT:
+    ok = instruction->b < 0 || jit_is_constant(c, instruction->b) || jit_read(c, state, instruction->b, JIT_EITHER);
+    break;
+  case VM_CALL:
+  case VM_TAIL_CALL:
+    ok = jit_read_integers(c, state, instruction->b, instruction->c);
+    break;
+  case VM_RETURN:
+    if (!jit_read(c, state, instruction->b, jit_type_of(c->returns)))
+    {
+      c->returns_other = jit_read(c, state, instruction->b, JIT_EITHER);
+      return "returns a value that isn't an Integer or Boolean";
+    }
+    break;
+  default:
+    break;
+  }
+  return ok ? NULL : values;
+}
+
+// Compiles the subroutines the region calls first, as it needs their results' types. A subroutine calls itself
+// through its own entry once that is set.
+static const char *jit_compile_callees(jit_compiler_ *c)
+{
+  for (int i = c->first; i <= c->last; i++)
+  {
+    const vm_instruction_ *instruction = &c->function->code[i];
+    if (instruction->opcode != VM_CALL && (instruction->opcode != VM_TAIL_CALL || !c->subroutine))
+      continue;
+
+    vm_function_ *callee = c->jit->vm->functions[instruction->d];
+    jit_function_ *compiled = jit_callee(c, instruction);
+    if (c->subroutine && callee == c->function)
+      continue;
+    if (compiled->compiling)
+      return "calls a subroutine that is still being compiled";
+    if (compiled->region == NULL)
+      jit_compile_subroutine(c->jit, callee);
+    if (compiled->native == NULL)
+      return "calls a subroutine that isn't compiled";
+    if (instruction->opcode == VM_TAIL_CALL && compiled->returns != c->returns)
+      return "returns a value that isn't an Integer or Boolean";
+  }
+  return NULL;
+}
+
+// Compares operands b and c, returning the condition code that holds when `b op c`, for the comparisons in the
+// VM's order (<, <=, >, >=, =, !=)
+static int jit_compare(jit_compiler_ *c, const vm_instruction_ *instruction, int comparison)
+{
+  static const int conditions[] = {CC_L, CC_LE, CC_G, CC_GE, CC_E, CC_NE};
+
+  jit_operand(c, RAX, instruction->b, JIT_INTEGER);
+  jit_operand(c, RCX, instruction->c, JIT_INTEGER);
+  jit_arithmetic(c, 1, 0x39, RAX, RCX);
+  return conditions[comparison];
+}
+
+// Whether a FOR loop's step is a constant, giving its sign
+static int jit_constant_step(jit_compiler_ *c, int reg, int *sign)
+{
+  if (!jit_is_constant(c, reg))
+    return 0;
+  int64_t step = jit_constant(c, reg).int_value;
+  *sign = (step > 0) - (step < 0);
+  return 1;
+}
+
+// Jumps to `target` when a FOR loop's counter (RAX) has or hasn't (`passed`) passed its end (RCX), for a step of
+// the sign in `sign`, or in RDX when it isn't a constant
+static void jit_for_branch(jit_compiler_ *c, int constant, int sign, int passed, int target)
+{
+  // Still going: step > 0 and counter <= end, or step < 0 and counter >= end
+  if (constant)
+  {
+    if (sign != 0)
+    {
+      jit_arithmetic(c, 1, 0x39, RAX, RCX);
+      int going = sign > 0 ? CC_LE : CC_GE;
+      jit_jump(c, passed ? going ^ 1 : going, target);
+    }
+    else if (passed)
+    {
+      jit_jump(c, JIT_JMP, target);
+    }
+    return;
+  }
+
+  jit_arithmetic(c, 1, 0x85, RDX, RDX);
+  size_t not_positive = jit_skip(c, CC_LE);
+  jit_arithmetic(c, 1, 0x39, RAX, RCX);
+  jit_jump(c, passed ? CC_G : CC_LE, target);
+  size_t done = jit_skip(c, JIT_JMP);
+  jit_land(c, not_positive);
+  if (passed)
+  {
+    jit_jump(c, CC_E, target);
+  }
+  size_t zero = passed ? 0 : jit_skip(c, CC_E);
+  jit_arithmetic(c, 1, 0x39, RAX, RCX);
+  jit_jump(c, passed ? CC_L : CC_GE, target);
+  if (!passed)
+    jit_land(c, zero);
+  jit_land(c, done);
+}
+
+// Calls a compiled subroutine with the instruction's arguments, storing its result; a call that can't be made
+// natively gives up on the instruction
+static void jit_emit_call(jit_compiler_ *c, int index, int tail)
+{
+  const vm_instruction_ *instruction = &c->function->code[index];
+  vm_function_ *callee = c->jit->vm->functions[instruction->d];
+  jit_function_ *compiled = jit_callee(c, instruction);
+  int give_up = jit_give_up(c, index);
+
+  // Not defined yet (the VM then gives a failed expression), or no longer compiled
+  jit_move_immediate(c, RAX, (int64_t)(intptr_t)&callee->defined);
+  jit_byte(c, 0x83);
+  jit_address(c, 7, RAX, 0);
+  jit_byte(c, 0);
+  jit_jump(c, CC_E, give_up);
+  jit_move_immediate(c, RAX, (int64_t)(intptr_t)&compiled->native);
+  jit_load(c, 1, RAX, RAX, 0);
+  jit_arithmetic(c, 1, 0x85, RAX, RAX);
+  jit_jump(c, CC_E, give_up);
+
+  if (c->subroutine)
+  {
+    // The arguments are consecutive integers already, and a tail call's result is this call's
+    jit_lea(c, RDI, RBX, 8 * instruction->b);
+    if (tail)
+      jit_arithmetic(c, 1, 0x89, RDX, R13);
+    else
+      jit_lea(c, RDX, RBX, 8 * instruction->a);
+  }
+  else
+  {
+    for (int i = 0; i < instruction->c; i++)
+    {
+      jit_operand(c, RCX, instruction->b + i, JIT_INTEGER);
+      jit_store(c, RCX, RSP, 8 * i);
+    }
+    jit_lea(c, RDI, RSP, 0);
+    jit_lea(c, RDX, RSP, 8 * instruction->c);
+  }
+  jit_arithmetic(c, 1, 0x89, RSI, R12);
+  jit_byte(c, 0xFF);
+  jit_direct(c, 2, RAX);
+  jit_arithmetic(c, 0, 0x85, RAX, RAX);
+  jit_jump(c, CC_E, give_up);
+
+  if (tail)
+  {
+    jit_move_immediate(c, RAX, 1);
+    jit_jump(c, JIT_JMP, JIT_FINISH);
+  }
+  else if (!c->subroutine)
+  {
+    jit_load(c, 1, RAX, RSP, 8 * instruction->c);
+    jit_result(c, RAX, instruction->a, jit_type_of(compiled->returns));
+  }
+}
+
+// Compiles one instruction that can run, given the state before it
+static void jit_emit_instruction(jit_compiler_ *c, int index)
+{
+  const vm_instruction_ *instruction = &c->function->code[index];
+  const unsigned char *state = jit_state(c, index);
+  ast_ *node = instruction->node;
+  int falls_through = 1;
+
+  if (jit_kind(c, instruction) == JIT_EXIT)
+  {
+    jit_jump(c, JIT_JMP, JIT_EXIT_AT(index));
+    return;
+  }
+
+  switch (instruction->opcode)
+  {
+  case VM_MOVE:
+  {
+    int reg = instruction->b;
+    int type = jit_is_constant(c, reg) ? jit_constant_type(c, reg) : JIT_TYPE(state[reg]);
+    if (type == JIT_OTHER)
+    {
+      // A constant the loop only copies, such as a string, copied whole
+      uint64_t words[2];
+      value_ value = jit_constant(c, reg);
+      memcpy(words, &value, sizeof(words));
+      jit_move_immediate(c, RAX, (int64_t)words[0]);
+      jit_store(c, RAX, RBX, 16 * instruction->a);
+      jit_move_immediate(c, RAX, (int64_t)words[1]);
+      jit_store(c, RAX, RBX, 16 * instruction->a + 8);
+      break;
+    }
+    jit_operand(c, RAX, reg, type);
+    jit_result(c, RAX, instruction->a, type);
+    break;
+  }
+
+  case VM_CLEAR:
+    for (int i = 0; i < instruction->b && !c->subroutine; i++)
+    {
+      jit_store_immediate(c, RBX, 16 * (instruction->a + i), AST_NOOP);
+      jit_move_immediate(c, RAX, (int64_t)(intptr_t)&vm_unset);
+      jit_store(c, RAX, RBX, 16 * (instruction->a + i) + 8);
+    }
+    break;
+
+  case VM_ADD:
+  case VM_SUBTRACT:
+  case VM_MULTIPLY:
+  case VM_DIVIDE:
+  case VM_MODULO:
+  case VM_POWER:
+    jit_operand(c, RAX, instruction->b, JIT_INTEGER);
+    jit_operand(c, RCX, instruction->c, JIT_INTEGER);
+    switch (instruction->opcode)
+    {
+    case VM_ADD:
+      jit_arithmetic(c, 1, 0x01, RAX, RCX);
+      break;
+    case VM_SUBTRACT:
+      jit_arithmetic(c, 1, 0x29, RAX, RCX);
+      break;
+    case VM_MULTIPLY:
+      jit_rex(c, 1, RAX, RCX);
+      jit_byte(c, 0x0F);
+      jit_byte(c, 0xAF);
+      jit_direct(c, RAX, RCX);
+      break;
+    case VM_POWER:
+      jit_arithmetic(c, 1, 0x89, RDI, RAX);
+      jit_arithmetic(c, 1, 0x89, RSI, RCX);
+      jit_call_function(c, (void *)power_integer);
+      break;
+    default:
+    {
+      // A zero divisor, which the VM reports, and -1, which traps in idiv for the most negative integer, are left
+      // to the VM
+      jit_arithmetic(c, 1, 0x85, RCX, RCX);
+      jit_jump(c, CC_E, jit_give_up(c, index));
+      jit_arithmetic_immediate(c, 7, RCX, -1);
+      jit_jump(c, CC_E, jit_give_up(c, index));
+      jit_byte(c, 0x48); // cqo; idiv rcx
+      jit_byte(c, 0x99);
+      jit_rex(c, 1, 0, RCX);
+      jit_byte(c, 0xF7);
+      jit_direct(c, 7, RCX);
+      if (instruction->opcode == VM_MODULO)
+      {
+        // modulo_Euclidean: a negative remainder moves by the divisor's size
+        jit_arithmetic(c, 1, 0x89, RAX, RDX);
+        jit_arithmetic(c, 1, 0x85, RAX, RAX);
+        size_t positive = jit_skip(c, CC_NS);
+        jit_arithmetic(c, 1, 0x85, RCX, RCX);
+        size_t negative_divisor = jit_skip(c, CC_S);
+        jit_arithmetic(c, 1, 0x01, RAX, RCX);
+        size_t done = jit_skip(c, JIT_JMP);
+        jit_land(c, negative_divisor);
+        jit_arithmetic(c, 1, 0x29, RAX, RCX);
+        jit_land(c, done);
+        jit_land(c, positive);
+      }
+      break;
+    }
+    }
+    jit_result(c, RAX, instruction->a, JIT_INTEGER);
+    break;
+
+  case VM_OPERATE:
+    if (node->left == NULL)
+    {
+      jit_operand(c, RAX, instruction->c, node->operator == OP_NOT ? JIT_BOOLEAN : JIT_INTEGER);
+      if (node->operator == OP_NOT)
+      {
+        jit_arithmetic(c, 0, 0x85, RAX, RAX);
+        jit_set(c, CC_E, RAX);
+      }
+      else
+      {
+        jit_rex(c, 1, 0, RAX); // neg rax
+        jit_byte(c, 0xF7);
+        jit_direct(c, 3, RAX);
+      }
+    }
+    else
+    {
+      jit_operand(c, RAX, instruction->b, JIT_BOOLEAN);
+      jit_operand(c, RCX, instruction->c, JIT_BOOLEAN);
+      jit_arithmetic(c, 0, 0x85, RAX, RAX);
+      jit_set(c, CC_NE, RAX);
+      jit_arithmetic(c, 0, 0x85, RCX, RCX);
+      jit_set(c, CC_NE, RCX);
+      jit_arithmetic(c, 0, node->operator == OP_AND ? 0x21 : 0x09, RAX, RCX);
+    }
+    jit_result(c, RAX, instruction->a, node->operator == OP_SUBTRACT ? JIT_INTEGER : JIT_BOOLEAN);
+    break;
+
+  case VM_LESS:
+  case VM_LESS_EQUAL:
+  case VM_GREATER:
+  case VM_GREATER_EQUAL:
+  case VM_EQUAL:
+  case VM_NOT_EQUAL:
+    jit_set(c, jit_compare(c, instruction, instruction->opcode - VM_LESS), RAX);
+    jit_result(c, RAX, instruction->a, JIT_BOOLEAN);
+    break;
+
+  case VM_JUMP:
+    jit_jump(c, JIT_JMP, instruction->a);
+    falls_through = 0;
+    break;
+
+  case VM_TEST:
+    jit_operand(c, RAX, instruction->b, JIT_BOOLEAN);
+    jit_arithmetic(c, 0, 0x85, RAX, RAX);
+    jit_jump(c, CC_E, instruction->a);
+    break;
+
+  case VM_BRANCH_LESS:
+  case VM_BRANCH_LESS_EQUAL:
+  case VM_BRANCH_GREATER:
+  case VM_BRANCH_GREATER_EQUAL:
+  case VM_BRANCH_EQUAL:
+  case VM_BRANCH_NOT_EQUAL:
+    jit_jump(c, jit_compare(c, instruction, instruction->opcode - VM_BRANCH_LESS) ^ 1, instruction->a);
+    break;
+
+  case VM_CHECK_INTEGER: // Its operand is known to be an integer
+    break;
+
+  case VM_CHECK_ARGUMENT: // Its operand is known to be an integer or boolean, which can't have failed
+    break;
+
+  case VM_FOR_TEST:
+  case VM_FOR_LOOP:
+  {
+    int sign = 0;
+    int constant = jit_constant_step(c, instruction->d, &sign);
+    jit_operand(c, RAX, instruction->b, JIT_INTEGER);
+    jit_operand(c, RCX, instruction->c, JIT_INTEGER);
+    if (!constant || instruction->opcode == VM_FOR_LOOP)
+      jit_operand(c, RDX, instruction->d, JIT_INTEGER);
+    if (instruction->opcode == VM_FOR_LOOP)
+    {
+      // The counter keeps its type, so only its value is stored
+      jit_arithmetic(c, 1, 0x01, RAX, RDX);
+      jit_store(c, RAX, RBX, c->subroutine ? 8 * instruction->b : 16 * instruction->b + 8);
+    }
+    jit_for_branch(c, constant, sign, instruction->opcode == VM_FOR_TEST, instruction->a);
+    break;
+  }
+
+  case VM_CALL:
+    jit_emit_call(c, index, 0);
+    break;
+
+  case VM_TAIL_CALL:
+    if (c->jit->vm->functions[instruction->d] != c->function)
+    {
+      jit_emit_call(c, index, 1);
+    }
+    else
+    {
+      // Calling itself starts the body over with new arguments, copied out first as they may overlap
+      ast_list_ *parameters = c->function->definition->parameters;
+      for (int i = 0; i < instruction->c; i++)
+      {
+        jit_operand(c, RAX, instruction->b + i, JIT_INTEGER);
+        jit_store(c, RAX, RBX, 8 * (c->registers + i));
+      }
+      for (int i = 0; i < instruction->c; i++)
+      {
+        jit_load(c, 1, RAX, RBX, 8 * (c->registers + i));
+        jit_store(c, RAX, RBX, 8 * parameters->items[i]->slot);
+      }
+      jit_jump(c, JIT_JMP, 0);
+    }
+    falls_through = 0;
+    break;
+
+  case VM_RETURN:
+    jit_operand(c, RAX, instruction->b, jit_type_of(c->returns));
+    jit_store(c, RAX, R13, 0);
+    jit_move_immediate(c, RAX, 1);
+    jit_jump(c, JIT_JMP, JIT_FINISH);
+    falls_through = 0;
+    break;
+
+  case VM_RETURN_NONE: // The VM gives the caller no value
+    jit_jump(c, JIT_JMP, JIT_GIVE_BACK);
+    falls_through = 0;
+    break;
+
+  case VM_OUTPUT:
+    jit_move_immediate(c, RDI, (int64_t)(intptr_t)c->jit->vm->interpreter);
+    if (instruction->b >= 0)
+      jit_lea(c, RSI, RBX, 16 * instruction->b);
+    else
+      jit_move_immediate(c, RSI, 0);
+    jit_move_immediate(c, RDX, instruction->c);
+    jit_call_function(c, (void *)jit_output);
+    break;
+
+  default:
+    break;
+  }
+
+  // The instruction after the last one is outside the loop
+  if (falls_through && index == c->last)
+    jit_jump(c, JIT_JMP, index + 1);
+}
+
+static void jit_prologue(jit_compiler_ *c)
+{
+  jit_push(c, RBP);
+  jit_arithmetic(c, 1, 0x89, RBP, RSP);
+  jit_push(c, RBX);
+  jit_push(c, R12);
+  jit_push(c, R13);
+  jit_push(c, R14);
+
+  // The frame keeps the stack aligned for calls
+  int slots = c->scratch + (c->subroutine ? c->registers : 0);
+  int frame = (8 * slots + 15) & ~15;
+  if (frame > 0)
+    jit_arithmetic_immediate(c, 5, RSP, frame);
+
+  if (!c->subroutine)
+  {
+    jit_arithmetic(c, 1, 0x89, RBX, RDI);
+    jit_arithmetic(c, 1, 0x89, R12, RSI);
+
+    // The registers whose types the loop relies on, as it is entered: a type and a clear null flag each
+    for (int reg = 0; reg < c->registers; reg++)
+    {
+      if (c->guards[reg] == JIT_OTHER)
+        continue;
+      jit_load(c, 1, RAX, RBX, 16 * reg);
+      jit_arithmetic_immediate(c, 7, RAX, c->guards[reg] == JIT_BOOLEAN ? AST_BOOLEAN : AST_INTEGER);
+      jit_jump(c, CC_NE, JIT_GIVE_BACK);
+    }
+    return;
+  }
+
+  // A subroutine takes one of the calls it is allowed, then binds its parameters
+  jit_arithmetic(c, 1, 0x89, RBX, RSP);
+  jit_arithmetic(c, 1, 0x89, R13, RDX);
+  jit_arithmetic(c, 1, 0x89, R12, RSI);
+  jit_arithmetic(c, 1, 0x85, R12, R12);
+  jit_jump(c, CC_LE, JIT_GIVE_BACK);
+  jit_arithmetic_immediate(c, 5, R12, 1);
+
+  ast_list_ *parameters = c->function->definition->parameters;
+  for (size_t i = 0; parameters != NULL && i < parameters->size; i++)
+  {
+    jit_load(c, 1, RAX, RDI, 8 * (int)i);
+    jit_store(c, RAX, RBX, 8 * parameters->items[i]->slot);
+  }
+}
+
+static void jit_epilogue(jit_compiler_ *c)
+{
+  c->epilogue = (int)c->size;
+  jit_lea(c, RSP, RBP, -32);
+  jit_pop(c, R14);
+  jit_pop(c, R13);
+  jit_pop(c, R12);
+  jit_pop(c, RBX);
+  jit_pop(c, RBP);
+  jit_byte(c, 0xC3);
+}
+
+// Code returning `value` from the region, whose offset is kept in `*label`
+static int jit_stub(jit_compiler_ *c, int *label, int32_t value)
+{
+  if (*label < 0)
+  {
+    *label = (int)c->size;
+    jit_byte(c, 0xB8); // mov eax, value
+    jit_int32(c, value);
+    jit_byte(c, 0xE9);
+    jit_int32(c, (int32_t)(c->epilogue - (int)(c->size + 4)));
+  }
+  return *label;
+}
+
+// Fills in every jump now the code is laid out, adding the code for the ways out of the region as it goes
+static void jit_link(jit_compiler_ *c)
+{
+  for (int i = 0; i < c->patch_count; i++)
+  {
+    int target = c->patches[i].target;
+    int offset;
+    if (target == JIT_GIVE_BACK)
+      offset = jit_stub(c, &c->give_back, c->subroutine ? 0 : -1);
+    else if (target == JIT_FINISH)
+      offset = c->epilogue;
+    else if (target >= 0 && jit_in_region(c, target))
+      offset = c->labels[target];
+    else
+    {
+      int index = target >= 0 ? target : JIT_EXIT_AT(target); // The mapping is its own inverse
+      offset = jit_stub(c, &c->exits[index], index);
+    }
+
+    int32_t displacement = (int32_t)(offset - (int)(c->patches[i].at + 4));
+    memcpy(c->bytes + c->patches[i].at, &displacement, sizeof(displacement));
+  }
+}
+
+// Copies the code to pages of its own, made executable once it is in place
+static int jit_install(jit_compiler_ *c)
+{
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t mapped = (c->size + page - 1) / page * page;
+  void *code = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (code == MAP_FAILED)
+    return 0;
+
+  memcpy(code, c->bytes, c->size);
+  if (mprotect(code, mapped, PROT_READ | PROT_EXEC) != 0)
+  {
+    munmap(code, mapped);
+    return 0;
+  }
+
+  c->region->code = code;
+  c->region->code_size = c->size;
+  c->region->mapped_size = mapped;
+  return 1;
+}
+
+// Analyses and compiles a region. A loop is entered with the values in `registers`; a subroutine with integer
+// arguments, returning `returns`. Sets the region's reason if it can't be compiled, and returns whether a RETURN
+// gave the other type.
+static int jit_compile(jit_ *jit, jit_region_ *region, const value_ *registers, enum ast_type returns)
+{
+  vm_function_ *function = region->function;
+  jit_compiler_ compiler = {
+      .jit = jit,
+      .region = region,
+      .function = function,
+      .first = region->first,
+      .last = region->last,
+      .subroutine = region->subroutine,
+      .registers = function->register_count,
+      .returns = returns,
+      .give_back = -1,
+      .epilogue = -1,
+  };
+  jit_compiler_ *c = &compiler;
+  int count = c->last - c->first + 1;
+
+  c->states = malloc((size_t)count * c->registers + 1);
+  c->reached = calloc(count, 1);
+  c->guards = calloc(c->registers + 1, 1);
+  c->labels = malloc((function->code_size + 1) * sizeof(int));
+  c->exits = malloc((function->code_size + 1) * sizeof(int));
+  unsigned char *entry = calloc(c->registers + 1, 1);
+  if (!c->states || !c->reached || !c->guards || !c->labels || !c->exits || !entry)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for the JIT.\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i <= function->code_size; i++)
+    c->labels[i] = c->exits[i] = -1;
+
+  // A loop starts from the types the registers hold now; a subroutine from its integer parameters alone
+  for (int reg = 0; reg < c->registers; reg++)
+  {
+    if (c->subroutine)
+      continue;
+    if (registers[reg].type == AST_INTEGER && !registers[reg].null)
+      entry[reg] = JIT_INTEGER | JIT_ENTRY;
+    else if (registers[reg].type == AST_BOOLEAN && !registers[reg].null)
+      entry[reg] = JIT_BOOLEAN | JIT_ENTRY;
+  }
+  ast_list_ *parameters = c->subroutine ? function->definition->parameters : NULL;
+  for (size_t i = 0; parameters != NULL && i < parameters->size; i++)
+    entry[parameters->items[i]->slot] = JIT_INTEGER;
+
+  region->reason = jit_compile_callees(c);
+  if (region->reason == NULL)
+    jit_analyse(c, entry);
+
+  // Every instruction that can run has to compile, and calls need room for their arguments and result
+  for (int i = c->first; i <= c->last && region->reason == NULL; i++)
+  {
+    if (!c->reached[i - c->first])
+      continue;
+    region->reason = jit_check(c, i, jit_state(c, i));
+
+    const vm_instruction_ *instruction = &function->code[i];
+    if (jit_kind(c, instruction) != JIT_NATIVE)
+      continue;
+    if (instruction->opcode == VM_CALL && !c->subroutine && instruction->c + 1 > c->scratch)
+      c->scratch = instruction->c + 1;
+    if (instruction->opcode == VM_TAIL_CALL && instruction->c > c->scratch)
+      c->scratch = instruction->c;
+  }
+
+  if (region->reason == NULL)
+  {
+    jit_prologue(c);
+    for (int i = c->first; i <= c->last; i++)
+    {
+      if (!c->reached[i - c->first])
+        continue;
+      c->labels[i] = (int)c->size;
+      jit_emit_instruction(c, i);
+    }
+    jit_epilogue(c);
+    jit_link(c);
+    if (!jit_install(c))
+      region->reason = "couldn't map executable memory";
+  }
+
+  free(c->states);
+  free(c->reached);
+  free(c->guards);
+  free(c->labels);
+  free(c->exits);
+  free(c->patches);
+  free(c->bytes);
+  free(entry);
+  return c->returns_other;
+}
+
+jit_region_ *jit_compile_loop(jit_ *jit, vm_function_ *function, int first, int last, const value_ *registers)
+{
+  jit_region_ *region = jit_add_region(jit, function, first, last, 0, function->code[last].node);
+  jit_compile(jit, region, registers, AST_NOOP);
+  if (region->code == NULL)
+    return NULL;
+  function->jit->loops[first] = region;
+  return region;
+}
+
+jit_region_ *jit_compile_subroutine(jit_ *jit, vm_function_ *function)
+{
+  jit_function_ *compiled = function->jit;
+  if (compiled->region != NULL)
+    return compiled->native != NULL ? compiled->region : NULL;
+
+  jit_region_ *region = compiled->region =
+      jit_add_region(jit, function, 0, function->code_size - 1, 1, function->definition);
+  if (function->register_count > JIT_MAX_REGISTERS)
+  {
+    region->reason = "has too many variables and temporaries for the C stack";
+    return NULL;
+  }
+
+  // Its result is taken to be an Integer, then a Boolean if that is what it returns
+  compiled->compiling = 1;
+  compiled->returns = AST_INTEGER;
+  if (jit_compile(jit, region, NULL, AST_INTEGER) && region->code == NULL)
+  {
+    compiled->returns = AST_BOOLEAN;
+    jit_compile(jit, region, NULL, AST_BOOLEAN);
+  }
+  compiled->compiling = 0;
+
+  if (region->code == NULL)
+    return NULL;
+  compiled->native = (jit_subroutine_code_)region->code;
+  return region;
+}
+
+#else
+
+jit_region_ *jit_compile_loop(jit_ *jit, vm_function_ *function, int first, int last, const value_ *registers)
+{
+  return NULL;
+}
+
+jit_region_ *jit_compile_subroutine(jit_ *jit, vm_function_ *function)
+{
+  return NULL;
+}
+
+#endif
+
+// Names a region by the loop or subroutine it was compiled from
+static void jit_describe(const jit_region_ *region, char *name, size_t size)
+{
+  const ast_ *node = region->node;
+  if (region->subroutine)
+    snprintf(name, size, "subroutine %s", region->function->scope_name);
+  else if (node->type == AST_DEFINITE_LOOP)
+    snprintf(name, size, "FOR %s loop in %s", node->loop_variable->lhs->variable_name, region->function->scope_name);
+  else if (node->type == AST_INDEFINITE_LOOP && node->indefinite_loop_type == 1)
+    snprintf(name, size, "WHILE loop in %s", region->function->scope_name);
+  else
+    snprintf(name, size, "REPEAT loop in %s", region->function->scope_name); // Its back edge is the condition
+}
+
+void jit_report(jit_ *jit, FILE *stream)
+{
+  int compiled = 0;
+  size_t bytes = 0;
+  for (int i = 0; i < jit->region_count; i++)
+  {
+    if (jit->regions[i]->code != NULL)
+    {
+      compiled++;
+      bytes += jit->regions[i]->code_size;
+    }
+  }
+  fprintf(stream, "JIT: compiled %d of %d regions, %zu bytes of machine code\n", compiled, jit->region_count, bytes);
+
+  for (int i = 0; i < jit->region_count; i++)
+  {
+    const jit_region_ *region = jit->regions[i];
+    char name[256];
+    jit_describe(region, name, sizeof(name));
+    fprintf(stream, "  %s (instructions %d-%d): ", name, region->first, region->last);
+    if (region->code == NULL)
+      fprintf(stream, "not compiled, it %s\n", region->reason);
+    else if (region->subroutine)
+      fprintf(stream, "compiled, called %ld times from the VM, bailed out %ld times\n", region->entries,
+              region->failures);
+    else
+      fprintf(stream, "compiled, entered %ld times, handed back %ld times\n", region->entries, region->failures);
+  }
+}
+
+void free_jit(jit_ *jit)
+{
+  for (int i = 0; i < jit->region_count; i++)
+  {
+#if JIT_AVAILABLE
+    if (jit->regions[i]->code != NULL)
+      munmap(jit->regions[i]->code, jit->regions[i]->mapped_size);
+#endif
+    free(jit->regions[i]);
+  }
+  for (int i = 0; i < jit->vm->function_count; i++)
+  {
+    jit->vm->functions[i]->jit = NULL;
+    free(jit->functions[i]->passes);
+    free(jit->functions[i]->loops);
+    free(jit->functions[i]);
+  }
+  free(jit->functions);
+  free(jit->regions);
+  free(jit);
+}
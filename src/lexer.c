@@ -4,6 +4,59 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+
+// Perfect hash over the reserved words: the first character, last character and length of every keyword
+// map to a distinct slot of keyword_table. The table is laid out by the compiler from the designators below,
+// so adding a keyword only needs a new row (build with -Wextra to have a slot collision reported as an override).
+#define KEYWORD_TABLE_SIZE 128
+#define KEYWORD_HASH(first, last, length) (((unsigned int)(first) + 35u * (unsigned int)(last) + 5u * (length)) & (KEYWORD_TABLE_SIZE - 1))
+
+typedef struct
+{
+  const char *text;
+  unsigned int length;
+  enum token_type type;
+  enum keyword_type keyword;
+  enum operator_type op;
+} keyword_entry_;
+
+static const keyword_entry_ keyword_table[KEYWORD_TABLE_SIZE] = {
+    [KEYWORD_HASH('C', 'T', 8)] = {"CONSTANT", 8, TOKEN_KEYWORD, KEYWORD_CONSTANT, OP_NONE},
+    [KEYWORD_HASH('R', 'T', 6)] = {"REPEAT", 6, TOKEN_KEYWORD, KEYWORD_REPEAT, OP_NONE},
+    [KEYWORD_HASH('U', 'L', 5)] = {"UNTIL", 5, TOKEN_KEYWORD, KEYWORD_UNTIL, OP_NONE},
+    [KEYWORD_HASH('W', 'E', 5)] = {"WHILE", 5, TOKEN_KEYWORD, KEYWORD_WHILE, OP_NONE},
+    [KEYWORD_HASH('E', 'E', 8)] = {"ENDWHILE", 8, TOKEN_KEYWORD, KEYWORD_ENDWHILE, OP_NONE},
+    [KEYWORD_HASH('F', 'R', 3)] = {"FOR", 3, TOKEN_KEYWORD, KEYWORD_FOR, OP_NONE},
+    [KEYWORD_HASH('T', 'O', 2)] = {"TO", 2, TOKEN_KEYWORD, KEYWORD_TO, OP_NONE},
+    [KEYWORD_HASH('S', 'P', 4)] = {"STEP", 4, TOKEN_KEYWORD, KEYWORD_STEP, OP_NONE},
+    [KEYWORD_HASH('I', 'N', 2)] = {"IN", 2, TOKEN_KEYWORD, KEYWORD_IN, OP_NONE},
+    [KEYWORD_HASH('E', 'R', 6)] = {"ENDFOR", 6, TOKEN_KEYWORD, KEYWORD_ENDFOR, OP_NONE},
+    [KEYWORD_HASH('I', 'F', 2)] = {"IF", 2, TOKEN_KEYWORD, KEYWORD_IF, OP_NONE},
+    [KEYWORD_HASH('T', 'N', 4)] = {"THEN", 4, TOKEN_KEYWORD, KEYWORD_THEN, OP_NONE},
+    [KEYWORD_HASH('E', 'E', 4)] = {"ELSE", 4, TOKEN_KEYWORD, KEYWORD_ELSE, OP_NONE},
+    [KEYWORD_HASH('E', 'F', 5)] = {"ENDIF", 5, TOKEN_KEYWORD, KEYWORD_ENDIF, OP_NONE},
+    [KEYWORD_HASH('R', 'D', 6)] = {"RECORD", 6, TOKEN_KEYWORD, KEYWORD_RECORD, OP_NONE},
+    [KEYWORD_HASH('E', 'D', 9)] = {"ENDRECORD", 9, TOKEN_KEYWORD, KEYWORD_ENDRECORD, OP_NONE},
+    [KEYWORD_HASH('S', 'E', 10)] = {"SUBROUTINE", 10, TOKEN_KEYWORD, KEYWORD_SUBROUTINE, OP_NONE},
+    [KEYWORD_HASH('E', 'E', 13)] = {"ENDSUBROUTINE", 13, TOKEN_KEYWORD, KEYWORD_ENDSUBROUTINE, OP_NONE},
+    [KEYWORD_HASH('R', 'N', 6)] = {"RETURN", 6, TOKEN_KEYWORD, KEYWORD_RETURN, OP_NONE},
+    [KEYWORD_HASH('O', 'T', 6)] = {"OUTPUT", 6, TOKEN_KEYWORD, KEYWORD_OUTPUT, OP_NONE},
+    [KEYWORD_HASH('E', 'T', 4)] = {"EXIT", 4, TOKEN_KEYWORD, KEYWORD_EXIT, OP_NONE},
+    [KEYWORD_HASH('U', 'T', 9)] = {"USERINPUT", 9, TOKEN_KEYWORD, KEYWORD_USERINPUT, OP_NONE},
+    [KEYWORD_HASH('S', 'g', 6)] = {"String", 6, TOKEN_ID, KEYWORD_STRING, OP_NONE},
+    [KEYWORD_HASH('I', 'r', 7)] = {"Integer", 7, TOKEN_ID, KEYWORD_INTEGER, OP_NONE},
+    [KEYWORD_HASH('R', 'l', 4)] = {"Real", 4, TOKEN_ID, KEYWORD_REAL, OP_NONE},
+    [KEYWORD_HASH('B', 'n', 7)] = {"Boolean", 7, TOKEN_ID, KEYWORD_BOOLEAN, OP_NONE},
+    [KEYWORD_HASH('C', 'r', 4)] = {"Char", 4, TOKEN_ID, KEYWORD_CHAR, OP_NONE},
+    [KEYWORD_HASH('T', 'e', 4)] = {"True", 4, TOKEN_BOOL, KEYWORD_TRUE, OP_NONE},
+    [KEYWORD_HASH('F', 'e', 5)] = {"False", 5, TOKEN_BOOL, KEYWORD_FALSE, OP_NONE},
+    [KEYWORD_HASH('D', 'V', 3)] = {"DIV", 3, TOKEN_ARITH_OP, KEYWORD_DIV, OP_INT_DIVIDE},
+    [KEYWORD_HASH('M', 'D', 3)] = {"MOD", 3, TOKEN_ARITH_OP, KEYWORD_MOD, OP_MODULO},
+    [KEYWORD_HASH('A', 'D', 3)] = {"AND", 3, TOKEN_BOOL_OP, KEYWORD_AND, OP_AND},
+    [KEYWORD_HASH('O', 'R', 2)] = {"OR", 2, TOKEN_BOOL_OP, KEYWORD_OR, OP_OR},
+    [KEYWORD_HASH('N', 'T', 3)] = {"NOT", 3, TOKEN_BOOL_OP, KEYWORD_NOT, OP_NOT}};
 
 /**
  * @brief Initialises the lexer with the contents of the program provided.
@@ -18,14 +71,144 @@ lexer_ *init_lexer(char *contents)
 {
   lexer_ *lexer = calloc(1, sizeof(lexer_));
   lexer->contents = contents;
+  lexer->length = strlen(contents); // Measured once so scanning stays linear
   lexer->index = 0;
   lexer->c = contents[lexer->index];
   lexer->line = 1;   // Start at line 1
   lexer->column = 1; // Start at column 1
+  lexer->scan = scan_select_kernels();
+  lexer->fd = -1; // The whole program is already in memory
 
   return lexer;
 }
 
+/**
+ * @brief Initialises a lexer that reads the program from a file descriptor in chunks of LEXER_CHUNK_SIZE bytes.
+ * Only a window of the input is kept in memory: bytes before the oldest token still needed are dropped
+ * whenever the window is refilled, and offsets in tokens stay relative to the whole input.
+ *
+ * @param fd
+ * @return lexer_*
+ */
+lexer_ *init_lexer_stream(int fd)
+{
+  lexer_ *lexer = calloc(1, sizeof(lexer_));
+  lexer->capacity = 2 * LEXER_CHUNK_SIZE + 1;
+  lexer->contents = malloc(lexer->capacity);
+  if (lexer->contents == NULL)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for lexer buffer of %u bytes.\n", lexer->capacity);
+    exit(EXIT_FAILURE);
+  }
+  lexer->contents[0] = '\0';
+  lexer->fd = fd;
+  lexer->line = 1;   // Start at line 1
+  lexer->column = 1; // Start at column 1
+  lexer->scan = scan_select_kernels();
+
+  lexer_refill(lexer);
+
+  return lexer;
+}
+
+/**
+ * @brief Reads the next chunk of a streaming lexer's input into its window.
+ * The window first drops everything before both the token being collected and the oldest token pinned
+ * by the token stream, and only grows when those alone fill it.
+ *
+ * @param lexer
+ * @return int 1 if more input was read, 0 at the end of the input (or for an in-memory lexer)
+ */
+int lexer_refill(lexer_ *lexer)
+{
+  if (lexer->fd < 0 || lexer->eof)
+    return 0;
+
+  // Keep everything from the earliest byte a token may still refer to
+  unsigned int keep = lexer->base + lexer->index;
+  if (lexer->token_start < keep)
+    keep = lexer->token_start;
+  if (lexer->pinned < keep)
+    keep = lexer->pinned;
+
+  unsigned int dropped = keep - lexer->base;
+  if (dropped > 0)
+  {
+    memmove(lexer->contents, lexer->contents + dropped, lexer->length - dropped);
+    lexer->length -= dropped;
+    lexer->index -= dropped;
+    lexer->base += dropped;
+  }
+
+  if (lexer->capacity - lexer->length - 1 < LEXER_CHUNK_SIZE)
+  {
+    lexer->capacity = 2 * (lexer->length + LEXER_CHUNK_SIZE) + 1;
+    lexer->contents = realloc(lexer->contents, lexer->capacity);
+    if (lexer->contents == NULL)
+    {
+      fprintf(stderr, "Error: Memory reallocation failed for lexer buffer of %u bytes.\n", lexer->capacity);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  ssize_t count;
+  do
+  {
+    count = read(lexer->fd, lexer->contents + lexer->length, LEXER_CHUNK_SIZE);
+  } while (count < 0 && errno == EINTR);
+
+  if (count < 0)
+  {
+    fprintf(stderr, "Error reading program input: %s\n", strerror(errno));
+    exit(2);
+  }
+
+  if (count == 0)
+    lexer->eof = 1;
+
+  lexer->length += count;
+  lexer->contents[lexer->length] = '\0';
+  lexer->c = lexer->contents[lexer->index];
+
+  return count > 0;
+}
+
+/**
+ * @brief Makes sure `count` characters from the current one are in the window, unless the input ends first.
+ *
+ * @param lexer
+ * @param count
+ */
+void lexer_ensure(lexer_ *lexer, unsigned int count)
+{
+  while (lexer->index + count > lexer->length && lexer_refill(lexer))
+  {
+  }
+}
+
+/**
+ * @brief Returns the offset of the current character within the whole input.
+ *
+ * @param lexer
+ * @return unsigned int
+ */
+unsigned int lexer_offset(lexer_ *lexer)
+{
+  return lexer->base + lexer->index;
+}
+
+/**
+ * @brief Returns a pointer to the character at `offset` within the whole input. The offset must still be in the window.
+ *
+ * @param lexer
+ * @param offset
+ * @return const char*
+ */
+const char *lexer_text(lexer_ *lexer, unsigned int offset)
+{
+  return lexer->contents + (offset - lexer->base);
+}
+
 /**
  * @brief Progresses the lexer to the next character in the program
  *
@@ -33,88 +216,105 @@ lexer_ *init_lexer(char *contents)
  */
 void lexer_progress(lexer_ *lexer)
 {
-  if (lexer->c != '\0' && lexer->index < strlen(lexer->contents))
+  if (lexer->c != '\0' && lexer->index < lexer->length)
   {
-    lexer->index++;
-    lexer->c = lexer->contents[lexer->index];
-
     if (lexer->c == '\n')
     {
       lexer->line++;
-      lexer->column = 1; // Reset column to 1 on a new line
+      lexer->column = 1; // Reset column to 1 after leaving a newline
     }
     else
     {
       lexer->column++; // Increment column for every character
     }
+
+    lexer->index++;
+    if (lexer->index == lexer->length)
+      lexer_refill(lexer); // A streaming lexer reads on as a token crosses into the next chunk
+    lexer->c = lexer->contents[lexer->index];
   }
 }
 
-token_ *lexer_peek(lexer_ *lexer)
+/**
+ * @brief Progresses the lexer over `count` characters that are known not to contain a newline,
+ * such as a run found by one of the scanning kernels.
+ *
+ * @param lexer
+ * @param count
+ */
+void lexer_advance(lexer_ *lexer, unsigned int count)
 {
-  // Save the current state of the lexer
-  int saved_index = lexer->index;
-  char saved_c = lexer->c;
-
-  // Fetch the next token using the existing lexer_next logic
-  token_ *next_token = lexer_next(lexer);
+  lexer->index += count;
+  lexer->column += count;
+  if (lexer->index == lexer->length)
+    lexer_refill(lexer);
+  lexer->c = lexer->contents[lexer->index];
+}
 
-  // Restore the lexer's state to what it was before peeking
-  lexer->index = saved_index;
-  lexer->c = saved_c;
+/**
+ * @brief Progresses the lexer over the run matched by a scanning kernel.
+ * When the run reaches the end of a streaming lexer's window the scan carries on into the next chunk.
+ *
+ * @param lexer
+ * @param kernel
+ */
+void lexer_scan(lexer_ *lexer, size_t (*kernel)(const char *text, size_t index, size_t length))
+{
+  while (1)
+  {
+    size_t end = kernel(lexer->contents, lexer->index, lexer->length);
+    int window_end = end == lexer->length;
+    lexer_advance(lexer, end - lexer->index);
 
-  return next_token;
+    if (!window_end || lexer->index >= lexer->length)
+      break; // The run ended inside the window, or the input is exhausted
+  }
 }
 
 /**
- * @brief This skips the lexer over whitespace characters and calls the progress function as if the lexer has parsed the current character.
+ * @brief This skips the lexer over spaces, tabs and comments and calls the progress function as if the lexer has parsed the current character.
+ * Newlines are significant and are left for lexer_next to return as tokens.
  *
  * @param lexer
  */
-token_ *lexer_skip(lexer_ *lexer)
+void lexer_skip(lexer_ *lexer)
 {
-  while (lexer->c == ' ' || lexer->c == '\t' || lexer->c == '\n' || lexer->c == '#')
+  while (lexer->c == ' ' || lexer->c == '\t' || lexer->c == '#')
   {
-    // Skip spaces and tabs
-    while (lexer->c == ' ' || lexer->c == '\t')
-    {
-      lexer_progress(lexer);
-    }
+    lexer->token_start = lexer_offset(lexer); // Skipped characters never need to stay in the window
 
-    // Handle newlines by returning a TOKEN_NEWLINE
-    if (lexer->c == '\n')
-    {
-      lexer_progress(lexer);
-      return init_token(TOKEN_NEWLINE, "\\n");
-    }
+    // Skip spaces and tabs
+    lexer_scan(lexer, lexer->scan->blanks);
 
     // Skip comments starting with '#'
     if (lexer->c == '#')
     {
       // Skip everything until a newline or the end of the string
-      while (lexer->c != '\n' && lexer->c != '\0')
-      {
-        lexer_progress(lexer);
-      }
+      lexer_scan(lexer, lexer->scan->line_end);
     }
   }
-
-  // If nothing more to skip, return NULL (indicating no skipped tokens left)
-  return NULL;
 }
 
-token_ *lexer_next(lexer_ *lexer)
+token_ lexer_next(lexer_ *lexer)
 {
-  while (lexer->c != '\0' && lexer->index < strlen(lexer->contents))
+  while (lexer->c != '\0' && lexer->index < lexer->length)
   {
-    // Skip spaces, tabs, newlines, and comments
-    if (lexer->c == ' ' || lexer->c == '\t' || lexer->c == '\n' || lexer->c == '#')
+    // Skip spaces, tabs and comments
+    if (lexer->c == ' ' || lexer->c == '\t' || lexer->c == '#')
     {
-      token_ *skipped = lexer_skip(lexer);
-      if (skipped)
-        return skipped;
+      lexer_skip(lexer);
+      if (lexer->c == '\0' || lexer->index >= lexer->length)
+        break; // A comment ran to the end of the input
     }
 
+    // Keep the token's text in the window, with one character of lookahead for two-character operators
+    lexer->token_start = lexer_offset(lexer);
+    lexer_ensure(lexer, 2);
+
+    // Newlines terminate statements, so they are returned as tokens
+    if (lexer->c == '\n')
+      return lexer_collect_token(lexer, TOKEN_NEWLINE);
+
     if (isdigit(lexer->c) || (lexer->c == '.' && isdigit(lexer->contents[lexer->index + 1])))
       return lexer_collect_number(lexer);
 
@@ -127,148 +327,173 @@ token_ *lexer_next(lexer_ *lexer)
     // Handle multi-character operators and special cases
     if (lexer->c == '<' && lexer->contents[lexer->index + 1] == '-')
     {
+      token_ token = init_token(TOKEN_ASSIGNMENT, lexer_offset(lexer), 2, lexer->line, lexer->column);
       lexer_progress(lexer); // progress past '<'
       lexer_progress(lexer); // progress past '-'
-      return init_token(TOKEN_ASSIGNMENT, "<-");
+      return token;
     }
 
     if (lexer->c == '<' && lexer->contents[lexer->index + 1] == '=')
     {
+      token_ token = init_token(TOKEN_REL_OP, lexer_offset(lexer), 2, lexer->line, lexer->column);
+      token.op = OP_LESS_EQUAL;
       lexer_progress(lexer); // progress past '<'
       lexer_progress(lexer); // progress past '='
-      return init_token(TOKEN_REL_OP, "<=");
+      return token;
     }
 
     if (lexer->c == '>' && lexer->contents[lexer->index + 1] == '=')
     {
+      token_ token = init_token(TOKEN_REL_OP, lexer_offset(lexer), 2, lexer->line, lexer->column);
+      token.op = OP_GREATER_EQUAL;
       lexer_progress(lexer); // progress past '>'
       lexer_progress(lexer); // progress past '='
-      return init_token(TOKEN_REL_OP, ">=");
+      return token;
     }
 
     if (lexer->c == '!' && lexer->contents[lexer->index + 1] == '=')
     {
+      token_ token = init_token(TOKEN_REL_OP, lexer_offset(lexer), 2, lexer->line, lexer->column);
+      token.op = OP_NOT_EQUAL;
       lexer_progress(lexer); // progress past '!'
       lexer_progress(lexer); // progress past '='
-      return init_token(TOKEN_REL_OP, "!=");
+      return token;
     }
 
     switch (lexer->c)
     {
     case '+':
-      return lexer_collect_token(lexer, init_token(TOKEN_ARITH_OP, lexer_get_char_as_string(lexer)));
+      return lexer_collect_operator(lexer, TOKEN_ARITH_OP, OP_ADD);
     case '-':
-      return lexer_collect_token(lexer, init_token(TOKEN_ARITH_OP, lexer_get_char_as_string(lexer)));
+      return lexer_collect_operator(lexer, TOKEN_ARITH_OP, OP_SUBTRACT);
     case '*':
-      return lexer_collect_token(lexer, init_token(TOKEN_ARITH_OP, lexer_get_char_as_string(lexer)));
+      return lexer_collect_operator(lexer, TOKEN_ARITH_OP, OP_MULTIPLY);
     case '/':
-      return lexer_collect_token(lexer, init_token(TOKEN_ARITH_OP, lexer_get_char_as_string(lexer)));
+      return lexer_collect_operator(lexer, TOKEN_ARITH_OP, OP_DIVIDE);
     case '^':
-      return lexer_collect_token(lexer, init_token(TOKEN_ARITH_OP, lexer_get_char_as_string(lexer)));
+      return lexer_collect_operator(lexer, TOKEN_ARITH_OP, OP_POWER);
     case '<':
-      return lexer_collect_token(lexer, init_token(TOKEN_REL_OP, lexer_get_char_as_string(lexer)));
+      return lexer_collect_operator(lexer, TOKEN_REL_OP, OP_LESS);
     case '>':
-      return lexer_collect_token(lexer, init_token(TOKEN_REL_OP, lexer_get_char_as_string(lexer)));
+      return lexer_collect_operator(lexer, TOKEN_REL_OP, OP_GREATER);
     case '=':
-      return lexer_collect_token(lexer, init_token(TOKEN_REL_OP, lexer_get_char_as_string(lexer)));
+      return lexer_collect_operator(lexer, TOKEN_REL_OP, OP_EQUAL);
     case '(':
-      return lexer_collect_token(lexer, init_token(TOKEN_LPAREN, lexer_get_char_as_string(lexer)));
+      return lexer_collect_token(lexer, TOKEN_LPAREN);
     case ')':
-      return lexer_collect_token(lexer, init_token(TOKEN_RPAREN, lexer_get_char_as_string(lexer)));
+      return lexer_collect_token(lexer, TOKEN_RPAREN);
     case '[':
-      return lexer_collect_token(lexer, init_token(TOKEN_LBRACKET, lexer_get_char_as_string(lexer)));
+      return lexer_collect_token(lexer, TOKEN_LBRACKET);
     case ']':
-      return lexer_collect_token(lexer, init_token(TOKEN_RBRACKET, lexer_get_char_as_string(lexer)));
+      return lexer_collect_token(lexer, TOKEN_RBRACKET);
     case '{':
-      return lexer_collect_token(lexer, init_token(TOKEN_LBRACE, lexer_get_char_as_string(lexer)));
+      return lexer_collect_token(lexer, TOKEN_LBRACE);
     case '}':
-      return lexer_collect_token(lexer, init_token(TOKEN_RBRACE, lexer_get_char_as_string(lexer)));
+      return lexer_collect_token(lexer, TOKEN_RBRACE);
     case ',':
-      return lexer_collect_token(lexer, init_token(TOKEN_COMMA, lexer_get_char_as_string(lexer)));
+      return lexer_collect_token(lexer, TOKEN_COMMA);
     case ':':
-      return lexer_collect_token(lexer, init_token(TOKEN_COLON, lexer_get_char_as_string(lexer)));
+      return lexer_collect_token(lexer, TOKEN_COLON);
     case '.':
-      return lexer_collect_token(lexer, init_token(TOKEN_FULLSTOP, lexer_get_char_as_string(lexer)));
+      return lexer_collect_token(lexer, TOKEN_FULLSTOP);
     case '|':
-      return lexer_collect_token(lexer, init_token(TOKEN_PIPE, lexer_get_char_as_string(lexer)));
+      return lexer_collect_token(lexer, TOKEN_PIPE);
+    case '\r':
+      lexer_progress(lexer); // Carriage returns of CRLF line endings are skipped like blanks
+      continue;
+    }
+
+    // Any other byte starts no token. A speculative shard may have started inside a string, so it stops and leaves
+    // the decision to whoever relexes it from the right place
+    if (lexer->speculative)
+    {
+      lexer->failed = 1;
+      break;
     }
+
+    unsigned char unexpected = (unsigned char)lexer->c;
+    fprintf(stderr, "Lexer Error at line %d, column %d:\n", lexer->line, lexer->column);
+    if (isprint(unexpected))
+      fprintf(stderr, "  Unexpected character `%c`.\n", unexpected);
+    else
+      fprintf(stderr, "  Unexpected byte 0x%02X.\n", unexpected);
+    exit(EXIT_FAILURE);
   }
 
-  return init_token(TOKEN_EOF, "\0");
+  return init_token(TOKEN_EOF, lexer_offset(lexer), 0, lexer->line, lexer->column);
 }
 
-token_ *lexer_collect_string(lexer_ *lexer)
+token_ lexer_collect_string(lexer_ *lexer)
 {
   if (lexer->c == '"' || lexer->c == '\'')
   {
+    int line = lexer->line;
+    int column = lexer->column;
     char quote_char = lexer->c;
     lexer_progress(lexer); // Move past the initial quote character
 
-    char *value = calloc(1, sizeof(char));
-    value[0] = '\0';
+    unsigned int start = lexer_offset(lexer);
 
     while (lexer->c != quote_char && lexer->c != '\0')
     {
-      char *s = lexer_get_char_as_string(lexer);
-      value = realloc(value, (strlen(value) + strlen(s) + 1) * sizeof(char));
-      strcat(value, s);
       lexer_progress(lexer);
     }
 
+    unsigned int length = lexer_offset(lexer) - start;
+
     lexer_progress(lexer); // Move past the closing quote character
 
-    if (quote_char == '\'' && strlen(value) == 1)
+    if (quote_char == '\'' && length == 1)
     {
-      return init_token(TOKEN_CHAR, value);
+      return init_token(TOKEN_CHAR, start, length, line, column);
     }
     else
     {
-      return init_token(TOKEN_STRING, value);
+      return init_token(TOKEN_STRING, start, length, line, column);
     }
   }
-  return NULL; // Return NULL if no string/char is detected
+  return lexer_collect_token(lexer, TOKEN_EOF); // Not reached: lexer_next only calls this on a quote
 }
 
-token_ *lexer_collect_alphanum(lexer_ *lexer)
+token_ lexer_collect_alphanum(lexer_ *lexer)
 {
-  char *value = calloc(1, sizeof(char));
-  value[0] = '\0';
+  unsigned int start = lexer_offset(lexer);
+  int line = lexer->line;
+  int column = lexer->column;
 
-  // Loop while the character is alphanumeric or an underscore
-  while (isalnum(lexer->c) || lexer->c == '_')
-  {
-    char *s = lexer_get_char_as_string(lexer);
-    value = realloc(value, (strlen(value) + strlen(s) + 1) * sizeof(char));
-    strcat(value, s);
+  // Skip the run of alphanumeric characters and underscores
+  lexer_scan(lexer, lexer->scan->identifier);
 
-    lexer_progress(lexer);
-  }
-
-  // Check if the collected value is "True" or "False"
-  if (strcmp(value, "True") == 0 || strcmp(value, "False") == 0)
-  {
-    return init_token(TOKEN_BOOL, value);
-  }
+  unsigned int length = lexer_offset(lexer) - start;
+  const char *text = lexer_text(lexer, start);
+  token_ token = init_token(TOKEN_ID, start, length, line, column);
 
-  if (strcmp(value, "DIV") == 0 || strcmp(value, "MOD") == 0)
+  // Classify reserved words with a single probe of the keyword table
+  const keyword_entry_ *entry = &keyword_table[KEYWORD_HASH(text[0], text[length - 1], length)];
+  if (entry->text != NULL && entry->length == length && memcmp(text, entry->text, length) == 0)
   {
-    return init_token(TOKEN_ARITH_OP, value);
+    token.type = entry->type;
+    token.keyword = entry->keyword;
+    token.op = entry->op;
   }
 
-  if (strcmp(value, "AND") == 0 || strcmp(value, "OR") == 0 || strcmp(value, "NOT") == 0)
-  {
-    return init_token(TOKEN_BOOL_OP, value);
-  }
-
-  return init_token(TOKEN_ID, value);
+  return token;
 }
 
-token_ *lexer_collect_number(lexer_ *lexer)
+token_ lexer_collect_number(lexer_ *lexer)
 {
-  char *value = calloc(1, sizeof(char));
-  value[0] = '\0';
-
+  unsigned int start = lexer_offset(lexer);
+  int line = lexer->line;
+  int column = lexer->column;
   int has_decimal_point = 0;
+  int has_exponent = 0;
+
+  // Decode the digits while scanning them: the mantissa collects every significant digit,
+  // and the decimal exponent tracks where the point falls
+  uint64_t mantissa = 0;
+  int significant_digits = 0;
+  int decimal_exponent = 0;
+  int overflow = 0;
 
   while (isdigit(lexer->c) || lexer->c == '.')
   {
@@ -278,10 +503,24 @@ token_ *lexer_collect_number(lexer_ *lexer)
         break;
       has_decimal_point = 1;
     }
-
-    char *s = lexer_get_char_as_string(lexer);
-    value = realloc(value, (strlen(value) + strlen(s) + 1) * sizeof(char));
-    strcat(value, s);
+    else
+    {
+      unsigned int digit = lexer->c - '0';
+      if (significant_digits < 19)
+      {
+        mantissa = mantissa * 10 + digit;
+        if (mantissa != 0)
+          significant_digits++;
+        if (has_decimal_point)
+          decimal_exponent--;
+      }
+      else
+      {
+        overflow = 1; // Digits beyond 19 no longer fit the mantissa exactly
+        if (!has_decimal_point)
+          decimal_exponent++;
+      }
+    }
 
     lexer_progress(lexer);
   }
@@ -289,49 +528,190 @@ token_ *lexer_collect_number(lexer_ *lexer)
   // Check for the exponent part (e.g., "e+2" or "E-3")
   if (lexer->c == 'e' || lexer->c == 'E')
   {
-    char *s = lexer_get_char_as_string(lexer);
-    value = realloc(value, (strlen(value) + strlen(s) + 1) * sizeof(char));
-    strcat(value, s);
+    has_exponent = 1;
+    int exponent_sign = 1;
+    int exponent = 0;
     lexer_progress(lexer);
 
     if (lexer->c == '+' || lexer->c == '-')
     {
-      s = lexer_get_char_as_string(lexer);
-      value = realloc(value, (strlen(value) + strlen(s) + 1) * sizeof(char));
-      strcat(value, s);
+      exponent_sign = lexer->c == '-' ? -1 : 1;
       lexer_progress(lexer);
     }
 
     while (isdigit(lexer->c))
     {
-      s = lexer_get_char_as_string(lexer);
-      value = realloc(value, (strlen(value) + strlen(s) + 1) * sizeof(char));
-      strcat(value, s);
+      if (exponent < 10000)
+        exponent = exponent * 10 + (lexer->c - '0');
       lexer_progress(lexer);
     }
+
+    decimal_exponent += exponent_sign * exponent;
   }
 
-  if (has_decimal_point)
+  unsigned int length = lexer_offset(lexer) - start;
+
+  if (has_decimal_point || has_exponent)
   {
-    return init_token(TOKEN_REAL, value);
+    token_ token = init_token(TOKEN_REAL, start, length, line, column);
+    token.real_value = lexer_decode_real(lexer_text(lexer, start), length, mantissa, decimal_exponent, overflow);
+    return token;
   }
-  else
+
+  if ((overflow || mantissa > INT64_MAX) && lexer->speculative)
   {
-    return init_token(TOKEN_INT, value);
+    lexer->failed = 1; // Reported only if this text turns out not to be inside a string
   }
+  else if (overflow || mantissa > INT64_MAX)
+  {
+    fprintf(stderr, "Lexer Error at line %d, column %d:\n", line, column);
+    fprintf(stderr, "  Integer literal `%.*s` does not fit in 64 bits.\n", (int)length, lexer_text(lexer, start));
+    exit(EXIT_FAILURE);
+  }
+
+  token_ token = init_token(TOKEN_INT, start, length, line, column);
+  token.int_value = (int64_t)mantissa;
+  return token;
 }
 
-token_ *lexer_collect_token(lexer_ *lexer, token_ *token)
+/**
+ * @brief Turns a decoded mantissa and decimal exponent into a double.
+ * When both the mantissa and the power of ten are exactly representable, one multiplication or division
+ * gives the correctly rounded result; anything else falls back to strtod on the literal's text.
+ *
+ * @param text
+ * @param length
+ * @param mantissa
+ * @param decimal_exponent
+ * @param overflow
+ * @return double
+ */
+double lexer_decode_real(const char *text, unsigned int length, uint64_t mantissa, int decimal_exponent, int overflow)
 {
+  static const double powers_of_ten[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  if (!overflow && mantissa <= (UINT64_C(1) << 53))
+  {
+    if (decimal_exponent == 0 || mantissa == 0)
+      return (double)mantissa;
+    if (decimal_exponent > 0 && decimal_exponent <= 22)
+      return (double)mantissa * powers_of_ten[decimal_exponent];
+    if (decimal_exponent < 0 && decimal_exponent >= -22)
+      return (double)mantissa / powers_of_ten[-decimal_exponent];
+  }
+
+  // The literal's text is not NUL-terminated inside the source, so round-trip through a copy of all of it
+  char *buffer = malloc(length + 1);
+  if (buffer == NULL)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for real literal of %u bytes.\n", length + 1);
+    exit(EXIT_FAILURE);
+  }
+  memcpy(buffer, text, length);
+  buffer[length] = '\0';
+
+  double value = strtod(buffer, NULL);
+  free(buffer);
+  return value;
+}
+
+/**
+ * @brief Collects the single character token under the lexer and progresses past it.
+ *
+ * @param lexer
+ * @param type
+ * @return token_
+ */
+token_ lexer_collect_token(lexer_ *lexer, enum token_type type)
+{
+  token_ token = init_token(type, lexer_offset(lexer), 1, lexer->line, lexer->column);
   lexer_progress(lexer);
   return token;
 }
 
-char *lexer_get_char_as_string(lexer_ *lexer)
+/**
+ * @brief Collects the single character operator under the lexer, recording which operator it is.
+ *
+ * @param lexer
+ * @param type
+ * @param op
+ * @return token_
+ */
+token_ lexer_collect_operator(lexer_ *lexer, enum token_type type, enum operator_type op)
+{
+  token_ token = lexer_collect_token(lexer, type);
+  token.op = op;
+  return token;
+}
+
+/**
+ * @brief Lexes the whole program once into a contiguous token stream terminated by a TOKEN_EOF token.
+ * The parser walks the stream by index, so lookahead of any depth never re-runs the lexer.
+ *
+ * @param lexer
+ * @return token_stream_*
+ */
+token_stream_ *lexer_tokenize(lexer_ *lexer)
+{
+  // Roughly one token per four characters of source keeps regrowth rare
+  token_stream_ *stream = init_token_stream(lexer->contents, lexer->length / 4 + 16);
+  token_ token;
+
+  do
+  {
+    token = lexer_next(lexer);
+    token_stream_push(stream, token);
+  } while (token.type != TOKEN_EOF);
+
+  return stream;
+}
+
+/**
+ * @brief Token stream callback for a streaming lexer: lexes up to and including the next newline.
+ * Before reading on it pins the oldest token the reader still holds, so that token's text survives refills.
+ *
+ * @param stream
+ * @return int 1 if tokens were added, 0 once the TOKEN_EOF token has been produced
+ */
+int lexer_fill_stream(token_stream_ *stream)
+{
+  lexer_ *lexer = stream->producer;
+
+  if (stream->count > 0 && stream->tokens[stream->count - 1].type == TOKEN_EOF)
+    return 0;
+
+  if (stream->released < stream->discarded + stream->count)
+    lexer->pinned = stream->tokens[stream->released > stream->discarded ? stream->released - stream->discarded : 0].offset;
+  else
+    lexer->pinned = lexer_offset(lexer);
+
+  token_ token;
+  do
+  {
+    token = lexer_next(lexer);
+    token_stream_push(stream, token);
+  } while (token.type != TOKEN_NEWLINE && token.type != TOKEN_EOF);
+
+  // Refills may have moved or compacted the window the tokens point into
+  stream->source = lexer->contents;
+  stream->base = lexer->base;
+
+  return 1;
+}
+
+/**
+ * @brief Creates a token stream that a streaming lexer fills on demand as the parser reads it,
+ * so parsing proceeds while the input is still being read.
+ *
+ * @param lexer
+ * @return token_stream_*
+ */
+token_stream_ *lexer_stream_tokens(lexer_ *lexer)
 {
-  char *str = calloc(2, sizeof(char));
-  str[0] = lexer->c;
-  str[1] = '\0';
+  token_stream_ *stream = init_token_stream(lexer->contents, 256);
+  stream->fill = lexer_fill_stream;
+  stream->producer = lexer;
 
-  return str;
+  return stream;
 }
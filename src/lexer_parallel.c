@@ -0,0 +1,230 @@
+#include "include/lexer.h"
+#include "include/token.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// Programs smaller than this are lexed on the calling thread; splitting them costs more than it saves
+#define LEXER_PARALLEL_MIN_BYTES (1024 * 1024)
+
+// Shards per thread, so threads that finish early pick up more work
+#define LEXER_SHARDS_PER_THREAD 4
+
+typedef struct LEXER_SHARD_STRUCT
+{
+  unsigned int start;     // First byte of the shard; always just after a newline (or 0)
+  unsigned int end;       // One past the shard's last byte; always just after a newline (or the end of input)
+  lexer_ *lexer;          // Lexer state where the shard stopped, possibly past `end` if a string crossed it
+  token_stream_ *tokens;  // Tokens with lines counted from the shard's first line
+  unsigned int line_base; // Lines before the shard's first line, added to its tokens when stitching
+  unsigned int first;     // Index of the shard's first token in the stitched stream
+} lexer_shard_;
+
+typedef struct
+{
+  lexer_shard_ *shards;
+  unsigned int shard_count;
+  unsigned int next; // Next shard to hand out, taken atomically by the workers
+  token_stream_ *stream;
+} lexer_pool_;
+
+/**
+ * @brief Lexes from the lexer's position until it reaches `end`, appending the tokens to the stream.
+ * The final token may run past `end` when a string literal crosses it; the lexer is left just after it.
+ *
+ * @param lexer
+ * @param end
+ * @param stream
+ */
+void lexer_tokenize_range(lexer_ *lexer, unsigned int end, token_stream_ *stream)
+{
+  while (lexer_offset(lexer) < end)
+  {
+    token_ token = lexer_next(lexer);
+    if (token.type == TOKEN_EOF)
+      break;
+    token_stream_push(stream, token);
+  }
+}
+
+// Creates a lexer over the same buffer, positioned at the start of a line.
+static lexer_ *lexer_at(lexer_ *source, unsigned int offset)
+{
+  lexer_ *lexer = malloc(sizeof(lexer_));
+  *lexer = *source;
+  lexer->index = offset;
+  lexer->c = lexer->contents[offset];
+  lexer->line = 1;
+  lexer->column = 1;
+  lexer->speculative = 0;
+  lexer->failed = 0;
+
+  return lexer;
+}
+
+static void *lexer_pool_lex(void *argument)
+{
+  lexer_pool_ *pool = argument;
+  unsigned int k;
+
+  while ((k = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->shard_count)
+  {
+    lexer_shard_ *shard = &pool->shards[k];
+    shard->tokens = init_token_stream(shard->lexer->contents, (shard->end - shard->start) / 4 + 16);
+    lexer_tokenize_range(shard->lexer, shard->end, shard->tokens);
+  }
+
+  return NULL;
+}
+
+static void *lexer_pool_copy(void *argument)
+{
+  lexer_pool_ *pool = argument;
+  unsigned int k;
+
+  while ((k = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->shard_count)
+  {
+    lexer_shard_ *shard = &pool->shards[k];
+    token_ *destination = pool->stream->tokens + shard->first;
+    memcpy(destination, shard->tokens->tokens, shard->tokens->count * sizeof(token_));
+    for (unsigned int i = 0; i < shard->tokens->count; i++)
+    {
+      destination[i].line += shard->line_base;
+    }
+  }
+
+  return NULL;
+}
+
+static void lexer_pool_run(lexer_pool_ *pool, void *(*work)(void *), int threads)
+{
+  pthread_t *workers = malloc(threads * sizeof(pthread_t));
+
+  pool->next = 0;
+  for (int t = 1; t < threads; t++)
+  {
+    if (pthread_create(&workers[t], NULL, work, pool) != 0)
+    {
+      fprintf(stderr, "Error: Unable to start lexer thread.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  work(pool); // The calling thread works too
+
+  for (int t = 1; t < threads; t++)
+  {
+    pthread_join(workers[t], NULL);
+  }
+
+  free(workers);
+}
+
+/**
+ * @brief Lexes the whole program on a pool of threads and stitches the shards into one token stream.
+ * The source is split just after newlines into shards that are lexed speculatively, each assuming it
+ * starts outside a string literal. When stitching, a shard is only used if the shard before it stopped
+ * exactly on its first byte; otherwise a string crossed the boundary and the shard is relexed from where
+ * the previous one actually stopped. Line numbers are shifted by the newlines in the shards before.
+ *
+ * @param lexer an in-memory lexer at the start of the program
+ * @param threads number of threads to use, or 0 for one per online CPU
+ * @return token_stream_*
+ */
+token_stream_ *lexer_tokenize_parallel(lexer_ *lexer, int threads)
+{
+  if (threads <= 0)
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+  if (threads <= 1 || lexer->fd >= 0 || lexer->index != 0 || lexer->length < LEXER_PARALLEL_MIN_BYTES)
+    return lexer_tokenize(lexer);
+
+  // Split just after the first newline following each evenly spaced target
+  unsigned int wanted = threads * LEXER_SHARDS_PER_THREAD;
+  lexer_shard_ *shards = calloc(wanted, sizeof(lexer_shard_));
+  unsigned int shard_count = 0;
+  unsigned int start = 0;
+
+  for (unsigned int k = 1; k <= wanted && start < lexer->length; k++)
+  {
+    unsigned int end = lexer->length;
+    if (k < wanted)
+    {
+      unsigned int target = (unsigned int)((unsigned long long)lexer->length * k / wanted);
+      if (target < start)
+        target = start;
+      const char *newline = memchr(lexer->contents + target, '\n', lexer->length - target);
+      end = newline != NULL ? (unsigned int)(newline - lexer->contents) + 1 : lexer->length;
+    }
+
+    shards[shard_count].start = start;
+    shards[shard_count].end = end;
+    shards[shard_count].lexer = lexer_at(lexer, start);
+    shards[shard_count].lexer->speculative = shard_count > 0; // The first shard really does start a line outside a string
+    shard_count++;
+    start = end;
+  }
+
+  lexer_pool_ pool = {shards, shard_count, 0, NULL};
+  lexer_pool_run(&pool, lexer_pool_lex, threads);
+
+  // Stitch in order, relexing any shard whose speculative start turned out to be wrong
+  lexer_ *previous = NULL;
+  unsigned int previous_base = 0;
+  unsigned int total = 0;
+
+  for (unsigned int k = 0; k < shard_count; k++)
+  {
+    lexer_shard_ *shard = &shards[k];
+
+    if (previous == NULL || (lexer_offset(previous) == shard->start && !shard->lexer->failed))
+    {
+      // The previous shard stopped on this shard's first line, so its speculative tokens are right
+      shard->line_base = previous == NULL ? 0 : previous_base + previous->line - 1;
+    }
+    else
+    {
+      // Carry on from where the previous shard stopped, reporting any errors with absolute lines
+      lexer_ *relexer = malloc(sizeof(lexer_));
+      *relexer = *previous;
+      relexer->line += previous_base;
+      relexer->speculative = 0;
+
+      free_token_stream(shard->tokens);
+      free(shard->lexer);
+      shard->lexer = relexer;
+      shard->tokens = init_token_stream(lexer->contents, (shard->end - shard->start) / 4 + 16);
+      shard->line_base = 0;
+      if (lexer_offset(relexer) < shard->end)
+        lexer_tokenize_range(relexer, shard->end, shard->tokens);
+    }
+
+    shard->first = total;
+    total += shard->tokens->count;
+    previous = shard->lexer;
+    previous_base = shard->line_base;
+  }
+
+  token_stream_ *stream = init_token_stream(lexer->contents, total + 1);
+  pool.stream = stream;
+  lexer_pool_run(&pool, lexer_pool_copy, threads);
+  stream->count = total;
+
+  // Leave the caller's lexer where a sequential lexer would have finished
+  lexer->index = previous->index;
+  lexer->c = previous->c;
+  lexer->line = previous->line + previous_base;
+  lexer->column = previous->column;
+  token_stream_push(stream, init_token(TOKEN_EOF, lexer_offset(lexer), 0, lexer->line, lexer->column));
+
+  for (unsigned int k = 0; k < shard_count; k++)
+  {
+    free_token_stream(shards[k].tokens);
+    free(shards[k].lexer);
+  }
+  free(shards);
+
+  return stream;
+}
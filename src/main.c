@@ -2,17 +2,46 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 #include "include/lexer.h"
 #include "include/parser.h"
 #include "include/scope.h"
 #include "include/io.h"
 #include "include/interpreter.h"
+#include "include/resolver.h"
+#include "include/inference.h"
+#include "include/stack_interpreter.h"
+#include "include/closure.h"
+#include "include/vm.h"
+#include "include/jit.h"
+#include "include/transpiler.h"
 
 #define MAX_LIMIT 128
 
+static jit_ *reported_jit = NULL; // JIT whose --jit-stats report is due, printed when the program ends or EXITs
+
+static void report_jit()
+{
+  if (reported_jit == NULL)
+    return;
+  fflush(stdout); // After the program's own output
+  jit_report(reported_jit, stderr);
+  reported_jit = NULL;
+}
+
 void print_help()
 {
-  printf("Usage:\np3 <filename> [--debug]\n");
+  printf("Usage:\np3 <filename> [--debug] [--engine=tree|stack|closure|vm] [--jit] [--jit-stats] [--max-depth=N]\n"
+         "p3 --emit-c <filename> > program.c\n"
+         "p3 - [--debug]    (read the program from standard input)\n\n"
+         "--engine=stack     keep subroutine calls on a heap stack instead of the C stack, for deep recursion\n"
+         "--engine=closure   compile each node to a closure specialised to its operator and operands as it first runs\n"
+         "--engine=vm        compile the program to register bytecode and run it on a virtual machine\n"
+         "--jit              run in the VM, compiling hot integer loops and subroutines to machine code\n"
+         "--jit-stats        as --jit, then list what was compiled and how often it ran\n"
+         "--max-depth=N      stop with an error once subroutine calls nest N deep (default %d)\n"
+         "--emit-c           write the program out as standalone C instead of running it\n",
+         INTERPRETER_MAX_CALL_DEPTH);
   exit(EXIT_FAILURE);
 }
 
@@ -21,6 +50,11 @@ int main(int argc, char *argv[])
   clock_t start_time = clock(); // Start the clock
   srand(time(NULL));
   int debug = 0;
+  const char *engine = "tree";                    // Which engine runs programs: tree, stack, closure or vm
+  int max_call_depth = INTERPRETER_MAX_CALL_DEPTH;
+  int jit = 0;       // Whether the VM compiles hot code to machine code
+  int jit_stats = 0; // Whether to report what the JIT compiled
+  int emit_c = 0;    // Whether to translate programs to C rather than run them
 
   // Check if --debug is present
   if (argc >= 2)
@@ -30,24 +64,59 @@ int main(int argc, char *argv[])
       if (strcmp(argv[i], "--debug") == 0)
       {
         debug = 1; // Set debug flag if --debug is specified
-        break;
+      }
+      else if (strncmp(argv[i], "--engine=", 9) == 0)
+      {
+        engine = argv[i] + 9;
+        if (strcmp(engine, "stack") != 0 && strcmp(engine, "tree") != 0 && strcmp(engine, "closure") != 0 &&
+            strcmp(engine, "vm") != 0)
+          print_help();
+      }
+      else if (strcmp(argv[i], "--jit") == 0 || strcmp(argv[i], "--jit-stats") == 0)
+      {
+        engine = "vm";
+        jit = 1;
+        jit_stats = jit_stats || strcmp(argv[i], "--jit-stats") == 0;
+      }
+      else if (strncmp(argv[i], "--max-depth=", 12) == 0)
+      {
+        max_call_depth = atoi(argv[i] + 12);
+        if (max_call_depth <= 0)
+          print_help();
+      }
+      else if (strcmp(argv[i], "--emit-c") == 0)
+      {
+        emit_c = 1;
       }
     }
 
     for (int i = 1; i < argc; i++)
     {
       int len = strlen(argv[i]);
-      char *extension = &argv[i][len - 3]; // For ".p3" extension
-      if (strcmp(extension, ".p3") == 0)
+      lexer_ *lexer = NULL;
+      token_stream_ *tokens = NULL;
+
+      if (strcmp(argv[i], "-") == 0)
+      {
+        // Stream the program from stdin; the parser pulls tokens as chunks arrive
+        lexer = init_lexer_stream(STDIN_FILENO);
+        tokens = lexer_stream_tokens(lexer);
+      }
+      else if (len >= 3 && strcmp(&argv[i][len - 3], ".p3") == 0)
       {
         char *file_contents = get_file_contents(argv[i]);
+        lexer = init_lexer(file_contents);
+        tokens = lexer_tokenize_parallel(lexer, 0); // Large programs are split across every CPU
+      }
 
+      if (lexer != NULL)
+      {
         // Initialize components
-        lexer_ *lexer = init_lexer(file_contents);
         scope_ *scope = init_scope(NULL, "global_scope");
-        token_ *token = NULL;
-        parser_ *parser = init_parser(lexer, scope);
-        interpreter_ *interpreter = init_interpreter();
+        parser_ *parser = init_parser(tokens, scope);
+        resolver_ *resolver = init_resolver(scope);
+        interpreter_ *interpreter = init_interpreter(scope);
+        interpreter->max_call_depth = max_call_depth;
 
         // Parse and interpret
         ast_ *root = parser_parse(parser, scope);
@@ -60,9 +129,50 @@ int main(int argc, char *argv[])
           printf("***********************************************************\n");
         }
 
-        interpreter_process(interpreter, root);
+        // Give variables their slots, reporting undefined variables and constant overwrites before anything runs
+        resolver_resolve(resolver, root);
+
+        // Prove what types expressions have, so the evaluator can skip checking them, and warn of type errors
+        inference_ *inference = init_inference(scope);
+        inference_infer(inference, root);
+        free_inference(inference);
+
+        vm_ *vm = NULL;
+        if (emit_c)
+        {
+          if (!transpiler_emit(interpreter, root, strcmp(argv[i], "-") == 0 ? "standard input" : argv[i], stdout))
+            exit(EXIT_FAILURE);
+        }
+        else if (strcmp(engine, "stack") == 0)
+          stack_interpreter_run(interpreter, root);
+        else if (strcmp(engine, "closure") == 0)
+          closure_run(interpreter, root);
+        else if (strcmp(engine, "vm") == 0 && (vm = vm_compile(interpreter, root)) != NULL)
+        {
+          vm->jit = jit ? init_jit(vm) : NULL;
+          if (jit_stats && vm->jit != NULL)
+          {
+            reported_jit = vm->jit;
+            atexit(report_jit);
+          }
+          vm_run(vm);
+          report_jit();
+        }
+        else
+        {
+          interpreter_process(interpreter, root); // Including programs the VM doesn't compile
+          if (jit_stats)
+            fprintf(stderr, "JIT: nothing compiled, the program ran in the tree-walking interpreter\n");
+        }
+        if (vm != NULL)
+          free_vm(vm);
+
+        // The whole program lives in the parser's arena, so this releases it in one go
+        free_parser(parser);
       }
-      else if (strcmp(argv[i], "--debug") != 0) // Ignore the --debug flag during extension check
+      else if (strcmp(argv[i], "--debug") != 0 && strncmp(argv[i], "--engine=", 9) != 0 &&
+               strncmp(argv[i], "--max-depth=", 12) != 0 && strncmp(argv[i], "--jit", 5) != 0 &&
+               strcmp(argv[i], "--emit-c") != 0) // Ignore the options during extension check
       {
         print_help();
       }
@@ -73,6 +183,7 @@ int main(int argc, char *argv[])
     char input[MAX_LIMIT];
     printf("Welcome to the P-cubed language v.1.0.0\nCreated by mxcury\nTo exit REPL mode call `>>> EXIT`\n");
     scope_ *scope = init_scope(NULL, "global_scope");
+    resolver_ *resolver = init_resolver(scope); // Shared by every line, so each is resolved against the ones before
     while (1)
     {
       printf(">>> ");
@@ -80,11 +191,13 @@ int main(int argc, char *argv[])
 
       // Initialize components for REPL mode
       lexer_ *lexer = init_lexer(input);
-      parser_ *parser = init_parser(lexer, scope);
-      interpreter_ *interpreter = init_interpreter();
+      token_stream_ *tokens = lexer_tokenize(lexer);
+      parser_ *parser = init_parser(tokens, scope);
+      interpreter_ *interpreter = init_interpreter(scope);
 
-      // Parse and interpret user input
+      // Parse and interpret user input; the parser is kept because the global scope refers to its nodes
       ast_ *root = parser_parse(parser, scope);
+      resolver_resolve(resolver, root);
       interpreter_process(interpreter, root);
     }
   }
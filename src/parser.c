@@ -1,52 +1,130 @@
 #include "include/parser.h"
 #include "include/scope.h"
+#include "include/intern.h"
 #include <stdio.h>
 #include <string.h>
 
-parser_ *init_parser(lexer_ *lexer, scope_ *scope)
+// Returns whether the current token is the reserved word `keyword`; classified by the lexer, so no text is compared.
+static int parser_current_is(parser_ *parser, enum keyword_type keyword)
+{
+  return parser->current_token->keyword == keyword;
+}
+
+// Returns a pointer to the current token's text inside the source buffer (not NUL-terminated at the token's end).
+static const char *parser_current_start(parser_ *parser)
+{
+  return token_stream_text(parser->tokens, parser->current_token);
+}
+
+// Materializes a copy of the current token's text in the parser's arena for storage in the AST or an error message.
+static char *parser_current_value(parser_ *parser)
+{
+  if (parser->current_token->type == TOKEN_NEWLINE)
+  {
+    return arena_strdup(parser->arena, "\\n");
+  }
+
+  return arena_strndup(parser->arena, parser_current_start(parser), parser->current_token->length);
+}
+
+// Interns the current identifier, so every reference to a name shares one pointer that scopes can hash by address.
+static char *parser_current_name(parser_ *parser)
+{
+  return intern_name_n(parser_current_start(parser), parser->current_token->length);
+}
+
+parser_ *init_parser(token_stream_ *tokens, scope_ *scope)
 {
   parser_ *parser = calloc(1, sizeof(struct PARSER_STRUCT));
-  parser->lexer = lexer;
-  parser->current_token = lexer_next(lexer);
-  parser->prev_token = parser->current_token;
+  parser->tokens = tokens;
+  parser->position = 0;
+  parser->current_token = token_stream_at(tokens, 0);
 
   parser->scope = scope;
+  parser->arena = init_arena(ARENA_BLOCK_SIZE);
 
   return parser;
 }
 
+// Releases the parser together with every node, list and name it produced, so the AST must no longer be in use.
+void free_parser(parser_ *parser)
+{
+  free_arena(parser->arena);
+  free(parser);
+}
+
+// Returns the token `distance` places after the current one, clamped to the terminating TOKEN_EOF.
+token_ *parser_peek(parser_ *parser, unsigned int distance)
+{
+  token_ *token = token_stream_at(parser->tokens, parser->position + distance);
+  parser->current_token = token_stream_at(parser->tokens, parser->position); // Filling may have moved the tokens
+
+  return token;
+}
+
 ast_ *parser_parse(parser_ *parser, scope_ *scope)
 {
-  return parser_parse_statements(parser, scope);
+  // Everything the parser builds comes from its arena; nodes made later by the interpreter use the heap
+  arena_ *previous = ast_use_arena(parser->arena);
+  ast_ *root = parser_parse_statements(parser, scope);
+  ast_use_arena(previous);
+
+  // The AST holds its own copies of every name, so the tokens can go before the program runs
+  free_token_stream(parser->tokens);
+  parser->tokens = NULL;
+  parser->current_token = NULL;
+
+  return root;
 }
 
 void parser_expect(parser_ *parser, enum token_type expected_type)
 {
   if (parser->current_token->type & expected_type)
   {
-    parser->prev_token = parser->current_token;
-    parser->current_token = lexer_next(parser->lexer); // Progress the lexer to get the next token
+    if (parser->current_token->type != TOKEN_EOF)
+    {
+      parser->position++; // Progress to the next token in the stream, staying on the terminating EOF
+    }
+    parser->tokens->released = parser->position; // Earlier tokens are never revisited
+    parser->current_token = token_stream_at(parser->tokens, parser->position);
   }
   else
   {
     // Get details about the current token
-    const char *found_type = token_type_to_string(parser->current_token->type);
-    const char *found_value = parser->current_token->value;
+    const char *found_value = parser_current_value(parser);
 
     // Get the expected token type for the error message
     const char *expected_type_str = token_type_to_string(expected_type);
 
     // Get the current token's line and column numbers
-    int line = parser->lexer->line;
-    int column = parser->lexer->column;
+    int line = parser->current_token->line;
+    int column = parser->current_token->column;
 
     // Print a detailed and informative error message
+    // (token_type_to_string reuses one buffer, so each type is printed before the next is formatted)
     fprintf(stderr, "Parse Error at line %d, column %d:\n", line, column);
-    fprintf(stderr, "  Expected token of type `%s`, but found `%s` (value: `%s`).\n",
-            expected_type_str, found_type, found_value);
+    fprintf(stderr, "  Expected token of type `%s`, ", expected_type_str);
+    fprintf(stderr, "but found `%s` (value: `%s`).\n", token_type_to_string(parser->current_token->type), found_value);
 
-    // Optionally: log previous token info for debugging
-    // fprintf(stderr, "Previous token was: %s\n", token_type_to_string(parser->prev_token->type));
+    exit(EXIT_FAILURE); // Terminate on error
+  }
+}
+
+void parser_expect_keyword(parser_ *parser, enum keyword_type expected_keyword)
+{
+  if (parser->current_token->keyword == expected_keyword)
+  {
+    parser_expect(parser, parser->current_token->type);
+  }
+  else
+  {
+    const char *found_value = parser_current_value(parser);
+    int line = parser->current_token->line;
+    int column = parser->current_token->column;
+
+    fprintf(stderr, "Parse Error at line %d, column %d:\n", line, column);
+    fprintf(stderr, "  Expected keyword `%s`, ", keyword_type_to_string(expected_keyword));
+    fprintf(stderr, "but found `%s` (value: `%s`).\n", token_type_to_string(parser->current_token->type), found_value);
 
     exit(EXIT_FAILURE); // Terminate on error
   }
@@ -54,9 +132,9 @@ void parser_expect(parser_ *parser, enum token_type expected_type)
 
 ast_ *parser_parse_statement(parser_ *parser, scope_ *scope)
 {
-  if (parser->current_token->type == TOKEN_ID)
+  if (parser->current_token->type & (TOKEN_ID | TOKEN_KEYWORD))
   {
-    // Parse the identifier and return the AST for it
+    // Parse the keyword or identifier and return the AST for it
     ast_ *ast = parser_parse_id(parser, scope);
     return ast;
   }
@@ -69,16 +147,16 @@ ast_ *parser_parse_statement(parser_ *parser, scope_ *scope)
   {
     // Handle unexpected tokens with an error
     const char *found_type = token_type_to_string(parser->current_token->type);
-    const char *found_value = parser->current_token->value;
-    int line = parser->lexer->line;
-    int column = parser->lexer->column;
+    const char *found_value = parser_current_value(parser);
+    int line = parser->current_token->line;
+    int column = parser->current_token->column;
 
     // Print an informative error message
     fprintf(stderr, "Parse Error at line %d, column %d:\n", line, column);
     fprintf(stderr, "  Unexpected token: `%s` (value: `%s`).\n", found_type, found_value);
 
     // Optionally, you can provide suggestions for what tokens are expected
-    fprintf(stderr, "  Expected either an identifier (TOKEN_ID) or a newline (TOKEN_NEWLINE).\n");
+    fprintf(stderr, "  Expected either a keyword or identifier (TOKEN_KEYWORD, TOKEN_ID) or a newline (TOKEN_NEWLINE).\n");
 
     exit(EXIT_FAILURE); // Terminate on error
   }
@@ -91,7 +169,6 @@ ast_ *parser_parse_statements(parser_ *parser, scope_ *scope)
 {
   ast_ *compound = init_ast(AST_COMPOUND);
   compound->compound_value = init_ast_list(); // Initialize the list for compound statements
-  set_scope(compound, scope);
 
   do
   {
@@ -100,8 +177,7 @@ ast_ *parser_parse_statements(parser_ *parser, scope_ *scope)
     // Only add valid statements that are not NOOPs (no-operation)
     if (ast_statement->type != AST_NOOP)
     {
-      set_scope(ast_statement, scope);
-      add_ast_to_list(&(compound->compound_value), ast_statement);
+      add_ast_to_list(compound->compound_value, ast_statement);
     }
 
   } while (parser->current_token->type != TOKEN_EOF); // Continue until the end of file
@@ -111,31 +187,28 @@ ast_ *parser_parse_statements(parser_ *parser, scope_ *scope)
 
 ast_ *parser_parse_id(parser_ *parser, scope_ *scope)
 {
-  keyword_map_entry keyword_map[] = {
-      {"CONSTANT", handle_id},
-      {"REPEAT", handle_undefined_loop},
-      {"WHILE", handle_undefined_loop},
-      {"FOR", handle_defined_loop},
-      {"IF", handle_selection},
-      {"RECORD", handle_record_defintion},
-      {"SUBROUTINE", handle_subroutine},
-      {"RETURN", handle_return},
-      {"OUTPUT", handle_output},
-      {"EXIT", handle_exit},
-      {NULL, NULL} // Sentinel value to mark the end of the array
-  };
-
-  const char *token_value = parser->current_token->value;
-
-  for (int i = 0; keyword_map[i].keyword != NULL; i++)
+  switch (parser->current_token->keyword)
   {
-    if (strcmp(token_value, keyword_map[i].keyword) == 0)
-    {
-      return keyword_map[i].handler(parser, scope); // Call the handler function and return its result
-    }
+  case KEYWORD_REPEAT:
+  case KEYWORD_WHILE:
+    return handle_undefined_loop(parser, scope);
+  case KEYWORD_FOR:
+    return handle_defined_loop(parser, scope);
+  case KEYWORD_IF:
+    return handle_selection(parser, scope);
+  case KEYWORD_RECORD:
+    return handle_record_defintion(parser, scope);
+  case KEYWORD_SUBROUTINE:
+    return handle_subroutine(parser, scope);
+  case KEYWORD_RETURN:
+    return handle_return(parser, scope);
+  case KEYWORD_OUTPUT:
+    return handle_output(parser, scope);
+  case KEYWORD_EXIT:
+    return handle_exit(parser, scope);
+  default:
+    return handle_id(parser, scope); // Assignments, calls and CONSTANT declarations
   }
-
-  return handle_id(parser, scope);
 }
 
 // Helper function to handle variables, array access, and record access
@@ -146,13 +219,13 @@ ast_ *parse_variable_or_access(parser_ *parser, scope_ *scope)
   int is_constant = 0;
   int is_userinput = 0;
 
-  if (strcmp(parser->current_token->value, "CONSTANT") == 0)
+  if (parser_current_is(parser, KEYWORD_CONSTANT))
   {
-    is_constant = 1;                 // Mark as constant
-    parser_expect(parser, TOKEN_ID); // Skip 'CONSTANT'
+    is_constant = 1;                                 // Mark as constant
+    parser_expect_keyword(parser, KEYWORD_CONSTANT); // Skip 'CONSTANT'
   }
 
-  variable_name = parser->current_token->value;
+  variable_name = parser_current_name(parser);
   parser_expect(parser, TOKEN_ID); // Consume the identifier
 
   // Handle array access
@@ -165,7 +238,7 @@ ast_ *parse_variable_or_access(parser_ *parser, scope_ *scope)
     {
       parser_expect(parser, TOKEN_LBRACKET);
       ast_ *element = parse_expression(parser, scope); // Parse the index
-      add_ast_to_list(&(expression->index), element);
+      add_ast_to_list(expression->index, element);
       parser_expect(parser, TOKEN_RBRACKET); // Consume ']'
     }
   }
@@ -175,7 +248,7 @@ ast_ *parse_variable_or_access(parser_ *parser, scope_ *scope)
     expression = init_ast(AST_RECORD_ACCESS);
     parser_expect(parser, TOKEN_FULLSTOP); // Consume '.'
     expression->variable_name = variable_name;
-    expression->field_name = parser->current_token->value;
+    expression->field_name = parser_current_value(parser);
     parser_expect(parser, TOKEN_ID); // Consume field name
   }
   // Handle class instantiation
@@ -192,10 +265,10 @@ ast_ *parse_variable_or_access(parser_ *parser, scope_ *scope)
       {
         ast_ *arg = NULL;
 
-        if (parser->current_token->type == TOKEN_ID && lexer_peek(parser->lexer)->type == TOKEN_COLON)
+        if (parser->current_token->type == TOKEN_ID && parser_peek(parser, 1)->type == TOKEN_COLON)
         {
           // Handle specified arguments like `make: 'Mazda'` as AST_ASSIGNMENT
-          char *arg_name = parser->current_token->value; // Store the argument name
+          char *arg_name = parser_current_name(parser); // Store the argument name
           parser_expect(parser, TOKEN_ID);               // Consume the argument name
           parser_expect(parser, TOKEN_COLON);            // Consume ':'
 
@@ -214,7 +287,7 @@ ast_ *parse_variable_or_access(parser_ *parser, scope_ *scope)
         }
 
         // Add the argument (either assignment or positional) to the arguments list
-        add_ast_to_list(&(expression->arguments), arg);
+        add_ast_to_list(expression->arguments, arg);
         expression->arguments_count++;
 
         if (parser->current_token->type == TOKEN_COMMA)
@@ -239,7 +312,6 @@ ast_ *parse_variable_or_access(parser_ *parser, scope_ *scope)
     expression->userinput = is_userinput;
   }
 
-  set_scope(expression, scope);
   return expression;
 }
 
@@ -257,7 +329,7 @@ ast_ *parse_array(parser_ *parser, scope_ *scope)
   while (parser->current_token->type != TOKEN_RBRACKET)
   {
     ast_ *element = parse_expression(parser, scope);         // Parse each element
-    add_ast_to_list(&(expression->array_elements), element); // Add element to the array
+    add_ast_to_list(expression->array_elements, element); // Add element to the array
 
     // If the element is an array, increment the array_dimension
     if (element->type == AST_ARRAY)
@@ -283,7 +355,6 @@ ast_ *parse_array(parser_ *parser, scope_ *scope)
   }
 
   parser_expect(parser, TOKEN_RBRACKET); // Consume ']'
-  set_scope(expression, scope);
 
   return expression;
 }
@@ -296,40 +367,35 @@ ast_ *parse_literal(parser_ *parser, scope_ *scope)
   if (parser->current_token->type == TOKEN_INT)
   {
     expression = init_ast(AST_INTEGER);
-    expression->int_value.value = atoi(parser->current_token->value);
+    expression->int_value.value = parser->current_token->int_value;
     expression->int_value.null = 0;
-    set_scope(expression, scope);
     parser_expect(parser, TOKEN_INT);
   }
   else if (parser->current_token->type == TOKEN_REAL)
   {
     expression = init_ast(AST_REAL);
-    expression->real_value.value = atof(parser->current_token->value);
+    expression->real_value.value = parser->current_token->real_value;
     expression->real_value.null = 0;
-    set_scope(expression, scope);
     parser_expect(parser, TOKEN_REAL);
   }
   else if (parser->current_token->type == TOKEN_CHAR)
   {
     expression = init_ast(AST_CHARACTER);
-    expression->char_value.value = parser->current_token->value[0];
+    expression->char_value.value = parser_current_start(parser)[0];
     expression->char_value.null = 0;
-    set_scope(expression, scope);
     parser_expect(parser, TOKEN_CHAR);
   }
   else if (parser->current_token->type == TOKEN_BOOL)
   {
     expression = init_ast(AST_BOOLEAN);
-    expression->boolean_value.value = strcmp(parser->current_token->value, "True") == 0;
+    expression->boolean_value.value = parser_current_is(parser, KEYWORD_TRUE);
     expression->boolean_value.null = 0;
-    set_scope(expression, scope);
     parser_expect(parser, TOKEN_BOOL);
   }
   else if (parser->current_token->type == TOKEN_STRING)
   {
     expression = init_ast(AST_STRING);
-    expression->string_value = strdup(parser->current_token->value);
-    set_scope(expression, scope);
+    expression->string_value = parser_current_value(parser);
     parser_expect(parser, TOKEN_STRING);
   }
   else if (parser->current_token->type == TOKEN_LBRACKET)
@@ -340,9 +406,9 @@ ast_ *parse_literal(parser_ *parser, scope_ *scope)
   {
     // Handle unexpected tokens with an error
     const char *found_type = token_type_to_string(parser->current_token->type);
-    const char *found_value = parser->current_token->value;
-    int line = parser->lexer->line;
-    int column = parser->lexer->column;
+    const char *found_value = parser_current_value(parser);
+    int line = parser->current_token->line;
+    int column = parser->current_token->column;
 
     // Print an informative error message
     fprintf(stderr, "Parse Error at line %d, column %d:\n", line, column);
@@ -364,8 +430,8 @@ ast_ *parse_primary_expression(parser_ *parser, scope_ *scope)
     expression = parse_expression(parser, scope); // Parse the inner expression
     parser_expect(parser, TOKEN_RPAREN);          // Consume ')'
   }
-  // Handle variables, arrays, or instantiation
-  else if (parser->current_token->type == TOKEN_ID)
+  // Handle variables (including CONSTANT declarations), arrays, or instantiation
+  else if (parser->current_token->type == TOKEN_ID || parser_current_is(parser, KEYWORD_CONSTANT))
   {
     expression = parse_variable_or_access(parser, scope);
   }
@@ -383,23 +449,25 @@ ast_ *parse_unary_expression(parser_ *parser, scope_ *scope)
 {
   ast_ *expression = NULL;
 
-  if (parser->current_token->type == TOKEN_ARITH_OP && strcmp(parser->current_token->value, "-") == 0)
+  if (parser->current_token->op == OP_SUBTRACT)
   {
     // Handle unary minus
     parser_expect(parser, TOKEN_ARITH_OP);                // Consume '-'
     expression = parse_primary_expression(parser, scope); // Parse right side
     ast_ *unary_expression = init_ast(AST_ARITHMETIC_EXPRESSION);
-    unary_expression->op = strdup("-");
+    unary_expression->op = arena_strdup(parser->arena, "-");
+    unary_expression->operator = OP_SUBTRACT;
     unary_expression->right = expression;
     return unary_expression;
   }
-  else if (parser->current_token->type == TOKEN_BOOL_OP && strcmp(parser->current_token->value, "NOT") == 0)
+  else if (parser->current_token->op == OP_NOT)
   {
     // Handle unary NOT
     parser_expect(parser, TOKEN_BOOL_OP);                 // Consume 'NOT'
     expression = parse_primary_expression(parser, scope); // Parse right side
     ast_ *unary_expression = init_ast(AST_BOOLEAN_EXPRESSION);
-    unary_expression->op = strdup("NOT");
+    unary_expression->op = arena_strdup(parser->arena, "NOT");
+    unary_expression->operator = OP_NOT;
     unary_expression->right = expression;
     return unary_expression;
   }
@@ -414,10 +482,11 @@ ast_ *parse_exponentiation_expression(parser_ *parser, scope_ *scope)
   ast_ *left = parse_unary_expression(parser, scope);
 
   // Handle exponentiation (highest precedence)
-  while (parser->current_token->type == TOKEN_ARITH_OP && strcmp(parser->current_token->value, "^") == 0)
+  while (parser->current_token->op == OP_POWER)
   {
     ast_ *op_node = init_ast(AST_ARITHMETIC_EXPRESSION);
-    op_node->op = strdup(parser->current_token->value);
+    op_node->op = parser_current_value(parser);
+    op_node->operator = parser->current_token->op;
     op_node->left = left;
 
     parser_expect(parser, TOKEN_ARITH_OP); // Consume '^'
@@ -435,12 +504,12 @@ ast_ *parse_multiplication_expression(parser_ *parser, scope_ *scope)
   ast_ *left = parse_exponentiation_expression(parser, scope);
 
   // Handle multiplication, division, modulus
-  while (parser->current_token->type == TOKEN_ARITH_OP &&
-         (strcmp(parser->current_token->value, "*") == 0 || strcmp(parser->current_token->value, "/") == 0 ||
-          strcmp(parser->current_token->value, "MOD") == 0 || strcmp(parser->current_token->value, "DIV") == 0))
+  while (parser->current_token->op == OP_MULTIPLY || parser->current_token->op == OP_DIVIDE ||
+         parser->current_token->op == OP_MODULO || parser->current_token->op == OP_INT_DIVIDE)
   {
     ast_ *op_node = init_ast(AST_ARITHMETIC_EXPRESSION);
-    op_node->op = strdup(parser->current_token->value);
+    op_node->op = parser_current_value(parser);
+    op_node->operator = parser->current_token->op;
     op_node->left = left;
 
     parser_expect(parser, TOKEN_ARITH_OP); // Consume the operator
@@ -458,11 +527,11 @@ ast_ *parse_addition_expression(parser_ *parser, scope_ *scope)
   ast_ *left = parse_multiplication_expression(parser, scope);
 
   // Handle addition, subtraction
-  while (parser->current_token->type == TOKEN_ARITH_OP &&
-         (strcmp(parser->current_token->value, "+") == 0 || strcmp(parser->current_token->value, "-") == 0))
+  while (parser->current_token->op == OP_ADD || parser->current_token->op == OP_SUBTRACT)
   {
     ast_ *op_node = init_ast(AST_ARITHMETIC_EXPRESSION);
-    op_node->op = strdup(parser->current_token->value);
+    op_node->op = parser_current_value(parser);
+    op_node->operator = parser->current_token->op;
     op_node->left = left;
 
     parser_expect(parser, TOKEN_ARITH_OP); // Consume the operator
@@ -483,7 +552,8 @@ ast_ *parse_relational_expression(parser_ *parser, scope_ *scope)
   if (parser->current_token->type == TOKEN_REL_OP)
   {
     ast_ *rel_op = init_ast(AST_BOOLEAN_EXPRESSION);
-    rel_op->op = strdup(parser->current_token->value);
+    rel_op->op = parser_current_value(parser);
+    rel_op->operator = parser->current_token->op;
     rel_op->left = left;
     parser_expect(parser, TOKEN_REL_OP);                      // Consume the operator
     rel_op->right = parse_addition_expression(parser, scope); // Parse the right side
@@ -500,11 +570,11 @@ ast_ *parse_boolean_expression(parser_ *parser, scope_ *scope)
   ast_ *left = parse_relational_expression(parser, scope);
 
   // Handle boolean operators (lowest precedence)
-  while (parser->current_token->type == TOKEN_BOOL_OP &&
-         (strcmp(parser->current_token->value, "AND") == 0 || strcmp(parser->current_token->value, "OR") == 0))
+  while (parser->current_token->op == OP_AND || parser->current_token->op == OP_OR)
   {
     ast_ *bool_op = init_ast(AST_BOOLEAN_EXPRESSION);
-    bool_op->op = strdup(parser->current_token->value);
+    bool_op->op = parser_current_value(parser);
+    bool_op->operator = parser->current_token->op;
     bool_op->left = left;
 
     parser_expect(parser, TOKEN_BOOL_OP); // Consume the operator
@@ -534,9 +604,9 @@ ast_ *handle_id(parser_ *parser, scope_ *scope)
 
     ast_ *rhs = NULL;
 
-    if (parser->current_token->type == TOKEN_ID && strcmp(parser->current_token->value, "USERINPUT") == 0)
+    if (parser_current_is(parser, KEYWORD_USERINPUT))
     {
-      parser_expect(parser, TOKEN_ID); // Consume 'USERINPUT'
+      parser_expect_keyword(parser, KEYWORD_USERINPUT); // Consume 'USERINPUT'
 
       lhs->userinput = 1;
       rhs = init_ast(AST_STRING);
@@ -552,12 +622,10 @@ ast_ *handle_id(parser_ *parser, scope_ *scope)
     ast_ *assignment = init_ast(AST_ASSIGNMENT);
     assignment->lhs = lhs;
     assignment->rhs = rhs;
-    set_scope(assignment, scope);
     return assignment; // Return the full assignment AST node
   }
 
   // If no assignment token is found, treat it as a standalone expression
-  set_scope(lhs, scope);
   return lhs;
 }
 
@@ -567,10 +635,10 @@ ast_ *handle_undefined_loop(parser_ *parser, scope_ *scope)
   ast_ *loop_ast = init_ast(AST_INDEFINITE_LOOP);
 
   // Determine if it's a REPEAT...UNTIL loop or a WHILE...ENDWHILE loop
-  if (strcmp(parser->current_token->value, "REPEAT") == 0)
+  if (parser_current_is(parser, KEYWORD_REPEAT))
   {
     loop_ast->indefinite_loop_type = 0;
-    parser_expect(parser, TOKEN_ID); // Consume 'REPEAT'
+    parser_expect_keyword(parser, KEYWORD_REPEAT); // Consume 'REPEAT'
 
     parser_expect(parser, TOKEN_NEWLINE); // Consume the newline after the REPEAT statement
 
@@ -578,21 +646,21 @@ ast_ *handle_undefined_loop(parser_ *parser, scope_ *scope)
     loop_ast->loop_body = init_ast_list();
 
     // Parse the loop body until we hit 'UNTIL'
-    while (strcmp(parser->current_token->value, "UNTIL") != 0)
+    while (!parser_current_is(parser, KEYWORD_UNTIL))
     {
       ast_ *statement = parser_parse_statement(parser, scope);
-      add_ast_to_list(&loop_ast->loop_body, statement);
+      add_ast_to_list(loop_ast->loop_body, statement);
       parser_expect(parser, TOKEN_NEWLINE);
     }
 
-    parser_expect(parser, TOKEN_ID); // Consume 'UNTIL'
+    parser_expect_keyword(parser, KEYWORD_UNTIL); // Consume 'UNTIL'
 
     // Parse the condition expression after 'UNTIL'
     loop_ast->condition = parse_expression(parser, scope);
   }
-  else if (strcmp(parser->current_token->value, "WHILE") == 0)
+  else if (parser_current_is(parser, KEYWORD_WHILE))
   {
-    parser_expect(parser, TOKEN_ID); // Consume 'WHILE'
+    parser_expect_keyword(parser, KEYWORD_WHILE); // Consume 'WHILE'
     loop_ast->indefinite_loop_type = 1;
 
     // Parse the condition expression after 'WHILE'
@@ -604,22 +672,22 @@ ast_ *handle_undefined_loop(parser_ *parser, scope_ *scope)
     loop_ast->loop_body = init_ast_list();
 
     // Parse the loop body until we hit 'ENDWHILE'
-    while (strcmp(parser->current_token->value, "ENDWHILE") != 0)
+    while (!parser_current_is(parser, KEYWORD_ENDWHILE))
     {
       ast_ *statement = parser_parse_statement(parser, scope);
-      add_ast_to_list(&loop_ast->loop_body, statement);
+      add_ast_to_list(loop_ast->loop_body, statement);
       parser_expect(parser, TOKEN_NEWLINE); // Consume the newline after each statement in the loop body
     }
 
-    parser_expect(parser, TOKEN_ID); // Consume 'ENDWHILE'
+    parser_expect_keyword(parser, KEYWORD_ENDWHILE); // Consume 'ENDWHILE'
   }
   else
   {
     // Handle unexpected tokens with an error
     const char *found_type = token_type_to_string(parser->current_token->type);
-    const char *found_value = parser->current_token->value;
-    int line = parser->lexer->line;
-    int column = parser->lexer->column;
+    const char *found_value = parser_current_value(parser);
+    int line = parser->current_token->line;
+    int column = parser->current_token->column;
 
     // Print an informative error message
     fprintf(stderr, "Parse Error at line %d, column %d:\n", line, column);
@@ -627,7 +695,6 @@ ast_ *handle_undefined_loop(parser_ *parser, scope_ *scope)
 
     exit(EXIT_FAILURE); // Terminate on error
   }
-  set_scope(loop_ast, scope);
   return loop_ast;
 }
 
@@ -637,16 +704,16 @@ ast_ *handle_defined_loop(parser_ *parser, scope_ *scope)
   ast_ *loop_ast = init_ast(AST_DEFINITE_LOOP);
 
   // Expect and consume the "FOR" keyword
-  parser_expect(parser, TOKEN_ID); // Consume the 'FOR' token
+  parser_expect_keyword(parser, KEYWORD_FOR); // Consume the 'FOR' token
 
   // Handle the loop variable
   loop_ast->loop_variable = init_ast(AST_ASSIGNMENT);
   loop_ast->loop_variable->lhs = init_ast(AST_VARIABLE);
-  loop_ast->loop_variable->lhs->variable_name = parser->current_token->value;
+  loop_ast->loop_variable->lhs->variable_name = parser_current_name(parser);
   parser_expect(parser, TOKEN_ID); // Consume the loop variable
 
   // Determine if it's a "FOR variable IN collection" or "FOR variable <- start TO end"
-  if (strcmp(parser->current_token->value, "<-") == 0)
+  if (parser->current_token->type == TOKEN_ASSIGNMENT)
   {
     // Case: FOR variable <- start TO end [STEP increment]
 
@@ -657,9 +724,9 @@ ast_ *handle_defined_loop(parser_ *parser, scope_ *scope)
     loop_ast->loop_variable->rhs = start_expr;
 
     // Expect and consume the "TO" keyword
-    if (strcmp(parser->current_token->value, "TO") == 0)
+    if (parser_current_is(parser, KEYWORD_TO))
     {
-      parser_expect(parser, TOKEN_ID); // Consume 'TO'
+      parser_expect_keyword(parser, KEYWORD_TO); // Consume 'TO'
 
       // Parse the end expression and assign it to the loop AST
       loop_ast->end_expr = parse_expression(parser, scope);
@@ -671,9 +738,9 @@ ast_ *handle_defined_loop(parser_ *parser, scope_ *scope)
     }
 
     // Optional: Handle the STEP part
-    if (strcmp(parser->current_token->value, "STEP") == 0)
+    if (parser_current_is(parser, KEYWORD_STEP))
     {
-      parser_expect(parser, TOKEN_ID); // Consume 'STEP'
+      parser_expect_keyword(parser, KEYWORD_STEP); // Consume 'STEP'
       loop_ast->step_expr = parse_expression(parser, scope);
     }
     else
@@ -684,11 +751,11 @@ ast_ *handle_defined_loop(parser_ *parser, scope_ *scope)
       loop_ast->step_expr->int_value.null = 0; // Default to step 1
     }
   }
-  else if (strcmp(parser->current_token->value, "IN") == 0)
+  else if (parser_current_is(parser, KEYWORD_IN))
   {
     // Case: FOR variable IN collection
 
-    parser_expect(parser, TOKEN_ID); // Consume 'IN'
+    parser_expect_keyword(parser, KEYWORD_IN); // Consume 'IN'
 
     // Parse the collection expression (could be a string, array, etc.)
     loop_ast->collection_expr = parser_parse_statement(parser, scope);
@@ -706,15 +773,15 @@ ast_ *handle_defined_loop(parser_ *parser, scope_ *scope)
 
   do
   {
-    ast_ *statement = parser_parse_statement(parser, get_scope(loop_ast));
-    add_ast_to_list(&(loop_ast->loop_body), statement); // Add each statement to the loop body
+    ast_ *statement = parser_parse_statement(parser, scope);
+    add_ast_to_list(loop_ast->loop_body, statement); // Add each statement to the loop body
     if (parser->current_token->type == TOKEN_NEWLINE)
     {
       parser_expect(parser, TOKEN_NEWLINE); // Consume newline after each statement
     }
-  } while (strcmp(parser->current_token->value, "ENDFOR") != 0);
+  } while (!parser_current_is(parser, KEYWORD_ENDFOR));
 
-  parser_expect(parser, TOKEN_ID); // Consume 'ENDFOR'
+  parser_expect_keyword(parser, KEYWORD_ENDFOR); // Consume 'ENDFOR'
 
   return loop_ast;
 }
@@ -725,101 +792,93 @@ ast_ *handle_selection(parser_ *parser, scope_ *scope)
   ast_ *selection_ast = init_ast(AST_SELECTION);
 
   // Expect and consume the "IF" keyword
-  parser_expect(parser, TOKEN_ID); // Consume 'IF'
+  parser_expect_keyword(parser, KEYWORD_IF); // Consume 'IF'
 
   // Parse the condition expression
   selection_ast->if_condition = parse_expression(parser, scope);
 
   // Expect and consume the "THEN" keyword
-  parser_expect(parser, TOKEN_ID); // Consume 'THEN'
+  parser_expect_keyword(parser, KEYWORD_THEN); // Consume 'THEN'
 
   // Parse the body of the IF statement
   selection_ast->if_body = init_ast_list();
 
   parser_expect(parser, TOKEN_NEWLINE); // Consume the newline after THEN
-  while (parser->current_token->type != TOKEN_ID ||
-         (strcmp(parser->current_token->value, "ENDIF") != 0 &&
-          strcmp(parser->current_token->value, "ELSE") != 0))
+  while (!parser_current_is(parser, KEYWORD_ENDIF) && !parser_current_is(parser, KEYWORD_ELSE))
   {
     ast_ *statement = parser_parse_statement(parser, scope);
-    add_ast_to_list(&selection_ast->if_body, statement);
+    add_ast_to_list(selection_ast->if_body, statement);
     parser_expect(parser, TOKEN_NEWLINE); // Consume the newline after each statement
   }
 
   // Handle ELSE IF blocks
-  ast_ **else_if_conditions = init_ast_list();
-  ast_ ***else_if_bodies = NULL; // We'll dynamically allocate memory for the list of lists
+  ast_list_ *else_if_conditions = init_ast_list();
+  ast_list_ **else_if_bodies = NULL; // One body per condition, grown alongside else_if_conditions
 
   size_t else_if_body_count = 0;
 
-  while (strcmp(parser->current_token->value, "ELSE") == 0)
+  while (parser_current_is(parser, KEYWORD_ELSE))
   {
-    parser_expect(parser, TOKEN_ID); // Consume 'ELSE'
+    parser_expect_keyword(parser, KEYWORD_ELSE); // Consume 'ELSE'
 
-    if (strcmp(parser->current_token->value, "IF") == 0)
+    if (parser_current_is(parser, KEYWORD_IF))
     {
       // Handle ELSE IF
-      parser_expect(parser, TOKEN_ID); // Consume 'IF'
+      parser_expect_keyword(parser, KEYWORD_IF); // Consume 'IF'
 
       // Parse the condition for ELSE IF
       ast_ *else_if_condition = parse_expression(parser, scope);
-      add_ast_to_list(&else_if_conditions, else_if_condition);
+      add_ast_to_list(else_if_conditions, else_if_condition);
 
       // Expect and consume the "THEN" keyword
-      parser_expect(parser, TOKEN_ID); // Consume 'THEN'
+      parser_expect_keyword(parser, KEYWORD_THEN); // Consume 'THEN'
 
       // Parse the body of the ELSE IF statement
-      ast_ **else_if_body = init_ast_list();
+      ast_list_ *else_if_body = init_ast_list();
       parser_expect(parser, TOKEN_NEWLINE); // Consume the newline after THEN
-      while (parser->current_token->type != TOKEN_ID ||
-             (strcmp(parser->current_token->value, "ENDIF") != 0 &&
-              strcmp(parser->current_token->value, "ELSE") != 0))
+      while (!parser_current_is(parser, KEYWORD_ENDIF) && !parser_current_is(parser, KEYWORD_ELSE))
       {
         ast_ *statement = parser_parse_statement(parser, scope);
-        add_ast_to_list(&else_if_body, statement);
+        add_ast_to_list(else_if_body, statement);
         parser_expect(parser, TOKEN_NEWLINE); // Consume the newline after each statement
       }
 
-      // Expand the else_if_bodies list and add the new body
+      // Expand the else_if_bodies list and add the new body; arena memory cannot be resized, so copy it across
+      ast_list_ **expanded = arena_alloc(parser->arena, sizeof(ast_list_ *) * (else_if_body_count + 1));
+      if (else_if_body_count > 0)
+        memcpy(expanded, else_if_bodies, sizeof(ast_list_ *) * else_if_body_count);
+      else_if_bodies = expanded;
       else_if_body_count++;
-      else_if_bodies = realloc(else_if_bodies, sizeof(ast_ **) * (else_if_body_count + 1));
-      if (else_if_bodies == NULL)
-      {
-        fprintf(stderr, "Error: Memory reallocation failed for else_if_bodies.\n");
-        exit(EXIT_FAILURE);
-      }
 
       else_if_bodies[else_if_body_count - 1] = else_if_body;
-      else_if_bodies[else_if_body_count] = NULL; // Null-terminate the list
     }
     else
     {
       // Handle ELSE block
       selection_ast->else_body = init_ast_list();
       parser_expect(parser, TOKEN_NEWLINE); // Consume the newline after ELSE
-      while (parser->current_token->type != TOKEN_ID || strcmp(parser->current_token->value, "ENDIF") != 0)
+      while (!parser_current_is(parser, KEYWORD_ENDIF))
       {
         ast_ *statement = parser_parse_statement(parser, scope);
-        add_ast_to_list(&selection_ast->else_body, statement);
+        add_ast_to_list(selection_ast->else_body, statement);
       }
     }
   }
 
   // Expect and consume the "ENDIF" keyword
-  parser_expect(parser, TOKEN_ID); // Consume 'ENDIF'
+  parser_expect_keyword(parser, KEYWORD_ENDIF); // Consume 'ENDIF'
 
   // Set the parsed ELSE IF conditions and bodies into the AST
   selection_ast->else_if_conditions = else_if_conditions;
   selection_ast->else_if_bodies = else_if_bodies;
-  set_scope(selection_ast, scope);
   return selection_ast;
 }
 
 ast_ *handle_record_defintion(parser_ *parser, scope_ *scope)
 {
   // Expect and store the record's name
-  parser_expect(parser, TOKEN_ID); // Consume 'RECORD'
-  char *record_name = parser->current_token->value;
+  parser_expect_keyword(parser, KEYWORD_RECORD); // Consume 'RECORD'
+  char *record_name = parser_current_value(parser);
   parser_expect(parser, TOKEN_ID); // Consume the record name
 
   // Initialize the AST node for the record
@@ -827,15 +886,15 @@ ast_ *handle_record_defintion(parser_ *parser, scope_ *scope)
   record_ast->record_name = record_name;
 
   // Initialize the record elements list
-  record_ast->record_elements = (ast_record_element_ **)init_ast_list();
+  record_ast->record_elements = init_ast_list();
 
   parser_expect(parser, TOKEN_NEWLINE);
 
   // Loop to parse all record fields
-  while (strcmp(parser->current_token->value, "ENDRECORD") != 0)
+  while (!parser_current_is(parser, KEYWORD_ENDRECORD))
   {
     // Handle the field name
-    char *field_name = parser->current_token->value;
+    char *field_name = parser_current_value(parser);
     parser_expect(parser, TOKEN_ID); // Consume the field name
 
     // Expect and handle the colon
@@ -846,31 +905,28 @@ ast_ *handle_record_defintion(parser_ *parser, scope_ *scope)
     int dimension = 0; // Initialize dimension counter
 
     // Determine the type of the field
-    if (strcmp(parser->current_token->value, "String") == 0)
+    switch (parser->current_token->keyword)
     {
+    case KEYWORD_STRING:
       field_ast = init_ast(AST_STRING);
-    }
-    else if (strcmp(parser->current_token->value, "Integer") == 0)
-    {
+      break;
+    case KEYWORD_INTEGER:
       field_ast = init_ast(AST_INTEGER);
-    }
-    else if (strcmp(parser->current_token->value, "Real") == 0)
-    {
+      break;
+    case KEYWORD_REAL:
       field_ast = init_ast(AST_REAL);
-    }
-    else if (strcmp(parser->current_token->value, "Boolean") == 0)
-    {
+      break;
+    case KEYWORD_BOOLEAN:
       field_ast = init_ast(AST_BOOLEAN);
-    }
-    else if (strcmp(parser->current_token->value, "Char") == 0)
-    {
+      break;
+    case KEYWORD_CHAR:
       field_ast = init_ast(AST_CHARACTER);
-    }
-    else
-    {
+      break;
+    default:
       field_ast = init_ast(AST_RECORD);
+      break;
     }
-    char *field_type = parser->current_token->value;
+    char *field_type = parser_current_value(parser);
     parser_expect(parser, TOKEN_ID); // Consume the type
 
     // Handle multi-dimensional arrays by counting the dimensions
@@ -893,42 +949,42 @@ ast_ *handle_record_defintion(parser_ *parser, scope_ *scope)
       }
       else if (field_ast->type == AST_STRING)
       {
-        field_ast->string_value = parser->current_token->value; // Store default value as string
+        field_ast->string_value = parser_current_value(parser); // Store default value as string
         parser_expect(parser, TOKEN_STRING);
       }
       else if (field_ast->type == AST_INTEGER)
       {
-        field_ast->int_value.value = atoi(parser->current_token->value); // Convert string to integer
+        field_ast->int_value.value = parser->current_token->int_value; // Decoded by the lexer
         field_ast->int_value.null = 0;
         parser_expect(parser, TOKEN_INT);
       }
       else if (field_ast->type == AST_REAL)
       {
-        field_ast->real_value.value = atof(parser->current_token->value); // Convert string to real
+        field_ast->real_value.value = parser->current_token->real_value; // Decoded by the lexer
         field_ast->real_value.null = 0;
         parser_expect(parser, TOKEN_REAL);
       }
       else if (field_ast->type == AST_BOOLEAN)
       {
-        field_ast->boolean_value.value = strcmp(parser->current_token->value, "True") == 0;
+        field_ast->boolean_value.value = parser_current_is(parser, KEYWORD_TRUE);
         field_ast->boolean_value.null = 0;
         parser_expect(parser, TOKEN_BOOL);
       }
       else if (field_ast->type == AST_CHARACTER)
       {
-        field_ast->char_value.value = parser->current_token->value[0]; // Convert string to character
+        field_ast->char_value.value = parser_current_start(parser)[0]; // Convert string to character
         field_ast->char_value.null = 0;
         parser_expect(parser, TOKEN_CHAR);
       }
       else if (field_ast->type == AST_RECORD)
       {
         field_ast->record_name = field_type;
-        field_ast->record_elements = (ast_record_element_ **)init_ast_list();
+        field_ast->record_elements = init_ast_list();
 
         parser_expect(parser, TOKEN_LBRACE);
         while (parser->current_token->type != TOKEN_RBRACE)
         {
-          char *nested_field_name = parser->current_token->value;
+          char *nested_field_name = parser_current_value(parser);
           parser_expect(parser, TOKEN_ID);    // Consume the nested field name
           parser_expect(parser, TOKEN_COLON); // Consume ':'
 
@@ -938,30 +994,30 @@ ast_ *handle_record_defintion(parser_ *parser, scope_ *scope)
           {
           case TOKEN_STRING:
             nested_field_ast = init_ast(AST_STRING);
-            nested_field_ast->string_value = parser->current_token->value; // Assign the string default value
+            nested_field_ast->string_value = parser_current_value(parser); // Assign the string default value
             parser_expect(parser, TOKEN_STRING);
             break;
           case TOKEN_INT:
             nested_field_ast = init_ast(AST_INTEGER);
-            nested_field_ast->int_value.value = atoi(parser->current_token->value); // Assign integer default
+            nested_field_ast->int_value.value = parser->current_token->int_value; // Assign integer default
             nested_field_ast->int_value.null = 0;
             parser_expect(parser, TOKEN_INT);
             break;
           case TOKEN_REAL:
             nested_field_ast = init_ast(AST_REAL);
-            nested_field_ast->real_value.value = atof(parser->current_token->value); // Assign real default
+            nested_field_ast->real_value.value = parser->current_token->real_value; // Assign real default
             nested_field_ast->real_value.null = 0;
             parser_expect(parser, TOKEN_REAL);
             break;
           case TOKEN_BOOL:
             nested_field_ast = init_ast(AST_BOOLEAN);
-            nested_field_ast->boolean_value.value = strcmp(parser->current_token->value, "True") == 0; // Assign real default
+            nested_field_ast->boolean_value.value = parser_current_is(parser, KEYWORD_TRUE); // Assign real default
             nested_field_ast->boolean_value.null = 0;
             parser_expect(parser, TOKEN_BOOL);
             break;
           case TOKEN_CHAR:
             nested_field_ast = init_ast(AST_CHARACTER);
-            nested_field_ast->char_value.value = parser->current_token->value[0]; // Assign real default
+            nested_field_ast->char_value.value = parser_current_start(parser)[0]; // Assign real default
             nested_field_ast->char_value.null = 0;
             parser_expect(parser, TOKEN_CHAR);
             break;
@@ -969,18 +1025,18 @@ ast_ *handle_record_defintion(parser_ *parser, scope_ *scope)
             nested_field_ast = parse_array(parser, scope);
             break;
           default:
-            fprintf(stderr, "Error: Unknown value type: %s\n", parser->current_token->value);
+            fprintf(stderr, "Error: Unknown value type: %s\n", parser_current_value(parser));
             exit(EXIT_FAILURE);
             break;
           }
 
           // Create the nested record element AST node
-          ast_record_element_ *nested_record_element = malloc(sizeof(ast_record_element_));
+          ast_record_element_ *nested_record_element = arena_alloc(parser->arena, sizeof(ast_record_element_));
           nested_record_element->element_name = nested_field_name;
           nested_record_element->element = nested_field_ast;
 
           // Add the nested element to the record's list
-          add_ast_to_list((ast_ ***)&field_ast->record_elements, (ast_ *)nested_record_element);
+          add_record_element_to_list(field_ast->record_elements, nested_record_element);
           field_ast->field_count++;
           // Expect a comma or closing brace
           if (parser->current_token->type == TOKEN_COMMA)
@@ -992,38 +1048,37 @@ ast_ *handle_record_defintion(parser_ *parser, scope_ *scope)
       }
       else
       {
-        fprintf(stderr, "Error: Default value for type %s is not supported.\n", parser->current_token->value);
+        fprintf(stderr, "Error: Default value for type %s is not supported.\n", parser_current_value(parser));
         exit(EXIT_FAILURE);
       }
     }
 
     // Create the record element AST node
-    ast_record_element_ *record_element = malloc(sizeof(ast_record_element_));
+    ast_record_element_ *record_element = arena_alloc(parser->arena, sizeof(ast_record_element_));
     record_element->element_name = field_name;
     record_element->element = field_ast;
     record_element->dimension = dimension; // Assign the dimension here
 
     // Add the record element to the record's list
-    add_ast_to_list((ast_ ***)&record_ast->record_elements, (ast_ *)record_element);
+    add_record_element_to_list(record_ast->record_elements, record_element);
     record_ast->field_count++;
     parser_expect(parser, TOKEN_NEWLINE);
   }
 
-  parser_expect(parser, TOKEN_ID); // Consume 'ENDRECORD'
-  set_scope(record_ast, scope);
+  parser_expect_keyword(parser, KEYWORD_ENDRECORD); // Consume 'ENDRECORD'
   return record_ast;
 }
 
 ast_ *handle_subroutine(parser_ *parser, scope_ *scope)
 {
   // Expect 'SUBROUTINE' keyword and subroutine name
-  parser_expect(parser, TOKEN_ID); // Consume 'SUBROUTINE'
-  char *subroutine_name = parser->current_token->value;
+  parser_expect_keyword(parser, KEYWORD_SUBROUTINE); // Consume 'SUBROUTINE'
+  char *subroutine_name = parser_current_value(parser);
   parser_expect(parser, TOKEN_ID); // Consume subroutine name
 
   // Create the subroutine AST node
   ast_ *subroutine_ast = init_ast(AST_SUBROUTINE);
-  subroutine_ast->subroutine_name = strdup(subroutine_name);
+  subroutine_ast->subroutine_name = subroutine_name;
 
   // Parse parameter list
   parser_expect(parser, TOKEN_LPAREN); // Consume '('
@@ -1034,8 +1089,8 @@ ast_ *handle_subroutine(parser_ *parser, scope_ *scope)
     if (parser->current_token->type == TOKEN_ID)
     {
       ast_ *param = init_ast(AST_VARIABLE);
-      param->variable_name = strdup(parser->current_token->value);
-      add_ast_to_list(&(subroutine_ast->parameters), param);
+      param->variable_name = parser_current_name(parser);
+      add_ast_to_list(subroutine_ast->parameters, param);
       subroutine_ast->parameter_count++;
       parser_expect(parser, TOKEN_ID); // Consume the parameter
 
@@ -1044,7 +1099,7 @@ ast_ *handle_subroutine(parser_ *parser, scope_ *scope)
     }
     else
     {
-      fprintf(stderr, "Error: Unexpected token in parameter list: %s\n", parser->current_token->value);
+      fprintf(stderr, "Error: Unexpected token in parameter list: %s\n", parser_current_value(parser));
       exit(EXIT_FAILURE);
     }
   }
@@ -1055,23 +1110,18 @@ ast_ *handle_subroutine(parser_ *parser, scope_ *scope)
   // Parse the subroutine body
   subroutine_ast->body = init_ast_list();
 
-  while (strcmp(parser->current_token->value, "ENDSUBROUTINE") != 0)
+  while (!parser_current_is(parser, KEYWORD_ENDSUBROUTINE))
   {
-    ast_ *statement = parser_parse_statement(parser, get_scope(subroutine_ast)); // Use subroutine's local scope
-
-    if (statement->type == AST_RETURN)
-    {
-      // Add return to the body, interpreter will handle actual returning logic
-      subroutine_ast->return_value = statement->return_value;
-    }
+    ast_ *statement = parser_parse_statement(parser, scope);
 
-    add_ast_to_list(&(subroutine_ast->body), statement);
+    // RETURN statements stay in the body; the interpreter handles the actual returning logic
+    add_ast_to_list(subroutine_ast->body, statement);
 
     if (parser->current_token->type == TOKEN_NEWLINE)
       parser_expect(parser, TOKEN_NEWLINE); // Consume newline after each statement
   }
 
-  parser_expect(parser, TOKEN_ID); // Consume 'ENDSUBROUTINE'
+  parser_expect_keyword(parser, KEYWORD_ENDSUBROUTINE); // Consume 'ENDSUBROUTINE'
   return subroutine_ast;
 }
 
@@ -1081,11 +1131,10 @@ ast_ *handle_return(parser_ *parser, scope_ *scope)
   ast_ *return_ast = init_ast(AST_RETURN);
 
   // Expect and consume the "RETURN" keyword
-  parser_expect(parser, TOKEN_ID); // Consume the 'RETURN' token
+  parser_expect_keyword(parser, KEYWORD_RETURN); // Consume the 'RETURN' token
 
   // Parse the expression following the RETURN keyword
   return_ast->return_value = parse_expression(parser, scope);
-  set_scope(return_ast, scope);
 
   return return_ast;
 }
@@ -1096,7 +1145,7 @@ ast_ *handle_output(parser_ *parser, scope_ *scope)
   ast_ *output_ast = init_ast(AST_OUTPUT);
 
   // Expect and consume the "OUTPUT" keyword
-  parser_expect(parser, TOKEN_ID); // Consume the 'OUTPUT' token
+  parser_expect_keyword(parser, KEYWORD_OUTPUT); // Consume the 'OUTPUT' token
 
   // Initialize the list of output expressions
   output_ast->output_expressions = init_ast_list();
@@ -1104,7 +1153,7 @@ ast_ *handle_output(parser_ *parser, scope_ *scope)
   do
   {
     ast_ *arg = parse_expression(parser, scope);
-    add_ast_to_list(&(output_ast->output_expressions), arg);
+    add_ast_to_list(output_ast->output_expressions, arg);
     if (parser->current_token->type == TOKEN_COMMA)
     {
       parser_expect(parser, TOKEN_COMMA); // Consume ','
@@ -1115,7 +1164,6 @@ ast_ *handle_output(parser_ *parser, scope_ *scope)
     }
   } while (parser->current_token->type != TOKEN_NEWLINE);
 
-  set_scope(output_ast, scope);
   return output_ast;
 }
 
@@ -1125,16 +1173,15 @@ ast_ *handle_exit(parser_ *parser, scope_ *scope)
   ast_ *exit_ast = init_ast(AST_EXIT);
 
   // Expect and consume the "EXIT" keyword
-  parser_expect(parser, TOKEN_ID);
+  parser_expect_keyword(parser, KEYWORD_EXIT);
 
   if (parser->current_token->type == TOKEN_INT)
   {
     // Parse and consume the exit code
-    exit_ast->exit_code = atoi(parser->current_token->value);
+    exit_ast->exit_code = parser->current_token->int_value;
     parser_expect(parser, TOKEN_INT);
   }
   parser_expect(parser, TOKEN_NEWLINE);
 
-  set_scope(exit_ast, scope);
   return exit_ast;
 }
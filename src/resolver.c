@@ -0,0 +1,374 @@
+#include "include/resolver.h"
+#include "include/intern.h"
+#include <stdio.h>
+#include <string.h>
+
+// The resolver walks a parsed program once before it runs and gives every variable reference a (depth, slot)
+// coordinate: how many scopes out from the current one the variable lives, and its slot there. The blocks that get a
+// scope of their own at runtime are the global scope, each loop and each subroutine call's frame. A frame's parent is
+// the global scope, so a subroutine body sees its parameters, its own variables and the program's globals.
+
+resolver_ *init_resolver(scope_ *global_scope)
+{
+  resolver_ *resolver = calloc(1, sizeof(struct RESOLVER_STRUCT));
+  resolver_block_ *global = calloc(1, sizeof(struct RESOLVER_BLOCK_STRUCT));
+  if (!resolver || !global)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for resolver.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  global->scope = global_scope;
+  global->constants = init_ast_list();
+  resolver->block = global;
+  resolver->global = global;
+  resolver->subroutines = init_ast_list();
+  return resolver;
+}
+
+// Finds the nearest block declaring `name`, storing how far out it is and the name's slot there.
+static resolver_block_ *resolver_lookup(resolver_ *resolver, const char *name, int *depth, long *slot)
+{
+  *depth = 0;
+  for (resolver_block_ *block = resolver->block; block != NULL; block = block->parent, (*depth)++)
+  {
+    *slot = scope_find_slot(block->scope, name);
+    if (*slot >= 0)
+      return block;
+  }
+  return NULL;
+}
+
+// Declares `name` in `block`, recording it in the block's layout if it is new there.
+static long resolver_declare(resolver_block_ *block, const char *name)
+{
+  size_t slot = scope_declare_variable(block->scope, name);
+  scope_layout_ *layout = block->layout;
+
+  if (layout != NULL && slot == layout->size)
+  {
+    if (layout->size == layout->capacity)
+    {
+      layout->capacity = layout->capacity ? layout->capacity * 2 : 8;
+      layout->names = realloc(layout->names, layout->capacity * sizeof(const char *));
+      if (!layout->names)
+      {
+        fprintf(stderr, "Error: Memory allocation failed for scope layout.\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    layout->names[layout->size++] = intern_name(name);
+  }
+
+  return (long)slot;
+}
+
+// Whether the variable in `slot` of `block` was declared CONSTANT, in this program or an earlier REPL line.
+static int resolver_is_constant(resolver_block_ *block, long slot, const char *name)
+{
+  ast_ *existing = block->scope->slots[slot];
+  if (existing != NULL && existing->lhs->constant == 1)
+    return 1;
+
+  for (size_t i = 0; i < block->constants->size; i++)
+  {
+    if (strcmp(block->constants->items[i]->variable_name, name) == 0)
+      return 1;
+  }
+  return 0;
+}
+
+// Makes sure a name assigned in the current block has a slot, without resolving a particular reference to it.
+static void resolver_declare_name(resolver_ *resolver, const char *name)
+{
+  int depth;
+  long slot;
+  if (resolver_lookup(resolver, name, &depth, &slot) == NULL)
+    resolver_declare(resolver->block, name);
+}
+
+static void resolver_resolve_read(resolver_ *resolver, ast_ *variable)
+{
+  int depth;
+  long slot;
+  if (resolver_lookup(resolver, variable->variable_name, &depth, &slot) != NULL)
+  {
+    variable->depth = depth;
+    variable->slot = (int)slot;
+    return;
+  }
+
+  variable->depth = -1;
+  if (resolver->checked)
+  {
+    fprintf(stderr, "Resolver Error: Undefined variable `%s`\n", variable->variable_name);
+    exit(EXIT_FAILURE);
+  }
+}
+
+static void resolver_resolve_write(resolver_ *resolver, ast_ *variable)
+{
+  int depth;
+  long slot;
+  resolver_block_ *block = resolver_lookup(resolver, variable->variable_name, &depth, &slot);
+
+  if (block != NULL)
+  {
+    if (resolver->checked && resolver_is_constant(block, slot, variable->variable_name))
+    {
+      fprintf(stderr, "Resolver Error: Cannot overwrite constant variable '%s'.\n", variable->variable_name);
+      exit(EXIT_FAILURE);
+    }
+  }
+  else
+  {
+    // Assigning a name that isn't set anywhere creates it in the current scope
+    block = resolver->block;
+    depth = 0;
+    slot = resolver_declare(block, variable->variable_name);
+  }
+
+  variable->depth = depth;
+  variable->slot = (int)slot;
+  if (variable->constant == 1)
+    add_ast_to_list(block->constants, variable);
+}
+
+// Declares every name a loop body assigns at its own level up front, since a statement sees what a later one
+// assigned on the previous iteration. Nested loops declare their own names, apart from the loop variable, which is
+// reset in this scope once they finish.
+static void resolver_collect(resolver_ *resolver, ast_list_ *statements)
+{
+  for (size_t i = 0; statements != NULL && i < statements->size; i++)
+  {
+    ast_ *statement = statements->items[i];
+
+    switch (statement->type)
+    {
+    case AST_ASSIGNMENT:
+      if (statement->lhs->type == AST_VARIABLE)
+        resolver_declare_name(resolver, statement->lhs->variable_name);
+      break;
+    case AST_DEFINITE_LOOP:
+      resolver_declare_name(resolver, statement->loop_variable->lhs->variable_name);
+      break;
+    case AST_SELECTION:
+      resolver_collect(resolver, statement->if_body);
+      for (size_t j = 0; statement->else_if_conditions != NULL && j < statement->else_if_conditions->size; j++)
+        resolver_collect(resolver, statement->else_if_bodies[j]);
+      resolver_collect(resolver, statement->else_body);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+static void resolver_resolve_node(resolver_ *resolver, ast_ *node);
+
+// Resolves a list of statements in order; nothing after an EXIT runs, so it is not checked.
+static void resolver_resolve_statements(resolver_ *resolver, ast_list_ *statements)
+{
+  int checked = resolver->checked;
+
+  for (size_t i = 0; statements != NULL && i < statements->size; i++)
+  {
+    resolver_resolve_node(resolver, statements->items[i]);
+    if (statements->items[i]->type == AST_EXIT)
+      resolver->checked = 0;
+  }
+
+  resolver->checked = checked;
+}
+
+// Starts resolving a block nested in `parent`, which gets a stand-in scope and a fresh layout.
+static void resolver_enter_block(resolver_ *resolver, resolver_block_ *block, resolver_block_ *parent)
+{
+  block->parent = parent;
+  block->scope = init_scope(NULL, "resolver_scope");
+  block->layout = calloc(1, sizeof(scope_layout_));
+  block->constants = init_ast_list();
+  if (!block->layout)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for scope layout.\n");
+    exit(EXIT_FAILURE);
+  }
+  resolver->block = block;
+}
+
+// Finishes a block entered with resolver_enter_block, returning its layout (NULL if it declares nothing).
+static scope_layout_ *resolver_leave_block(resolver_ *resolver, resolver_block_ *block, resolver_block_ *previous)
+{
+  resolver->block = previous;
+  free_scope(block->scope);
+  free(block->constants->items);
+  free(block->constants);
+
+  if (block->layout->size == 0)
+  {
+    free(block->layout);
+    return NULL;
+  }
+  return block->layout;
+}
+
+static void resolver_resolve_loop(resolver_ *resolver, ast_ *node)
+{
+  // The loop's header is evaluated in the enclosing scope
+  if (node->type == AST_DEFINITE_LOOP)
+  {
+    resolver_resolve_node(resolver, node->collection_expr);
+    resolver_resolve_node(resolver, node->loop_variable->rhs);
+    resolver_resolve_node(resolver, node->end_expr);
+    resolver_resolve_node(resolver, node->step_expr);
+  }
+  else
+  {
+    resolver_resolve_node(resolver, node->condition);
+  }
+
+  resolver_block_ *enclosing = resolver->block;
+  resolver_block_ block;
+  resolver_enter_block(resolver, &block, enclosing);
+
+  if (node->type == AST_DEFINITE_LOOP)
+  {
+    resolver_resolve_write(resolver, node->loop_variable->lhs); // Set in the loop's scope before every iteration
+  }
+  resolver_collect(resolver, node->loop_body);
+  resolver_resolve_statements(resolver, node->loop_body);
+
+  node->layout = resolver_leave_block(resolver, &block, enclosing);
+
+  // The loop variable is reset in the enclosing scope once the loop finishes
+  if (node->type == AST_DEFINITE_LOOP)
+  {
+    resolver_declare_name(resolver, node->loop_variable->lhs->variable_name);
+  }
+}
+
+// Whether evaluating an operand calls a subroutine, or may, without going through an array index or record access
+static int resolver_makes_call(ast_ *operand)
+{
+  if (operand == NULL)
+    return 0;
+  if (operand->type == AST_ARITHMETIC_EXPRESSION || operand->type == AST_BOOLEAN_EXPRESSION)
+    return operand->calls;
+  return operand->type == AST_INSTANTIATION;
+}
+
+static void resolver_resolve_node(resolver_ *resolver, ast_ *node)
+{
+  if (node == NULL)
+    return;
+
+  switch (node->type)
+  {
+  case AST_COMPOUND:
+    resolver_resolve_statements(resolver, node->compound_value);
+    break;
+  case AST_VARIABLE:
+  case AST_RECORD_ACCESS:
+    resolver_resolve_read(resolver, node);
+    break;
+  case AST_ARRAY_ACCESS:
+    for (size_t i = 0; i < node->index->size; i++)
+      resolver_resolve_node(resolver, node->index->items[i]);
+    resolver_resolve_read(resolver, node);
+    break;
+  case AST_ARRAY:
+    for (size_t i = 0; i < node->array_elements->size; i++)
+      resolver_resolve_node(resolver, node->array_elements->items[i]);
+    break;
+  case AST_INSTANTIATION:
+    for (size_t i = 0; i < node->arguments->size; i++)
+    {
+      // Named arguments assign a record field, not a variable
+      ast_ *argument = node->arguments->items[i];
+      resolver_resolve_node(resolver, argument->type == AST_ASSIGNMENT ? argument->rhs : argument);
+    }
+    break;
+  case AST_ARITHMETIC_EXPRESSION:
+  case AST_BOOLEAN_EXPRESSION:
+    resolver_resolve_node(resolver, node->left);
+    resolver_resolve_node(resolver, node->right);
+    node->calls = resolver_makes_call(node->left) || resolver_makes_call(node->right);
+    break;
+  case AST_ASSIGNMENT:
+    resolver_resolve_node(resolver, node->rhs);
+    if (node->lhs->type == AST_VARIABLE)
+    {
+      resolver_resolve_write(resolver, node->lhs);
+    }
+    else
+    {
+      // Assigning an element or field updates the array or record, which must already exist
+      resolver_resolve_node(resolver, node->lhs);
+      if ((node->lhs->type == AST_ARRAY_ACCESS || node->lhs->type == AST_RECORD_ACCESS) && node->lhs->depth >= 0)
+        resolver_resolve_write(resolver, node->lhs); // Only checks it isn't a constant, as the name was found
+    }
+    break;
+  case AST_OUTPUT:
+    for (size_t i = 0; i < node->output_expressions->size; i++)
+      resolver_resolve_node(resolver, node->output_expressions->items[i]);
+    break;
+  case AST_RETURN:
+    resolver_resolve_node(resolver, node->return_value);
+    break;
+  case AST_DEFINITE_LOOP:
+  case AST_INDEFINITE_LOOP:
+    resolver_resolve_loop(resolver, node);
+    break;
+  case AST_SELECTION:
+    resolver_resolve_node(resolver, node->if_condition);
+    resolver_resolve_statements(resolver, node->if_body);
+    for (size_t i = 0; node->else_if_conditions != NULL && i < node->else_if_conditions->size; i++)
+    {
+      resolver_resolve_node(resolver, node->else_if_conditions->items[i]);
+      resolver_resolve_statements(resolver, node->else_if_bodies[i]);
+    }
+    resolver_resolve_statements(resolver, node->else_body);
+    break;
+  case AST_SUBROUTINE:
+    // Bodies are resolved once the whole program has been, so they see every global however late it is assigned.
+    // A subroutine defined after an EXIT is never defined at all.
+    if (resolver->checked)
+      add_ast_to_list(resolver->subroutines, node);
+    break;
+  default:
+    break;
+  }
+}
+
+// Resolves a subroutine body in the block of its frame, whose first slots hold the parameters.
+static void resolver_resolve_subroutine(resolver_ *resolver, ast_ *node)
+{
+  resolver_block_ *caller = resolver->block;
+  resolver_block_ block;
+  resolver_enter_block(resolver, &block, resolver->global);
+
+  for (int i = 0; i < node->parameter_count; i++)
+  {
+    ast_ *parameter = node->parameters->items[i];
+    parameter->depth = 0;
+    parameter->slot = (int)resolver_declare(&block, parameter->variable_name);
+  }
+  resolver_resolve_statements(resolver, node->body);
+
+  node->frame_layout = resolver_leave_block(resolver, &block, caller);
+}
+
+// Resolves a parsed program against the global scope, declaring its global variables there. Exits with an error if
+// the program reads a variable that can never have been set or assigns to a constant.
+void resolver_resolve(resolver_ *resolver, ast_ *root)
+{
+  resolver->checked = 1;
+  resolver_resolve_node(resolver, root);
+
+  // Subroutines defined inside a body are appended as it is resolved, and picked up by the same loop
+  for (size_t i = 0; i < resolver->subroutines->size; i++)
+  {
+    resolver_resolve_subroutine(resolver, resolver->subroutines->items[i]);
+  }
+  resolver->subroutines->size = 0;
+}
@@ -0,0 +1,200 @@
+#include "include/scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+static int is_identifier_char(unsigned char c)
+{
+  return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '_';
+}
+
+/* Scalar kernels: one character at a time, also used for the tails of the vector kernels */
+
+static size_t scan_blanks_scalar(const char *text, size_t index, size_t length)
+{
+  while (index < length && (text[index] == ' ' || text[index] == '\t'))
+    index++;
+  return index;
+}
+
+static size_t scan_line_end_scalar(const char *text, size_t index, size_t length)
+{
+  while (index < length && text[index] != '\n')
+    index++;
+  return index;
+}
+
+static size_t scan_identifier_scalar(const char *text, size_t index, size_t length)
+{
+  while (index < length && is_identifier_char((unsigned char)text[index]))
+    index++;
+  return index;
+}
+
+static const scan_kernels_ scalar_kernels = {"scalar", scan_blanks_scalar, scan_line_end_scalar, scan_identifier_scalar};
+
+const scan_kernels_ *scan_scalar_kernels()
+{
+  return &scalar_kernels;
+}
+
+#ifdef SCAN_X86
+
+/* SSE2 kernels: 16 bytes per step. Each block builds a mask of the bytes that end the run and
+ * the lowest set bit gives the position. Loads never go past `length`; the tail is scalar. */
+
+// Bytes >= 0x80 compare as negative, so they fall outside every ASCII range below.
+__attribute__((target("sse2"))) static __m128i identifier_mask_sse2(__m128i block)
+{
+  __m128i lower = _mm_or_si128(block, _mm_set1_epi8(0x20)); // Fold upper case onto lower case
+  __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+  __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+  __m128i underscore = _mm_cmpeq_epi8(block, _mm_set1_epi8('_'));
+  return _mm_or_si128(_mm_or_si128(digit, alpha), underscore);
+}
+
+__attribute__((target("sse2"))) static size_t scan_blanks_sse2(const char *text, size_t index, size_t length)
+{
+  // Most gaps between tokens are a single space, which is cheaper to step over without a vector load
+  if (index + 1 < length && text[index + 1] != ' ' && text[index + 1] != '\t')
+    return text[index] == ' ' || text[index] == '\t' ? index + 1 : index;
+
+  while (index + 16 <= length)
+  {
+    __m128i block = _mm_loadu_si128((const __m128i *)(text + index));
+    __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\t')));
+    unsigned int stop = ~_mm_movemask_epi8(blank) & 0xFFFF;
+    if (stop)
+      return index + __builtin_ctz(stop);
+    index += 16;
+  }
+  return scan_blanks_scalar(text, index, length);
+}
+
+__attribute__((target("sse2"))) static size_t scan_line_end_sse2(const char *text, size_t index, size_t length)
+{
+  while (index + 16 <= length)
+  {
+    __m128i block = _mm_loadu_si128((const __m128i *)(text + index));
+    unsigned int stop = _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+    if (stop)
+      return index + __builtin_ctz(stop);
+    index += 16;
+  }
+  return scan_line_end_scalar(text, index, length);
+}
+
+__attribute__((target("sse2"))) static size_t scan_identifier_sse2(const char *text, size_t index, size_t length)
+{
+  while (index + 16 <= length)
+  {
+    __m128i block = _mm_loadu_si128((const __m128i *)(text + index));
+    unsigned int stop = ~_mm_movemask_epi8(identifier_mask_sse2(block)) & 0xFFFF;
+    if (stop)
+      return index + __builtin_ctz(stop);
+    index += 16;
+  }
+  return scan_identifier_scalar(text, index, length);
+}
+
+static const scan_kernels_ sse2_kernels = {"sse2", scan_blanks_sse2, scan_line_end_sse2, scan_identifier_sse2};
+
+/* AVX2 kernels: the same masks over 32 bytes per step, compiled for AVX2 without changing the global flags */
+
+__attribute__((target("avx2"))) static __m256i identifier_mask_avx2(__m256i block)
+{
+  __m256i lower = _mm256_or_si256(block, _mm256_set1_epi8(0x20));
+  __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), block));
+  __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+  __m256i underscore = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('_'));
+  return _mm256_or_si256(_mm256_or_si256(digit, alpha), underscore);
+}
+
+__attribute__((target("avx2"))) static size_t scan_blanks_avx2(const char *text, size_t index, size_t length)
+{
+  // Most gaps between tokens are a single space, which is cheaper to step over without a vector load
+  if (index + 1 < length && text[index + 1] != ' ' && text[index + 1] != '\t')
+    return text[index] == ' ' || text[index] == '\t' ? index + 1 : index;
+
+  while (index + 32 <= length)
+  {
+    __m256i block = _mm256_loadu_si256((const __m256i *)(text + index));
+    __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t')));
+    unsigned int stop = ~(unsigned int)_mm256_movemask_epi8(blank);
+    if (stop)
+      return index + __builtin_ctz(stop);
+    index += 32;
+  }
+  return scan_blanks_scalar(text, index, length);
+}
+
+__attribute__((target("avx2"))) static size_t scan_line_end_avx2(const char *text, size_t index, size_t length)
+{
+  while (index + 32 <= length)
+  {
+    __m256i block = _mm256_loadu_si256((const __m256i *)(text + index));
+    unsigned int stop = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')));
+    if (stop)
+      return index + __builtin_ctz(stop);
+    index += 32;
+  }
+  return scan_line_end_scalar(text, index, length);
+}
+
+__attribute__((target("avx2"))) static size_t scan_identifier_avx2(const char *text, size_t index, size_t length)
+{
+  while (index + 32 <= length)
+  {
+    __m256i block = _mm256_loadu_si256((const __m256i *)(text + index));
+    unsigned int stop = ~(unsigned int)_mm256_movemask_epi8(identifier_mask_avx2(block));
+    if (stop)
+      return index + __builtin_ctz(stop);
+    index += 32;
+  }
+  return scan_identifier_scalar(text, index, length);
+}
+
+static const scan_kernels_ avx2_kernels = {"avx2", scan_blanks_avx2, scan_line_end_avx2, scan_identifier_avx2};
+
+const scan_kernels_ *scan_sse2_kernels()
+{
+  return __builtin_cpu_supports("sse2") ? &sse2_kernels : NULL;
+}
+
+const scan_kernels_ *scan_avx2_kernels()
+{
+  return __builtin_cpu_supports("avx2") ? &avx2_kernels : NULL;
+}
+
+#else
+
+const scan_kernels_ *scan_sse2_kernels()
+{
+  return NULL;
+}
+
+const scan_kernels_ *scan_avx2_kernels()
+{
+  return NULL;
+}
+
+#endif
+
+// Picks the widest kernels the CPU supports (CPUID via __builtin_cpu_supports), falling back to scalar.
+const scan_kernels_ *scan_select_kernels()
+{
+  static const scan_kernels_ *selected = NULL;
+
+  if (selected == NULL)
+  {
+    selected = scan_avx2_kernels();
+    if (selected == NULL)
+      selected = scan_sse2_kernels();
+    if (selected == NULL)
+      selected = scan_scalar_kernels();
+  }
+
+  return selected;
+}
@@ -1,4 +1,5 @@
 #include "include/scope.h"
+#include "include/intern.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -30,233 +31,73 @@ int is_builtin_method(const char *name)
   return 0; // No match
 }
 
-scope_ *init_scope(scope_ *parent_scope, const char *scope_name)
+// Allocates an empty variable map with room for `capacity` entries.
+static void scope_alloc_variables(scope_ *scope, size_t capacity)
 {
-  scope_ *scope = calloc(1, sizeof(struct SCOPE_STRUCT));
-  if (!scope)
+  scope->variables = calloc(capacity, sizeof(scope_variable_));
+  if (!scope->variables)
   {
-    fprintf(stderr, "Error: Memory allocation failed for scope initialization.\n");
+    fprintf(stderr, "Error: Memory allocation failed for scope variables.\n");
     exit(EXIT_FAILURE);
   }
+  scope->variable_capacity = capacity;
+}
 
-  if (parent_scope)
-  {
-    // Initialize lists from parent scope and copy elements
-    scope->instantiation_definitions = init_ast_list();
-    scope->variable_definitions = init_ast_list();
-
-    // Copy parent instantiation_definitions list
-    for (size_t i = 0; parent_scope->instantiation_definitions[i] != NULL; i++)
-    {
-      add_ast_to_list(&scope->instantiation_definitions, parent_scope->instantiation_definitions[i]);
-    }
+// Freed scopes, linked through their parent field and handed out again by init_scope
+static scope_ *free_scopes = NULL;
 
-    // Copy parent variable_definitions list
-    for (size_t i = 0; parent_scope->variable_definitions[i] != NULL; i++)
+// Creates a scope whose lookups fall back to `parent_scope`. Nothing is copied from the parent, so this is O(1)
+// however much the enclosing program defines; a recycled scope only clears the slots it allocated itself.
+scope_ *init_scope(scope_ *parent_scope, const char *scope_name)
+{
+  scope_ *scope = free_scopes;
+  if (scope)
+  {
+    free_scopes = scope->parent;
+    scope->instantiation_definitions->size = 0;
+    if (scope->variable_count > 0)
     {
-      add_ast_to_list(&scope->variable_definitions, parent_scope->variable_definitions[i]);
+      memset(scope->variables, 0, scope->variable_capacity * sizeof(scope_variable_));
+      scope->variable_count = 0; // Slots are cleared as they are declared again
     }
-    // printf("Created new scope %p from parent scope %p\n", scope, parent_scope);
   }
   else
   {
-    // Initialize empty lists
+    scope = calloc(1, sizeof(struct SCOPE_STRUCT));
+    if (!scope)
+    {
+      fprintf(stderr, "Error: Memory allocation failed for scope initialization.\n");
+      exit(EXIT_FAILURE);
+    }
+
     scope->instantiation_definitions = init_ast_list();
-    scope->variable_definitions = init_ast_list();
-    // printf("Created new scope %p\n", scope);
+    scope_alloc_variables(scope, SCOPE_INITIAL_CAPACITY);
+    scope->slots = malloc(SCOPE_INITIAL_CAPACITY * sizeof(ast_ *));
+    scope->slot_capacity = SCOPE_INITIAL_CAPACITY;
   }
 
+  scope->parent = parent_scope;
   scope->scope_name = scope_name;
 
   return scope;
 }
 
-void set_scope(ast_ *node, scope_ *scope)
+// Returns a scope to the free list once nothing will be defined in or looked up through it again.
+void free_scope(scope_ *scope)
 {
   if (scope == NULL)
     return;
-  if (node == NULL)
-  {
-    // break condition
-    return;
-  }
-
-  // Assign the scope to the node
-  node->scope = scope;
-
-  // If node has child nodes, propagate the scope to them
-  switch (node->type)
-  {
-  case AST_COMPOUND:
-  {
-    int i = 0;
-    while (node->compound_value[i] != NULL)
-    {
-      set_scope(node->compound_value[i], scope);
-      i++;
-    }
-  }
-  break;
-  case AST_ASSIGNMENT:
-    if (node->lhs != NULL)
-    {
-      set_scope(node->lhs, scope);
-    }
-    if (node->rhs != NULL)
-    {
-      set_scope(node->rhs, scope);
-    }
-    break;
-  case AST_ARITHMETIC_EXPRESSION:
-  case AST_BOOLEAN_EXPRESSION:
-    if (node->left != NULL)
-    {
-      set_scope(node->left, scope);
-    }
-    if (node->right != NULL)
-    {
-      set_scope(node->right, scope);
-    }
-    break;
-  case AST_ARRAY_ACCESS:
-  {
-    int i = 0;
-    while (node->index[i] != NULL)
-    {
-      set_scope(node->index[i], scope);
-      i++;
-    }
-  }
-  break;
-  case AST_INSTANTIATION:
-  {
-    int i = 0;
-    while (node->arguments[i] != NULL)
-    {
-      set_scope(node->arguments[i], scope);
-      i++;
-    }
-  }
-  break;
-  case AST_SUBROUTINE:
-  {
-    // Set scope for parameters and body
-    int i = 0;
-    while (node->parameters[i] != NULL)
-    {
-      set_scope(node->parameters[i], scope);
-      i++;
-    }
-    i = 0;
-    while (node->body[i] != NULL)
-    {
-      set_scope(node->body[i], scope);
-      i++;
-    }
-  }
-  break;
-  case AST_DEFINITE_LOOP:
-  case AST_INDEFINITE_LOOP:
-    if (node->loop_variable != NULL)
-    {
-      set_scope(node->loop_variable, scope);
-    }
-    if (node->collection_expr != NULL)
-    {
-      set_scope(node->collection_expr, scope);
-    }
-    if (node->end_expr != NULL)
-    {
-      set_scope(node->end_expr, scope);
-    }
-    if (node->step_expr != NULL)
-    {
-      set_scope(node->step_expr, scope);
-    }
-    {
-      int i = 0;
-      while (node->loop_body[i] != NULL)
-      {
-        set_scope(node->loop_body[i], scope);
-        i++;
-      }
-    }
-    break;
-  case AST_SELECTION:
-    if (node->if_condition != NULL)
-    {
-      set_scope(node->if_condition, scope);
-    }
-    {
-      int i = 0;
-      while (node->if_body[i] != NULL)
-      {
-        set_scope(node->if_body[i], scope);
-        i++;
-      }
-    }
 
-    // Set scope for ELSE IF conditions and bodies
-    if (node->else_if_conditions != NULL && node->else_if_bodies != NULL)
-    {
-      int i = 0;
-      while (node->else_if_conditions[i] != NULL && node->else_if_bodies[i] != NULL)
-      {
-        set_scope(node->else_if_conditions[i], scope);
-
-        int j = 0;
-        while (node->else_if_bodies[i][j] != NULL)
-        {
-          set_scope(node->else_if_bodies[i][j], scope);
-          j++;
-        }
-        i++;
-      }
-    }
-
-    // Set scope for ELSE body
-    if (node->else_body != NULL)
-    {
-      int i = 0;
-      while (node->else_body[i] != NULL)
-      {
-        set_scope(node->else_body[i], scope);
-        i++;
-      }
-    }
-    break;
-  case AST_OUTPUT:
-  {
-    int i = 0;
-    while (node->output_expressions[i] != NULL)
-    {
-      set_scope(node->output_expressions[i], scope);
-      i++;
-    }
-  }
-  case AST_RETURN:
-  {
-    set_scope(node->return_value, scope);
-  }
-  default:
-    break;
-  }
+  scope->parent = free_scopes;
+  free_scopes = scope;
 }
 
-scope_ *get_scope(ast_ *node)
+// Unsets every slot and forgets the scope's instantiation definitions, keeping the variables it declares. A frame
+// reset this way is as good as a new one for another call of the same subroutine.
+void scope_reset(scope_ *scope)
 {
-  if (node == NULL)
-  {
-    fprintf(stderr, "Error: Invalid node\n");
-    return NULL;
-  }
-
-  if (node->scope == NULL)
-  {
-    return NULL;
-  }
-
-  return node->scope;
+  memset(scope->slots, 0, scope->variable_count * sizeof(ast_ *));
+  scope->instantiation_definitions->size = 0;
 }
 
 ast_ *scope_add_instantiation_definition(scope_ *scope, ast_ *idef)
@@ -290,72 +131,80 @@ ast_ *scope_add_instantiation_definition(scope_ *scope, ast_ *idef)
     exit(EXIT_FAILURE);
   }
 
-  // Check for conflicting record or subroutine names
-  for (size_t i = 0; scope->instantiation_definitions[i] != NULL; i++)
+  // Check for conflicting record or subroutine names here and in every enclosing scope
+  for (scope_ *visible = scope; visible != NULL; visible = visible->parent)
   {
-    ast_ *existing_def = scope->instantiation_definitions[i];
-
-    // Check for record name conflicts
-    if (idef->type == AST_RECORD_DEFINITION)
+    for (size_t i = 0; i < visible->instantiation_definitions->size; i++)
     {
-      if (existing_def->type == AST_RECORD_DEFINITION &&
-          strcmp(existing_def->record_name, idef->record_name) == 0)
-      {
-        fprintf(stderr, "Error: Record '%s' already exists in scope `%s`.\n", idef->record_name, scope->scope_name);
-        exit(EXIT_FAILURE);
-      }
-      else if (existing_def->type == AST_SUBROUTINE &&
-               strcmp(existing_def->subroutine_name, idef->record_name) == 0 &&
-               existing_def->parameter_count == idef->field_count)
-      {
-        // A record cannot have the same name and field count as an existing subroutine
-        fprintf(stderr, "Error: Record '%s' with %d fields conflicts with subroutine '%s' with %d parameters in scope `%s`.\n",
-                idef->record_name, idef->field_count, existing_def->subroutine_name, existing_def->parameter_count, scope->scope_name);
-        exit(EXIT_FAILURE);
-      }
-    }
+      ast_ *existing_def = visible->instantiation_definitions->items[i];
 
-    // Check for subroutine name conflicts
-    else if (idef->type == AST_SUBROUTINE)
-    {
-      if (existing_def->type == AST_RECORD_DEFINITION &&
-          strcmp(existing_def->record_name, idef->subroutine_name) == 0 &&
-          existing_def->field_count == idef->parameter_count)
+      // Check for record name conflicts
+      if (idef->type == AST_RECORD_DEFINITION)
       {
-        // A subroutine cannot have the same name and parameter count as an existing record
-        fprintf(stderr, "Error: Subroutine '%s' with %d parameters conflicts with record '%s' with %d fields in scope `%s`.\n",
-                idef->subroutine_name, idef->parameter_count, existing_def->record_name, existing_def->field_count, scope->scope_name);
-        exit(EXIT_FAILURE);
+        if (existing_def->type == AST_RECORD_DEFINITION &&
+            strcmp(existing_def->record_name, idef->record_name) == 0)
+        {
+          fprintf(stderr, "Error: Record '%s' already exists in scope `%s`.\n", idef->record_name, scope->scope_name);
+          exit(EXIT_FAILURE);
+        }
+        else if (existing_def->type == AST_SUBROUTINE &&
+                 strcmp(existing_def->subroutine_name, idef->record_name) == 0 &&
+                 existing_def->parameter_count == idef->field_count)
+        {
+          // A record cannot have the same name and field count as an existing subroutine
+          fprintf(stderr, "Error: Record '%s' with %d fields conflicts with subroutine '%s' with %d parameters in scope `%s`.\n",
+                  idef->record_name, idef->field_count, existing_def->subroutine_name, existing_def->parameter_count, scope->scope_name);
+          exit(EXIT_FAILURE);
+        }
       }
-      else if (existing_def->type == AST_SUBROUTINE &&
-               strcmp(existing_def->subroutine_name, idef->subroutine_name) == 0 &&
-               existing_def->parameter_count == idef->parameter_count)
+
+      // Check for subroutine name conflicts
+      else if (idef->type == AST_SUBROUTINE)
       {
-        // A subroutine cannot have the same name and parameter count as an existing subroutine
-        fprintf(stderr, "Error: Subroutine '%s' with %d parameters already exists in scope `%s`.\n",
-                idef->subroutine_name, idef->parameter_count, scope->scope_name);
-        exit(EXIT_FAILURE);
+        if (existing_def->type == AST_RECORD_DEFINITION &&
+            strcmp(existing_def->record_name, idef->subroutine_name) == 0 &&
+            existing_def->field_count == idef->parameter_count)
+        {
+          // A subroutine cannot have the same name and parameter count as an existing record
+          fprintf(stderr, "Error: Subroutine '%s' with %d parameters conflicts with record '%s' with %d fields in scope `%s`.\n",
+                  idef->subroutine_name, idef->parameter_count, existing_def->record_name, existing_def->field_count, scope->scope_name);
+          exit(EXIT_FAILURE);
+        }
+        else if (existing_def->type == AST_SUBROUTINE &&
+                 strcmp(existing_def->subroutine_name, idef->subroutine_name) == 0 &&
+                 existing_def->parameter_count == idef->parameter_count)
+        {
+          // A subroutine cannot have the same name and parameter count as an existing subroutine
+          fprintf(stderr, "Error: Subroutine '%s' with %d parameters already exists in scope `%s`.\n",
+                  idef->subroutine_name, idef->parameter_count, scope->scope_name);
+          exit(EXIT_FAILURE);
+        }
       }
     }
   }
 
   // Add the record or subroutine definition to the list
-  add_ast_to_list(&scope->instantiation_definitions, idef);
+  add_ast_to_list(scope->instantiation_definitions, idef);
 
   return idef;
 }
 
-ast_ *scope_get_instantiation_definition(scope_ *scope, const char *iname)
+// Searches the outermost scope first, so a name defined in an enclosing scope wins over a local redefinition.
+// Returns NULL when nothing is defined under the name.
+ast_ *scope_find_instantiation_definition(scope_ *scope, const char *iname)
 {
-  if (!scope || !iname)
+  if (scope->parent)
   {
-    fprintf(stderr, "Error: Invalid scope or instantiation name.\n");
-    exit(EXIT_FAILURE);
+    ast_ *idef = scope_find_instantiation_definition(scope->parent, iname);
+    if (idef)
+    {
+      return idef;
+    }
   }
 
-  for (size_t i = 0; scope->instantiation_definitions[i] != NULL; i++)
+  for (size_t i = 0; i < scope->instantiation_definitions->size; i++)
   {
-    ast_ *idef = scope->instantiation_definitions[i];
+    ast_ *idef = scope->instantiation_definitions->items[i];
 
     if (idef->type == AST_SUBROUTINE && strcmp(idef->subroutine_name, iname) == 0)
     {
@@ -366,10 +215,189 @@ ast_ *scope_get_instantiation_definition(scope_ *scope, const char *iname)
       return idef; // Record found
     }
   }
+
+  return NULL;
+}
+
+ast_ *scope_get_instantiation_definition(scope_ *scope, const char *iname)
+{
+  if (!scope || !iname)
+  {
+    fprintf(stderr, "Error: Invalid scope or instantiation name.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  ast_ *idef = scope_find_instantiation_definition(scope, iname);
+  if (idef)
+  {
+    return idef;
+  }
   fprintf(stderr, "Error: No instantiation definition found for '%s' in scope `%s`\n", iname, scope->scope_name);
   exit(EXIT_FAILURE);
 }
 
+// Home entry of an interned name: its address mixed by a Fibonacci multiplier
+static size_t scope_variable_home(const char *name, size_t capacity)
+{
+  return (size_t)(((uintptr_t)name * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+}
+
+// Finds the map entry holding `name`, or the empty entry where it would be inserted.
+static scope_variable_ *scope_find_variable(scope_ *scope, const char *name)
+{
+  size_t mask = scope->variable_capacity - 1;
+  size_t entry = scope_variable_home(name, scope->variable_capacity);
+
+  while (scope->variables[entry].name != NULL && scope->variables[entry].name != name)
+    entry = (entry + 1) & mask;
+
+  return &scope->variables[entry];
+}
+
+// Finds the slot of `name` in the nearest scope of the chain that has set it, returning NULL if none has.
+// Slots that are declared but still unset are passed over, just as if the name weren't there.
+static ast_ **scope_resolve_variable(scope_ *scope, const char *name)
+{
+  for (; scope != NULL; scope = scope->parent)
+  {
+    scope_variable_ *variable = scope_find_variable(scope, name);
+    if (variable->name != NULL && scope->slots[variable->slot] != NULL)
+      return &scope->slots[variable->slot];
+  }
+  return NULL;
+}
+
+// Resolves `name` through the chain, interning it first if a name that isn't interned missed on its address.
+static ast_ **scope_lookup_variable(scope_ *scope, const char *name)
+{
+  ast_ **slot = scope_resolve_variable(scope, name);
+  if (slot == NULL)
+  {
+    const char *interned = intern_name(name);
+    if (interned != name)
+      slot = scope_resolve_variable(scope, interned);
+  }
+  return slot;
+}
+
+// Doubles the variable map, reinserting every entry; the slots themselves don't move.
+static void scope_grow_variables(scope_ *scope)
+{
+  scope_variable_ *old_variables = scope->variables;
+  size_t old_capacity = scope->variable_capacity;
+
+  scope_alloc_variables(scope, old_capacity * 2);
+  for (size_t i = 0; i < old_capacity; i++)
+  {
+    if (old_variables[i].name != NULL)
+    {
+      *scope_find_variable(scope, old_variables[i].name) = old_variables[i];
+    }
+  }
+
+  free(old_variables);
+}
+
+// Returns the slot of an interned name in this scope, declaring it with no value if the scope doesn't have one yet.
+static size_t scope_declare_interned(scope_ *scope, const char *interned)
+{
+  scope_variable_ *variable = scope_find_variable(scope, interned);
+  if (variable->name != NULL)
+  {
+    return variable->slot;
+  }
+
+  if ((scope->variable_count + 1) * 2 > scope->variable_capacity)
+  {
+    scope_grow_variables(scope);
+    variable = scope_find_variable(scope, interned);
+  }
+  if (scope->variable_count == scope->slot_capacity)
+  {
+    scope->slot_capacity *= 2;
+    scope->slots = realloc(scope->slots, scope->slot_capacity * sizeof(ast_ *));
+    if (!scope->slots)
+    {
+      fprintf(stderr, "Error: Memory allocation failed for scope variables.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  variable->name = interned;
+  variable->slot = scope->variable_count++;
+  scope->slots[variable->slot] = NULL;
+
+  return variable->slot;
+}
+
+size_t scope_declare_variable(scope_ *scope, const char *name)
+{
+  return scope_declare_interned(scope, intern_name(name));
+}
+
+// Slot of `name` in this scope alone, or -1 if it isn't declared here.
+long scope_find_slot(scope_ *scope, const char *name)
+{
+  scope_variable_ *variable = scope_find_variable(scope, intern_name(name));
+  return variable->name != NULL ? (long)variable->slot : -1;
+}
+
+// Declares a resolved block's names in a fresh scope, so each one lands in the slot the resolver gave it.
+void scope_declare_layout(scope_ *scope, scope_layout_ *layout)
+{
+  if (layout == NULL)
+    return;
+
+  for (size_t i = 0; i < layout->size; i++)
+  {
+    scope_declare_interned(scope, layout->names[i]); // The resolver only records interned names
+  }
+}
+
+// Prompts for the value of a variable assigned from user input.
+void scope_read_userinput(ast_ *vdef)
+{
+  printf("%s <- ", vdef->lhs->variable_name);
+
+  // Allocate buffer for user input
+  char input_buffer[1024]; // Adjust size as needed
+  if (fgets(input_buffer, sizeof(input_buffer), stdin) != NULL)
+  {
+    // Remove newline character if present
+    size_t len = strlen(input_buffer);
+    if (len > 0 && input_buffer[len - 1] == '\n')
+    {
+      input_buffer[len - 1] = '\0';
+    }
+
+    // Store the input as the variable's value (in vdef->rhs or a suitable location)
+    vdef->rhs->string_value = strdup(input_buffer); // Assuming rhs stores a string_value
+  }
+}
+
+// Stores `vdef` in a slot, overwriting the definition already there unless it is a constant.
+static ast_ *scope_store_variable(ast_ **slot, ast_ *vdef)
+{
+  ast_ *existing = *slot;
+  if (existing == NULL)
+  {
+    *slot = vdef;
+    return vdef;
+  }
+
+  // Check if the existing variable is a constant
+  if (existing->lhs->constant == 1)
+  {
+    fprintf(stderr, "Error: Cannot overwrite constant variable '%s'.\n", vdef->lhs->variable_name);
+    exit(EXIT_FAILURE);
+  }
+
+  // Overwrite the existing variable definition
+  existing->lhs = vdef->lhs;
+  existing->rhs = vdef->rhs;
+  return existing; // Return the overwritten variable
+}
+
 ast_ *scope_add_variable_definition(scope_ *scope, ast_ *vdef)
 {
   if (!scope || !vdef)
@@ -378,55 +406,30 @@ ast_ *scope_add_variable_definition(scope_ *scope, ast_ *vdef)
     exit(EXIT_FAILURE);
   }
 
-  // Variable name is accessed via vdef->lhs->variable_name
-  const char *new_var_name = vdef->lhs->variable_name;
-
   // Check if user input is required for the new variable
   if (vdef->lhs->userinput == 1)
   {
-    printf("%s <- ", new_var_name);
-
-    // Allocate buffer for user input
-    char input_buffer[1024]; // Adjust size as needed
-    if (fgets(input_buffer, sizeof(input_buffer), stdin) != NULL)
-    {
-      // Remove newline character if present
-      size_t len = strlen(input_buffer);
-      if (len > 0 && input_buffer[len - 1] == '\n')
-      {
-        input_buffer[len - 1] = '\0';
-      }
-
-      // Store the input as the variable's value (in vdef->rhs or a suitable location)
-      vdef->rhs->string_value = strdup(input_buffer); // Assuming rhs stores a string_value
-    }
+    scope_read_userinput(vdef);
   }
 
-  // Iterate through the existing variable definitions to check for overwriting
-  for (size_t i = 0; scope->variable_definitions[i] != NULL; i++)
+  // Assigning to a variable of an enclosing scope updates it there
+  const char *name = vdef->lhs->variable_name;
+  ast_ **slot = scope_resolve_variable(scope, name);
+  if (slot == NULL)
   {
-    if (strcmp(scope->variable_definitions[i]->lhs->variable_name, new_var_name) == 0)
-    {
-      // Check if the existing variable is a constant
-      if (scope->variable_definitions[i]->lhs->constant == 1)
-      {
-        fprintf(stderr, "Error: Cannot overwrite constant variable '%s'.\n", new_var_name);
-        exit(EXIT_FAILURE);
-      }
+    const char *interned = intern_name(name);
+    if (interned != name)
+      slot = scope_resolve_variable(scope, interned);
 
-      // Overwrite the existing variable definition
-      // printf("Overwriting variable '%s' in scope %p\n", new_var_name, scope);
-      scope->variable_definitions[i]->lhs = vdef->lhs;
-      scope->variable_definitions[i]->rhs = vdef->rhs;
-      return scope->variable_definitions[i]; // Return the overwritten variable
+    // Otherwise the variable is set in this scope, in the slot it was declared with if it has one
+    if (slot == NULL)
+    {
+      size_t declared = scope_declare_interned(scope, interned); // May move the slots
+      slot = &scope->slots[declared];
     }
   }
 
-  // If no existing variable was found, add the new definition to the list
-  add_ast_to_list(&scope->variable_definitions, vdef);
-  // printf("Adding variable %s to scope %p\n", vdef->lhs->variable_name, scope);
-
-  return vdef;
+  return scope_store_variable(slot, vdef);
 }
 
 ast_ *scope_get_variable_definition(scope_ *scope, const char *vname)
@@ -437,15 +440,55 @@ ast_ *scope_get_variable_definition(scope_ *scope, const char *vname)
     exit(EXIT_FAILURE);
   }
 
-  for (size_t i = 0; scope->variable_definitions[i] != NULL; i++)
+  ast_ **slot = scope_lookup_variable(scope, vname);
+  if (slot != NULL)
   {
-    if (strcmp(scope->variable_definitions[i]->lhs->variable_name, vname) == 0)
-    {
-      // printf("Found variable %s in scope %p with value %d\n", vname, scope, scope->variable_definitions[i]->rhs->int_value.value);
-      return scope->variable_definitions[i]->rhs;
-    }
+    return (*slot)->rhs;
   }
 
   fprintf(stderr, "Error: Variable definition `%s` not found in scope `%s`.\n", vname, scope->scope_name);
   exit(EXIT_FAILURE); // Variable not found
 }
+
+// Slot a resolved variable refers to: `depth` scopes out from `scope`, at the index the resolver gave it.
+static ast_ **scope_variable_slot(scope_ *scope, ast_ *variable)
+{
+  for (int depth = variable->depth; depth > 0; depth--)
+    scope = scope->parent;
+
+  return &scope->slots[variable->slot];
+}
+
+// Like scope_add_variable_definition, but a variable the resolver gave a slot is stored there without a lookup.
+ast_ *scope_assign_variable(scope_ *scope, ast_ *vdef)
+{
+  if (vdef->lhs->depth < 0)
+  {
+    return scope_add_variable_definition(scope, vdef);
+  }
+
+  if (vdef->lhs->userinput == 1)
+  {
+    scope_read_userinput(vdef);
+  }
+
+  return scope_store_variable(scope_variable_slot(scope, vdef->lhs), vdef);
+}
+
+// Like scope_get_variable_definition, but a variable the resolver gave a slot is read from it without a lookup.
+ast_ *scope_read_variable(scope_ *scope, ast_ *variable)
+{
+  if (variable->depth < 0)
+  {
+    return scope_get_variable_definition(scope, variable->variable_name);
+  }
+
+  ast_ *vdef = *scope_variable_slot(scope, variable);
+  if (vdef != NULL)
+  {
+    return vdef->rhs;
+  }
+
+  fprintf(stderr, "Error: Variable definition `%s` not found in scope `%s`.\n", variable->variable_name, scope->scope_name);
+  exit(EXIT_FAILURE); // Variable not set yet
+}
@@ -0,0 +1,781 @@
+#include "include/stack_interpreter.h"
+#include "include/arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Number of work items and values the stacks start with; both double whenever they fill up
+#ifndef STACK_INITIAL_CAPACITY
+#define STACK_INITIAL_CAPACITY 64
+#endif
+
+// What a work item is running
+typedef enum
+{
+  WORK_STATEMENTS, // A list of statements, one after another
+  WORK_OPERATION,  // An arithmetic or boolean expression, once its operands are on the value stack
+  WORK_CALL,       // A subroutine call: its arguments, then its body in a frame of its own
+  WORK_RETURN,
+  WORK_ASSIGNMENT,
+  WORK_OUTPUT,
+  WORK_SELECTION,
+  WORK_FOR_TO,
+  WORK_FOR_IN,
+  WORK_WHILE,
+  WORK_REPEAT,
+} stack_work_kind_;
+
+// A node part-way through running. Whenever it needs a subexpression's value or a body run, the item pushes the
+// work for it and yields; it resumes at `state` once that's done, finding any value on top of the value stack.
+typedef struct STACK_WORK_STRUCT
+{
+  stack_work_kind_ kind;
+  int state;
+  int index;             // Statement, argument, output expression or ELSE IF reached
+  ast_ *node;
+  ast_list_ *statements; // List a WORK_STATEMENTS item runs
+  scope_ *scope;         // Loop scope or call frame the item made, NULL until then
+  scope_ *saved_scope;   // Scope to go back to once the item's body has run
+  union
+  {
+    struct
+    {
+      ast_ *variable;   // Assignment setting the loop variable in the loop's scope
+      ast_ *collection; // String or array a FOR-IN loop walks
+      int64_t start, end, step;
+    } loop;
+    struct
+    {
+      ast_ *definition;       // Subroutine whose body runs next (or is running)
+      ast_ *frame_definition; // Subroutine the frame's layout was declared for
+      int caller;             // Work item of the call this one runs inside, -1 in the main program
+      int discard;            // Whether the call is a statement, so its result is dropped
+    } call;
+    ast_ *tail_call; // Subroutine a RETURN calls in tail position
+  };
+} stack_work_;
+
+typedef struct STACK_INTERPRETER_STRUCT
+{
+  interpreter_ *interpreter; // Scopes and limits, shared with the tree walker for the expressions it evaluates
+  stack_work_ *work;
+  size_t work_count;
+  size_t work_capacity;
+  value_ *values; // Values of evaluated subexpressions and arguments, waiting for the item that needs them
+  size_t value_count;
+  size_t value_capacity;
+  int call; // Innermost WORK_CALL item, -1 in the main program
+} stack_interpreter_;
+
+// What a subroutine returns when its body ends without a RETURN
+static ast_ stack_noop = {.type = AST_NOOP};
+
+static stack_work_ *stack_push_work(stack_interpreter_ *machine, stack_work_kind_ kind, ast_ *node)
+{
+  if (machine->work_count == machine->work_capacity)
+  {
+    machine->work_capacity = machine->work_capacity ? machine->work_capacity * 2 : STACK_INITIAL_CAPACITY;
+    machine->work = realloc(machine->work, machine->work_capacity * sizeof(stack_work_));
+    if (!machine->work)
+    {
+      fprintf(stderr, "Interpreter Error: Memory allocation failed for the work stack.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  stack_work_ *work = &machine->work[machine->work_count++];
+  work->kind = kind;
+  work->state = 0;
+  work->index = 0;
+  work->node = node;
+  work->scope = NULL;
+  return work;
+}
+
+static void stack_push_statements(stack_interpreter_ *machine, ast_list_ *statements)
+{
+  if (statements != NULL && statements->size > 0)
+    stack_push_work(machine, WORK_STATEMENTS, NULL)->statements = statements;
+}
+
+static void stack_push_value(stack_interpreter_ *machine, value_ value)
+{
+  if (machine->value_count == machine->value_capacity)
+  {
+    machine->value_capacity = machine->value_capacity ? machine->value_capacity * 2 : STACK_INITIAL_CAPACITY;
+    machine->values = realloc(machine->values, machine->value_capacity * sizeof(value_));
+    if (!machine->values)
+    {
+      fprintf(stderr, "Interpreter Error: Memory allocation failed for the value stack.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  machine->values[machine->value_count++] = value;
+}
+
+static value_ stack_pop_value(stack_interpreter_ *machine)
+{
+  return machine->values[--machine->value_count];
+}
+
+// Pushes the work for a subroutine call, or an operator with one among its operands, and returns 1; anything else is
+// left to the caller. Operators that make no calls are evaluated by the tree walker, which only recurses as deep as
+// the expression is.
+static int stack_start(stack_interpreter_ *machine, ast_ *node)
+{
+  if ((node->type == AST_ARITHMETIC_EXPRESSION || node->type == AST_BOOLEAN_EXPRESSION) && node->calls)
+  {
+    stack_push_work(machine, WORK_OPERATION, node);
+    return 1;
+  }
+
+  if (node->type == AST_INSTANTIATION)
+  {
+    ast_ *definition = interpreter_called_subroutine(machine->interpreter, node);
+    if (definition != NULL)
+    {
+      stack_work_ *work = stack_push_work(machine, WORK_CALL, node);
+      work->call.definition = definition;
+      work->call.discard = 0;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// Starts evaluating an expression. Returns 0 when work was pushed, so the item asking has to yield until the value
+// is on the value stack; otherwise the tree walker evaluated it straight away, and its value has been pushed.
+static int stack_evaluate(stack_interpreter_ *machine, ast_ *node)
+{
+  if (stack_start(machine, node))
+    return 0;
+
+  stack_push_value(machine, interpreter_evaluate(machine->interpreter, node));
+  return 1;
+}
+
+// Like stack_evaluate, for the places the tree walker keeps the node interpreter_process returns (assigned values,
+// returned values, FOR-IN collections), so a variable assigned from another refers to the same node as it does there.
+// The node is stored in `result` when there was no work to push.
+static int stack_process(stack_interpreter_ *machine, ast_ *node, ast_ **result)
+{
+  if (stack_start(machine, node))
+    return 0;
+
+  *result = interpreter_process(machine->interpreter, node);
+  return 1;
+}
+
+// Whether stack_start would push work for an expression, short of looking up the subroutine a call names
+static int stack_makes_call(ast_ *node)
+{
+  if (node->type == AST_ARITHMETIC_EXPRESSION || node->type == AST_BOOLEAN_EXPRESSION)
+    return node->calls;
+  return node->type == AST_INSTANTIATION;
+}
+
+// Whether a condition evaluated to a boolean that can be tested
+static int stack_condition(value_ condition)
+{
+  return condition.type == AST_BOOLEAN && !condition.null;
+}
+
+// Starts the next body of the call on top of the work stack, taking its arguments off the value stack. The first
+// time a frame is pushed; after a tail call the frame is reset, or recycled for a different subroutine.
+static void stack_enter_call(stack_interpreter_ *machine, stack_work_ *work)
+{
+  interpreter_ *interpreter = machine->interpreter;
+  ast_ *definition = work->call.definition;
+
+  if (work->state == 0)
+  {
+    if (interpreter->call_depth >= interpreter->max_call_depth)
+      interpreter_call_depth_error(interpreter, definition);
+    interpreter->call_depth++;
+
+    work->state = 1;
+    work->saved_scope = interpreter->scope;
+    work->call.frame_definition = NULL;
+    work->call.caller = machine->call;
+    machine->call = (int)(work - machine->work);
+  }
+
+  if (work->call.frame_definition == definition)
+  {
+    scope_reset(work->scope);
+  }
+  else
+  {
+    free_scope(work->scope);
+    work->scope = init_scope(interpreter->global_scope, definition->subroutine_name);
+    scope_declare_layout(work->scope, definition->frame_layout);
+    work->call.frame_definition = definition;
+  }
+
+  machine->value_count -= definition->parameter_count;
+  interpreter_bind_arguments(work->scope, definition, &machine->values[machine->value_count]);
+  interpreter->scope = work->scope;
+  work->index = 0; // The body's statements are run by the call's own item
+}
+
+// Pops the innermost call, leaving its result on the value stack unless the call was a statement.
+static void stack_leave_call(stack_interpreter_ *machine, ast_ *result)
+{
+  interpreter_ *interpreter = machine->interpreter;
+  stack_work_ *work = &machine->work[machine->call];
+
+  interpreter->scope = work->saved_scope;
+  interpreter->call_depth--;
+  free_scope(work->scope);
+  machine->call = work->call.caller;
+
+  int discard = work->call.discard;
+  machine->work_count--;
+  if (!discard)
+    stack_push_value(machine, value_from_ast(result));
+}
+
+// Ends the innermost call from a RETURN, however deep in loops and selections it is. With a tail call, the call's
+// next body runs in the same frame, its arguments already on the value stack.
+static void stack_return(stack_interpreter_ *machine, ast_ *result, ast_ *tail_call)
+{
+  while (machine->work_count - 1 > (size_t)machine->call)
+  {
+    stack_work_ *work = &machine->work[--machine->work_count];
+    if (work->kind >= WORK_FOR_TO && work->scope != NULL)
+      free_scope(work->scope); // A loop the RETURN was in
+  }
+
+  stack_work_ *call = &machine->work[machine->call];
+  if (tail_call != NULL)
+  {
+    call->call.definition = tail_call;
+    stack_enter_call(machine, call);
+  }
+  else
+  {
+    stack_leave_call(machine, result);
+  }
+}
+
+// Starts a statement: those that make calls get a work item, the rest run in the tree walker straight away.
+static void stack_statement(stack_interpreter_ *machine, ast_ *node)
+{
+  switch (node->type)
+  {
+  case AST_COMPOUND:
+    stack_push_statements(machine, node->compound_value);
+    break;
+  case AST_ASSIGNMENT:
+    if (stack_makes_call(node->rhs))
+      stack_push_work(machine, WORK_ASSIGNMENT, node);
+    else
+      interpreter_process_assignment(machine->interpreter, node);
+    break;
+  case AST_OUTPUT:
+    for (size_t i = 0; i < node->output_expressions->size; i++)
+    {
+      if (stack_makes_call(node->output_expressions->items[i]))
+      {
+        stack_push_work(machine, WORK_OUTPUT, node);
+        return;
+      }
+    }
+    interpreter_process_output(machine->interpreter, node);
+    break;
+  case AST_SELECTION:
+    stack_push_work(machine, WORK_SELECTION, node);
+    break;
+  case AST_DEFINITE_LOOP:
+    stack_push_work(machine, node->collection_expr != NULL ? WORK_FOR_IN : WORK_FOR_TO, node);
+    break;
+  case AST_INDEFINITE_LOOP:
+    if (node->indefinite_loop_type == 1)
+      stack_push_work(machine, WORK_WHILE, node);
+    else if (node->indefinite_loop_type == 0)
+      stack_push_work(machine, WORK_REPEAT, node);
+    break;
+  case AST_RETURN:
+    if (machine->call >= 0 && stack_makes_call(node->return_value))
+      stack_push_work(machine, WORK_RETURN, node);
+    else if (machine->call >= 0)
+      stack_return(machine, interpreter_process(machine->interpreter, node->return_value), NULL);
+    else
+      fprintf(stderr, "Interpreter Error: Uncaught statement of type `%s`\n", ast_type_to_string(node->type));
+    break;
+  case AST_INSTANTIATION:
+    if (stack_start(machine, node))
+      machine->work[machine->work_count - 1].call.discard = 1; // A call made as a statement
+    else
+      interpreter_process(machine->interpreter, node);
+    break;
+  default:
+    interpreter_process(machine->interpreter, node);
+    break;
+  }
+}
+
+// Sets a loop variable to a new value in the loop's scope
+static void stack_assign_loop_variable(stack_work_ *work, ast_ *value)
+{
+  work->loop.variable->rhs = value;
+  scope_assign_variable(work->scope, work->loop.variable);
+}
+
+// Runs a loop's body once in the loop's scope; the item resumes at `state` when it's done.
+static void stack_run_loop_body(stack_interpreter_ *machine, stack_work_ *work, int state)
+{
+  work->state = state;
+  work->saved_scope = machine->interpreter->scope;
+  machine->interpreter->scope = work->scope;
+  stack_push_statements(machine, work->node->loop_body);
+}
+
+// Drops a loop whose condition could not be tested, or that has finished
+static void stack_end_loop(stack_interpreter_ *machine, stack_work_ *work)
+{
+  free_scope(work->scope);
+  machine->work_count--;
+}
+
+void stack_interpreter_run(interpreter_ *interpreter, ast_ *root)
+{
+  stack_interpreter_ machine = {interpreter};
+  machine.call = -1;
+
+  // Nodes made while running (bound arguments, assigned values) are bump-allocated rather than taken from the heap
+  // one by one. What the run assigns can outlive it in the global scope, which the REPL runs each line against, so
+  // like the tree walker's nodes the arena is never freed.
+  arena_ *previous_arena = ast_use_arena(init_arena(ARENA_BLOCK_SIZE));
+
+  stack_statement(&machine, root);
+
+  while (machine.work_count > 0)
+  {
+    stack_work_ *work = &machine.work[machine.work_count - 1];
+    ast_ *node = work->node;
+
+    switch (work->kind)
+    {
+    case WORK_STATEMENTS:
+      if (work->index == (int)work->statements->size)
+        machine.work_count--;
+      else
+        stack_statement(&machine, work->statements->items[work->index++]);
+      break;
+
+    case WORK_OPERATION:
+    {
+      if (work->state == 0)
+      {
+        work->state = 1;
+        if (node->left != NULL && !stack_evaluate(&machine, node->left))
+          break;
+      }
+      if (work->state == 1)
+      {
+        work->state = 2;
+        if (!stack_evaluate(&machine, node->right))
+          break;
+      }
+
+      value_ right_val = stack_pop_value(&machine);
+      value_ left_val = node->left != NULL ? stack_pop_value(&machine) : value_error();
+      machine.work_count--;
+      stack_push_value(&machine, interpreter_apply_operation(node, left_val, right_val));
+      break;
+    }
+
+    case WORK_CALL:
+      if (work->state == 1)
+      {
+        if (work->index < (int)work->call.definition->body->size)
+          stack_statement(&machine, work->call.definition->body->items[work->index++]);
+        else
+          stack_leave_call(&machine, &stack_noop); // The body ran to its end without a RETURN
+        break;
+      }
+
+      // Arguments are evaluated in the caller's scope, in order, and wait on the value stack until all are there
+      while (1)
+      {
+        if (work->index > 0 && value_is_error(machine.values[machine.value_count - 1]))
+        {
+          machine.value_count -= work->index;
+          machine.work_count--;
+          if (!work->call.discard)
+            stack_push_value(&machine, value_error());
+          break;
+        }
+        if (work->index == node->arguments_count)
+        {
+          stack_enter_call(&machine, work);
+          break;
+        }
+        if (!stack_evaluate(&machine, node->arguments->items[work->index++]))
+          break;
+      }
+      break;
+
+    case WORK_RETURN:
+    {
+      ast_ *value = node->return_value;
+      ast_ *result = NULL;
+
+      if (work->state == 0)
+      {
+        work->tail_call = interpreter_called_subroutine(interpreter, value);
+        work->state = work->tail_call != NULL ? 1 : 2;
+        if (work->state == 2)
+        {
+          if (!stack_process(&machine, value, &result))
+            break;
+          stack_return(&machine, result, NULL);
+          break;
+        }
+      }
+
+      if (work->state == 2)
+      {
+        stack_return(&machine, value_to_ast(stack_pop_value(&machine)), NULL);
+        break;
+      }
+
+      // A tail call's arguments are evaluated here, in the scope the RETURN is in, like any call's
+      while (1)
+      {
+        if (work->index > 0 && value_is_error(machine.values[machine.value_count - 1]))
+        {
+          machine.value_count -= work->index;
+          stack_return(&machine, NULL, NULL);
+          break;
+        }
+        if (work->index == value->arguments_count)
+        {
+          stack_return(&machine, NULL, work->tail_call);
+          break;
+        }
+        if (!stack_evaluate(&machine, value->arguments->items[work->index++]))
+          break;
+      }
+      break;
+    }
+
+    case WORK_ASSIGNMENT:
+    {
+      ast_ *rhs_value = NULL;
+      if (work->state == 0)
+      {
+        work->state = 1;
+        if (!stack_process(&machine, node->rhs, &rhs_value))
+          break;
+      }
+      else
+      {
+        rhs_value = value_to_ast(stack_pop_value(&machine));
+      }
+
+      machine.work_count--;
+      interpreter_store_assignment(interpreter, node, rhs_value);
+      break;
+    }
+
+    case WORK_OUTPUT:
+    {
+      ast_list_ *expressions = node->output_expressions;
+      while (1)
+      {
+        if (work->state == 1)
+        {
+          interpreter_output_value(stack_pop_value(&machine), interpreter);
+
+          // Print a space between expressions, but avoid trailing space after the last expression
+          if (work->index < (int)expressions->size)
+            printf(" ");
+          work->state = 0;
+        }
+        if (work->index == (int)expressions->size)
+        {
+          printf("\n");
+          machine.work_count--;
+          break;
+        }
+        work->state = 1;
+        if (!stack_evaluate(&machine, expressions->items[work->index++]))
+          break;
+      }
+      break;
+    }
+
+    case WORK_SELECTION:
+    {
+      if (work->state == 0)
+      {
+        if (node->if_condition == NULL || node->if_body == NULL)
+        {
+          fprintf(stderr, "Interpreter Error: IF statement without condition or body\n");
+          machine.work_count--;
+          break;
+        }
+        work->state = 1;
+        if (!stack_evaluate(&machine, node->if_condition))
+          break;
+      }
+
+      if (work->state == 1)
+      {
+        value_ if_condition = stack_pop_value(&machine);
+        if (!stack_condition(if_condition))
+        {
+          fprintf(stderr, "Interpreter Error: IF condition could not be evaluated to a boolean\n");
+          machine.work_count--;
+          break;
+        }
+        if (if_condition.boolean_value)
+        {
+          // The selection has nothing left to do once a body is chosen, so the body takes its place
+          machine.work_count--;
+          stack_push_statements(&machine, node->if_body);
+          break;
+        }
+        work->state = 2;
+      }
+
+      // ELSE IF conditions are tried in order until one holds, then the ELSE body runs if none did
+      while (1)
+      {
+        if (work->state == 3)
+        {
+          value_ else_if_condition = stack_pop_value(&machine);
+          if (!stack_condition(else_if_condition))
+          {
+            fprintf(stderr, "Interpreter Error: ELSE IF condition could not be evaluated to a boolean\n");
+            machine.work_count--;
+            break;
+          }
+          if (else_if_condition.boolean_value)
+          {
+            machine.work_count--;
+            stack_push_statements(&machine, node->else_if_bodies[work->index]);
+            break;
+          }
+          work->index++;
+          work->state = 2;
+        }
+
+        if (node->else_if_conditions == NULL || node->else_if_bodies == NULL ||
+            work->index == (int)node->else_if_conditions->size)
+        {
+          machine.work_count--;
+          stack_push_statements(&machine, node->else_body);
+          break;
+        }
+
+        work->state = 3;
+        if (!stack_evaluate(&machine, node->else_if_conditions->items[work->index]))
+          break;
+      }
+      break;
+    }
+
+    case WORK_FOR_TO:
+    {
+      // FOR variable <- start TO end [STEP step], evaluating end, step and start in that order
+      if (work->state == 0)
+      {
+        work->state = 1;
+        if (!stack_evaluate(&machine, node->end_expr))
+          break;
+      }
+      if (work->state == 1)
+      {
+        value_ end = stack_pop_value(&machine);
+        if (end.type != AST_INTEGER || end.null)
+        {
+          fprintf(stderr, "Interpreter Error: End expression could not be recognized as an integer\n");
+          machine.work_count--;
+          break;
+        }
+        work->loop.end = end.int_value;
+
+        work->state = 2;
+        if (node->step_expr == NULL)
+          stack_push_value(&machine, value_integer(1));
+        else if (!stack_evaluate(&machine, node->step_expr))
+          break;
+      }
+      if (work->state == 2)
+      {
+        value_ step = stack_pop_value(&machine);
+        if (step.type != AST_INTEGER || step.null)
+        {
+          fprintf(stderr, "Interpreter Error: Step expression could not be recognized as an integer\n");
+          machine.work_count--;
+          break;
+        }
+        work->loop.step = step.int_value;
+
+        work->state = 3;
+        if (!stack_evaluate(&machine, node->loop_variable->rhs))
+          break;
+      }
+      if (work->state == 3)
+      {
+        value_ start = stack_pop_value(&machine);
+        if (start.type != AST_INTEGER || start.null)
+        {
+          fprintf(stderr, "Interpreter Error: Start expression could not be recognized as an integer\n");
+          machine.work_count--;
+          break;
+        }
+        work->loop.start = start.int_value;
+
+        // The loop variable is counted in an assignment of this run's own, as in the tree walker
+        work->loop.variable = init_ast(AST_ASSIGNMENT);
+        work->loop.variable->lhs = node->loop_variable->lhs;
+        work->scope = init_scope(interpreter->scope, "child_scope");
+        scope_declare_layout(work->scope, node->layout);
+        stack_assign_loop_variable(work, value_to_ast(start));
+        work->state = 4;
+      }
+      else if (work->state == 5)
+      {
+        // The body has run: step the loop variable
+        interpreter->scope = work->saved_scope;
+        work->loop.variable->rhs->int_value.value += work->loop.step;
+        scope_assign_variable(work->scope, work->loop.variable);
+      }
+
+      int64_t counter = work->loop.variable->rhs->int_value.value;
+      if ((work->loop.step > 0 && counter <= work->loop.end) || (work->loop.step < 0 && counter >= work->loop.end))
+      {
+        stack_run_loop_body(&machine, work, 5);
+        break;
+      }
+
+      // Reset the loop variable to its start value
+      ast_ *reset = init_ast(AST_ASSIGNMENT);
+      reset->lhs = node->loop_variable->lhs;
+      reset->rhs = value_to_ast(value_integer(work->loop.start));
+      stack_end_loop(&machine, work);
+      scope_add_variable_definition(interpreter->scope, reset);
+      break;
+    }
+
+    case WORK_FOR_IN:
+    {
+      if (work->state < 2)
+      {
+        ast_ *collection = NULL;
+        if (work->state == 0)
+        {
+          work->state = 1;
+          if (!stack_process(&machine, node->collection_expr, &collection))
+            break;
+        }
+        else
+        {
+          collection = value_to_ast(stack_pop_value(&machine));
+        }
+
+        if (collection == NULL || (collection->type != AST_STRING && collection->type != AST_ARRAY))
+        {
+          fprintf(stderr, "Interpreter Error: Collection type not supported in FOR-IN loop\n");
+          machine.work_count--;
+          break;
+        }
+
+        work->loop.collection = collection;
+        work->loop.end = collection->type == AST_STRING ? (int64_t)strlen(collection->string_value)
+                                                        : collection->array_size;
+        work->loop.variable = init_ast(AST_ASSIGNMENT);
+        work->loop.variable->lhs = node->loop_variable->lhs;
+        work->scope = init_scope(interpreter->scope, "child_scope");
+        scope_declare_layout(work->scope, node->layout);
+        work->state = 2;
+      }
+      else
+      {
+        interpreter->scope = work->saved_scope; // The body has run
+        work->index++;
+      }
+
+      if (work->index < work->loop.end)
+      {
+        ast_ *collection = work->loop.collection;
+        if (collection->type == AST_STRING)
+        {
+          // Set loop variable to the current character
+          ast_ *character = init_ast(AST_STRING);
+          character->string_value = (char *)malloc(2);
+          character->string_value[0] = collection->string_value[work->index];
+          character->string_value[1] = '\0'; // Null-terminate
+          stack_assign_loop_variable(work, character);
+        }
+        else
+        {
+          stack_assign_loop_variable(work, collection->array_elements->items[work->index]);
+        }
+
+        stack_run_loop_body(&machine, work, 3);
+        break;
+      }
+
+      // Reset the loop variable to its original (unset) value
+      ast_ *reset = init_ast(AST_ASSIGNMENT);
+      reset->lhs = node->loop_variable->lhs;
+      reset->rhs = node->loop_variable->rhs;
+      stack_end_loop(&machine, work);
+      scope_add_variable_definition(interpreter->scope, reset);
+      break;
+    }
+
+    case WORK_WHILE:
+    case WORK_REPEAT:
+    {
+      // Both test their condition before the first run of the body, but a REPEAT runs it regardless
+      if (work->state == 0)
+      {
+        work->scope = init_scope(interpreter->scope, "child_scope");
+        scope_declare_layout(work->scope, node->layout);
+      }
+      else if (work->state == 2)
+      {
+        interpreter->scope = work->saved_scope; // The body has run
+      }
+
+      if (work->state != 1)
+      {
+        work->state = 1;
+        if (!stack_evaluate(&machine, node->condition))
+          break;
+      }
+
+      value_ condition = stack_pop_value(&machine);
+      if (!stack_condition(condition))
+      {
+        fprintf(stderr, "Interpreter Error: Condition could not be evaluated to an integer\n");
+        stack_end_loop(&machine, work);
+        break;
+      }
+
+      int first = work->index == 0;
+      work->index = 1;
+      if (work->kind == WORK_WHILE ? condition.boolean_value : first || !condition.boolean_value)
+      {
+        stack_run_loop_body(&machine, work, 2);
+        break;
+      }
+
+      stack_end_loop(&machine, work);
+      break;
+    }
+    }
+  }
+
+  ast_use_arena(previous_arena);
+  free(machine.work);
+  free(machine.values);
+}
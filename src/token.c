@@ -1,6 +1,7 @@
 #include "include/token.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
 
 const char *token_type_to_string(enum token_type types)
 {
@@ -33,7 +34,8 @@ const char *token_type_to_string(enum token_type types)
       {TOKEN_COLON, "COLON"},
       {TOKEN_FULLSTOP, "FULLSTOP"},
       {TOKEN_PIPE, "PIPE"},
-      {TOKEN_EOF, "END OF FILE"}};
+      {TOKEN_EOF, "END OF FILE"},
+      {TOKEN_KEYWORD, "KEYWORD"}};
 
   int remaining_bits = types;
 
@@ -62,11 +64,143 @@ const char *token_type_to_string(enum token_type types)
   return buffer;
 }
 
-token_ *init_token(enum token_type type, char *value)
+const char *keyword_type_to_string(enum keyword_type keyword)
 {
-  token_ *token = calloc(1, sizeof(token_));
-  token->type = type;
-  token->value = value;
+  static const char *names[] = {
+      [KEYWORD_NONE] = "NONE",
+      [KEYWORD_CONSTANT] = "CONSTANT",
+      [KEYWORD_REPEAT] = "REPEAT",
+      [KEYWORD_UNTIL] = "UNTIL",
+      [KEYWORD_WHILE] = "WHILE",
+      [KEYWORD_ENDWHILE] = "ENDWHILE",
+      [KEYWORD_FOR] = "FOR",
+      [KEYWORD_TO] = "TO",
+      [KEYWORD_STEP] = "STEP",
+      [KEYWORD_IN] = "IN",
+      [KEYWORD_ENDFOR] = "ENDFOR",
+      [KEYWORD_IF] = "IF",
+      [KEYWORD_THEN] = "THEN",
+      [KEYWORD_ELSE] = "ELSE",
+      [KEYWORD_ENDIF] = "ENDIF",
+      [KEYWORD_RECORD] = "RECORD",
+      [KEYWORD_ENDRECORD] = "ENDRECORD",
+      [KEYWORD_SUBROUTINE] = "SUBROUTINE",
+      [KEYWORD_ENDSUBROUTINE] = "ENDSUBROUTINE",
+      [KEYWORD_RETURN] = "RETURN",
+      [KEYWORD_OUTPUT] = "OUTPUT",
+      [KEYWORD_EXIT] = "EXIT",
+      [KEYWORD_USERINPUT] = "USERINPUT",
+      [KEYWORD_STRING] = "String",
+      [KEYWORD_INTEGER] = "Integer",
+      [KEYWORD_REAL] = "Real",
+      [KEYWORD_BOOLEAN] = "Boolean",
+      [KEYWORD_CHAR] = "Char",
+      [KEYWORD_TRUE] = "True",
+      [KEYWORD_FALSE] = "False",
+      [KEYWORD_DIV] = "DIV",
+      [KEYWORD_MOD] = "MOD",
+      [KEYWORD_AND] = "AND",
+      [KEYWORD_OR] = "OR",
+      [KEYWORD_NOT] = "NOT"};
+
+  return names[keyword];
+}
+
+token_ init_token(enum token_type type, unsigned int offset, unsigned int length, int line, int column)
+{
+  token_ token;
+  token.type = type;
+  token.offset = offset;
+  token.length = length;
+  token.line = line;
+  token.column = column;
+  token.keyword = KEYWORD_NONE;
+  token.op = OP_NONE;
+  token.int_value = 0;
 
   return token;
 }
+
+// Returns a pointer to the token's text inside the stream's current source buffer (not NUL-terminated at the token's end).
+const char *token_stream_text(token_stream_ *stream, token_ *token)
+{
+  return stream->source + (token->offset - stream->base);
+}
+
+// Materializes the token's text as an owned, NUL-terminated string.
+char *token_copy_value(token_stream_ *stream, token_ *token)
+{
+  char *value = malloc(token->length + 1);
+  memcpy(value, token_stream_text(stream, token), token->length);
+  value[token->length] = '\0';
+
+  return value;
+}
+
+token_stream_ *init_token_stream(const char *source, unsigned int capacity)
+{
+  token_stream_ *stream = calloc(1, sizeof(token_stream_));
+  stream->source = source;
+  stream->capacity = capacity > 0 ? capacity : 1;
+  stream->tokens = malloc(stream->capacity * sizeof(token_));
+  if (stream->tokens == NULL)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for token stream of %u tokens.\n", stream->capacity);
+    exit(EXIT_FAILURE);
+  }
+
+  return stream;
+}
+
+void free_token_stream(token_stream_ *stream)
+{
+  if (stream == NULL)
+    return;
+
+  free(stream->tokens);
+  free(stream);
+}
+
+void token_stream_push(token_stream_ *stream, token_ token)
+{
+  if (stream->count == stream->capacity && stream->released > stream->discarded)
+  {
+    // Reuse the space of tokens the reader has released before growing
+    unsigned int dropped = stream->released - stream->discarded;
+    if (dropped > stream->count)
+      dropped = stream->count;
+    memmove(stream->tokens, stream->tokens + dropped, (stream->count - dropped) * sizeof(token_));
+    stream->count -= dropped;
+    stream->discarded += dropped;
+  }
+
+  if (stream->count == stream->capacity)
+  {
+    // Grow geometrically so appending stays amortized O(1)
+    stream->capacity *= 2;
+    stream->tokens = realloc(stream->tokens, stream->capacity * sizeof(token_));
+    if (stream->tokens == NULL)
+    {
+      fprintf(stderr, "Error: Memory reallocation failed for token stream of %u tokens.\n", stream->capacity);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  stream->tokens[stream->count++] = token;
+}
+
+// Returns token number `number`, filling the stream as needed and clamping to the terminating TOKEN_EOF.
+// Filling may move the tokens, so pointers from earlier calls should not be kept across this one.
+token_ *token_stream_at(token_stream_ *stream, unsigned int number)
+{
+  while (number >= stream->discarded + stream->count && stream->fill != NULL && stream->fill(stream))
+  {
+  }
+
+  if (number >= stream->discarded + stream->count)
+  {
+    number = stream->discarded + stream->count - 1;
+  }
+
+  return &stream->tokens[number - stream->discarded];
+}
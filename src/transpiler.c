@@ -0,0 +1,1389 @@
+#include "include/transpiler.h"
+#include "include/intern.h"
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The transpiler writes a resolved program out as C that runs it the way the VM does. Every variable becomes a C
+// variable of the main program or subroutine it belongs to, loops' variables included, every subexpression a
+// temporary, and every subroutine a C function; values, operators, records and built-in methods come from the
+// runtime header (runtime/p3_runtime.h), which copies the tree walker's rules and messages. Programs the VM leaves
+// to the tree walker, whose definitions only get a meaning as they run, aren't translated.
+
+// Text of the C being written, grown as it is appended to
+typedef struct TRANSPILER_TEXT_STRUCT
+{
+  char *data;
+  size_t size;
+  size_t capacity;
+} transpiler_text_;
+
+// A block of the program that gets a scope of its own in the tree walker, and the C names of its variables
+typedef struct TRANSPILER_BLOCK_STRUCT
+{
+  struct TRANSPILER_BLOCK_STRUCT *parent;
+  scope_layout_ *layout; // Names the block declares, NULL for the global scope (whose own map is searched)
+  char **names;          // C name of each of the block's variables, by slot
+  size_t size;
+} transpiler_block_;
+
+typedef struct TRANSPILER_STRUCT
+{
+  interpreter_ *interpreter;
+  ast_list_ *definitions;        // Records and subroutines the program defines, outside loops and subroutines
+  transpiler_text_ declarations; // Globals, constants, records and subroutine prototypes
+  transpiler_text_ constants;    // Body of the function that builds array and record constants
+  transpiler_text_ *code;        // Body of the function being written
+  transpiler_block_ *block;      // Innermost block of the code being written
+  ast_ *subroutine;              // Subroutine being written, or NULL for the main program
+  int indent;                    // Levels the next line of code is indented by
+  int temporaries;               // Temporaries the function being written has declared
+  int loop_blocks;               // Loop blocks the function being written has declared variables for
+  int loops;                     // Loops the code being written is nested in, in its function
+  int restarts;                  // Whether the subroutine being written makes a tail call to itself
+  ast_list_ *tail_callees;       // Subroutines another one makes a tail call to, whose trampolines are declared
+  int constant_count;
+  int input_count;
+  char failure[256]; // Why the program can't be translated, empty if it can
+} transpiler_;
+
+static void transpiler_statements(transpiler_ *transpiler, ast_list_ *statements);
+
+static void transpiler_append(transpiler_text_ *text, const char *format, ...)
+{
+  va_list arguments;
+  va_start(arguments, format);
+  int length = vsnprintf(NULL, 0, format, arguments);
+  va_end(arguments);
+
+  if (text->size + length + 1 > text->capacity)
+  {
+    size_t capacity = text->capacity ? text->capacity : 4096;
+    while (text->size + length + 1 > capacity)
+      capacity *= 2;
+    text->data = realloc(text->data, capacity);
+    if (!text->data)
+    {
+      fprintf(stderr, "Error: Memory allocation failed for the transpiler.\n");
+      exit(EXIT_FAILURE);
+    }
+    text->capacity = capacity;
+  }
+
+  va_start(arguments, format);
+  vsnprintf(text->data + text->size, length + 1, format, arguments);
+  va_end(arguments);
+  text->size += length;
+}
+
+// Records why the program can't be translated; the first reason is the one reported
+static void transpiler_fail(transpiler_ *transpiler, const char *format, ...)
+{
+  if (transpiler->failure[0] != '\0')
+    return;
+
+  va_list arguments;
+  va_start(arguments, format);
+  vsnprintf(transpiler->failure, sizeof(transpiler->failure), format, arguments);
+  va_end(arguments);
+}
+
+// Writes a line of code at the current indentation
+static void transpiler_line(transpiler_ *transpiler, const char *format, ...)
+{
+  transpiler_append(transpiler->code, "%*s", 2 * transpiler->indent, "");
+
+  va_list arguments;
+  va_start(arguments, format);
+  int length = vsnprintf(NULL, 0, format, arguments);
+  va_end(arguments);
+  char line[length + 1];
+  va_start(arguments, format);
+  vsnprintf(line, sizeof(line), format, arguments);
+  va_end(arguments);
+
+  transpiler_append(transpiler->code, "%s\n", line);
+}
+
+static void transpiler_open(transpiler_ *transpiler)
+{
+  transpiler_line(transpiler, "{");
+  transpiler->indent++;
+}
+
+static void transpiler_close(transpiler_ *transpiler)
+{
+  transpiler->indent--;
+  transpiler_line(transpiler, "}");
+}
+
+// Declares a temporary holding the value of a C expression, returning its number
+static int transpiler_value(transpiler_ *transpiler, const char *format, ...)
+{
+  va_list arguments;
+  va_start(arguments, format);
+  int length = vsnprintf(NULL, 0, format, arguments);
+  va_end(arguments);
+  char expression[length + 1];
+  va_start(arguments, format);
+  vsnprintf(expression, sizeof(expression), format, arguments);
+  va_end(arguments);
+
+  int temporary = ++transpiler->temporaries;
+  transpiler_line(transpiler, "p3_value_ t%d = %s;", temporary, expression);
+  return temporary;
+}
+
+// Appends a list of temporaries, separated by commas
+static void transpiler_temporary_list(transpiler_text_ *text, const int *temporaries, int count)
+{
+  for (int i = 0; i < count; i++)
+    transpiler_append(text, "%st%d", i > 0 ? ", " : "", temporaries[i]);
+}
+
+// Gives each of a block's variables a C name: the prefix followed by the variable's own name
+static void transpiler_enter_block(transpiler_ *transpiler, transpiler_block_ *block, scope_layout_ *layout,
+                                   const char **names, size_t size, const char *prefix)
+{
+  block->parent = transpiler->block;
+  block->layout = layout;
+  block->size = size;
+  block->names = calloc(size > 0 ? size : 1, sizeof(char *));
+  if (!block->names)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for the transpiler.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (size_t i = 0; i < size; i++)
+  {
+    const char *name = names[i] != NULL ? names[i] : "unused";
+    block->names[i] = malloc(strlen(prefix) + strlen(name) + 1);
+    if (!block->names[i])
+    {
+      fprintf(stderr, "Error: Memory allocation failed for the transpiler.\n");
+      exit(EXIT_FAILURE);
+    }
+    sprintf(block->names[i], "%s%s", prefix, name);
+  }
+  transpiler->block = block;
+}
+
+static void transpiler_leave_block(transpiler_ *transpiler, transpiler_block_ *block)
+{
+  for (size_t i = 0; i < block->size; i++)
+    free(block->names[i]);
+  free(block->names);
+  transpiler->block = block->parent;
+}
+
+// C name of a resolved variable, or NULL if the blocks don't reach it
+static const char *transpiler_variable(transpiler_ *transpiler, int depth, int slot)
+{
+  transpiler_block_ *block = transpiler->block;
+  for (int i = 0; i < depth && block != NULL; i++)
+    block = block->parent;
+
+  if (block == NULL || slot < 0 || (size_t)slot >= block->size)
+  {
+    transpiler_fail(transpiler, "a variable outside the blocks it was resolved to");
+    return NULL;
+  }
+  return block->names[slot];
+}
+
+// C name of the variable `name` the way assigning it by name finds it in the tree walker, from the innermost block
+// outwards
+static const char *transpiler_find_name(transpiler_ *transpiler, const char *name)
+{
+  const char *interned = intern_name(name);
+  for (transpiler_block_ *block = transpiler->block; block != NULL; block = block->parent)
+  {
+    if (block->layout == NULL)
+    {
+      long slot = scope_find_slot(transpiler->interpreter->global_scope, name);
+      if (slot >= 0 && (size_t)slot < block->size)
+        return block->names[slot];
+      continue;
+    }
+
+    for (size_t i = 0; i < block->layout->size; i++)
+    {
+      if (block->layout->names[i] == interned)
+        return block->names[i];
+    }
+  }
+
+  transpiler_fail(transpiler, "a loop variable `%s` that no scope declares", name);
+  return NULL;
+}
+
+// Name of the scope a variable read is reported against, as the tree walker names the scope it runs in
+static const char *transpiler_scope_name(transpiler_ *transpiler)
+{
+  if (transpiler->loops > 0)
+    return "child_scope";
+  if (transpiler->subroutine != NULL)
+    return transpiler->subroutine->subroutine_name;
+  return transpiler->interpreter->global_scope->scope_name;
+}
+
+static const char *transpiler_type_name(enum ast_type type)
+{
+  switch (type)
+  {
+  case AST_INTEGER:
+    return "P3_INTEGER";
+  case AST_REAL:
+    return "P3_REAL";
+  case AST_CHARACTER:
+    return "P3_CHARACTER";
+  case AST_STRING:
+    return "P3_STRING";
+  case AST_BOOLEAN:
+    return "P3_BOOLEAN";
+  case AST_ARRAY:
+    return "P3_ARRAY";
+  case AST_RECORD:
+    return "P3_RECORD";
+  default:
+    return "P3_NOOP";
+  }
+}
+
+// Appends a string as a C string literal
+static void transpiler_string(transpiler_text_ *text, const char *string)
+{
+  transpiler_append(text, "\"");
+  for (const unsigned char *c = (const unsigned char *)string; *c != '\0'; c++)
+  {
+    if (*c == '"' || *c == '\\')
+      transpiler_append(text, "\\%c", *c);
+    else if (*c == '?')
+      transpiler_append(text, "\\?"); // Never part of a trigraph
+    else if (*c < ' ' || *c >= 127)
+      transpiler_append(text, "\\%03o", *c);
+    else
+      transpiler_append(text, "%c", *c);
+  }
+  transpiler_append(text, "\"");
+}
+
+static int transpiler_constant(transpiler_ *transpiler, ast_ *node);
+
+// Appends the value of a literal, or of a record field's default, as a C expression. Arrays and records become
+// constants built before the program starts.
+static void transpiler_literal(transpiler_ *transpiler, transpiler_text_ *text, ast_ *node)
+{
+  switch (node->type)
+  {
+  case AST_INTEGER:
+    if (node->int_value.null)
+      transpiler_append(text, "P3_NULL_VALUE(P3_INTEGER)");
+    else
+      transpiler_append(text, "P3_INTEGER_VALUE(INT64_C(%" PRId64 "))", node->int_value.value);
+    break;
+  case AST_REAL:
+  {
+    if (node->real_value.null)
+    {
+      transpiler_append(text, "P3_NULL_VALUE(P3_REAL)");
+      break;
+    }
+    char real[64];
+    snprintf(real, sizeof(real), "%.17g", node->real_value.value);
+    transpiler_append(text, "P3_REAL_VALUE(%s%s)", real, strpbrk(real, ".en") != NULL ? "" : ".0");
+    break;
+  }
+  case AST_CHARACTER:
+  {
+    unsigned char c = (unsigned char)node->char_value.value;
+    if (node->char_value.null)
+      transpiler_append(text, "P3_NULL_VALUE(P3_CHARACTER)");
+    else if (c >= ' ' && c < 127 && c != '\'' && c != '\\')
+      transpiler_append(text, "P3_CHARACTER_VALUE('%c')", c);
+    else
+      transpiler_append(text, "P3_CHARACTER_VALUE((char)%d)", c);
+    break;
+  }
+  case AST_BOOLEAN:
+    if (node->boolean_value.null)
+      transpiler_append(text, "P3_NULL_VALUE(P3_BOOLEAN)");
+    else
+      transpiler_append(text, "P3_BOOLEAN_VALUE(%d)", node->boolean_value.value ? 1 : 0);
+    break;
+  case AST_STRING:
+    if (node->string_value == NULL)
+    {
+      transpiler_append(text, "P3_STRING_VALUE(NULL)");
+      break;
+    }
+    transpiler_append(text, "P3_STRING_VALUE(");
+    transpiler_string(text, node->string_value);
+    transpiler_append(text, ")");
+    break;
+  case AST_ARRAY:
+    transpiler_append(text, "k%d", transpiler_constant(transpiler, node));
+    break;
+  case AST_RECORD:
+    if (node->record_name == NULL)
+      transpiler_append(text, "(p3_value_){.type = P3_RECORD}"); // A record field without a default
+    else
+      transpiler_append(text, "k%d", transpiler_constant(transpiler, node));
+    break;
+  default:
+    transpiler_fail(transpiler, "an array literal holding a `%s`", ast_type_to_string(node->type));
+    transpiler_append(text, "P3_ERROR_VALUE");
+    break;
+  }
+}
+
+// Declares a constant for an array literal or a record default, built along with the ones nested in it
+static int transpiler_constant(transpiler_ *transpiler, ast_ *node)
+{
+  transpiler_text_ items = {0};
+  int count = node->type == AST_ARRAY ? node->array_size : node->field_count;
+  for (int i = 0; i < count; i++)
+  {
+    if (i > 0)
+      transpiler_append(&items, ", ");
+    if (node->type == AST_ARRAY)
+    {
+      transpiler_literal(transpiler, &items, node->array_elements->items[i]);
+      continue;
+    }
+
+    ast_record_element_ *field = node->record_elements->elements[i];
+    transpiler_append(&items, "{\"%s\", ", field->element_name);
+    transpiler_literal(transpiler, &items, field->element);
+    transpiler_append(&items, ", %d}", field->element->type == AST_ARRAY ? field->element->array_dimension : 0);
+  }
+
+  int constant = ++transpiler->constant_count;
+  transpiler_append(&transpiler->declarations, "static p3_value_ k%d;\n", constant);
+  if (node->type == AST_ARRAY)
+    transpiler_append(&transpiler->constants, "  k%d = p3_array(%s, %d, %d, %s%s%s);\n", constant,
+                      transpiler_type_name(node->array_type), node->array_dimension, count,
+                      count > 0 ? "(p3_value_[]){" : "NULL", count > 0 ? items.data : "", count > 0 ? "}" : "");
+  else
+    transpiler_append(&transpiler->constants, "  k%d = p3_record(\"%s\", %d, %s%s%s);\n", constant,
+                      node->record_name, count, count > 0 ? "(p3_field_[]){" : "NULL", count > 0 ? items.data : "",
+                      count > 0 ? "}" : "");
+  free(items.data);
+  return constant;
+}
+
+// Built-in methods, with the number of arguments each takes and the name its messages use
+static const struct
+{
+  const char *name;
+  const char *function;
+  const char *message_name;
+  int arguments;
+} transpiler_builtins[] = {
+    {"LEN", "p3_len", "LEN", 1},
+    {"POSITION", "p3_position", "POS", 2},
+    {"SUBSTRING", "p3_substring", "SUBSTRING", 3},
+    {"SLICE", "p3_slice", "SLICE", 3},
+    {"STRING_TO_INT", "p3_string_to_int", "STRING_TO_INT", 1},
+    {"STRING_TO_REAL", "p3_string_to_real", "STRING_TO_REAL", 1},
+    {"INT_TO_STRING", "p3_int_to_string", "INT_TO_STRING", 1},
+    {"REAL_TO_STRING", "p3_real_to_string", "REAL_TO_STRING", 1},
+    {"CHAR_TO_CODE", "p3_char_to_code", "CHAR_TO_CODE", 1},
+    {"CODE_TO_CHAR", "p3_code_to_char", "CODE_TO_CHAR", 1},
+    {"RANDOM_INT", "p3_random_int", "RANDOM_INT", 2},
+};
+
+static int transpiler_builtin(const char *name)
+{
+  for (size_t i = 0; i < sizeof(transpiler_builtins) / sizeof(transpiler_builtins[0]); i++)
+  {
+    if (strcmp(name, transpiler_builtins[i].name) == 0)
+      return (int)i;
+  }
+  return -1;
+}
+
+// Finds the record or subroutine the program defines under `name`
+static ast_ *transpiler_definition(transpiler_ *transpiler, const char *name)
+{
+  for (size_t i = 0; i < transpiler->definitions->size; i++)
+  {
+    ast_ *definition = transpiler->definitions->items[i];
+    const char *defined = definition->type == AST_SUBROUTINE ? definition->subroutine_name : definition->record_name;
+    if (strcmp(defined, name) == 0)
+      return definition;
+  }
+  return NULL;
+}
+
+static int transpiler_expression(transpiler_ *transpiler, ast_ *node);
+
+// Evaluates a call's arguments into temporaries, in order; a named argument's value is its assignment's
+// Evaluates each argument of a call into a temporary. Like the tree walker, a call to a subroutine (`checked`) stops
+// at its first failed argument: the ones after it are left failed without running.
+static int *transpiler_arguments(transpiler_ *transpiler, ast_ *node, int checked)
+{
+  int *temporaries = malloc((node->arguments_count > 0 ? node->arguments_count : 1) * sizeof(int));
+  if (!temporaries)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for the transpiler.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  int guard = -1; // The argument before, if it could have failed
+  for (int i = 0; i < node->arguments_count; i++)
+  {
+    ast_ *argument = node->arguments->items[i];
+    if (argument->type == AST_ASSIGNMENT)
+      argument = argument->rhs;
+
+    if (guard < 0)
+    {
+      temporaries[i] = transpiler_expression(transpiler, argument);
+    }
+    else
+    {
+      temporaries[i] = transpiler_value(transpiler, "P3_ERROR_VALUE");
+      transpiler_line(transpiler, "if (!p3_failed(t%d))", guard);
+      transpiler_open(transpiler);
+      int value = transpiler_expression(transpiler, argument);
+      transpiler_line(transpiler, "t%d = t%d;", temporaries[i], value);
+      transpiler_close(transpiler);
+    }
+
+    int literal = argument->type == AST_INTEGER || argument->type == AST_REAL || argument->type == AST_CHARACTER ||
+                  argument->type == AST_STRING || argument->type == AST_BOOLEAN;
+    if (checked && (!literal || guard >= 0))
+      guard = temporaries[i]; // Failed too when it was skipped
+  }
+  return temporaries;
+}
+
+static int transpiler_named_arguments(ast_ *node)
+{
+  int named = 0;
+  for (int i = 0; i < node->arguments_count; i++)
+    named += node->arguments->items[i]->type == AST_ASSIGNMENT;
+  return named;
+}
+
+// Appends the condition that one of the temporaries holds a failed expression
+static void transpiler_arguments_failed(transpiler_text_ *text, const int *temporaries, int count)
+{
+  for (int i = 0; i < count; i++)
+    transpiler_append(text, "%sp3_failed(t%d)", i > 0 ? " || " : "", temporaries[i]);
+}
+
+// Stops the program, as the tree walker does, if a record or subroutine's definition hasn't run when it is called
+static void transpiler_defined(transpiler_ *transpiler, ast_ *definition)
+{
+  int record = definition->type == AST_RECORD_DEFINITION;
+  const char *name = record ? definition->record_name : definition->subroutine_name;
+  transpiler_line(transpiler, record ? "if (!r_%s.defined)" : "if (!s_%s_defined)", name);
+  transpiler_line(transpiler, "  p3_undefined(\"%s\", \"%s\");", name, transpiler_scope_name(transpiler));
+}
+
+// Instantiates a record: with an argument for every field, positionally; otherwise by name, in the order of the
+// record's fields, with the defaults for the rest
+static int transpiler_instantiate(transpiler_ *transpiler, ast_ *node, ast_ *definition, const int *temporaries)
+{
+  int named = transpiler_named_arguments(node);
+  int complete = node->arguments_count == definition->field_count;
+  if ((complete && named > 0) || (!complete && named < node->arguments_count))
+  {
+    transpiler_fail(transpiler, "%s arguments instantiating record `%s`", complete ? "named" : "positional",
+                    definition->record_name);
+    return transpiler_value(transpiler, "P3_ERROR_VALUE");
+  }
+  if (definition->field_count == 0)
+    return transpiler_value(transpiler, "p3_instantiate(&r_%s, %d, NULL)", definition->record_name, complete);
+
+  transpiler_text_ values = {0};
+  int j = 0;
+  for (int i = 0; i < definition->field_count; i++)
+  {
+    ast_record_element_ *field = definition->record_elements->elements[i];
+    if (i > 0)
+      transpiler_append(&values, ", ");
+
+    if (complete)
+      transpiler_append(&values, "t%d", temporaries[i]);
+    else if (j < node->arguments_count &&
+             strcmp(node->arguments->items[j]->lhs->variable_name, field->element_name) == 0)
+      transpiler_append(&values, "t%d", temporaries[j++]);
+    else
+      transpiler_append(&values, "P3_UNSET_VALUE");
+  }
+
+  int temporary = transpiler_value(transpiler, "p3_instantiate(&r_%s, %d, (p3_value_[]){%s})",
+                                   definition->record_name, complete, values.data);
+  free(values.data);
+  return temporary;
+}
+
+// Calls a built-in method or subroutine, or instantiates a record, once the arguments are evaluated
+static int transpiler_call(transpiler_ *transpiler, ast_ *node)
+{
+  int builtin = transpiler_builtin(node->class_name);
+  ast_ *definition = builtin < 0 ? transpiler_definition(transpiler, node->class_name) : NULL;
+  if ((builtin >= 0 || (definition != NULL && definition->type == AST_SUBROUTINE)) &&
+      transpiler_named_arguments(node) > 0)
+  {
+    transpiler_fail(transpiler, "named arguments in a call to `%s`", node->class_name);
+    return transpiler_value(transpiler, "P3_ERROR_VALUE");
+  }
+
+  int checked = definition != NULL && definition->type == AST_SUBROUTINE &&
+                definition->parameter_count == node->arguments_count;
+  int *temporaries = transpiler_arguments(transpiler, node, checked);
+  int count = node->arguments_count;
+  transpiler_text_ list = {0};
+  transpiler_temporary_list(&list, temporaries, count);
+  int result;
+
+  if (builtin >= 0)
+  {
+    if (count != transpiler_builtins[builtin].arguments)
+      result = transpiler_value(transpiler, "p3_builtin_arguments(\"%s\", %d, %d)",
+                                transpiler_builtins[builtin].message_name, transpiler_builtins[builtin].arguments,
+                                count);
+    else
+      result = transpiler_value(transpiler, "%s(%s)", transpiler_builtins[builtin].function, list.data);
+  }
+  else if (definition == NULL)
+  {
+    result = transpiler_value(transpiler, "p3_undefined(\"%s\", \"%s\")", node->class_name,
+                              transpiler_scope_name(transpiler)); // Names nothing the program defines
+  }
+  else if (definition->type == AST_RECORD_DEFINITION)
+  {
+    transpiler_defined(transpiler, definition);
+    result = transpiler_instantiate(transpiler, node, definition, temporaries);
+  }
+  else if (count != definition->parameter_count)
+  {
+    transpiler_defined(transpiler, definition);
+    result = transpiler_value(transpiler, "p3_mismatched_arguments(\"%s\")", definition->subroutine_name);
+  }
+  else
+  {
+    // A call with a failed argument fails without running
+    transpiler_defined(transpiler, definition);
+    transpiler_text_ failed = {0};
+    transpiler_arguments_failed(&failed, temporaries, count);
+    if (count > 0)
+      result = transpiler_value(transpiler, "%s ? P3_ERROR_VALUE : p3_settle(s_%s(%s))", failed.data,
+                                definition->subroutine_name, list.data);
+    else
+      result = transpiler_value(transpiler, "p3_settle(s_%s())", definition->subroutine_name);
+    free(failed.data);
+  }
+
+  free(list.data);
+  free(temporaries);
+  return result;
+}
+
+// The array or record an access reads, as a C expression, without checking it is set: the access reports that
+static const char *transpiler_container(transpiler_ *transpiler, ast_ *node)
+{
+  if (node->depth < 0)
+    return "P3_ERROR_VALUE"; // Only in code after an EXIT, which never runs
+  const char *name = transpiler_variable(transpiler, node->depth, node->slot);
+  return name != NULL ? name : "P3_ERROR_VALUE";
+}
+
+// Evaluates an array access's indices into temporaries, appending them as an array of values
+static void transpiler_indices(transpiler_ *transpiler, ast_ *node, transpiler_text_ *text)
+{
+  int count = (int)node->index->size;
+  int temporaries[count];
+  for (int i = 0; i < count; i++)
+    temporaries[i] = transpiler_expression(transpiler, node->index->items[i]);
+
+  transpiler_append(text, "%d, (p3_value_[]){", count);
+  transpiler_temporary_list(text, temporaries, count);
+  transpiler_append(text, "}");
+}
+
+// Runtime functions for the operators whose integer form they handle inline, in the order of enum operator_type
+static const char *transpiler_operations[] = {
+    [OP_ADD] = "p3_add",
+    [OP_SUBTRACT] = "p3_subtract",
+    [OP_MULTIPLY] = "p3_multiply",
+    [OP_DIVIDE] = "p3_divide",
+    [OP_POWER] = "p3_power",
+    [OP_INT_DIVIDE] = "p3_int_divide",
+    [OP_MODULO] = "p3_modulo",
+    [OP_LESS] = "p3_less",
+    [OP_GREATER] = "p3_greater",
+    [OP_EQUAL] = "p3_equal",
+    [OP_NOT_EQUAL] = "p3_not_equal",
+    [OP_LESS_EQUAL] = "p3_less_equal",
+    [OP_GREATER_EQUAL] = "p3_greater_equal",
+    [OP_AND] = NULL,
+    [OP_OR] = NULL,
+    [OP_NOT] = NULL,
+};
+
+static const char *transpiler_operators[] = {
+    [OP_NONE] = "P3_NONE",
+    [OP_ADD] = "P3_ADD",
+    [OP_SUBTRACT] = "P3_SUBTRACT",
+    [OP_MULTIPLY] = "P3_MULTIPLY",
+    [OP_DIVIDE] = "P3_DIVIDE",
+    [OP_POWER] = "P3_POWER",
+    [OP_INT_DIVIDE] = "P3_INT_DIVIDE",
+    [OP_MODULO] = "P3_MODULO",
+    [OP_LESS] = "P3_LESS",
+    [OP_GREATER] = "P3_GREATER",
+    [OP_EQUAL] = "P3_EQUAL",
+    [OP_NOT_EQUAL] = "P3_NOT_EQUAL",
+    [OP_LESS_EQUAL] = "P3_LESS_EQUAL",
+    [OP_GREATER_EQUAL] = "P3_GREATER_EQUAL",
+    [OP_AND] = "P3_AND",
+    [OP_OR] = "P3_OR",
+    [OP_NOT] = "P3_NOT",
+};
+
+// Writes the code computing an expression into a new temporary, returning its number. Operands are computed left to
+// right, and a variable is read where it appears, so a call further right can't change what was read.
+static int transpiler_expression(transpiler_ *transpiler, ast_ *node)
+{
+  switch (node->type)
+  {
+  case AST_INTEGER:
+  case AST_REAL:
+  case AST_CHARACTER:
+  case AST_BOOLEAN:
+  case AST_STRING:
+  case AST_ARRAY:
+  {
+    transpiler_text_ literal = {0};
+    transpiler_literal(transpiler, &literal, node);
+    int temporary = transpiler_value(transpiler, "%s", literal.data);
+    free(literal.data);
+    return temporary;
+  }
+
+  case AST_VARIABLE:
+  {
+    if (node->depth < 0)
+      return transpiler_value(transpiler, "P3_ERROR_VALUE"); // Only in code after an EXIT, which never runs
+    const char *name = transpiler_variable(transpiler, node->depth, node->slot);
+    if (name == NULL)
+      return transpiler_value(transpiler, "P3_ERROR_VALUE");
+    return transpiler_value(transpiler, "p3_read(%s, \"%s\", \"%s\")", name, node->variable_name,
+                            transpiler_scope_name(transpiler));
+  }
+
+  case AST_ARITHMETIC_EXPRESSION:
+  case AST_BOOLEAN_EXPRESSION:
+  {
+    if (node->left == NULL)
+    {
+      int right = transpiler_expression(transpiler, node->right);
+      return transpiler_value(transpiler, "p3_unary(%s, t%d)", transpiler_operators[node->operator], right);
+    }
+
+    int left = transpiler_expression(transpiler, node->left);
+    int right = transpiler_expression(transpiler, node->right);
+    if (transpiler_operations[node->operator] != NULL)
+      return transpiler_value(transpiler, "%s(t%d, t%d)", transpiler_operations[node->operator], left, right);
+    return transpiler_value(transpiler, "p3_operate(%s, t%d, t%d)", transpiler_operators[node->operator], left, right);
+  }
+
+  case AST_INSTANTIATION:
+    return transpiler_call(transpiler, node);
+
+  case AST_ARRAY_ACCESS:
+  {
+    const char *container = transpiler_container(transpiler, node);
+    transpiler_text_ indices = {0};
+    transpiler_indices(transpiler, node, &indices);
+    int temporary = transpiler_value(transpiler, "p3_index(%s, \"%s\", \"%s\", %s)", container, node->variable_name,
+                                     transpiler_scope_name(transpiler), indices.data);
+    free(indices.data);
+    return temporary;
+  }
+
+  case AST_RECORD_ACCESS:
+    return transpiler_value(transpiler, "p3_field(%s, \"%s\", \"%s\", \"%s\")", transpiler_container(transpiler, node),
+                            node->variable_name, node->field_name, transpiler_scope_name(transpiler));
+
+  default:
+    transpiler_fail(transpiler, "an expression of type `%s`", ast_type_to_string(node->type));
+    return transpiler_value(transpiler, "P3_ERROR_VALUE");
+  }
+}
+
+// Checks a condition, declaring a flag that is 1 if it is True, 0 if False and -1 if it isn't a boolean (reported)
+static int transpiler_condition(transpiler_ *transpiler, ast_ *condition, const char *statement)
+{
+  int value = transpiler_expression(transpiler, condition);
+  int flag = ++transpiler->temporaries;
+  transpiler_line(transpiler, "int c%d = p3_condition(t%d, %s);", flag, value, statement);
+  return flag;
+}
+
+// Declares a loop's variables, unset, as the tree walker's fresh scope for the loop would have them
+static void transpiler_enter_loop(transpiler_ *transpiler, transpiler_block_ *block, ast_ *node)
+{
+  char prefix[32];
+  snprintf(prefix, sizeof(prefix), "l%d_", ++transpiler->loop_blocks);
+  size_t size = node->layout != NULL ? node->layout->size : 0;
+  transpiler_enter_block(transpiler, block, node->layout, node->layout != NULL ? node->layout->names : NULL, size,
+                         prefix);
+
+  for (size_t i = 0; i < size; i++)
+    transpiler_line(transpiler, "p3_value_ %s = P3_UNSET_VALUE;", block->names[i]);
+}
+
+static void transpiler_loop_body(transpiler_ *transpiler, ast_ *node)
+{
+  transpiler->loops++;
+  transpiler_statements(transpiler, node->loop_body);
+  transpiler->loops--;
+}
+
+// Checks a FOR loop's bound is an integer, opening the block the loop runs in if it is; a literal needs no check
+static int transpiler_bound(transpiler_ *transpiler, ast_ *bound, int value, const char *name)
+{
+  if (bound->type == AST_INTEGER && !bound->int_value.null)
+    return 0;
+  transpiler_line(transpiler, "if (p3_bound(t%d, \"%s\"))", value, name);
+  transpiler_open(transpiler);
+  return 1;
+}
+
+static void transpiler_for_to(transpiler_ *transpiler, ast_ *node)
+{
+  ast_ *variable = node->loop_variable->lhs;
+  int opened = 0;
+
+  // The bounds are evaluated once, end first, in the enclosing scope; one that isn't an integer stops the loop
+  // before it starts, without the reset
+  int end = transpiler_expression(transpiler, node->end_expr);
+  opened += transpiler_bound(transpiler, node->end_expr, end, "End");
+
+  int step = 0;
+  ast_ *step_expr = node->step_expr;
+  if (step_expr != NULL)
+  {
+    step = transpiler_expression(transpiler, step_expr);
+    opened += transpiler_bound(transpiler, step_expr, step, "Step");
+  }
+
+  int start = transpiler_expression(transpiler, node->loop_variable->rhs);
+  opened += transpiler_bound(transpiler, node->loop_variable->rhs, start, "Start");
+
+  transpiler_open(transpiler);
+  transpiler_block_ block;
+  transpiler_enter_loop(transpiler, &block, node);
+
+  // A variable of the loop's own scope is the counter itself, so assigning it in the body moves the count along as
+  // it does in the tree walker; one found further out is set from a separate counter before every iteration
+  char counter[64];
+  const char *name = transpiler_variable(transpiler, variable->depth, variable->slot);
+  if (name == NULL)
+    name = "P3_ERROR_VALUE";
+  if (variable->depth == 0)
+  {
+    transpiler_line(transpiler, "%s = t%d;", name, start);
+    snprintf(counter, sizeof(counter), "%s.int_value", name);
+  }
+  else
+  {
+    int number = ++transpiler->temporaries;
+    transpiler_line(transpiler, "int64_t n%d = t%d.int_value;", number, start);
+    snprintf(counter, sizeof(counter), "n%d", number);
+  }
+
+  // A literal step settles which way the loop counts
+  char step_value[64];
+  if (step_expr == NULL || (step_expr->type == AST_INTEGER && !step_expr->int_value.null))
+  {
+    int64_t by = step_expr == NULL ? 1 : step_expr->int_value.value;
+    snprintf(step_value, sizeof(step_value), "%" PRId64, by);
+    if (by > 0)
+      transpiler_line(transpiler, "for (; %s <= t%d.int_value; %s += %s)", counter, end, counter, step_value);
+    else if (by < 0)
+      transpiler_line(transpiler, "for (; %s >= t%d.int_value; %s += %s)", counter, end, counter, step_value);
+    else
+      transpiler_line(transpiler, "for (; 0;)");
+  }
+  else
+  {
+    snprintf(step_value, sizeof(step_value), "t%d.int_value", step);
+    transpiler_line(transpiler, "for (; (%s > 0 && %s <= t%d.int_value) || (%s < 0 && %s >= t%d.int_value); %s += %s)",
+                    step_value, counter, end, step_value, counter, end, counter, step_value);
+  }
+
+  transpiler_open(transpiler);
+  if (variable->depth != 0)
+    transpiler_line(transpiler, "%s = P3_INTEGER_VALUE(%s);", name, counter);
+  transpiler_loop_body(transpiler, node);
+  transpiler_close(transpiler);
+
+  transpiler_leave_block(transpiler, &block);
+  transpiler_close(transpiler);
+
+  const char *reset = transpiler_find_name(transpiler, variable->variable_name);
+  if (reset != NULL)
+    transpiler_line(transpiler, "%s = t%d;", reset, start);
+  while (opened-- > 0)
+    transpiler_close(transpiler);
+}
+
+static void transpiler_for_in(transpiler_ *transpiler, ast_ *node)
+{
+  ast_ *variable = node->loop_variable->lhs;
+
+  // The collection is fixed when the loop starts; a string or array's items are read as the loop reaches them
+  int collection = transpiler_expression(transpiler, node->collection_expr);
+  int iterator = ++transpiler->temporaries;
+  transpiler_line(transpiler, "p3_iterator_ i%d;", iterator);
+  transpiler_line(transpiler, "if (p3_iterate(&i%d, t%d))", iterator, collection);
+  transpiler_open(transpiler);
+
+  transpiler_open(transpiler);
+  transpiler_block_ block;
+  transpiler_enter_loop(transpiler, &block, node);
+  const char *item = transpiler_variable(transpiler, variable->depth, variable->slot);
+  transpiler_line(transpiler, "while (p3_next(&i%d, &%s))", iterator, item != NULL ? item : "P3_ERROR_VALUE");
+  transpiler_open(transpiler);
+  transpiler_loop_body(transpiler, node);
+  transpiler_close(transpiler);
+  transpiler_leave_block(transpiler, &block);
+  transpiler_close(transpiler);
+
+  // Unset, as a FOR-IN loop's variable has no start value
+  const char *reset = transpiler_find_name(transpiler, variable->variable_name);
+  if (reset != NULL)
+    transpiler_line(transpiler, "%s = P3_ERROR_VALUE;", reset);
+  transpiler_close(transpiler);
+}
+
+static void transpiler_indefinite_loop(transpiler_ *transpiler, ast_ *node)
+{
+  transpiler_open(transpiler);
+  transpiler_block_ block;
+  transpiler_enter_loop(transpiler, &block, node);
+  transpiler->block = block.parent; // The condition is evaluated in the enclosing scope
+
+  if (node->indefinite_loop_type == 1) // WHILE loop
+  {
+    transpiler_line(transpiler, "for (;;)");
+    transpiler_open(transpiler);
+    int condition = transpiler_condition(transpiler, node->condition, "P3_LOOP");
+    transpiler_line(transpiler, "if (c%d <= 0)", condition);
+    transpiler_line(transpiler, "  break;");
+    transpiler->block = &block;
+    transpiler_loop_body(transpiler, node);
+    transpiler->block = block.parent;
+    transpiler_close(transpiler);
+  }
+  else // REPEAT loop: the condition is checked once before the body first runs too
+  {
+    int first = transpiler_condition(transpiler, node->condition, "P3_LOOP");
+    transpiler_line(transpiler, "if (c%d >= 0)", first);
+    transpiler_line(transpiler, "  for (;;)");
+    transpiler->indent++;
+    transpiler_open(transpiler);
+    transpiler->block = &block;
+    transpiler_loop_body(transpiler, node);
+    transpiler->block = block.parent;
+    int condition = transpiler_condition(transpiler, node->condition, "P3_LOOP");
+    transpiler_line(transpiler, "if (c%d != 0)", condition);
+    transpiler_line(transpiler, "  break;");
+    transpiler_close(transpiler);
+    transpiler->indent--;
+  }
+
+  transpiler->block = &block;
+  transpiler_leave_block(transpiler, &block);
+  transpiler_close(transpiler);
+}
+
+static void transpiler_body(transpiler_ *transpiler, ast_list_ *statements)
+{
+  transpiler_open(transpiler);
+  transpiler_statements(transpiler, statements);
+  transpiler_close(transpiler);
+}
+
+static void transpiler_selection(transpiler_ *transpiler, ast_ *node)
+{
+  if (node->if_condition == NULL || node->if_body == NULL)
+  {
+    transpiler_fail(transpiler, "an IF statement without a condition or body");
+    return;
+  }
+
+  // Each ELSE IF and the ELSE run once the condition before them is False, and not when it isn't a boolean
+  int condition = transpiler_condition(transpiler, node->if_condition, "P3_IF");
+  transpiler_line(transpiler, "if (c%d > 0)", condition);
+  transpiler_body(transpiler, node->if_body);
+
+  int opened = 0;
+  for (size_t k = 0; node->else_if_conditions != NULL && k < node->else_if_conditions->size; k++)
+  {
+    transpiler_line(transpiler, "else if (c%d == 0)", condition);
+    transpiler_open(transpiler);
+    opened++;
+    condition = transpiler_condition(transpiler, node->else_if_conditions->items[k], "P3_ELSE_IF");
+    transpiler_line(transpiler, "if (c%d > 0)", condition);
+    transpiler_body(transpiler, node->else_if_bodies[k]);
+  }
+
+  if (node->else_body != NULL)
+  {
+    transpiler_line(transpiler, "else if (c%d == 0)", condition);
+    transpiler_body(transpiler, node->else_body);
+  }
+  while (opened-- > 0)
+    transpiler_close(transpiler);
+}
+
+static void transpiler_assignment(transpiler_ *transpiler, ast_ *node)
+{
+  ast_ *lhs = node->lhs;
+
+  if (lhs->type == AST_VARIABLE)
+  {
+    if (lhs->depth < 0)
+      return; // Only in code after an EXIT, which never runs
+    if (lhs->constant && transpiler->loops > 0)
+    {
+      transpiler_fail(transpiler, "a CONSTANT assigned inside a loop"); // The tree walker stops its second pass
+      return;
+    }
+
+    const char *name = transpiler_variable(transpiler, lhs->depth, lhs->slot);
+    if (name == NULL)
+      return;
+
+    if (lhs->userinput == 1)
+    {
+      // Each USERINPUT statement keeps the last line it read
+      int input = ++transpiler->input_count;
+      transpiler_append(&transpiler->declarations, "static const char *input%d = \"\";\n", input);
+      transpiler_line(transpiler, "%s = p3_input(\"%s\", &input%d);", name, lhs->variable_name, input);
+    }
+    else if (node->rhs->type == AST_ARRAY)
+    {
+      transpiler_line(transpiler, "%s = p3_copy(k%d);", name, transpiler_constant(transpiler, node->rhs));
+    }
+    else
+    {
+      transpiler_line(transpiler, "%s = t%d;", name, transpiler_expression(transpiler, node->rhs));
+    }
+  }
+  else if (lhs->type == AST_ARRAY_ACCESS || lhs->type == AST_RECORD_ACCESS)
+  {
+    int value = node->rhs->type == AST_ARRAY
+                    ? transpiler_value(transpiler, "p3_copy(k%d)", transpiler_constant(transpiler, node->rhs))
+                    : transpiler_expression(transpiler, node->rhs);
+
+    // A store that finds no element or field assigns the value to the container's variable instead
+    char target[128];
+    const char *name = lhs->depth >= 0 ? transpiler_variable(transpiler, lhs->depth, lhs->slot) : NULL;
+    if (name != NULL)
+      snprintf(target, sizeof(target), "%s", name);
+    else
+      snprintf(target, sizeof(target), "t%d", transpiler_value(transpiler, "P3_ERROR_VALUE"));
+
+    if (lhs->type == AST_ARRAY_ACCESS)
+    {
+      transpiler_text_ indices = {0};
+      transpiler_indices(transpiler, lhs, &indices);
+      transpiler_line(transpiler, "p3_store_index(&%s, \"%s\", \"%s\", t%d, %s);", target, lhs->variable_name,
+                      transpiler_scope_name(transpiler), value, indices.data);
+      free(indices.data);
+    }
+    else
+    {
+      transpiler_line(transpiler, "p3_store_field(&%s, \"%s\", \"%s\", \"%s\", t%d);", target, lhs->variable_name,
+                      lhs->field_name, transpiler_scope_name(transpiler), value);
+    }
+  }
+  else
+  {
+    transpiler_fail(transpiler, "an assignment to a `%s`", ast_type_to_string(lhs->type));
+  }
+}
+
+static void transpiler_output(transpiler_ *transpiler, ast_ *node)
+{
+  size_t count = node->output_expressions->size;
+  if (count == 0)
+    transpiler_line(transpiler, "putchar('\\n');");
+
+  for (size_t i = 0; i < count; i++)
+  {
+    int value = transpiler_expression(transpiler, node->output_expressions->items[i]);
+    transpiler_line(transpiler, "p3_output(t%d, %d);", value, i + 1 == count);
+  }
+}
+
+// Declares the trampoline a tail call to a subroutine from another one returns, the first time there is one: it calls
+// the subroutine with the arguments the tail call left beside it
+static void transpiler_tail_callee(transpiler_ *transpiler, ast_ *callee)
+{
+  for (size_t i = 0; i < transpiler->tail_callees->size; i++)
+  {
+    if (transpiler->tail_callees->items[i] == callee)
+      return;
+  }
+  add_ast_to_list(transpiler->tail_callees, callee);
+
+  const char *name = callee->subroutine_name;
+  if (callee->parameter_count > 0)
+    transpiler_append(&transpiler->declarations, "static p3_value_ s_%s_arguments[%d];\n", name,
+                      callee->parameter_count);
+  transpiler_append(&transpiler->declarations, "static p3_value_ s_%s_tail(void)\n{\n  return s_%s(", name, name);
+  for (int i = 0; i < callee->parameter_count; i++)
+    transpiler_append(&transpiler->declarations, "%ss_%s_arguments[%d]", i > 0 ? ", " : "", name, i);
+  transpiler_append(&transpiler->declarations, ");\n}\n");
+}
+
+static void transpiler_return(transpiler_ *transpiler, ast_ *node)
+{
+  ast_ *subroutine = transpiler->subroutine;
+  if (subroutine == NULL)
+  {
+    transpiler_line(transpiler, "p3_uncaught(\"AST_RETURN\");");
+    return;
+  }
+
+  // Returning another call's result is a tail call: the call takes over the running one's depth, a call to the
+  // running subroutine starts it again on the new arguments, and a call to another one is left to the trampoline in
+  // p3_settle, so that mutual recursion doesn't grow the C stack
+  ast_ *value = node->return_value;
+  ast_ *callee = NULL;
+  if (value->type == AST_INSTANTIATION && transpiler_builtin(value->class_name) < 0)
+  {
+    callee = transpiler_definition(transpiler, value->class_name);
+    if (callee != NULL && (callee->type != AST_SUBROUTINE || callee->parameter_count != value->arguments_count))
+      callee = NULL;
+  }
+  if (callee == NULL || transpiler_named_arguments(value) > 0)
+  {
+    transpiler_line(transpiler, "return p3_leave(t%d);", transpiler_expression(transpiler, value));
+    return;
+  }
+
+  int *temporaries = transpiler_arguments(transpiler, value, 1);
+  int count = value->arguments_count;
+  transpiler_text_ failed = {0};
+  transpiler_arguments_failed(&failed, temporaries, count);
+  if (callee != subroutine)
+    transpiler_defined(transpiler, callee);
+  if (count > 0)
+  {
+    transpiler_line(transpiler, "if (%s)", failed.data);
+    transpiler_line(transpiler, "  return p3_leave(P3_ERROR_VALUE);");
+  }
+
+  if (callee == subroutine)
+  {
+    for (int i = 0; i < count; i++)
+      transpiler_line(transpiler, "a%d = t%d;", i, temporaries[i]);
+    transpiler_line(transpiler, "goto restart;");
+    transpiler->restarts = 1;
+  }
+  else
+  {
+    transpiler_tail_callee(transpiler, callee);
+    for (int i = 0; i < count; i++)
+      transpiler_line(transpiler, "s_%s_arguments[%d] = t%d;", callee->subroutine_name, i, temporaries[i]);
+    transpiler_line(transpiler, "p3_tail_call = s_%s_tail;", callee->subroutine_name);
+    transpiler_line(transpiler, "return p3_leave(P3_NOOP_VALUE);");
+  }
+
+  free(failed.data);
+  free(temporaries);
+}
+
+static void transpiler_statement(transpiler_ *transpiler, ast_ *node)
+{
+  switch (node->type)
+  {
+  case AST_COMPOUND:
+    transpiler_statements(transpiler, node->compound_value);
+    break;
+  case AST_NOOP:
+  case AST_INTEGER:
+  case AST_REAL:
+  case AST_CHARACTER:
+  case AST_STRING:
+  case AST_BOOLEAN:
+  case AST_ARRAY:
+  case AST_RECORD:
+    break;
+  case AST_VARIABLE:
+  case AST_RECORD_ACCESS:
+  case AST_ARRAY_ACCESS:
+  case AST_INSTANTIATION:
+  case AST_ARITHMETIC_EXPRESSION:
+  case AST_BOOLEAN_EXPRESSION:
+    transpiler_line(transpiler, "(void)t%d;", transpiler_expression(transpiler, node));
+    break;
+  case AST_ASSIGNMENT:
+    transpiler_assignment(transpiler, node);
+    break;
+  case AST_OUTPUT:
+    transpiler_output(transpiler, node);
+    break;
+  case AST_DEFINITE_LOOP:
+    if (node->collection_expr != NULL)
+      transpiler_for_in(transpiler, node);
+    else
+      transpiler_for_to(transpiler, node);
+    break;
+  case AST_INDEFINITE_LOOP:
+    transpiler_indefinite_loop(transpiler, node);
+    break;
+  case AST_SELECTION:
+    transpiler_selection(transpiler, node);
+    break;
+  case AST_RECORD_DEFINITION:
+    transpiler_line(transpiler, "r_%s.defined = 1;", node->record_name);
+    break;
+  case AST_SUBROUTINE:
+    transpiler_line(transpiler, "s_%s_defined = 1;", node->subroutine_name);
+    break;
+  case AST_RETURN:
+    transpiler_return(transpiler, node);
+    break;
+  case AST_EXIT:
+    transpiler_line(transpiler, "p3_exit(%d);", node->exit_code);
+    break;
+  default:
+    transpiler_fail(transpiler, "a statement of type `%s`", ast_type_to_string(node->type));
+    break;
+  }
+}
+
+// Writes a list of statements in order; nothing after an EXIT runs, and the resolver hasn't checked it.
+static void transpiler_statements(transpiler_ *transpiler, ast_list_ *statements)
+{
+  for (size_t i = 0; statements != NULL && i < statements->size; i++)
+  {
+    transpiler_statement(transpiler, statements->items[i]);
+    if (statements->items[i]->type == AST_EXIT)
+      break;
+  }
+}
+
+// Collects the records and subroutines a program defines. Definitions without a fixed meaning aren't translated:
+// one inside a loop or a subroutine, whose scope doesn't outlive it, or two sharing a name, which the tree walker
+// picks between as the definitions run.
+static void transpiler_collect_definitions(transpiler_ *transpiler, ast_list_ *statements, int nested)
+{
+  for (size_t i = 0; statements != NULL && i < statements->size; i++)
+  {
+    ast_ *node = statements->items[i];
+    switch (node->type)
+    {
+    case AST_SUBROUTINE:
+    case AST_RECORD_DEFINITION:
+    {
+      const char *name = node->type == AST_SUBROUTINE ? node->subroutine_name : node->record_name;
+      if (transpiler_definition(transpiler, name) != NULL)
+        transpiler_fail(transpiler, "two definitions named `%s`", name);
+      if (nested)
+        transpiler_fail(transpiler, "`%s` defined inside a loop or subroutine", name);
+      if (node->type == AST_SUBROUTINE && transpiler_builtin(name) >= 0)
+        transpiler_fail(transpiler, "a subroutine named after the built-in method `%s`", name);
+      add_ast_to_list(transpiler->definitions, node);
+
+      if (node->type == AST_SUBROUTINE)
+        transpiler_collect_definitions(transpiler, node->body, 1);
+      break;
+    }
+    case AST_SELECTION:
+      transpiler_collect_definitions(transpiler, node->if_body, nested);
+      for (size_t k = 0; node->else_if_conditions != NULL && k < node->else_if_conditions->size; k++)
+        transpiler_collect_definitions(transpiler, node->else_if_bodies[k], nested);
+      transpiler_collect_definitions(transpiler, node->else_body, nested);
+      break;
+    case AST_DEFINITE_LOOP:
+    case AST_INDEFINITE_LOOP:
+      transpiler_collect_definitions(transpiler, node->loop_body, 1);
+      break;
+    case AST_EXIT:
+      return;
+    default:
+      break;
+    }
+  }
+}
+
+// Declares a record definition, whose fields are filled in with the constants before the program starts
+static void transpiler_record(transpiler_ *transpiler, ast_ *definition)
+{
+  int count = definition->field_count;
+  transpiler_append(&transpiler->declarations, "static p3_field_ r_%s_fields[%d];\n", definition->record_name,
+                    count > 0 ? count : 1);
+  transpiler_append(&transpiler->declarations, "static p3_record_definition_ r_%s = {\"%s\", %d, r_%s_fields, 0};\n",
+                    definition->record_name, definition->record_name, count, definition->record_name);
+
+  for (int i = 0; i < count; i++)
+  {
+    ast_record_element_ *field = definition->record_elements->elements[i];
+    transpiler_text_ value = {0};
+    transpiler_literal(transpiler, &value, field->element);
+    transpiler_append(&transpiler->constants, "  r_%s_fields[%d] = (p3_field_){\"%s\", %s, %d};\n",
+                      definition->record_name, i, field->element_name, value.data, field->dimension);
+    free(value.data);
+  }
+}
+
+// Writes a subroutine as a C function taking its arguments in order. Its frame's variables are the function's own,
+// set up as each call binds its arguments; a tail call to itself starts the body again.
+static void transpiler_subroutine(transpiler_ *transpiler, ast_ *definition, transpiler_text_ *functions)
+{
+  transpiler_text_ body = {0};
+  transpiler->code = &body;
+  transpiler->subroutine = definition;
+  transpiler->indent = 1;
+  transpiler->temporaries = 0;
+  transpiler->loop_blocks = 0;
+  transpiler->loops = 0;
+  transpiler->restarts = 0;
+
+  scope_layout_ *layout = definition->frame_layout;
+  size_t size = layout != NULL ? layout->size : 0;
+  transpiler_block_ frame;
+  transpiler_enter_block(transpiler, &frame, layout, layout != NULL ? layout->names : NULL, size, "v_");
+
+  for (size_t slot = 0; slot < size; slot++)
+  {
+    int parameter = -1;
+    for (int i = 0; i < definition->parameter_count; i++)
+    {
+      if (definition->parameters->items[i]->slot == (int)slot)
+        parameter = i;
+    }
+    if (parameter >= 0)
+      transpiler_line(transpiler, "%s = a%d;", frame.names[slot], parameter);
+    else
+      transpiler_line(transpiler, "%s = P3_UNSET_VALUE;", frame.names[slot]);
+  }
+  transpiler_statements(transpiler, definition->body);
+  transpiler_line(transpiler, "return p3_leave(P3_NOOP_VALUE);");
+
+  const char *name = definition->subroutine_name;
+  transpiler_append(functions, "static p3_value_ s_%s(", name);
+  for (int i = 0; i < definition->parameter_count; i++)
+    transpiler_append(functions, "%sp3_value_ a%d", i > 0 ? ", " : "", i);
+  transpiler_append(functions, "%s)\n{\n", definition->parameter_count > 0 ? "" : "void");
+  for (size_t slot = 0; slot < size; slot++)
+    transpiler_append(functions, "  p3_value_ %s;\n", frame.names[slot]);
+  transpiler_append(functions, "  p3_enter(\"%s\");\n", name);
+  if (transpiler->restarts)
+    transpiler_append(functions, "restart:;\n");
+  transpiler_append(functions, "%s}\n\n", body.data);
+
+  transpiler_leave_block(transpiler, &frame);
+  free(body.data);
+}
+
+int transpiler_emit(interpreter_ *interpreter, ast_ *root, const char *source, FILE *stream)
+{
+  if (root == NULL || root->type != AST_COMPOUND)
+  {
+    fprintf(stderr, "Transpiler Error: There is no program to translate.\n");
+    return 0;
+  }
+
+  transpiler_ transpiler = {0};
+  transpiler.interpreter = interpreter;
+  transpiler.definitions = init_ast_list();
+  transpiler.tail_callees = init_ast_list();
+  transpiler_collect_definitions(&transpiler, root->compound_value, 0);
+
+  // The main program's own block is the global scope, whose variables are the program's globals, unset until assigned
+  scope_ *global_scope = interpreter->global_scope;
+  const char **global_names = calloc(global_scope->variable_count + 1, sizeof(char *));
+  if (!global_names)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for the transpiler.\n");
+    exit(EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < global_scope->variable_capacity; i++)
+  {
+    if (global_scope->variables[i].name != NULL)
+      global_names[global_scope->variables[i].slot] = global_scope->variables[i].name;
+  }
+  transpiler_block_ global;
+  transpiler_enter_block(&transpiler, &global, NULL, global_names, global_scope->variable_count, "g_");
+  for (size_t i = 0; i < global.size; i++)
+    transpiler_append(&transpiler.declarations, "static p3_value_ %s;\n", global.names[i]);
+
+  for (size_t i = 0; i < transpiler.definitions->size; i++)
+  {
+    ast_ *definition = transpiler.definitions->items[i];
+    if (definition->type == AST_RECORD_DEFINITION)
+    {
+      transpiler_record(&transpiler, definition);
+      continue;
+    }
+
+    transpiler_append(&transpiler.declarations, "static int s_%s_defined;\n", definition->subroutine_name);
+    transpiler_append(&transpiler.declarations, "static p3_value_ s_%s(", definition->subroutine_name);
+    for (int j = 0; j < definition->parameter_count; j++)
+      transpiler_append(&transpiler.declarations, "%sp3_value_ a%d", j > 0 ? ", " : "", j);
+    transpiler_append(&transpiler.declarations, "%s);\n", definition->parameter_count > 0 ? "" : "void");
+  }
+
+  // Subroutines see their own frame, then the global scope
+  transpiler_text_ functions = {0};
+  for (size_t i = 0; i < transpiler.definitions->size; i++)
+  {
+    if (transpiler.definitions->items[i]->type == AST_SUBROUTINE)
+      transpiler_subroutine(&transpiler, transpiler.definitions->items[i], &functions);
+  }
+
+  transpiler_text_ main_body = {0};
+  transpiler.code = &main_body;
+  transpiler.subroutine = NULL;
+  transpiler.indent = 1;
+  transpiler.temporaries = 0;
+  transpiler.loop_blocks = 0;
+  transpiler.loops = 0;
+  transpiler_statements(&transpiler, root->compound_value);
+  transpiler_leave_block(&transpiler, &global);
+  free(global_names);
+
+  if (transpiler.failure[0] != '\0')
+  {
+    fprintf(stderr, "Transpiler Error: The program can't be translated to C: it has %s.\n", transpiler.failure);
+    return 0;
+  }
+
+  fprintf(stream, "// Translated from %s by `p3 --emit-c`. Build it against the runtime header that comes with p3:\n"
+                  "//   cc -O2 -I <p3>/runtime program.c -o program -lm\n",
+          source);
+  if (interpreter->max_call_depth != INTERPRETER_MAX_CALL_DEPTH)
+    fprintf(stream, "#define P3_MAX_CALL_DEPTH %d\n", interpreter->max_call_depth);
+  fprintf(stream, "#include \"p3_runtime.h\"\n\n");
+  if (transpiler.declarations.size > 0)
+    fprintf(stream, "%s\n", transpiler.declarations.data);
+  fprintf(stream, "// Builds the program's array literals and record defaults\nstatic void initialise(void)\n{\n%s}\n\n",
+          transpiler.constants.size > 0 ? transpiler.constants.data : "");
+  if (functions.size > 0)
+    fprintf(stream, "%s", functions.data);
+  fprintf(stream, "int main(void)\n{\n  p3_start();\n  initialise();\n%s  return 0;\n}\n",
+          main_body.size > 0 ? main_body.data : "");
+
+  free(transpiler.declarations.data);
+  free(transpiler.constants.data);
+  free(functions.data);
+  free(main_body.data);
+  return 1;
+}
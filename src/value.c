@@ -0,0 +1,99 @@
+#include "include/value.h"
+#include <stdlib.h>
+
+value_ value_integer(int64_t int_value)
+{
+  value_ value = {AST_INTEGER, 0};
+  value.int_value = int_value;
+  return value;
+}
+
+value_ value_real(double real_value)
+{
+  value_ value = {AST_REAL, 0};
+  value.real_value = real_value;
+  return value;
+}
+
+value_ value_boolean(int boolean_value)
+{
+  value_ value = {AST_BOOLEAN, 0};
+  value.boolean_value = boolean_value;
+  return value;
+}
+
+// The result of an expression that failed to evaluate; it converts back to a NULL node.
+value_ value_error()
+{
+  value_ value = {AST_NOOP, 0};
+  value.node = NULL;
+  return value;
+}
+
+int value_is_error(value_ value)
+{
+  return !VALUE_INLINE(value.type) && value.node == NULL;
+}
+
+// Reads a literal node into a value, copying inline types and borrowing the node for the rest.
+value_ value_from_ast(ast_ *node)
+{
+  if (node == NULL)
+    return value_error();
+
+  value_ value = {node->type, 0};
+  switch (node->type)
+  {
+  case AST_INTEGER:
+    value.int_value = node->int_value.value;
+    value.null = node->int_value.null;
+    break;
+  case AST_REAL:
+    value.real_value = node->real_value.value;
+    value.null = node->real_value.null;
+    break;
+  case AST_CHARACTER:
+    value.char_value = node->char_value.value;
+    value.null = node->char_value.null;
+    break;
+  case AST_BOOLEAN:
+    value.boolean_value = node->boolean_value.value;
+    value.null = node->boolean_value.null;
+    break;
+  default:
+    value.node = node;
+    break;
+  }
+
+  return value;
+}
+
+// Turns a value back into a node, allocating one only for inline types; boxed values return their own node.
+ast_ *value_to_ast(value_ value)
+{
+  if (!VALUE_INLINE(value.type))
+    return value.node;
+
+  ast_ *node = init_ast(value.type);
+  switch (value.type)
+  {
+  case AST_INTEGER:
+    node->int_value.value = value.int_value;
+    node->int_value.null = value.null;
+    break;
+  case AST_REAL:
+    node->real_value.value = value.real_value;
+    node->real_value.null = value.null;
+    break;
+  case AST_CHARACTER:
+    node->char_value.value = value.char_value;
+    node->char_value.null = value.null;
+    break;
+  default:
+    node->boolean_value.value = value.boolean_value;
+    node->boolean_value.null = value.null;
+    break;
+  }
+
+  return node;
+}
@@ -0,0 +1,1771 @@
+#include "include/vm.h"
+#include "include/jit.h"
+#include "include/arena.h"
+#include "include/intern.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The VM compiles a resolved program to bytecode for a register machine and runs it in one loop. Every variable
+// gets a register of the frame of the main program or subroutine it belongs to, loops' variables included, so
+// reading and assigning one is a copy of a value rather than a scope lookup and a node. Operators handle integers
+// inline and leave everything else to the tree walker's dispatch tables; built-in methods and records go through
+// the tree walker with their arguments already evaluated. GCC and Clang dispatch with computed gotos, others with
+// a switch.
+#if defined(__GNUC__)
+#define VM_COMPUTED_GOTO 1
+#else
+#define VM_COMPUTED_GOTO 0
+#endif
+
+// The JIT takes over instructions by changing the labels they are threaded to
+#define VM_JIT (VM_COMPUTED_GOTO && JIT_AVAILABLE)
+
+// Which statement a condition that isn't a boolean is reported for
+enum
+{
+  VM_MESSAGE_IF,
+  VM_MESSAGE_ELSE_IF,
+  VM_MESSAGE_LOOP,
+};
+
+// Which of a FOR loop's bounds isn't an integer
+enum
+{
+  VM_BOUND_END,
+  VM_BOUND_STEP,
+  VM_BOUND_START,
+};
+
+// A variable's register before anything is assigned to it, and a call's result when the body ended without RETURN
+ast_ vm_unset = {.type = AST_NOOP};
+static ast_ vm_noop = {.type = AST_NOOP};
+
+// A block of the program that gets a scope of its own in the tree walker
+typedef struct VM_BLOCK_STRUCT
+{
+  struct VM_BLOCK_STRUCT *parent;
+  scope_layout_ *layout; // Names the block declares, NULL for the global scope (whose own map is searched)
+  int base;              // Register of the block's first variable, or -1 for the global scope seen from a subroutine
+} vm_block_;
+
+// A value an expression compiled to: the register it is in, and whether that is a variable's own register
+typedef struct VM_OPERAND_STRUCT
+{
+  int reg;
+  int variable;
+} vm_operand_;
+
+typedef struct VM_COMPILER_STRUCT
+{
+  vm_ *vm;
+  vm_function_ *function; // Function being compiled
+  vm_block_ *block;       // Innermost block of the code being compiled
+  vm_block_ *global;
+  int next_register;      // First register not holding a variable or a live temporary
+  int loops;              // Loops the code being compiled is nested in, in its function
+  int failed;             // Whether the program uses something the VM doesn't compile
+} vm_compiler_;
+
+static void vm_compile_statements(vm_compiler_ *compiler, ast_list_ *statements);
+
+static void *vm_grow(void *items, int *capacity, size_t item_size)
+{
+  *capacity = *capacity ? *capacity * 2 : 16;
+  items = realloc(items, *capacity * item_size);
+  if (!items)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for the VM.\n");
+    exit(EXIT_FAILURE);
+  }
+  return items;
+}
+
+static vm_function_ *init_vm_function(ast_ *definition, const char *scope_name, int variable_count)
+{
+  vm_function_ *function = calloc(1, sizeof(struct VM_FUNCTION_STRUCT));
+  if (!function)
+  {
+    fprintf(stderr, "Error: Memory allocation failed for the VM.\n");
+    exit(EXIT_FAILURE);
+  }
+  function->definition = definition;
+  function->scope_name = scope_name;
+  function->variable_count = variable_count;
+  function->register_count = variable_count;
+  return function;
+}
+
+static void free_vm_function(vm_function_ *function)
+{
+  free(function->code);
+  free(function->constants);
+  free(function);
+}
+
+void free_vm(vm_ *vm)
+{
+  if (vm->jit != NULL)
+    free_jit(vm->jit);
+  for (int i = 0; i < vm->function_count; i++)
+    free_vm_function(vm->functions[i]);
+  free(vm->functions);
+  free(vm->registers);
+  free(vm->frames);
+  free(vm->arguments);
+  free(vm);
+}
+
+// Appends an instruction to the function being compiled, returning where it is.
+static int vm_emit(vm_compiler_ *compiler, vm_opcode_ opcode, int a, int b, int c, int d, int flags, ast_ *node)
+{
+  vm_function_ *function = compiler->function;
+  if (function->code_size == function->code_capacity)
+    function->code = vm_grow(function->code, &function->code_capacity, sizeof(vm_instruction_));
+
+  vm_instruction_ *instruction = &function->code[function->code_size];
+  instruction->handler = NULL;
+  instruction->opcode = opcode;
+  instruction->flags = flags | (compiler->loops > 0 ? VM_IN_LOOP : 0);
+  instruction->a = a;
+  instruction->b = b;
+  instruction->c = c;
+  instruction->d = d;
+  instruction->node = node;
+  return function->code_size++;
+}
+
+// Where the next instruction emitted will be, for jumps to it
+static int vm_here(vm_compiler_ *compiler)
+{
+  return compiler->function->code_size;
+}
+
+static int vm_temporary(vm_compiler_ *compiler)
+{
+  int reg = compiler->next_register++;
+  if (compiler->next_register > compiler->function->register_count)
+    compiler->function->register_count = compiler->next_register;
+  return reg;
+}
+
+// Returns the operand of a constant, sharing one register between equal inline values and uses of the same node.
+static int vm_constant(vm_compiler_ *compiler, value_ value)
+{
+  vm_function_ *function = compiler->function;
+  for (int i = 0; i < function->constant_count; i++)
+  {
+    if (memcmp(&function->constants[i], &value, sizeof(value_)) == 0)
+      return VM_CONSTANT | i;
+  }
+
+  if (function->constant_count == function->constant_capacity)
+    function->constants = vm_grow(function->constants, &function->constant_capacity, sizeof(value_));
+  function->constants[function->constant_count] = value;
+  return VM_CONSTANT | function->constant_count++;
+}
+
+// Returns the subroutine function a call runs directly, or NULL if it goes through the tree walker: it names no
+// subroutine, the argument count doesn't match, or it passes named arguments.
+static int vm_called_function(vm_compiler_ *compiler, ast_ *node)
+{
+  for (int i = 1; i < compiler->vm->function_count; i++)
+  {
+    ast_ *definition = compiler->vm->functions[i]->definition;
+    if (strcmp(definition->subroutine_name, node->class_name) != 0)
+      continue;
+
+    if (node->arguments_count != definition->parameter_count)
+      return -1;
+    for (int j = 0; j < node->arguments_count; j++)
+    {
+      if (node->arguments->items[j]->type == AST_ASSIGNMENT)
+      {
+        compiler->failed = 1; // Would assign variables through the call
+        return -1;
+      }
+    }
+    return i;
+  }
+  return -1;
+}
+
+// Finds the register of a resolved variable, or returns -1 and sets `global` to its slot when it is a global
+// seen from a subroutine.
+static int vm_variable_register(vm_compiler_ *compiler, int depth, int slot, int *global)
+{
+  vm_block_ *block = compiler->block;
+  for (int i = 0; i < depth && block != NULL; i++)
+    block = block->parent;
+
+  *global = -1;
+  if (block == NULL)
+  {
+    compiler->failed = 1;
+    return 0;
+  }
+  if (block->base < 0)
+  {
+    *global = slot;
+    return -1;
+  }
+  return block->base + slot;
+}
+
+// Finds `name` the way assigning it by name does in the tree walker, from the innermost block outwards.
+static int vm_find_name(vm_compiler_ *compiler, const char *name, int *depth, int *slot)
+{
+  const char *interned = intern_name(name);
+  *depth = 0;
+  for (vm_block_ *block = compiler->block; block != NULL; block = block->parent, (*depth)++)
+  {
+    if (block->layout == NULL)
+    {
+      *slot = (int)scope_find_slot(compiler->vm->interpreter->global_scope, name);
+      if (*slot >= 0)
+        return 1;
+      continue;
+    }
+
+    for (size_t i = 0; i < block->layout->size; i++)
+    {
+      if (block->layout->names[i] == interned)
+      {
+        *slot = (int)i;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+// Copies a register into the variable at (depth, slot), as a loop does when it sets its variable.
+static void vm_store_variable(vm_compiler_ *compiler, int depth, int slot, int source, ast_ *variable)
+{
+  int global;
+  int reg = vm_variable_register(compiler, depth, slot, &global);
+  if (reg >= 0)
+  {
+    if (reg != source)
+      vm_emit(compiler, VM_MOVE, reg, source, 0, 0, 0, variable);
+  }
+  else
+  {
+    vm_emit(compiler, VM_SET_GLOBAL, global, source, 0, 0, 0, variable);
+  }
+}
+
+static vm_operand_ vm_compile_expression(vm_compiler_ *compiler, ast_ *node, int target);
+
+// Compiles an expression into a particular register. A variable copied onto itself is still read, which reports it
+// if it is undefined.
+static void vm_compile_into(vm_compiler_ *compiler, ast_ *node, int target)
+{
+  vm_operand_ operand = vm_compile_expression(compiler, node, target);
+  if (operand.reg != target || operand.variable)
+    vm_emit(compiler, VM_MOVE, target, operand.reg, 0, 0, operand.variable ? VM_READ_B : 0, node);
+}
+
+// Compiles each argument of a call into consecutive temporaries, returning the first. Like the tree walker, a call
+// to a subroutine (`checked`) stops at its first failed argument: each one that isn't a literal or the last goes on
+// to the call instruction, which the caller emits next and which then fails, if its value is an error.
+static int vm_compile_arguments(vm_compiler_ *compiler, ast_ *node, int checked)
+{
+  int base = compiler->next_register, start = vm_here(compiler);
+  for (int i = 0; i < node->arguments_count; i++)
+  {
+    int reg = vm_temporary(compiler);
+    ast_ *argument = node->arguments->items[i];
+    vm_operand_ operand = vm_compile_expression(compiler, argument->type == AST_ASSIGNMENT ? argument->rhs : argument,
+                                                reg);
+    if (operand.reg != reg)
+      vm_emit(compiler, VM_MOVE, reg, operand.reg, 0, 0, operand.variable ? VM_READ_B : 0, argument);
+    if (checked && i < node->arguments_count - 1 && (operand.reg == reg || operand.variable))
+      vm_emit(compiler, VM_CHECK_ARGUMENT, -1, reg, 0, 0, 0, argument);
+    compiler->next_register = reg + 1;
+  }
+
+  for (int i = start; i < vm_here(compiler); i++)
+  {
+    if (compiler->function->code[i].opcode == VM_CHECK_ARGUMENT && compiler->function->code[i].a < 0)
+      compiler->function->code[i].a = vm_here(compiler);
+  }
+  return base;
+}
+
+// The tree walker runs a built-in method or record instantiation on a copy of the node whose arguments are
+// replaced by their values before each run. Named arguments keep their assignment, with its value replaced.
+static ast_ *vm_instantiation(ast_ *node)
+{
+  ast_ *instantiation = init_ast(AST_INSTANTIATION);
+  *instantiation = *node;
+  instantiation->arguments = init_ast_list();
+
+  for (int i = 0; i < node->arguments_count; i++)
+  {
+    ast_ *argument = node->arguments->items[i];
+    if (argument->type == AST_ASSIGNMENT)
+    {
+      ast_ *named = init_ast(AST_ASSIGNMENT);
+      named->lhs = init_ast(AST_VARIABLE);
+      named->lhs->variable_name = argument->lhs->variable_name;
+      named->lhs->depth = -1; // Only looked up by name, should the tree walker assign it
+      argument = named;
+    }
+    add_ast_to_list(instantiation->arguments, argument);
+  }
+
+  return instantiation;
+}
+
+// Compiles the array or record an access reads, returning its register without checking it is set: the access
+// reports that the way the tree walker does.
+static int vm_compile_container(vm_compiler_ *compiler, ast_ *node)
+{
+  if (node->depth < 0)
+    return vm_constant(compiler, value_error());
+
+  int global;
+  int reg = vm_variable_register(compiler, node->depth, node->slot, &global);
+  if (reg >= 0)
+    return reg;
+
+  reg = vm_temporary(compiler);
+  vm_emit(compiler, VM_GET_GLOBAL, reg, global, 0, 0, 0, node);
+  return reg;
+}
+
+// Compiles an array access's indices into consecutive temporaries, returning the first.
+static int vm_compile_indices(vm_compiler_ *compiler, ast_ *node)
+{
+  int base = compiler->next_register;
+  for (size_t i = 0; i < node->index->size; i++)
+  {
+    int reg = vm_temporary(compiler);
+    vm_compile_into(compiler, node->index->items[i], reg);
+    compiler->next_register = reg + 1;
+  }
+  return base;
+}
+
+// Picks the instruction for an operator whose integer form the VM runs inline
+static vm_opcode_ vm_operator_opcode(enum operator_type operator)
+{
+  switch (operator)
+  {
+  case OP_ADD:
+    return VM_ADD;
+  case OP_SUBTRACT:
+    return VM_SUBTRACT;
+  case OP_MULTIPLY:
+    return VM_MULTIPLY;
+  case OP_DIVIDE:
+  case OP_INT_DIVIDE:
+    return VM_DIVIDE;
+  case OP_MODULO:
+    return VM_MODULO;
+  case OP_POWER:
+    return VM_POWER;
+  case OP_LESS:
+    return VM_LESS;
+  case OP_LESS_EQUAL:
+    return VM_LESS_EQUAL;
+  case OP_GREATER:
+    return VM_GREATER;
+  case OP_GREATER_EQUAL:
+    return VM_GREATER_EQUAL;
+  case OP_EQUAL:
+    return VM_EQUAL;
+  case OP_NOT_EQUAL:
+    return VM_NOT_EQUAL;
+  default:
+    return VM_OPERATE;
+  }
+}
+
+// Compiles an expression, returning where its value ends up: a variable's or constant's own register, or
+// `target` (a new temporary if it is -1) for anything computed.
+static vm_operand_ vm_compile_expression(vm_compiler_ *compiler, ast_ *node, int target)
+{
+  vm_operand_ operand = {0, 0};
+  int mark = compiler->next_register;
+
+  switch (node->type)
+  {
+  case AST_INTEGER:
+  case AST_REAL:
+  case AST_CHARACTER:
+  case AST_BOOLEAN:
+  case AST_STRING:
+  case AST_ARRAY:
+  case AST_RECORD:
+    operand.reg = vm_constant(compiler, value_from_ast(node));
+    return operand;
+
+  case AST_VARIABLE:
+  {
+    if (node->depth < 0)
+    {
+      operand.reg = vm_constant(compiler, value_error()); // Only in code after an EXIT, which never runs
+      return operand;
+    }
+
+    int global;
+    operand.reg = vm_variable_register(compiler, node->depth, node->slot, &global);
+    if (operand.reg >= 0)
+    {
+      operand.variable = 1;
+      return operand;
+    }
+
+    operand.reg = target >= 0 ? target : vm_temporary(compiler);
+    vm_emit(compiler, VM_GET_GLOBAL, operand.reg, global, 0, 0, VM_READ_B, node);
+    return operand;
+  }
+
+  case AST_ARITHMETIC_EXPRESSION:
+  case AST_BOOLEAN_EXPRESSION:
+  {
+    vm_operand_ left = {0, 0};
+    if (node->left != NULL)
+    {
+      left = vm_compile_expression(compiler, node->left, -1);
+
+      // A call in the right operand could assign the variable, which has to be read before it
+      if (node->calls && left.variable)
+      {
+        int reg = vm_temporary(compiler);
+        vm_emit(compiler, VM_MOVE, reg, left.reg, 0, 0, VM_READ_B, node->left);
+        left.reg = reg;
+        left.variable = 0;
+      }
+    }
+    vm_operand_ right = vm_compile_expression(compiler, node->right, -1);
+
+    vm_opcode_ opcode = node->left != NULL ? vm_operator_opcode(node->operator) : VM_OPERATE;
+    compiler->next_register = mark;
+    operand.reg = target >= 0 ? target : vm_temporary(compiler);
+    vm_emit(compiler, opcode, operand.reg, left.reg, right.reg, 0,
+            (left.variable ? VM_READ_B : 0) | (right.variable ? VM_READ_C : 0), node);
+    return operand;
+  }
+
+  case AST_INSTANTIATION:
+  {
+    int function = vm_called_function(compiler, node);
+    int base = vm_compile_arguments(compiler, node, function >= 0);
+    compiler->next_register = mark;
+    operand.reg = target >= 0 ? target : vm_temporary(compiler);
+    if (function >= 0)
+      vm_emit(compiler, VM_CALL, operand.reg, base, node->arguments_count, function, 0, node);
+    else
+      vm_emit(compiler, VM_INSTANTIATE, operand.reg, base, node->arguments_count, 0, 0, vm_instantiation(node));
+    return operand;
+  }
+
+  case AST_ARRAY_ACCESS:
+  {
+    int array = vm_compile_container(compiler, node);
+    int base = vm_compile_indices(compiler, node);
+    compiler->next_register = mark;
+    operand.reg = target >= 0 ? target : vm_temporary(compiler);
+    vm_emit(compiler, VM_INDEX, operand.reg, array, base, (int)node->index->size, 0, node);
+    return operand;
+  }
+
+  case AST_RECORD_ACCESS:
+  {
+    int record = vm_compile_container(compiler, node);
+    compiler->next_register = mark;
+    operand.reg = target >= 0 ? target : vm_temporary(compiler);
+    vm_emit(compiler, VM_FIELD, operand.reg, record, 0, 0, 0, node);
+    return operand;
+  }
+
+  default:
+    compiler->failed = 1;
+    return operand;
+  }
+}
+
+// Compiles a condition to a single instruction that falls through when it is True, and returns where that is so
+// the jumps for False (a) and for a condition that isn't a boolean (d) can be filled in.
+static int vm_compile_condition(vm_compiler_ *compiler, ast_ *condition, int message)
+{
+  int mark = compiler->next_register;
+  int jump;
+
+  if (condition->type == AST_BOOLEAN_EXPRESSION && condition->left != NULL &&
+      condition->operator >= OP_LESS && condition->operator <= OP_GREATER_EQUAL)
+  {
+    // A comparison branches on its operands directly
+    static const vm_opcode_ branches[] = {
+        [OP_LESS] = VM_BRANCH_LESS,
+        [OP_GREATER] = VM_BRANCH_GREATER,
+        [OP_EQUAL] = VM_BRANCH_EQUAL,
+        [OP_NOT_EQUAL] = VM_BRANCH_NOT_EQUAL,
+        [OP_LESS_EQUAL] = VM_BRANCH_LESS_EQUAL,
+        [OP_GREATER_EQUAL] = VM_BRANCH_GREATER_EQUAL,
+    };
+
+    vm_operand_ left = vm_compile_expression(compiler, condition->left, -1);
+    if (condition->calls && left.variable)
+    {
+      int reg = vm_temporary(compiler);
+      vm_emit(compiler, VM_MOVE, reg, left.reg, 0, 0, VM_READ_B, condition->left);
+      left.reg = reg;
+      left.variable = 0;
+    }
+    vm_operand_ right = vm_compile_expression(compiler, condition->right, -1);
+    jump = vm_emit(compiler, branches[condition->operator], -1, left.reg, right.reg, -1,
+                   (left.variable ? VM_READ_B : 0) | (right.variable ? VM_READ_C : 0) | VM_WITH_MESSAGE(message),
+                   condition);
+  }
+  else
+  {
+    vm_operand_ value = vm_compile_expression(compiler, condition, -1);
+    jump = vm_emit(compiler, VM_TEST, -1, value.reg, 0, -1,
+                   (value.variable ? VM_READ_B : 0) | VM_WITH_MESSAGE(message), condition);
+  }
+
+  compiler->next_register = mark;
+  return jump;
+}
+
+// Enters a loop's block, giving its variables the registers after those in use and unsetting them, as the tree
+// walker's fresh scope for the loop would be.
+static void vm_enter_loop(vm_compiler_ *compiler, vm_block_ *block, ast_ *node)
+{
+  block->parent = compiler->block;
+  block->layout = node->layout;
+  block->base = compiler->next_register;
+
+  int size = node->layout != NULL ? (int)node->layout->size : 0;
+  for (int i = 0; i < size; i++)
+    vm_temporary(compiler);
+  if (size > 0)
+    vm_emit(compiler, VM_CLEAR, block->base, size, 0, 0, 0, node);
+
+  compiler->block = block;
+}
+
+static void vm_leave_loop(vm_compiler_ *compiler, vm_block_ *block)
+{
+  compiler->block = block->parent;
+  compiler->next_register = block->base;
+}
+
+static void vm_compile_loop_body(vm_compiler_ *compiler, ast_ *node)
+{
+  compiler->loops++;
+  vm_compile_statements(compiler, node->loop_body);
+  compiler->loops--;
+}
+
+// Resets a FOR loop's variable by name in the enclosing scope once the loop finishes, to the value in `source`.
+static void vm_compile_loop_reset(vm_compiler_ *compiler, ast_ *node, int source)
+{
+  int depth, slot;
+  if (vm_find_name(compiler, node->loop_variable->lhs->variable_name, &depth, &slot))
+    vm_store_variable(compiler, depth, slot, source, node->loop_variable->lhs);
+  else
+    compiler->failed = 1;
+}
+
+static void vm_compile_for_to(vm_compiler_ *compiler, ast_ *node)
+{
+  int mark = compiler->next_register;
+  ast_ *variable = node->loop_variable->lhs;
+
+  // The bounds are evaluated once, end first, in the enclosing scope
+  int end = vm_temporary(compiler);
+  vm_compile_into(compiler, node->end_expr, end);
+  int end_check = vm_emit(compiler, VM_CHECK_INTEGER, -1, end, VM_BOUND_END, 0, 0, node->end_expr);
+
+  int step = -1, step_check = -1;
+  if (node->step_expr != NULL)
+  {
+    step = vm_temporary(compiler);
+    vm_compile_into(compiler, node->step_expr, step);
+    step_check = vm_emit(compiler, VM_CHECK_INTEGER, -1, step, VM_BOUND_STEP, 0, 0, node->step_expr);
+  }
+  else
+  {
+    step = vm_constant(compiler, value_integer(1));
+  }
+
+  int start = vm_temporary(compiler);
+  vm_compile_into(compiler, node->loop_variable->rhs, start);
+  int start_check = vm_emit(compiler, VM_CHECK_INTEGER, -1, start, VM_BOUND_START, 0, 0, node->loop_variable->rhs);
+
+  vm_block_ block;
+  vm_enter_loop(compiler, &block, node);
+
+  // A variable of the loop's own scope is the counter itself, so assigning it in the body moves the count along as
+  // it does in the tree walker; one found further out is set from a separate counter before every iteration
+  int counter;
+  int global;
+  if (variable->depth == 0)
+    counter = vm_variable_register(compiler, 0, variable->slot, &global);
+  else
+    counter = vm_temporary(compiler);
+  vm_emit(compiler, VM_MOVE, counter, start, 0, 0, 0, variable);
+
+  int test = vm_emit(compiler, VM_FOR_TEST, -1, counter, end, step, 0, node);
+  int body = vm_here(compiler);
+  if (variable->depth != 0)
+    vm_store_variable(compiler, variable->depth, variable->slot, counter, variable);
+  vm_compile_loop_body(compiler, node);
+  vm_emit(compiler, VM_FOR_LOOP, body, counter, end, step, 0, node);
+  compiler->function->code[test].a = vm_here(compiler);
+  vm_leave_loop(compiler, &block);
+
+  vm_compile_loop_reset(compiler, node, start);
+
+  // A bound that isn't an integer stops the loop before it starts, without the reset
+  int done = vm_here(compiler);
+  compiler->function->code[end_check].a = done;
+  compiler->function->code[start_check].a = done;
+  if (step_check >= 0)
+    compiler->function->code[step_check].a = done;
+  compiler->next_register = mark;
+}
+
+static void vm_compile_for_in(vm_compiler_ *compiler, ast_ *node)
+{
+  int mark = compiler->next_register;
+  ast_ *variable = node->loop_variable->lhs;
+
+  // Position, length and the collection itself, which the body can't replace
+  vm_operand_ collection = vm_compile_expression(compiler, node->collection_expr, -1);
+  compiler->next_register = mark;
+  int state = vm_temporary(compiler);
+  vm_temporary(compiler);
+  vm_temporary(compiler);
+  int start = vm_emit(compiler, VM_FOR_IN_START, -1, collection.reg, state, 0, collection.variable ? VM_READ_B : 0,
+                      node->collection_expr);
+
+  vm_block_ block;
+  vm_enter_loop(compiler, &block, node);
+
+  int global;
+  int item = vm_variable_register(compiler, variable->depth, variable->slot, &global);
+  if (item < 0)
+    item = vm_temporary(compiler);
+
+  int next = vm_emit(compiler, VM_FOR_IN_NEXT, -1, 0, state, item, 0, node);
+  vm_store_variable(compiler, variable->depth, variable->slot, item, variable);
+  vm_compile_loop_body(compiler, node);
+  vm_emit(compiler, VM_JUMP, next, 0, 0, 0, 0, node);
+  compiler->function->code[next].a = vm_here(compiler);
+  vm_leave_loop(compiler, &block);
+
+  // Unset, as a FOR-IN loop's variable has no start value
+  vm_compile_loop_reset(compiler, node, vm_constant(compiler, value_from_ast(node->loop_variable->rhs)));
+
+  compiler->function->code[start].a = vm_here(compiler);
+  compiler->next_register = mark;
+}
+
+static void vm_compile_indefinite_loop(vm_compiler_ *compiler, ast_ *node)
+{
+  vm_block_ block;
+  vm_enter_loop(compiler, &block, node);
+  vm_block_ *loop = compiler->block;
+  compiler->block = block.parent; // The condition is evaluated in the enclosing scope
+
+  if (node->indefinite_loop_type == 1) // WHILE loop
+  {
+    int top = vm_here(compiler);
+    int test = vm_compile_condition(compiler, node->condition, VM_MESSAGE_LOOP);
+    compiler->block = loop;
+    vm_compile_loop_body(compiler, node);
+    compiler->block = block.parent;
+    vm_emit(compiler, VM_JUMP, top, 0, 0, 0, 0, node);
+    compiler->function->code[test].a = vm_here(compiler);
+    compiler->function->code[test].d = vm_here(compiler);
+  }
+  else // REPEAT loop: the condition is checked once before the body first runs too
+  {
+    int first = vm_compile_condition(compiler, node->condition, VM_MESSAGE_LOOP);
+    int top = vm_here(compiler);
+    compiler->function->code[first].a = top;
+    compiler->block = loop;
+    vm_compile_loop_body(compiler, node);
+    compiler->block = block.parent;
+    int test = vm_compile_condition(compiler, node->condition, VM_MESSAGE_LOOP);
+    compiler->function->code[test].a = top;
+    compiler->function->code[first].d = vm_here(compiler);
+    compiler->function->code[test].d = vm_here(compiler);
+  }
+
+  compiler->block = loop;
+  vm_leave_loop(compiler, &block);
+}
+
+static void vm_compile_selection(vm_compiler_ *compiler, ast_ *node)
+{
+  if (node->if_condition == NULL || node->if_body == NULL)
+  {
+    compiler->failed = 1;
+    return;
+  }
+
+  // Jumps to the end of the statement: from each body, and from conditions that aren't booleans
+  int exits[2 * (node->else_if_conditions != NULL ? node->else_if_conditions->size : 0) + 2];
+  int exit_count = 0;
+
+  int test = vm_compile_condition(compiler, node->if_condition, VM_MESSAGE_IF);
+  vm_compile_statements(compiler, node->if_body);
+
+  for (size_t k = 0; node->else_if_conditions != NULL && k < node->else_if_conditions->size; k++)
+  {
+    exits[exit_count++] = vm_emit(compiler, VM_JUMP, -1, 0, 0, 0, 0, node);
+    compiler->function->code[test].a = vm_here(compiler);
+    exits[exit_count++] = test;
+
+    test = vm_compile_condition(compiler, node->else_if_conditions->items[k], VM_MESSAGE_ELSE_IF);
+    vm_compile_statements(compiler, node->else_if_bodies[k]);
+  }
+
+  if (node->else_body != NULL)
+  {
+    exits[exit_count++] = vm_emit(compiler, VM_JUMP, -1, 0, 0, 0, 0, node);
+    compiler->function->code[test].a = vm_here(compiler);
+    vm_compile_statements(compiler, node->else_body);
+  }
+  else
+  {
+    compiler->function->code[test].a = vm_here(compiler);
+  }
+  compiler->function->code[test].d = vm_here(compiler);
+
+  for (int i = 0; i < exit_count; i++)
+  {
+    vm_instruction_ *exit = &compiler->function->code[exits[i]];
+    if (exit->opcode == VM_JUMP)
+      exit->a = vm_here(compiler);
+    else
+      exit->d = vm_here(compiler);
+  }
+}
+
+static void vm_compile_assignment(vm_compiler_ *compiler, ast_ *node)
+{
+  int mark = compiler->next_register;
+  ast_ *lhs = node->lhs;
+
+  if (lhs->type == AST_VARIABLE)
+  {
+    if (lhs->depth < 0)
+      return; // Only in code after an EXIT, which never runs
+    if (lhs->constant && compiler->loops > 0)
+      compiler->failed = 1; // The tree walker stops the loop's second pass over it, which the VM doesn't track
+
+    int global;
+    int reg = vm_variable_register(compiler, lhs->depth, lhs->slot, &global);
+    int target = reg >= 0 ? reg : vm_temporary(compiler);
+
+    if (lhs->userinput == 1)
+      vm_emit(compiler, VM_INPUT, target, 0, 0, 0, 0, node);
+    else if (node->rhs->type == AST_ARRAY)
+      vm_emit(compiler, VM_NEW_ARRAY, target, vm_constant(compiler, value_from_ast(node->rhs)), 0, 0, 0, node);
+    else
+      vm_compile_into(compiler, node->rhs, target);
+
+    if (reg < 0)
+      vm_emit(compiler, VM_SET_GLOBAL, global, target, 0, 0, 0, lhs);
+  }
+  else if (lhs->type == AST_ARRAY_ACCESS || lhs->type == AST_RECORD_ACCESS)
+  {
+    int value = vm_temporary(compiler);
+    if (node->rhs->type == AST_ARRAY)
+      vm_emit(compiler, VM_NEW_ARRAY, value, vm_constant(compiler, value_from_ast(node->rhs)), 0, 0, 0, node);
+    else
+      vm_compile_into(compiler, node->rhs, value);
+
+    int container = vm_compile_container(compiler, lhs);
+    if (lhs->type == AST_ARRAY_ACCESS)
+    {
+      int base = vm_compile_indices(compiler, lhs);
+      vm_emit(compiler, VM_STORE_INDEX, value, container, base, (int)lhs->index->size, 0, lhs);
+    }
+    else
+    {
+      vm_emit(compiler, VM_STORE_FIELD, value, container, 0, 0, 0, lhs);
+    }
+
+    // A global array or record goes back where it came from, as a failed store replaces it with the value
+    int global;
+    if (lhs->depth >= 0 && vm_variable_register(compiler, lhs->depth, lhs->slot, &global) < 0)
+      vm_emit(compiler, VM_SET_GLOBAL, global, container, 0, 0, 0, lhs);
+  }
+  else
+  {
+    compiler->failed = 1;
+  }
+
+  compiler->next_register = mark;
+}
+
+static void vm_compile_output(vm_compiler_ *compiler, ast_ *node)
+{
+  size_t count = node->output_expressions->size;
+  if (count == 0)
+    vm_emit(compiler, VM_OUTPUT, 0, -1, 1, 0, 0, node);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    int mark = compiler->next_register;
+    ast_ *expression = node->output_expressions->items[i];
+    vm_operand_ value = vm_compile_expression(compiler, expression, -1);
+    vm_emit(compiler, VM_OUTPUT, 0, value.reg, i + 1 == count, 0, value.variable ? VM_READ_B : 0, expression);
+    compiler->next_register = mark;
+  }
+}
+
+static void vm_compile_return(vm_compiler_ *compiler, ast_ *node)
+{
+  if (compiler->function->definition == NULL)
+  {
+    vm_emit(compiler, VM_UNCAUGHT, 0, 0, 0, 0, 0, node);
+    return;
+  }
+
+  int mark = compiler->next_register;
+  ast_ *value = node->return_value;
+  int function = value->type == AST_INSTANTIATION ? vm_called_function(compiler, value) : -1;
+
+  if (function >= 0)
+  {
+    int base = vm_compile_arguments(compiler, value, 1);
+    vm_emit(compiler, VM_TAIL_CALL, 0, base, value->arguments_count, function, 0, value);
+  }
+  else
+  {
+    vm_operand_ result = vm_compile_expression(compiler, value, -1);
+    vm_emit(compiler, VM_RETURN, 0, result.reg, 0, 0, result.variable ? VM_READ_B : 0, value);
+  }
+
+  compiler->next_register = mark;
+}
+
+// Returns the function compiled for a subroutine definition, or -1 for one defined after an EXIT
+static int vm_defined_function(vm_compiler_ *compiler, ast_ *node)
+{
+  for (int i = 1; i < compiler->vm->function_count; i++)
+  {
+    if (compiler->vm->functions[i]->definition == node)
+      return i;
+  }
+  return -1;
+}
+
+static void vm_compile_statement(vm_compiler_ *compiler, ast_ *node)
+{
+  int mark = compiler->next_register;
+
+  switch (node->type)
+  {
+  case AST_COMPOUND:
+    vm_compile_statements(compiler, node->compound_value);
+    break;
+  case AST_NOOP:
+  case AST_INTEGER:
+  case AST_REAL:
+  case AST_CHARACTER:
+  case AST_STRING:
+  case AST_BOOLEAN:
+  case AST_ARRAY:
+  case AST_RECORD:
+    break;
+  case AST_VARIABLE:
+  case AST_RECORD_ACCESS:
+  case AST_ARRAY_ACCESS:
+  case AST_INSTANTIATION:
+  case AST_ARITHMETIC_EXPRESSION:
+  case AST_BOOLEAN_EXPRESSION:
+  {
+    vm_operand_ value = vm_compile_expression(compiler, node, -1);
+    if (value.variable)
+      vm_emit(compiler, VM_MOVE, vm_temporary(compiler), value.reg, 0, 0, VM_READ_B, node);
+    break;
+  }
+  case AST_ASSIGNMENT:
+    vm_compile_assignment(compiler, node);
+    break;
+  case AST_OUTPUT:
+    vm_compile_output(compiler, node);
+    break;
+  case AST_DEFINITE_LOOP:
+    if (node->collection_expr != NULL)
+      vm_compile_for_in(compiler, node);
+    else
+      vm_compile_for_to(compiler, node);
+    break;
+  case AST_INDEFINITE_LOOP:
+    vm_compile_indefinite_loop(compiler, node);
+    break;
+  case AST_SELECTION:
+    vm_compile_selection(compiler, node);
+    break;
+  case AST_RECORD_DEFINITION:
+  case AST_SUBROUTINE:
+    vm_emit(compiler, VM_DEFINE, 0, node->type == AST_SUBROUTINE ? vm_defined_function(compiler, node) : -1, 0, 0, 0,
+            node);
+    break;
+  case AST_RETURN:
+    vm_compile_return(compiler, node);
+    break;
+  case AST_EXIT:
+    vm_emit(compiler, VM_EXIT, 0, 0, 0, 0, 0, node);
+    break;
+  default:
+    compiler->failed = 1;
+    break;
+  }
+
+  compiler->next_register = mark;
+}
+
+// Compiles a list of statements in order; nothing after an EXIT runs, and the resolver hasn't checked it.
+static void vm_compile_statements(vm_compiler_ *compiler, ast_list_ *statements)
+{
+  for (size_t i = 0; statements != NULL && i < statements->size; i++)
+  {
+    vm_compile_statement(compiler, statements->items[i]);
+    if (statements->items[i]->type == AST_EXIT)
+      break;
+  }
+}
+
+// Collects the subroutines a program defines. Definitions the VM can't give a fixed meaning to make it leave the
+// program to the tree walker: one inside a loop or a subroutine, whose scope doesn't outlive it, or a subroutine
+// sharing its name with another definition, which the tree walker picks between as the definitions run.
+static void vm_collect_definitions(vm_compiler_ *compiler, ast_list_ *statements, ast_list_ *definitions, int nested)
+{
+  for (size_t i = 0; statements != NULL && i < statements->size; i++)
+  {
+    ast_ *node = statements->items[i];
+    switch (node->type)
+    {
+    case AST_SUBROUTINE:
+    case AST_RECORD_DEFINITION:
+    {
+      const char *name = node->type == AST_SUBROUTINE ? node->subroutine_name : node->record_name;
+      for (size_t j = 0; j < definitions->size; j++)
+      {
+        ast_ *other = definitions->items[j];
+        const char *other_name = other->type == AST_SUBROUTINE ? other->subroutine_name : other->record_name;
+        if ((node->type == AST_SUBROUTINE || other->type == AST_SUBROUTINE) && strcmp(name, other_name) == 0)
+          compiler->failed = 1;
+      }
+      if (nested)
+        compiler->failed = 1;
+      add_ast_to_list(definitions, node);
+
+      if (node->type == AST_SUBROUTINE)
+      {
+        vm_ *vm = compiler->vm;
+        vm->functions = realloc(vm->functions, (vm->function_count + 1) * sizeof(vm_function_ *));
+        if (!vm->functions)
+        {
+          fprintf(stderr, "Error: Memory allocation failed for the VM.\n");
+          exit(EXIT_FAILURE);
+        }
+        int variables = node->frame_layout != NULL ? (int)node->frame_layout->size : 0;
+        vm->functions[vm->function_count++] = init_vm_function(node, node->subroutine_name, variables);
+        vm_collect_definitions(compiler, node->body, definitions, 1);
+      }
+      break;
+    }
+    case AST_SELECTION:
+      vm_collect_definitions(compiler, node->if_body, definitions, nested);
+      for (size_t k = 0; node->else_if_conditions != NULL && k < node->else_if_conditions->size; k++)
+        vm_collect_definitions(compiler, node->else_if_bodies[k], definitions, nested);
+      vm_collect_definitions(compiler, node->else_body, definitions, nested);
+      break;
+    case AST_DEFINITE_LOOP:
+    case AST_INDEFINITE_LOOP:
+      vm_collect_definitions(compiler, node->loop_body, definitions, 1);
+      break;
+    case AST_EXIT:
+      return;
+    default:
+      break;
+    }
+  }
+}
+
+// Turns the constant operands of a function's instructions into the registers after its others, where each call
+// copies the constants to.
+static void vm_place_constants(vm_function_ *function)
+{
+  for (int i = 0; i < function->code_size; i++)
+  {
+    int *operands[] = {&function->code[i].a, &function->code[i].b, &function->code[i].c, &function->code[i].d};
+    for (int j = 0; j < 4; j++)
+    {
+      if (*operands[j] >= 0 && (*operands[j] & VM_CONSTANT))
+        *operands[j] = function->register_count + (*operands[j] & ~VM_CONSTANT);
+    }
+  }
+  function->frame_size = function->register_count + function->constant_count;
+}
+
+vm_ *vm_compile(interpreter_ *interpreter, ast_ *root)
+{
+  vm_ *vm = calloc(1, sizeof(struct VM_STRUCT));
+  if (!vm || root->type != AST_COMPOUND)
+  {
+    free(vm);
+    return NULL;
+  }
+  vm->interpreter = interpreter;
+
+  // The main program's own block is the global scope, whose slots are its first registers
+  scope_ *global_scope = interpreter->global_scope;
+  vm->functions = malloc(sizeof(vm_function_ *));
+  vm->functions[0] = init_vm_function(NULL, global_scope->scope_name, (int)global_scope->variable_count);
+  vm->function_count = 1;
+
+  vm_block_ global = {NULL, NULL, 0};
+  vm_compiler_ compiler = {vm, vm->functions[0], &global, &global};
+  ast_list_ *definitions = init_ast_list();
+  vm_collect_definitions(&compiler, root->compound_value, definitions, 0);
+
+  compiler.next_register = compiler.function->variable_count;
+  vm_compile_statements(&compiler, root->compound_value);
+  vm_emit(&compiler, VM_HALT, 0, 0, 0, 0, 0, root);
+  vm_place_constants(compiler.function);
+
+  // A subroutine's frame sees its own block, then the global scope, whose registers belong to the main program
+  global.base = -1;
+  for (int i = 1; i < vm->function_count && !compiler.failed; i++)
+  {
+    vm_function_ *function = vm->functions[i];
+    ast_ *definition = function->definition;
+    vm_block_ frame = {&global, definition->frame_layout, 0};
+
+    compiler.function = function;
+    compiler.block = &frame;
+    compiler.next_register = function->variable_count;
+    compiler.loops = 0;
+    vm_compile_statements(&compiler, definition->body);
+    vm_emit(&compiler, VM_RETURN_NONE, 0, 0, 0, 0, 0, definition);
+    vm_place_constants(function);
+  }
+
+  if (compiler.failed)
+  {
+    free_vm(vm);
+    return NULL;
+  }
+  return vm;
+}
+
+// Reads a variable's register the way the tree walker reads its slot: an unset variable stops the program, and one
+// holding a failed expression or a call's missing result reports it and reads as a failed expression. Errors name
+// the scope the instruction runs in.
+static value_ vm_read(const vm_function_ *function, const vm_instruction_ *instruction, value_ value, ast_ *variable)
+{
+  if (value.type != AST_NOOP)
+    return value;
+
+  if (value.node == &vm_unset)
+  {
+    fprintf(stderr, "Error: Variable definition `%s` not found in scope `%s`.\n", variable->variable_name,
+            instruction->flags & VM_IN_LOOP ? "child_scope" : function->scope_name);
+    exit(EXIT_FAILURE);
+  }
+  if (value.node == NULL)
+    fprintf(stderr, "Interpreter Error: Undefined variable `%s`\n", variable->variable_name);
+  else
+    fprintf(stderr, "Interpreter Error: Uncaught statement of type `%s`\n", ast_type_to_string(value.node->type));
+  return value_error();
+}
+
+// Reads operand b or c of an instruction, applying the read rules when it is a variable
+static value_ vm_operand(const vm_function_ *function, const vm_instruction_ *instruction, const value_ *registers,
+                         int which)
+{
+  ast_ *node = instruction->node;
+  value_ value = registers[which == VM_READ_B ? instruction->b : instruction->c];
+  if (!(instruction->flags & which))
+    return value;
+
+  // An operator's operands are its own children; any other instruction reads the variable it was compiled from
+  if (node->type == AST_ARITHMETIC_EXPRESSION || node->type == AST_BOOLEAN_EXPRESSION)
+    node = which == VM_READ_B ? node->left : node->right;
+  return vm_read(function, instruction, value, node);
+}
+
+// Applies an instruction's operator to its operands, reading (and so reporting) them left to right as the tree walker
+// does
+static value_ vm_operation(const vm_function_ *function, const vm_instruction_ *instruction, const value_ *registers)
+{
+  value_ left = vm_operand(function, instruction, registers, VM_READ_B);
+  return interpreter_apply_operation(instruction->node, left, vm_operand(function, instruction, registers, VM_READ_C));
+}
+
+// The node an array or record access works on, read from its variable's register
+static ast_ *vm_container(const vm_function_ *function, const vm_instruction_ *instruction, value_ value)
+{
+  if (value.type == AST_NOOP && value.node == &vm_unset)
+    vm_read(function, instruction, value, instruction->node);
+  return value_to_ast(value);
+}
+
+// Finds the element of an array access's array at its evaluated indices, or reports why there is none.
+static ast_ **vm_element(const vm_function_ *function, const vm_instruction_ *instruction, const value_ *registers)
+{
+  ast_ *array = interpreter_array_variable(vm_container(function, instruction, registers[instruction->b]),
+                                           instruction->node);
+  ast_ **element = NULL;
+  for (int i = 0; array != NULL && i < instruction->d; i++)
+  {
+    element = interpreter_array_element(array, registers[instruction->c + i]);
+    if (element == NULL)
+      return NULL;
+    array = *element;
+  }
+  return element;
+}
+
+// Reports a condition that isn't a boolean, for the statement it belongs to
+static void vm_condition_error(const vm_instruction_ *instruction)
+{
+  switch (VM_MESSAGE(instruction->flags))
+  {
+  case VM_MESSAGE_IF:
+    fprintf(stderr, "Interpreter Error: IF condition could not be evaluated to a boolean\n");
+    break;
+  case VM_MESSAGE_ELSE_IF:
+    fprintf(stderr, "Interpreter Error: ELSE IF condition could not be evaluated to a boolean\n");
+    break;
+  default:
+    fprintf(stderr, "Interpreter Error: Condition could not be evaluated to an integer\n");
+    break;
+  }
+}
+
+// Where a condition goes once it has been evaluated, as TEST and the fused comparisons' slow path do
+static const vm_instruction_ *vm_branch(const vm_instruction_ *code, const vm_instruction_ *instruction,
+                                        value_ condition)
+{
+  if (condition.type != AST_BOOLEAN || condition.null)
+  {
+    vm_condition_error(instruction);
+    return code + instruction->d;
+  }
+  return condition.boolean_value ? instruction + 1 : code + instruction->a;
+}
+
+// Makes room for a frame of `size` registers from `base`, returning the registers, which may have moved
+static value_ *vm_reserve(vm_ *vm, size_t base, int size)
+{
+  if (base + size > vm->register_capacity)
+  {
+    size_t capacity = vm->register_capacity ? vm->register_capacity : VM_INITIAL_REGISTERS;
+    while (base + size > capacity)
+      capacity *= 2;
+    vm->registers = realloc(vm->registers, capacity * sizeof(value_));
+    if (!vm->registers)
+    {
+      fprintf(stderr, "Error: Memory allocation failed for the VM.\n");
+      exit(EXIT_FAILURE);
+    }
+    vm->register_capacity = capacity;
+  }
+  return vm->registers + base;
+}
+
+// Starts a function in its frame: its variables unset, its constants in place and its parameters bound. Like the
+// tree walker, a parameter gets its own copy of a boxed argument's node.
+static void vm_enter(vm_function_ *function, value_ *registers, const value_ *arguments)
+{
+  for (int i = 0; i < function->variable_count; i++)
+  {
+    registers[i].type = AST_NOOP;
+    registers[i].node = &vm_unset;
+  }
+  if (function->constant_count > 0)
+    memcpy(registers + function->register_count, function->constants, function->constant_count * sizeof(value_));
+
+  ast_ *definition = function->definition;
+  for (int i = 0; definition != NULL && i < definition->parameter_count; i++)
+  {
+    value_ argument = arguments[i];
+    if (!VALUE_INLINE(argument.type))
+    {
+      ast_ *copy = init_ast(argument.type);
+      *copy = *argument.node;
+      argument.node = copy;
+    }
+    registers[definition->parameters->items[i]->slot] = argument;
+  }
+}
+
+// Whether any of a call's evaluated arguments failed, which fails the call without running it
+static int vm_arguments_failed(const value_ *arguments, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    if (value_is_error(arguments[i]))
+      return 1;
+  }
+  return 0;
+}
+
+#define VM_INTEGERS(left, right) ((left).type == AST_INTEGER && (right).type == AST_INTEGER && !((left).null | (right).null))
+
+void vm_run(vm_ *vm)
+{
+#if VM_COMPUTED_GOTO
+#define VM_LABEL(name) &&vm_op_##name,
+  static const void *const labels[] = {VM_OPCODES(VM_LABEL)};
+#undef VM_LABEL
+
+  // Threads the code: every instruction carries the label it runs at, so dispatch is a single indirect jump
+  for (int i = 0; i < vm->function_count; i++)
+  {
+    for (int j = 0; j < vm->functions[i]->code_size; j++)
+      vm->functions[i]->code[j].handler = labels[vm->functions[i]->code[j].opcode];
+  }
+
+#if VM_JIT
+  // With the JIT on, back edges count their loop's passes and calls their subroutine's calls
+  for (int i = 0; vm->jit != NULL && i < vm->function_count; i++)
+  {
+    for (int j = 0; j < vm->functions[i]->code_size; j++)
+    {
+      vm_instruction_ *instruction = &vm->functions[i]->code[j];
+      if (instruction->opcode == VM_CALL)
+        instruction->handler = &&vm_jit_call;
+      else if ((instruction->opcode == VM_JUMP || instruction->opcode == VM_FOR_LOOP ||
+                instruction->opcode == VM_TEST ||
+                (instruction->opcode >= VM_BRANCH_LESS && instruction->opcode <= VM_BRANCH_NOT_EQUAL)) &&
+               instruction->a >= 0 && instruction->a <= j)
+        instruction->handler = &&vm_jit_back_edge;
+    }
+  }
+#endif
+#define VM_CASE(name) vm_op_##name:
+#define VM_NEXT() goto *ip->handler
+#else
+#define VM_CASE(name) case VM_##name:
+#define VM_NEXT() goto dispatch
+#endif
+
+  interpreter_ *interpreter = vm->interpreter;
+  interpreter->scope = interpreter->global_scope; // Where definitions are registered and records looked up
+
+  // Nodes made while running are bump-allocated, and kept for the REPL as the other engines keep theirs
+  arena_ *previous_arena = ast_use_arena(init_arena(ARENA_BLOCK_SIZE));
+
+  vm_function_ *function = vm->functions[0];
+  size_t base = 0;
+  int frame_count = 0;
+  value_ *registers = vm_reserve(vm, base, function->frame_size);
+  vm_enter(function, registers, NULL);
+  const vm_instruction_ *code = function->code;
+  const vm_instruction_ *ip = code;
+  value_ result; // What a returning call gives its caller
+
+#if VM_COMPUTED_GOTO
+  VM_NEXT();
+#else
+dispatch:
+  switch (ip->opcode)
+  {
+#endif
+
+  VM_CASE(MOVE)
+  {
+    value_ value = registers[ip->b];
+    if (value.type == AST_NOOP)
+      value = vm_operand(function, ip, registers, VM_READ_B);
+    registers[ip->a] = value;
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(NEW_ARRAY)
+  {
+    registers[ip->a] = value_from_ast(deep_copy(registers[ip->b].node));
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(GET_GLOBAL)
+  {
+    value_ value = vm->registers[ip->b]; // The main program's frame is the first
+    if (value.type == AST_NOOP && (ip->flags & VM_READ_B))
+      value = vm_read(function, ip, value, ip->node);
+    registers[ip->a] = value;
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(SET_GLOBAL)
+  {
+    vm->registers[ip->a] = registers[ip->b];
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(CLEAR)
+  {
+    for (int i = 0; i < ip->b; i++)
+    {
+      registers[ip->a + i].type = AST_NOOP;
+      registers[ip->a + i].node = &vm_unset;
+    }
+    ip++;
+    VM_NEXT();
+  }
+
+// Integer operands run inline while `defined` holds; anything else, such as a zero divisor, gets the full rules
+#define VM_ARITHMETIC(name, defined, result)                                                                         \
+  VM_CASE(name)                                                                                                      \
+  {                                                                                                                  \
+    value_ left = registers[ip->b], right = registers[ip->c];                                                        \
+    int64_t x = left.int_value, y = right.int_value;                                                                 \
+    if (VM_INTEGERS(left, right) && (defined))                                                                       \
+    {                                                                                                                \
+      registers[ip->a] = (value_){.type = AST_INTEGER, .int_value = (result)};                                       \
+    }                                                                                                                \
+    else                                                                                                             \
+    {                                                                                                                \
+      registers[ip->a] = vm_operation(function, ip, registers);                                                      \
+    }                                                                                                                \
+    ip++;                                                                                                            \
+    VM_NEXT();                                                                                                       \
+  }
+
+#define VM_COMPARISON(name, operator)                                                                                \
+  VM_CASE(name)                                                                                                      \
+  {                                                                                                                  \
+    value_ left = registers[ip->b], right = registers[ip->c];                                                        \
+    if (VM_INTEGERS(left, right))                                                                                    \
+    {                                                                                                                \
+      registers[ip->a] = (value_){.type = AST_BOOLEAN,                                                               \
+                                  .boolean_value = left.int_value operator right.int_value};                         \
+    }                                                                                                                \
+    else                                                                                                             \
+    {                                                                                                                \
+      registers[ip->a] = vm_operation(function, ip, registers);                                                      \
+    }                                                                                                                \
+    ip++;                                                                                                            \
+    VM_NEXT();                                                                                                       \
+  }
+
+  // The same expressions as the tree walker's integer operations, which report a zero divisor
+  VM_ARITHMETIC(ADD, 1, INTEGER_ADD(x, y))
+  VM_ARITHMETIC(SUBTRACT, 1, INTEGER_SUBTRACT(x, y))
+  VM_ARITHMETIC(MULTIPLY, 1, INTEGER_MULTIPLY(x, y))
+  VM_ARITHMETIC(DIVIDE, y != 0, divide_integer(x, y))
+  VM_ARITHMETIC(MODULO, y != 0, modulo_Euclidean(x, y))
+  VM_ARITHMETIC(POWER, 1, power_integer(x, y))
+  VM_CASE(OPERATE)
+  {
+    registers[ip->a] = vm_operation(function, ip, registers);
+    ip++;
+    VM_NEXT();
+  }
+  VM_COMPARISON(LESS, <)
+  VM_COMPARISON(LESS_EQUAL, <=)
+  VM_COMPARISON(GREATER, >)
+  VM_COMPARISON(GREATER_EQUAL, >=)
+  VM_COMPARISON(EQUAL, ==)
+  VM_COMPARISON(NOT_EQUAL, !=)
+
+  VM_CASE(JUMP)
+  {
+    ip = code + ip->a;
+    VM_NEXT();
+  }
+
+  VM_CASE(TEST)
+  {
+    value_ condition = registers[ip->b];
+    if (condition.type == AST_BOOLEAN && !condition.null)
+      ip = condition.boolean_value ? ip + 1 : code + ip->a;
+    else
+      ip = vm_branch(code, ip, vm_operand(function, ip, registers, VM_READ_B));
+    VM_NEXT();
+  }
+
+#define VM_BRANCH(name, operator)                                                                                    \
+  VM_CASE(name)                                                                                                      \
+  {                                                                                                                  \
+    value_ left = registers[ip->b], right = registers[ip->c];                                                        \
+    if (VM_INTEGERS(left, right))                                                                                    \
+    {                                                                                                                \
+      ip = left.int_value operator right.int_value ? ip + 1 : code + ip->a;                                          \
+    }                                                                                                                \
+    else                                                                                                             \
+    {                                                                                                                \
+      ip = vm_branch(code, ip, vm_operation(function, ip, registers));                                               \
+    }                                                                                                                \
+    VM_NEXT();                                                                                                       \
+  }
+
+  VM_BRANCH(BRANCH_LESS, <)
+  VM_BRANCH(BRANCH_LESS_EQUAL, <=)
+  VM_BRANCH(BRANCH_GREATER, >)
+  VM_BRANCH(BRANCH_GREATER_EQUAL, >=)
+  VM_BRANCH(BRANCH_EQUAL, ==)
+  VM_BRANCH(BRANCH_NOT_EQUAL, !=)
+
+  VM_CASE(CHECK_INTEGER)
+  {
+    value_ bound = registers[ip->b];
+    if (bound.type == AST_INTEGER && !bound.null)
+    {
+      ip++;
+      VM_NEXT();
+    }
+
+    static const char *const bounds[] = {"End", "Step", "Start"};
+    fprintf(stderr, "Interpreter Error: %s expression could not be recognized as an integer\n", bounds[ip->c]);
+    ip = code + ip->a;
+    VM_NEXT();
+  }
+
+  VM_CASE(CHECK_ARGUMENT)
+  {
+    ip = value_is_error(registers[ip->b]) ? code + ip->a : ip + 1;
+    VM_NEXT();
+  }
+
+  VM_CASE(FOR_TEST)
+  {
+    int64_t counter = registers[ip->b].int_value, end = registers[ip->c].int_value, step = registers[ip->d].int_value;
+    ip = (step > 0 && counter <= end) || (step < 0 && counter >= end) ? ip + 1 : code + ip->a;
+    VM_NEXT();
+  }
+
+  VM_CASE(FOR_LOOP)
+  {
+    int64_t step = registers[ip->d].int_value, end = registers[ip->c].int_value;
+    int64_t counter = registers[ip->b].int_value += step;
+    ip = (step > 0 && counter <= end) || (step < 0 && counter >= end) ? code + ip->a : ip + 1;
+    VM_NEXT();
+  }
+
+  VM_CASE(FOR_IN_START)
+  {
+    value_ collection = vm_operand(function, ip, registers, VM_READ_B);
+    int64_t length;
+    if (collection.type == AST_STRING && collection.node != NULL)
+      length = collection.node->string_value != NULL ? (int64_t)strlen(collection.node->string_value) : 0;
+    else if (collection.type == AST_ARRAY && collection.node != NULL)
+      length = (int64_t)collection.node->array_size;
+    else
+    {
+      fprintf(stderr, "Interpreter Error: Collection type not supported in FOR-IN loop\n");
+      ip = code + ip->a;
+      VM_NEXT();
+    }
+
+    // The collection may have been computed into the state's own registers, so it is read before they are set
+    registers[ip->c] = (value_){.type = AST_INTEGER, .int_value = 0};
+    registers[ip->c + 1] = (value_){.type = AST_INTEGER, .int_value = length};
+    registers[ip->c + 2] = collection;
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(FOR_IN_NEXT)
+  {
+    value_ *state = registers + ip->c;
+    if (state[0].int_value >= state[1].int_value)
+    {
+      ip = code + ip->a;
+      VM_NEXT();
+    }
+
+    ast_ *collection = state[2].node;
+    int64_t position = state[0].int_value++;
+    if (collection->type == AST_STRING)
+    {
+      unsigned char character = (unsigned char)collection->string_value[position];
+      ast_ *item = vm->characters[character];
+      if (item == NULL)
+      {
+        item = vm->characters[character] = init_ast(AST_STRING);
+        item->string_value = malloc(2);
+        item->string_value[0] = (char)character;
+        item->string_value[1] = '\0';
+      }
+      registers[ip->d] = value_from_ast(item);
+    }
+    else
+    {
+      registers[ip->d] = value_from_ast(collection->array_elements->items[position]);
+    }
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(CALL)
+  {
+    vm_function_ *callee = vm->functions[ip->d];
+    if (!callee->defined || vm_arguments_failed(registers + ip->b, ip->c))
+    {
+      registers[ip->a] = value_error(); // The tree walker finds no definition, or an argument failed
+      ip++;
+      VM_NEXT();
+    }
+
+    if (interpreter->call_depth >= interpreter->max_call_depth)
+      interpreter_call_depth_error(interpreter, callee->definition);
+    interpreter->call_depth++;
+
+    if (frame_count == vm->frame_capacity)
+    {
+      vm->frame_capacity = vm->frame_capacity ? vm->frame_capacity * 2 : VM_INITIAL_FRAMES;
+      vm->frames = realloc(vm->frames, vm->frame_capacity * sizeof(vm_frame_));
+      if (!vm->frames)
+      {
+        fprintf(stderr, "Error: Memory allocation failed for the VM.\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    vm->frames[frame_count++] = (vm_frame_){function, ip + 1, base, ip->a};
+
+    // The callee's frame starts after the caller's, with the arguments copied across before it is set up
+    size_t caller = base;
+    int arguments = ip->b;
+    base += function->frame_size;
+    registers = vm_reserve(vm, base, callee->frame_size);
+    vm_enter(callee, registers, vm->registers + caller + arguments);
+
+    function = callee;
+    code = ip = function->code;
+    VM_NEXT();
+  }
+
+  VM_CASE(TAIL_CALL)
+  {
+    vm_function_ *callee = vm->functions[ip->d];
+    if (!callee->defined || vm_arguments_failed(registers + ip->b, ip->c))
+    {
+      result = value_error(); // The call fails, and so does the one returning it
+      goto vm_return;
+    }
+
+    // The arguments are in the frame the callee is about to take over
+    if (ip->c > vm->argument_capacity)
+    {
+      vm->argument_capacity = ip->c;
+      vm->arguments = realloc(vm->arguments, vm->argument_capacity * sizeof(value_));
+      if (!vm->arguments)
+      {
+        fprintf(stderr, "Error: Memory allocation failed for the VM.\n");
+        exit(EXIT_FAILURE);
+      }
+    }
+    if (ip->c > 0)
+      memcpy(vm->arguments, registers + ip->b, ip->c * sizeof(value_));
+
+    registers = vm_reserve(vm, base, callee->frame_size);
+    vm_enter(callee, registers, vm->arguments);
+    function = callee;
+    code = ip = function->code;
+    VM_NEXT();
+  }
+
+  VM_CASE(RETURN_NONE)
+  {
+    result.type = AST_NOOP;
+    result.node = &vm_noop;
+    goto vm_return;
+  }
+
+  VM_CASE(RETURN)
+  {
+    result = vm_operand(function, ip, registers, VM_READ_B);
+  vm_return:
+    interpreter->call_depth--;
+    vm_frame_ *frame = &vm->frames[--frame_count];
+    function = frame->function;
+    code = function->code;
+    ip = frame->resume;
+    base = frame->base;
+    registers = vm->registers + base;
+    registers[frame->result] = result;
+    VM_NEXT();
+  }
+
+  VM_CASE(INSTANTIATE)
+  {
+    // The arguments' values go in the shadow node's argument list, where the tree walker evaluates them to themselves
+    ast_ *instantiation = ip->node;
+    for (int i = 0; i < ip->c; i++)
+    {
+      ast_ *argument = instantiation->arguments->items[i];
+      ast_ *value = value_to_ast(registers[ip->b + i]);
+      if (argument->type == AST_ASSIGNMENT)
+        argument->rhs = value;
+      else
+        instantiation->arguments->items[i] = value;
+    }
+    registers[ip->a] = value_from_ast(interpreter_process_instantiation(interpreter, instantiation));
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(INDEX)
+  {
+    ast_ **element = vm_element(function, ip, registers);
+    registers[ip->a] = element != NULL ? value_from_ast(*element) : value_error();
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(STORE_INDEX)
+  {
+    value_ value = registers[ip->a];
+    ast_ **element = vm_element(function, ip, registers);
+    if (element == NULL)
+      registers[ip->b] = value; // The tree walker assigns the value to the array's variable instead
+    else if (value_is_error(value) || (*element)->type != value.type)
+      fprintf(stderr, "Interpreter Error: Type mismatch during assignment.\n");
+    else
+      *element = value_to_ast(value);
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(FIELD)
+  {
+    ast_ **field = interpreter_record_field(vm_container(function, ip, registers[ip->b]), ip->node);
+    registers[ip->a] = field != NULL ? value_from_ast(*field) : value_error();
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(STORE_FIELD)
+  {
+    value_ value = registers[ip->a];
+    ast_ **field = interpreter_record_field(vm_container(function, ip, registers[ip->b]), ip->node);
+    if (field == NULL)
+      registers[ip->b] = value; // The tree walker assigns the value to the record's variable instead
+    else if (value_is_error(value) || (*field)->type != value.type)
+      fprintf(stderr, "Interpreter Error: Type mismatch during assignment.\n");
+    else
+      *field = value_to_ast(value);
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(OUTPUT)
+  {
+    if (ip->b >= 0)
+      interpreter_output_value(vm_operand(function, ip, registers, VM_READ_B), interpreter);
+    putchar(ip->c ? '\n' : ' ');
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(INPUT)
+  {
+    scope_read_userinput(ip->node); // Stores the line in the assignment's string, as the tree walker does
+    registers[ip->a] = value_from_ast(ip->node->rhs);
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(DEFINE)
+  {
+    interpreter_process(interpreter, ip->node);
+    if (ip->b >= 0)
+      vm->functions[ip->b]->defined = 1;
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(UNCAUGHT)
+  {
+    fprintf(stderr, "Interpreter Error: Uncaught statement of type `%s`\n", ast_type_to_string(ip->node->type));
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(EXIT)
+  {
+    interpreter_process_exit(interpreter, ip->node);
+    ip++;
+    VM_NEXT();
+  }
+
+  VM_CASE(HALT)
+  {
+    goto halt;
+  }
+
+#if VM_JIT
+  // A hot loop is compiled from the instruction its back edge goes to, which from then on runs it; the back edge
+  // itself is taken as usual
+vm_jit_back_edge:
+  {
+    int at = (int)(ip - code);
+    if (++function->jit->passes[at] >= JIT_HOT_LOOP)
+    {
+      function->code[at].handler = labels[ip->opcode]; // Compiled or not, the loop isn't counted again
+      jit_region_ *loop = function->jit->loops[ip->a];
+      if ((loop == NULL || loop->last < at) && jit_compile_loop(vm->jit, function, ip->a, at, registers) != NULL)
+        function->code[ip->a].handler = &&vm_jit_loop;
+    }
+    goto *labels[ip->opcode];
+  }
+
+  // Runs a compiled loop, which returns where the VM carries on; its first instruction runs as usual when the
+  // registers don't hold the types it was compiled for, and always once that keeps happening
+vm_jit_loop:
+  {
+    jit_region_ *loop = function->jit->loops[ip - code];
+    int next = jit_run_loop(vm->jit, loop, registers);
+    if (next >= 0)
+    {
+      ip = code + next;
+      VM_NEXT();
+    }
+    if (loop->failures >= JIT_MAX_BAILS)
+      function->code[ip - code].handler = labels[ip->opcode];
+    goto *labels[ip->opcode];
+  }
+
+  // Calls a compiled subroutine directly, compiling it once it is hot; anything it can't do is an ordinary call
+vm_jit_call:
+  {
+    vm_function_ *callee = vm->functions[ip->d];
+    if (callee->jit->region == NULL && ++callee->jit->calls >= JIT_HOT_CALL)
+      jit_compile_subroutine(vm->jit, callee);
+    if (callee->jit->native != NULL && callee->defined &&
+        jit_call(vm->jit, callee, registers + ip->b, ip->c, registers + ip->a))
+    {
+      ip++;
+      VM_NEXT();
+    }
+    goto vm_op_CALL;
+  }
+#endif
+
+#if !VM_COMPUTED_GOTO
+  default:
+    goto halt;
+  }
+#endif
+
+halt:
+  ast_use_arena(previous_arena);
+
+#undef VM_ARITHMETIC
+#undef VM_COMPARISON
+#undef VM_BRANCH
+#undef VM_CASE
+#undef VM_NEXT
+}